@@ -0,0 +1,296 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "BenchmarkHarness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+#include <boost/regex.hpp>
+
+static const unsigned long long BenchmarkMaxIterations = 1000000000ULL;
+static const double BenchmarkDefaultMinTime = 0.5;
+
+static double BenchmarkClock(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+BenchmarkState::BenchmarkState(unsigned long long maxIterations)
+	: m_iterations(0)
+	, m_maxIterations(maxIterations)
+	, m_itemsProcessed(0)
+	, m_started(false)
+	, m_running(false)
+	, m_realStart(0.0)
+	, m_cpuStart(0.0)
+	, m_realElapsed(0.0)
+	, m_cpuElapsed(0.0)
+{
+}
+
+bool BenchmarkState::KeepRunning()
+{
+	if (!m_started) {
+		m_started = true;
+		Start();
+	}
+
+	if (m_iterations < m_maxIterations) {
+		m_iterations++;
+		return true;
+	}
+
+	if (m_running) {
+		Stop();
+	}
+
+	return false;
+}
+
+void BenchmarkState::PauseTiming()
+{
+	if (m_running) {
+		Stop();
+	}
+}
+
+void BenchmarkState::ResumeTiming()
+{
+	if (!m_running) {
+		Start();
+	}
+}
+
+void BenchmarkState::SetItemsProcessed(unsigned long long items)
+{
+	m_itemsProcessed = items;
+}
+
+unsigned long long BenchmarkState::GetIterations() const
+{
+	return m_iterations;
+}
+
+unsigned long long BenchmarkState::GetItemsProcessed() const
+{
+	return m_itemsProcessed;
+}
+
+double BenchmarkState::GetRealNanoseconds() const
+{
+	return m_realElapsed;
+}
+
+double BenchmarkState::GetCpuNanoseconds() const
+{
+	return m_cpuElapsed;
+}
+
+void BenchmarkState::Start()
+{
+	m_running = true;
+	m_realStart = BenchmarkClock(CLOCK_MONOTONIC);
+	m_cpuStart = BenchmarkClock(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void BenchmarkState::Stop()
+{
+	m_realElapsed += BenchmarkClock(CLOCK_MONOTONIC) - m_realStart;
+	m_cpuElapsed += BenchmarkClock(CLOCK_PROCESS_CPUTIME_ID) - m_cpuStart;
+	m_running = false;
+}
+
+BenchmarkRegistry& BenchmarkRegistry::GetInstance()
+{
+	static BenchmarkRegistry s_registry;
+	return s_registry;
+}
+
+int BenchmarkRegistry::Register(const char *name, BenchmarkFunction function)
+{
+	Entry entry;
+	entry.m_name = name;
+	entry.m_function = function;
+	m_entries.push_back(entry);
+
+	return (int)m_entries.size();
+}
+
+/*
+ * Start with a single iteration and grow the count until one run takes at
+ * least the minimum time, the same way Google Benchmark sizes its runs.  The
+ * final run is the one reported.
+ */
+BenchmarkRegistry::Result BenchmarkRegistry::Run(const Entry& entry,
+	double minTime) const
+{
+	unsigned long long iterations = 1;
+	double minNs = minTime * 1e9;
+
+	while (true) {
+		BenchmarkState state(iterations);
+		entry.m_function(state);
+
+		double elapsed = state.GetRealNanoseconds();
+		if ((elapsed >= minNs) || (iterations >= BenchmarkMaxIterations)) {
+			Result result;
+			result.m_name = entry.m_name;
+			result.m_iterations = state.GetIterations();
+			result.m_items = state.GetItemsProcessed();
+			result.m_realNs = state.GetRealNanoseconds();
+			result.m_cpuNs = state.GetCpuNanoseconds();
+			return result;
+		}
+
+		double multiplier = (elapsed > 0.0) ?
+			((minNs * 1.4) / elapsed) : 10.0;
+		if (multiplier > 10.0) {
+			multiplier = 10.0;
+		} else if (multiplier < 1.5) {
+			multiplier = 1.5;
+		}
+
+		double next = (double)iterations * multiplier;
+		if (next > (double)BenchmarkMaxIterations) {
+			iterations = BenchmarkMaxIterations;
+		} else {
+			iterations = (unsigned long long)next;
+		}
+	}
+}
+
+void BenchmarkRegistry::PrintConsole(const std::vector<Result>& results) const
+{
+	fprintf(stdout, "%-48s %15s %15s %12s\n", "Benchmark", "Time",
+		"CPU", "Iterations");
+	fprintf(stdout, "%s\n", std::string(93, '-').c_str());
+
+	for (std::vector<Result>::const_iterator iter = results.begin();
+		iter != results.end(); ++iter) {
+		double n = (double)iter->m_iterations;
+		fprintf(stdout, "%-48s %12.0f ns %12.0f ns %12llu",
+			iter->m_name.c_str(), iter->m_realNs / n, iter->m_cpuNs / n,
+			iter->m_iterations);
+		if (iter->m_items && (iter->m_cpuNs > 0.0)) {
+			fprintf(stdout, " %12.0f items/s", (double)iter->m_items *
+				n * 1e9 / iter->m_cpuNs);
+		}
+		fprintf(stdout, "\n");
+	}
+}
+
+void BenchmarkRegistry::PrintJson(const std::vector<Result>& results) const
+{
+	char date[64];
+	time_t now = time(NULL);
+	struct tm tm;
+	localtime_r(&now, &tm);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &tm);
+
+	fprintf(stdout, "{\n");
+	fprintf(stdout, "  \"context\": {\n");
+	fprintf(stdout, "    \"date\": \"%s\",\n", date);
+	fprintf(stdout, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef MOJ_DEBUG
+	fprintf(stdout, "    \"library_build_type\": \"debug\"\n");
+#else
+	fprintf(stdout, "    \"library_build_type\": \"release\"\n");
+#endif
+	fprintf(stdout, "  },\n");
+	fprintf(stdout, "  \"benchmarks\": [");
+
+	for (std::vector<Result>::const_iterator iter = results.begin();
+		iter != results.end(); ++iter) {
+		double n = (double)iter->m_iterations;
+		fprintf(stdout, "%s\n    {\n", (iter == results.begin()) ? "" : ",");
+		fprintf(stdout, "      \"name\": \"%s\",\n", iter->m_name.c_str());
+		fprintf(stdout, "      \"iterations\": %llu,\n", iter->m_iterations);
+		fprintf(stdout, "      \"real_time\": %.3f,\n", iter->m_realNs / n);
+		fprintf(stdout, "      \"cpu_time\": %.3f,\n", iter->m_cpuNs / n);
+		if (iter->m_items && (iter->m_cpuNs > 0.0)) {
+			fprintf(stdout, "      \"items_per_second\": %.3f,\n",
+				(double)iter->m_items * n * 1e9 / iter->m_cpuNs);
+		}
+		fprintf(stdout, "      \"time_unit\": \"ns\"\n");
+		fprintf(stdout, "    }");
+	}
+
+	fprintf(stdout, "\n  ]\n}\n");
+}
+
+/*
+ * Recognized options:
+ *   --filter=<regex>     Only run benchmarks whose name matches
+ *   --min-time=<secs>    Minimum measured time per benchmark (default 0.5)
+ *   --format=console|json
+ */
+int BenchmarkRegistry::RunAll(int argc, char **argv)
+{
+	std::string filter;
+	double minTime = BenchmarkDefaultMinTime;
+	bool json = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--filter=", 9) == 0) {
+			filter = argv[i] + 9;
+		} else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+			minTime = strtod(argv[i] + 11, NULL);
+		} else if (strcmp(argv[i], "--format=json") == 0) {
+			json = true;
+		} else if (strcmp(argv[i], "--format=console") == 0) {
+			json = false;
+		} else {
+			fprintf(stderr, "Usage: %s [--filter=<regex>] "
+				"[--min-time=<seconds>] [--format=console|json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	boost::regex expr;
+	try {
+		expr.assign(filter.empty() ? std::string(".") : filter);
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Invalid filter \"%s\": %s\n", filter.c_str(),
+			except.what());
+		return 1;
+	}
+
+	std::vector<Result> results;
+	for (std::vector<Entry>::const_iterator iter = m_entries.begin();
+		iter != m_entries.end(); ++iter) {
+		if (!boost::regex_search(iter->m_name, expr)) {
+			continue;
+		}
+
+		results.push_back(Run(*iter, minTime));
+	}
+
+	if (json) {
+		PrintJson(results);
+	} else {
+		PrintConsole(results);
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_BENCHMARKHARNESS_H__
+#define __ACTIVITYMANAGER_BENCHMARKHARNESS_H__
+
+#include <string>
+#include <vector>
+
+/*
+ * Minimal micro-benchmark harness modelled on Google Benchmark.  It is
+ * self-contained so that it can be built with the same C++03 toolchain as
+ * the daemon, and it emits the same JSON schema so the results can be fed
+ * to existing comparison tooling.
+ *
+ *   static void BM_Something(BenchmarkState& state) {
+ *       while (state.KeepRunning()) {
+ *           ...
+ *       }
+ *   }
+ *   BENCHMARK(BM_Something);
+ */
+
+class BenchmarkState {
+public:
+	BenchmarkState(unsigned long long maxIterations);
+
+	bool KeepRunning();
+
+	/* Exclude setup/teardown inside the loop from the measurement */
+	void PauseTiming();
+	void ResumeTiming();
+
+	/* Optional per-iteration item count, reported as items_per_second */
+	void SetItemsProcessed(unsigned long long items);
+
+	unsigned long long GetIterations() const;
+	unsigned long long GetItemsProcessed() const;
+	double GetRealNanoseconds() const;
+	double GetCpuNanoseconds() const;
+
+protected:
+	void Start();
+	void Stop();
+
+	unsigned long long	m_iterations;
+	unsigned long long	m_maxIterations;
+	unsigned long long	m_itemsProcessed;
+
+	bool	m_started;
+	bool	m_running;
+
+	double	m_realStart;
+	double	m_cpuStart;
+	double	m_realElapsed;
+	double	m_cpuElapsed;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+class BenchmarkRegistry {
+public:
+	static BenchmarkRegistry& GetInstance();
+
+	int Register(const char *name, BenchmarkFunction function);
+
+	int RunAll(int argc, char **argv);
+
+protected:
+	struct Entry {
+		std::string			m_name;
+		BenchmarkFunction	m_function;
+	};
+
+	struct Result {
+		std::string			m_name;
+		unsigned long long	m_iterations;
+		unsigned long long	m_items;
+		double				m_realNs;
+		double				m_cpuNs;
+	};
+
+	Result Run(const Entry& entry, double minTime) const;
+
+	void PrintConsole(const std::vector<Result>& results) const;
+	void PrintJson(const std::vector<Result>& results) const;
+
+	std::vector<Entry>	m_entries;
+};
+
+#define BENCHMARK_CONCAT2(a, b)	a##b
+#define BENCHMARK_CONCAT(a, b)	BENCHMARK_CONCAT2(a, b)
+
+#define BENCHMARK(func) \
+	static int BENCHMARK_CONCAT(s_benchmark_, __LINE__) = \
+		BenchmarkRegistry::GetInstance().Register(#func, func)
+
+/* Prevent the optimizer from discarding a computed value */
+template<class T>
+inline void BenchmarkDoNotOptimize(const T& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif /* __ACTIVITYMANAGER_BENCHMARKHARNESS_H__ */
@@ -0,0 +1,495 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "BenchmarkHarness.h"
+
+#include "Activity.h"
+#include "ActivityJson.h"
+#include "ActivityManager.h"
+#include "ContainerManager.h"
+#include "DefaultRequirementManager.h"
+#include "IntervalSchedule.h"
+#include "LunaBusProxy.h"
+#include "MojoJsonConverter.h"
+#include "MojoTriggerManager.h"
+#include "MojoWhereMatcher.h"
+#include "PowerManager.h"
+#include "RequirementManager.h"
+#include "ResourceContainer.h"
+#include "ResourceManager.h"
+#include "Schedule.h"
+#include "Scheduler.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+/*
+ * Scheduler with no timer source, so queue maintenance can be measured
+ * without a main loop or powerd.
+ */
+class BenchScheduler : public Scheduler
+{
+public:
+	virtual void Enable() {}
+
+	void ForceTimeChanged() { TimeChanged(); }
+
+protected:
+	virtual void UpdateTimeout(time_t nextWakeup, time_t curTime) {}
+	virtual void CancelTimeout() {}
+};
+
+/*
+ * The same object graph ServiceApp builds for the simulator target, minus
+ * anything that needs a live bus.
+ */
+class BenchEnvironment
+{
+public:
+	static BenchEnvironment& GetInstance()
+	{
+		static BenchEnvironment s_environment;
+		return s_environment;
+	}
+
+	boost::shared_ptr<MasterResourceManager>	m_resourceManager;
+	boost::shared_ptr<ActivityManager>			m_am;
+	boost::shared_ptr<MasterRequirementManager>	m_requirementManager;
+	boost::shared_ptr<BenchScheduler>			m_scheduler;
+	boost::shared_ptr<PowerManager>				m_powerManager;
+	boost::shared_ptr<MojoTriggerManager>		m_triggerManager;
+	boost::shared_ptr<MojoJsonConverter>		m_json;
+
+private:
+	BenchEnvironment()
+	{
+		m_resourceManager = boost::make_shared<MasterResourceManager>();
+		m_am = boost::make_shared<ActivityManager>(m_resourceManager);
+
+		m_requirementManager = boost::make_shared<MasterRequirementManager>();
+		m_requirementManager->AddManager(
+			boost::make_shared<DefaultRequirementManager>());
+
+		m_scheduler = boost::make_shared<BenchScheduler>();
+
+		m_powerManager = boost::make_shared<NoopPowerManager>();
+		m_requirementManager->AddManager(m_powerManager);
+
+		m_triggerManager = boost::make_shared<MojoTriggerManager>(
+			(MojService *)NULL);
+		m_json = boost::make_shared<MojoJsonConverter>((MojService *)NULL,
+			m_am, m_scheduler, m_triggerManager, m_requirementManager,
+			m_powerManager);
+	}
+};
+
+static MojObject BenchParseJson(const char *json)
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(json);
+	if (err) {
+		throw std::runtime_error(std::string("Unable to parse: ") + json);
+	}
+
+	return obj;
+}
+
+static const char *BenchActivitySpec =
+	"{\"name\":\"bench\",\"description\":\"Benchmark Activity\","
+	"\"type\":{\"background\":true,\"power\":true,\"powerDebounce\":true},"
+	"\"schedule\":{\"interval\":\"1h\",\"start\":\"2030-01-01 00:00:00\"},"
+	"\"requirements\":{\"never\":true},"
+	"\"callback\":{\"method\":\"palm://com.palm.benchmark/run\","
+		"\"params\":{\"account\":\"0123456789\"}},"
+	"\"metadata\":{\"source\":\"bench\",\"count\":42}}";
+
+static void BM_WhereMatcherMatch(BenchmarkState& state)
+{
+	MojObject where = BenchParseJson(
+		"{\"and\":["
+			"{\"prop\":\"status\",\"op\":\"=\",\"val\":\"connected\"},"
+			"{\"or\":["
+				"{\"prop\":[\"wifi\",\"state\"],\"op\":\"=\",\"val\":\"connected\"},"
+				"{\"prop\":[\"wan\",\"state\"],\"op\":\"=\",\"val\":\"connected\"}"
+			"]},"
+			"{\"prop\":\"level\",\"op\":\">=\",\"val\":20}"
+		"]}");
+	MojObject response = BenchParseJson(
+		"{\"status\":\"connected\",\"level\":57,"
+		"\"wifi\":{\"state\":\"disconnected\"},"
+		"\"wan\":{\"state\":\"connected\",\"network\":\"umts\"}}");
+
+	MojoNewWhereMatcher matcher(where);
+
+	while (state.KeepRunning()) {
+		bool matched = matcher.Match(response);
+		BenchmarkDoNotOptimize(matched);
+	}
+}
+BENCHMARK(BM_WhereMatcherMatch);
+
+/* Keep a realistic number of future-dated items queued while measuring */
+static const unsigned BenchQueueDepth = 1000;
+
+static void BenchFillScheduler(
+	std::vector<boost::shared_ptr<Schedule> >& schedules)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+	time_t base = time(NULL) + Schedule::DAY_ONE;
+
+	for (unsigned i = 0; i < BenchQueueDepth; i++) {
+		boost::shared_ptr<Activity> act = env.m_am->GetNewActivity();
+		boost::shared_ptr<Schedule> schedule = boost::make_shared<Schedule>(
+			env.m_scheduler, act, base + (time_t)((i * 7919) % 86400));
+		schedules.push_back(schedule);
+		env.m_scheduler->AddItem(schedule);
+	}
+}
+
+static void BenchDrainScheduler(
+	std::vector<boost::shared_ptr<Schedule> >& schedules)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	for (std::vector<boost::shared_ptr<Schedule> >::iterator iter =
+		schedules.begin(); iter != schedules.end(); ++iter) {
+		env.m_scheduler->RemoveItem(*iter);
+	}
+
+	schedules.clear();
+}
+
+static void BM_SchedulerAddRemoveItem(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	std::vector<boost::shared_ptr<Schedule> > schedules;
+	BenchFillScheduler(schedules);
+
+	boost::shared_ptr<Activity> act = env.m_am->GetNewActivity();
+	boost::shared_ptr<Schedule> schedule = boost::make_shared<Schedule>(
+		env.m_scheduler, act, time(NULL) + Schedule::DAY_ONE + 43200);
+
+	while (state.KeepRunning()) {
+		env.m_scheduler->AddItem(schedule);
+		env.m_scheduler->RemoveItem(schedule);
+	}
+
+	BenchDrainScheduler(schedules);
+}
+BENCHMARK(BM_SchedulerAddRemoveItem);
+
+static void BM_SchedulerTimeChanged(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	std::vector<boost::shared_ptr<Schedule> > schedules;
+	BenchFillScheduler(schedules);
+
+	while (state.KeepRunning()) {
+		env.m_scheduler->ForceTimeChanged();
+	}
+
+	state.SetItemsProcessed(BenchQueueDepth);
+
+	BenchDrainScheduler(schedules);
+}
+BENCHMARK(BM_SchedulerTimeChanged);
+
+static void BM_ActivityManagerRegister(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+	BusId creator("com.palm.benchmark", BusService);
+
+	boost::shared_ptr<Activity> act = env.m_am->GetNewActivity();
+	act->SetName("bench.register");
+	act->SetCreator(creator);
+
+	while (state.KeepRunning()) {
+		env.m_am->RegisterActivityId(act);
+		env.m_am->RegisterActivityName(act);
+		env.m_am->UnregisterActivityName(act);
+		env.m_am->ReleaseActivity(act);
+	}
+}
+BENCHMARK(BM_ActivityManagerRegister);
+
+/* Populate a name table of realistic size for the lookup benchmarks */
+static void BenchPopulateActivities(
+	std::vector<boost::shared_ptr<Activity> >& activities, const BusId& creator)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	for (unsigned i = 0; i < BenchQueueDepth; i++) {
+		boost::shared_ptr<Activity> act = env.m_am->GetNewActivity();
+		act->SetName("bench.lookup." + boost::lexical_cast<std::string>(i));
+		act->SetCreator(creator);
+		env.m_am->RegisterActivityId(act);
+		env.m_am->RegisterActivityName(act);
+		activities.push_back(act);
+	}
+}
+
+static void BenchReleaseActivities(
+	std::vector<boost::shared_ptr<Activity> >& activities)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	for (std::vector<boost::shared_ptr<Activity> >::iterator iter =
+		activities.begin(); iter != activities.end(); ++iter) {
+		env.m_am->UnregisterActivityName(*iter);
+		env.m_am->ReleaseActivity(*iter);
+	}
+
+	activities.clear();
+}
+
+static void BM_ActivityManagerLookupByName(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+	BusId creator("com.palm.benchmark", BusService);
+
+	std::vector<boost::shared_ptr<Activity> > activities;
+	BenchPopulateActivities(activities, creator);
+
+	std::string name("bench.lookup." +
+		boost::lexical_cast<std::string>(BenchQueueDepth / 2));
+
+	while (state.KeepRunning()) {
+		boost::shared_ptr<Activity> act = env.m_am->GetActivity(name, creator);
+		BenchmarkDoNotOptimize(act);
+	}
+
+	BenchReleaseActivities(activities);
+}
+BENCHMARK(BM_ActivityManagerLookupByName);
+
+static void BM_ActivityManagerLookupById(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+	BusId creator("com.palm.benchmark", BusService);
+
+	std::vector<boost::shared_ptr<Activity> > activities;
+	BenchPopulateActivities(activities, creator);
+
+	activityId_t id = activities[BenchQueueDepth / 2]->GetId();
+
+	while (state.KeepRunning()) {
+		boost::shared_ptr<Activity> act = env.m_am->GetActivity(id);
+		BenchmarkDoNotOptimize(act);
+	}
+
+	BenchReleaseActivities(activities);
+}
+BENCHMARK(BM_ActivityManagerLookupById);
+
+static void BM_ActivityToJson(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+
+	boost::shared_ptr<Activity> act = env.m_json->CreateActivity(
+		BenchParseJson(BenchActivitySpec), Activity::PublicBus);
+	env.m_am->RegisterActivityId(act);
+
+	while (state.KeepRunning()) {
+		MojObject rep;
+		MojErr err = act->ToJson(rep, ACTIVITY_JSON_DETAIL |
+			ACTIVITY_JSON_CURRENT);
+		BenchmarkDoNotOptimize(err);
+	}
+
+	env.m_am->ReleaseActivity(act);
+}
+BENCHMARK(BM_ActivityToJson);
+
+static void BM_JsonConverterCreateActivity(BenchmarkState& state)
+{
+	BenchEnvironment& env = BenchEnvironment::GetInstance();
+	MojObject spec = BenchParseJson(BenchActivitySpec);
+
+	while (state.KeepRunning()) {
+		boost::shared_ptr<Activity> act = env.m_json->CreateActivity(spec,
+			Activity::PublicBus);
+
+		state.PauseTiming();
+		env.m_am->RegisterActivityId(act);
+		env.m_am->ReleaseActivity(act);
+		act.reset();
+		state.ResumeTiming();
+	}
+}
+BENCHMARK(BM_JsonConverterCreateActivity);
+
+/*
+ * Container with no backing resource.  UpdatePriority() reads the
+ * aggregate priority, as the real containers do before deciding whether
+ * anything needs writing.
+ */
+class BenchContainer : public ResourceContainer
+{
+public:
+	BenchContainer(const std::string& name,
+		boost::shared_ptr<ContainerManager> manager)
+		: ResourceContainer(name, manager) {}
+
+	virtual void UpdatePriority()
+	{
+		ActivityPriority_t priority = GetPriority();
+		bool focused = IsFocused();
+		BenchmarkDoNotOptimize(priority);
+		BenchmarkDoNotOptimize(focused);
+	}
+
+	virtual void MapProcess(pid_t pid) {}
+	virtual void Enable() {}
+	virtual void Disable() {}
+};
+
+class BenchContainerManager : public ContainerManager
+{
+public:
+	BenchContainerManager(boost::shared_ptr<MasterResourceManager> master)
+		: ContainerManager(master) {}
+
+	virtual boost::shared_ptr<ResourceContainer> CreateContainer(
+		const std::string& name)
+	{
+		return boost::make_shared<BenchContainer>(name,
+			boost::dynamic_pointer_cast<ContainerManager, ResourceManager>(
+				shared_from_this()));
+	}
+
+	virtual ActivityPriority_t GetDefaultPriority() const
+	{
+		return ActivityPriorityLow;
+	}
+
+	virtual ActivityPriority_t GetDisabledPriority() const
+	{
+		return ActivityPriorityHigh;
+	}
+};
+
+class BenchBusProxy : public LunaBusProxy
+{
+public:
+	BenchBusProxy(boost::shared_ptr<ContainerManager> containerManager)
+		: LunaBusProxy(containerManager, NULL) {}
+
+	void Deliver(const MojObject& response)
+	{
+		ProcessBusUpdate(NULL, response, MojErrNone);
+	}
+};
+
+/* Number of services in the hub's status batch at boot */
+static const unsigned BenchBootServices = 300;
+
+/*
+ * Status batch shaped like the one the hub sends when the subscription to
+ * _private_service_status is first made: every service with all its names
+ * and pid.  As on a device, most services have an old and a new name and
+ * an anonymous one, some names are shared between services (which are
+ * then mapped to the last one), and a few services are restricted.
+ */
+static MojObject BenchHubStatusBatch(unsigned count)
+{
+	std::string json = "{\"returnValue\":true,\"services\":[";
+
+	for (unsigned i = 0; i < count; i++) {
+		std::string n = boost::lexical_cast<std::string>(i);
+
+		if (i) {
+			json += ",";
+		}
+
+		json += "{\"serviceName\":\"com.palm.service" + n + "\","
+			"\"pid\":" + boost::lexical_cast<std::string>(1000 + i) + ","
+			"\"allNames\":[\"com.palm.service" + n + "\","
+			"\"com.webos.service" + n + "\",\"/var/run/ls2/anon" + n + "\"";
+
+		if ((i % 10) == 0) {
+			json += ",\"com.palm.shared" +
+				boost::lexical_cast<std::string>(i / 30) + "\"";
+		}
+
+		if ((i % 50) == 0) {
+			json += ",\"com.palm.mediad.plugin" + n + "\"";
+		}
+
+		json += "]}";
+	}
+
+	json += "]}";
+
+	return BenchParseJson(json.c_str());
+}
+
+static void BM_LunaBusProxyBootBatch(BenchmarkState& state)
+{
+	MojObject batch = BenchHubStatusBatch(BenchBootServices);
+
+	boost::shared_ptr<MasterResourceManager> master;
+	boost::shared_ptr<BenchContainerManager> containers;
+	boost::shared_ptr<BenchBusProxy> proxy;
+
+	while (state.KeepRunning()) {
+		/* Every iteration is a fresh boot */
+		state.PauseTiming();
+		proxy.reset();
+		containers.reset();
+		master = boost::make_shared<MasterResourceManager>();
+		containers = boost::make_shared<BenchContainerManager>(master);
+		master->SetManager("cpu", containers);
+		proxy = boost::make_shared<BenchBusProxy>(containers);
+		state.ResumeTiming();
+
+		proxy->Deliver(batch);
+	}
+
+	state.SetItemsProcessed(BenchBootServices);
+}
+BENCHMARK(BM_LunaBusProxyBootBatch);
+
+static void BM_StringToInterval(BenchmarkState& state)
+{
+	static const char *intervals[] = { "5m", "1h", "12h", "3d", "1d12h" };
+	static const unsigned count = sizeof(intervals) / sizeof(intervals[0]);
+
+	unsigned i = 0;
+	while (state.KeepRunning()) {
+		unsigned interval = IntervalSchedule::StringToInterval(
+			intervals[i % count]);
+		BenchmarkDoNotOptimize(interval);
+		i++;
+	}
+}
+BENCHMARK(BM_StringToInterval);
+
+int main(int argc, char **argv)
+{
+	try {
+		return BenchmarkRegistry::GetInstance().RunAll(argc, argv);
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Benchmark failed: %s\n", except.what());
+		return 1;
+	}
+}
@@ -25,6 +25,7 @@
 #include <string>
 #include <vector>
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
 
@@ -36,6 +37,7 @@
 #include "PersistCommand.h"
 #include "Requirement.h"
 #include "Callback.h"
+#include "FlightRecorder.h"
 
 #include <core/MojServiceMessage.h>
 
@@ -206,9 +208,25 @@ public:
 	bool IsRunning() const;
 	bool IsYielding() const;
 
+	/* Approximate heap and object footprint, broken down by component.
+	 * Used to track the per-Activity cost on devices with many Activities. */
+	struct MemoryUsage {
+		MemoryUsage();
+
+		size_t	m_object;
+		size_t	m_strings;
+		size_t	m_requirements;
+		size_t	m_persistCommands;
+		size_t	m_coldState;
+		size_t	m_coldStateCount;
+	};
+
+	void AccumulateMemoryUsage(MemoryUsage& usage) const;
+
 private:
 	/* Activity Manager may access "private" control interfaces. */
 	friend class ActivityManager;
+	friend class RequirementManager;
 
 	ActivityCommand_t ComputeNextExternalCommand() const;
 	void BroadcastCommand(ActivityCommand_t command);
@@ -223,7 +241,21 @@ private:
 	void YieldActivity();
 	void EndActivity();
 
+	/* Runnable is kept incrementally: the readiness bits below, plus the
+	 * count of unmet Requirements.  ComputeRunnable() is the full
+	 * evaluation, which debug builds cross-check it against. */
 	bool IsRunnable() const;
+	bool ComputeRunnable() const;
+	void SetReadiness(unsigned bit, bool ready);
+	void UpdateTriggerReadiness();
+	void UpdateScheduleReadiness();
+	void LinkRequirement(Requirement& requirement);
+	void UnlinkRequirement(Requirement& requirement);
+
+	/* Requirement transitions inside a RequirementManager batch */
+	void DeferToBatch();
+	void RequirementsSettled();
+
 	bool ShouldRestart() const;
 	bool ShouldRequeue() const;
 
@@ -237,6 +269,9 @@ private:
 	/* State is a computed property based on internal state */
 	ActivityState_t GetState(void) const;
 
+	/* Record a state change, if there was one, in the flight recorder */
+	void NoteState(FlightReason reason, MojUInt32 arg = 0);
+
 	/* DISALLOW */
 	Activity();
 	Activity(const Activity& copy);
@@ -272,12 +307,41 @@ private:
 
 	typedef std::list<boost::weak_ptr<Subscription> > AdopterQueue;
 
-	typedef std::map<std::string, boost::shared_ptr<Requirement> >
-		RequirementMap;
+	/* Most Activities have zero to three Requirements, so a flat vector
+	 * searched linearly is both smaller and faster than a map. */
+	typedef std::vector<boost::shared_ptr<Requirement> > RequirementVec;
 
 	typedef std::set<boost::shared_ptr<ActivitySetAutoAssociation> >
 		EntityAssociationSet;
 
+	/* State that only a small fraction of Activities ever use.  It is
+	 * allocated the first time it is written, so the typical idle,
+	 * scheduled Activity doesn't pay for it. */
+	struct ColdState {
+		/* Subscriptions waiting to adopt the Activity */
+		AdopterQueue		m_adopters;
+
+		/* Parent that released the Activity, waiting to hear it was
+		 * adopted */
+		boost::weak_ptr<Subscription>	m_releasedParent;
+
+		/* Activity Manager should arbitrate with Power Management to keep
+		 * device awake while Activity is running. */
+		boost::shared_ptr<PowerActivity>	m_powerActivity;
+
+		/* Associations other objects have to this Activity (that will
+		 * auto-unlink when the association objects are deallocated when the
+		 * Activity dies */
+		EntityAssociationSet	m_associations;
+	};
+
+	ColdState& GetColdState();
+	const ColdState& PeekColdState() const;
+
+	RequirementVec::iterator FindRequirement(const std::string& name);
+	RequirementVec::const_iterator FindRequirement(
+		const std::string& name) const;
+
 	/* External properties */
 	std::string		m_name;
 	std::string		m_description;
@@ -289,100 +353,121 @@ private:
 	 * and decoration of the Activity. */
 	std::string		m_metadata;
 
+	/* Priority of Activity: "highest", "high", "normal", "low", "lowest".
+	 * Generally not directly set - just "background" ("low"), or
+	 * "foreground" ("immediate", "normal"). */
+	ActivityPriority_t	m_priority;
+
+	/* Whether the request to create the Activity was received on the public
+	 * or private bus.  Outbound trigger calls will be made on the same
+	 * bus, to prevent privilege escalation. */
+	BusType			m_bus;
+
+	/* Flags are packed into single bits; there can be tens of thousands of
+	 * Activities and most of them are idle. */
+
 	/* The Activity will be stored in the Open webOS database.  Any command
 	 * that causes an update to the Activity's persisted state will wait until
 	 * that update has been acknowledged by MojoDB before returning to the
 	 * caller (or otherwise generating externally visible events). */
-	bool			m_persistent;
+	bool			m_persistent : 1;
 
 	/* The Activity must be explicitly terminated by command, rather than
 	 * implicitly cancelled if its parent unsubscribes.  If the parent of
 	 * an explicit Activity unsubscribes, cancel events are generated to the
 	 * remaining subscribers.  After all subscribers unsubscribe, the Activity
 	 * will be automatically rescheduled to run again. */
-	bool			m_explicit;
+	bool			m_explicit : 1;
 
 	/* Activity should begin running (callback called, 'start' event generated)
 	 * as soon as its prerequisites are met, without delay.  Otherwise, the
 	 * Activity Manager may delay the Activity while other Activities run,
 	 * and may change the order that those Activities are executed in. */
-	bool			m_immediate;
-
-	/* Priority of Activity: "highest", "high", "normal", "low", "lowest".
-	 * Generally not directly set - just "background" ("low"), or
-	 * "foreground" ("immediate", "normal"). */
-	ActivityPriority_t	m_priority;
+	bool			m_immediate : 1;
 
 	/* If 'immediate' and 'priority' were assigned jointly as 'foreground'
 	 * or 'background'. */
-	bool			m_useSimpleType;
+	bool			m_useSimpleType : 1;
 
 	/* Activity is currently focused.  This value isn't persisted, and should
 	 * be kept updated by the rest of the system */
-	bool			m_focused;
+	bool			m_focused : 1;
 
 	/* Activity is expected to run for a potentially indefinite anount of time.
 	 * Do not defer scheduling other things.  Activity should be set for
 	 * immediate scheduling, otherwise, it's a bug. */
-	bool			m_continuous;
+	bool			m_continuous : 1;
 
 	/* Activity was directly user-initiated. */
-	bool			m_userInitiated;
+	bool			m_userInitiated : 1;
 
 	/* Activity should support power debouncing */
-	bool			m_powerDebounce;
-
-	/* Whether the request to create the Activity was received on the public
-	 * or private bus.  Outbound trigger calls will be made on the same
-	 * bus, to prevent privilege escalation. */
-	BusType			m_bus;
+	bool			m_powerDebounce : 1;
 
 	/* Activity has been commanded to start, and requested permission to 
 	 * schedule */	
-	bool			m_initialized;
+	bool			m_initialized : 1;
 
 	/* Activity has been told to schedule itself by the Activity Manager */
-	bool			m_scheduled;
+	bool			m_scheduled : 1;
 
 	/* Activity has requested permission to run */
-	bool			m_ready;
+	bool			m_ready : 1;
 
 	/* Activity has started (prereqs met, dequeued if subject to queuing) */
-	bool			m_running;
+	bool			m_running : 1;
 
 	/* Activity is ending (by command or abandonment) */
-	bool			m_ending;
+	bool			m_ending : 1;
 
 	/* Activity is ending due to explicit command */
-	bool			m_terminate;
+	bool			m_terminate : 1;
 
 	/* Activity has been requested to restart (via Complete) */
-	bool			m_restart;
+	bool			m_restart : 1;
 
 	/* Activity had an issue while attempting to start, and should return to
 	 * the queue.  (Don't advance the Schedule, and don't lose the Trigger
 	 * information) */
-	bool			m_requeue;
+	bool			m_requeue : 1;
 
 	/* Activity has been told to yield. */
-	bool			m_yielding;
+	bool			m_yielding : 1;
+
+	bool			m_released : 1;
+
+	/* State as last written to the flight recorder */
+	unsigned		m_flightState : 4;
 
-	bool			m_released;
+	/* Readiness bits: the next external command is start, the Trigger (if
+	 * any) has fired, and the Schedule (if any) is due */
+	enum {
+		ReadyCommand = 1,
+		ReadyTriggered = 2,
+		ReadyScheduleDue = 4,
+		ReadyAll = 7
+	};
+
+	unsigned		m_readiness : 3;
+
+	/* Waiting on the open requirement batch to commit */
+	bool			m_batched : 1;
+
+	/* Number of Requirements on m_unmetRequirements */
+	unsigned		m_unmetCount;
 
 	ActivityCommand_t	m_intCommand;
 	ActivityCommand_t	m_extCommand;
 	ActivityCommand_t	m_sentCommand;
 
-	AdopterQueue		m_adopters;
 	SubscriptionSet		m_subscriptions;
 	SubscriberSet		m_subscribers;
 
-	RequirementMap		m_requirements;
+	RequirementVec		m_requirements;
 	RequirementList		m_metRequirements;
 	RequirementList		m_unmetRequirements;
 
 	boost::weak_ptr<Subscription>	m_parent;
-	boost::weak_ptr<Subscription>	m_releasedParent;
 
 	boost::shared_ptr<Trigger>		m_trigger;
 	boost::shared_ptr<Callback>		m_callback;
@@ -390,13 +475,8 @@ private:
 
 	boost::shared_ptr<PersistToken>	m_persistToken;
 
-	/* Activity Manager should arbitrate with Power Management to keep device
-	 * awake while Activity is running. */
-	boost::shared_ptr<PowerActivity>	m_powerActivity;
-
-	/* Associations other objects have to this Activity (that will auto-unlink
-	 * when the association objects are deallocated when the Activity dies */
-	EntityAssociationSet	m_associations;
+	/* Adopters, released parent, power activity and associations */
+	boost::scoped_ptr<ColdState>	m_coldState;
 
 	/* Index this in table of Activity names (and auto-unlink) */
 	ActivityTableItem	m_nameTableItem;
@@ -33,6 +33,7 @@ class MojoTriggerManager;
 class MojoJsonConverter;
 class MasterResourceManager;
 class ContainerManager;
+class MasterRequirementManager;
 class MojoSubscription;
 
 class ActivityCategoryHandler : public MojService::CategoryHandler
@@ -44,7 +45,8 @@ public:
 		boost::shared_ptr<MojoTriggerManager> triggerManager,
 		boost::shared_ptr<PowerManager> powerManager,
 		boost::shared_ptr<MasterResourceManager> resourceManager,
-		boost::shared_ptr<ContainerManager> containerManager);
+		boost::shared_ptr<ContainerManager> containerManager,
+		boost::shared_ptr<MasterRequirementManager> requirementManager);
 
     virtual ~ActivityCategoryHandler();
 
@@ -150,6 +152,7 @@ protected:
 	boost::shared_ptr<PowerManager>			m_powerManager;
 	boost::shared_ptr<MasterResourceManager>	m_resourceManager;
 	boost::shared_ptr<ContainerManager>		m_containerManager;
+	boost::shared_ptr<MasterRequirementManager>	m_requirementManager;
 };
 
 #endif /* __ACTIVITYMANAGER_ACTIVITYCATEGORY_H__ */
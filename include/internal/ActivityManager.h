@@ -26,6 +26,7 @@
 #include "Activity.h"
 #include "Subscriber.h"
 #include "Timeout.h"
+#include "FlightRecorder.h"
 
 /*
  * Central Activity registry and control object.
@@ -88,6 +89,9 @@ public:
 	void EvictAllBackgroundActivities();
 	void RunReadyBackgroundActivity(boost::shared_ptr<Activity> act);
 	void RunAllReadyActivities();
+
+	/* Approximate memory used by all instantiated Activities */
+	MojErr MemoryUsageToJson(MojObject& rep) const;
 #endif
 
 	/* INTERFACE:  ACTIVITY ----> ACTIVITY MANAGER */
@@ -121,6 +125,12 @@ public:
 	void InformActivityLostSubscriberId(boost::shared_ptr<Activity> act,
 		const BusId& id);
 
+	/* While held, checks of the ready queue are deferred, and one is made
+	 * when the last hold is released.  Lets a batch of Activities become
+	 * ready without each of them running the queue. */
+	void HoldReadyQueue();
+	void ReleaseReadyQueue();
+
 	/* END INTERFACE  */
 
 	static const unsigned DefaultBackgroundConcurrencyLevel = 1;
@@ -131,6 +141,27 @@ public:
 	/* Activity Manager info state gatherer */
 	MojErr InfoToJson(MojObject& rep) const;
 
+	/* Number of Activities on each run queue, by queue name */
+	MojErr QueueDepthsToJson(MojObject& rep) const;
+
+	/* Run queues, by index into m_runQueue.  Also label the queue moves in
+	 * the flight recorder. */
+	typedef enum {
+		RunQueueNone = -1,
+		RunQueueInitialized = 0,
+		RunQueueScheduled,
+		RunQueueReady,
+		RunQueueReadyInteractive,
+		RunQueueBackground,
+		RunQueueBackgroundInteractive,
+		RunQueueLongBackground,
+		RunQueueImmediate,
+		RunQueueEnded,
+		RunQueueMax
+	} RunQueueId;
+
+	static const char *RunQueueNames[];
+
 private:
 	/* DISALLOW */
 	ActivityManager(const ActivityManager& copy);
@@ -145,25 +176,18 @@ protected:
 	unsigned GetRunningBackgroundActivitiesCount() const;
 	void CheckReadyQueue();
 
+	/* Append to a run queue (the Activity must not be on one) */
+	void QueueActivity(Activity& act, RunQueueId queue, FlightReason reason);
+
 	void UpdateYieldTimeout();
 	void CancelYieldTimeout();
 	void InteractiveYieldTimeout();
 
-protected:
-	typedef enum {
-		RunQueueNone = -1,
-		RunQueueInitialized = 0,
-		RunQueueScheduled,
-		RunQueueReady,
-		RunQueueReadyInteractive,
-		RunQueueBackground,
-		RunQueueBackgroundInteractive,
-		RunQueueLongBackground,
-		RunQueueImmediate,
-		RunQueueEnded,
-		RunQueueMax
-	} RunQueueId;
+	/* Tell the Resource Manager when the first focused or immediate
+	 * Activity starts, or the last one stops */
+	void UpdateForeground();
 
+protected:
 	/* Lightweight comparator object to search the Activity Name Table for
 	 * a particular name */
 	typedef std::pair<std::string, BusId>	ActivityKey;
@@ -207,8 +231,6 @@ protected:
 	typedef boost::intrusive::list<Activity, ActivityFocusedListOption,
 		boost::intrusive::constant_time_size<false> > ActivityFocusedList;
 
-	static const char *RunQueueNames[];
-
 	/* Activity Name Table
 	 * The most recent Activity to attempt to claim a name will be listed
 	 * in the Table, and all Activties in the table are currently live and
@@ -253,6 +275,11 @@ protected:
 
 	unsigned		m_yieldTimeoutSeconds;
 
+	unsigned		m_readyQueueHolds;
+	bool			m_readyQueueCheckPending;
+
+	bool			m_foreground;
+
 #ifndef ACTIVITYMANAGER_RANDOM_IDS
 	activityId_t	m_nextActivityId;
 #endif
@@ -23,6 +23,7 @@
 #include "BusId.h"
 #include "ActivityTypes.h"
 #include "ActivityAutoAssociation.h"
+#include "PriorityCounts.h"
 
 #include <set>
 
@@ -30,7 +31,9 @@ class Activity;
 
 /* Represents an App or Service on the Bus that has running Activities
  * associated with it.  Tracks all of its running Activities, sorted
- * by priority, and its current priority.
+ * by priority, and its current priority.  The priority is kept as counts
+ * per level, updated as Activities are associated, dissociated or change
+ * focus, so reading it does not look at the Activities.
  *
  * A single BusEntity may ultimate be mapped into multiple Resource
  * Containers of various different types (mem, cpu, io).  The Container
@@ -51,6 +54,9 @@ public:
 	ActivityPriority_t GetPriority() const;
 	bool IsFocused() const;
 
+	/* True if the priority or focus has changed since the last call */
+	bool ConsumeChange();
+
 	MojErr ToJson(MojObject& rep, bool includeActivities) const;
 	void PushJson(MojObject& array, bool includeActivities) const;
 
@@ -84,14 +90,30 @@ protected:
 
 		virtual std::string GetTargetName() const;
 
+		/* What the Activity is currently counted as in the Entity's
+		 * PriorityCounts, so the right level can be decremented after the
+		 * Activity has changed. */
+		ActivityPriority_t	m_countedPriority;
+		bool				m_countedFocused;
+		bool				m_counted;
+
 	protected:
 		boost::weak_ptr<BusEntity>	m_entity;
 	};
 
+	void CountActivity(BusEntityAssociation& association);
+	void UncountActivity(BusEntityAssociation& association);
+
 	/* Track all Activities whos priority should effect the priority of
 	 * this entity's (App or Service) container. */
 	ActivityAssociations	m_associations;
 
+	PriorityCounts		m_counts;
+
+	/* Last values ConsumeChange() reported against */
+	ActivityPriority_t	m_reportedPriority;
+	bool				m_reportedFocused;
+
 	BusId	m_id;
 
 	static MojLogger	s_log;
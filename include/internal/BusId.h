@@ -31,24 +31,47 @@ enum BusIdType {
 
 class Subscriber;
 
+/*
+ * A BusId names an app, service, or anonymous client on the bus.  The
+ * (id, type) pairs are interned in a global symbol table, so each BusId
+ * is just a reference to a shared symbol: copies don't allocate, and
+ * equality is a pointer comparison.  Symbols are reference counted and
+ * dropped from the table when the last BusId referring to them goes away.
+ *
+ * The table is never destroyed, so a BusId with static storage duration
+ * is safe to construct and destroy at any point of startup or exit.
+ */
 class BusId {
 public:
 	BusId();
+	BusId(const BusId& rhs);
 	BusId(const std::string& id, BusIdType type);
 	BusId(const char *id, BusIdType type);
+	BusId(const char *id, size_t length, BusIdType type);
 	BusId(const Subscriber& subscriber);
+	~BusId();
 
 	BusIdType GetType() const;
-	std::string GetId() const;
+	const std::string& GetId() const;
 
-	std::string GetString() const;
+	/* Small integer, unique among live BusIds, suitable for hashing */
+	unsigned GetHandle() const;
+
+	const std::string& GetString() const;
 	static std::string GetString(const std::string& id, BusIdType type);
 	static std::string GetString(const char *id, BusIdType type);
 
+	/* Bytes of the symbol's storage attributable to this reference: its
+	 * size split evenly between the BusIds sharing it */
+	size_t GetMemoryShare() const;
+
 	MojErr ToJson(MojObject& rep) const;
 
+	BusId& operator=(const BusId& rhs);
 	BusId& operator=(const Subscriber& rhs);
 
+	/* Orders by type, then by handle.  This is stable for the life of the
+	 * symbols involved, but is not alphabetical. */
 	bool operator<(const BusId& rhs) const;
 	bool operator!=(const BusId& rhs) const;
 	bool operator==(const BusId& rhs) const;
@@ -59,9 +82,22 @@ public:
 	bool operator!=(const std::string& rhs) const;
 	bool operator==(const std::string& rhs) const;
 
+	/* Number of distinct BusIds currently interned */
+	static size_t GetSymbolCount();
+
+	/* Interned (id, type) pair.  Opaque outside of BusId. */
+	struct Symbol;
+
 protected:
-	std::string	m_id;
-	BusIdType	m_type;
+	static Symbol *Intern(const char *id, size_t length, BusIdType type);
+	static Symbol *GetNullSymbol();
+
+	void Retain() const;
+	void Release() const;
+
+	Symbol	*m_symbol;
 };
 
+std::size_t hash_value(const BusId& id);
+
 #endif /* __ACTIVITYMANAGER_BUSID_H__ */
@@ -19,7 +19,20 @@
 #ifndef __ACTIVITYMANAGER_CATEGORY_H__
 #define __ACTIVITYMANAGER_CATEGORY_H__
 
-#define ACTIVITY_SERVICEMETHOD_BEGIN() try { do {} while (0) \
+#include "MethodLatency.h"
+#include "WorkloadRecorder.h"
+
+/* Each handler looks up its latency stats once, on its first request */
+#define ACTIVITY_SERVICEMETHOD_BEGIN(serviceMsg, servicePayload) try { \
+	static MethodLatency& s_methodLatency = MethodLatency::Get(serviceMsg); \
+	MethodTimer methodTimer(s_methodLatency, (serviceMsg), (servicePayload)); \
+	if (WorkloadRecorder::IsRecording()) \
+		WorkloadRecorder::RecordCall((serviceMsg), (servicePayload))
+
+/* Completion of a request that was already recorded on the way in, and
+ * whose reply was deferred until now */
+#define ACTIVITY_SERVICEMETHODFINISH_BEGIN(serviceMsg, servicePayload) try { \
+	MethodFinishTimer methodFinishTimer((serviceMsg).get(), (servicePayload))
 
 #define ACTIVITY_SERVICEMETHOD_END(serviceMsg) \
 } catch (const std::exception& except) { \
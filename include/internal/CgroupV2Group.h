@@ -0,0 +1,53 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_CGROUPV2GROUP_H__
+#define __ACTIVITYMANAGER_CGROUPV2GROUP_H__
+
+#include "ResourceContainer.h"
+
+#include <list>
+
+class CgroupV2Manager;
+
+class CgroupV2Group : public ResourceContainer
+{
+public:
+	CgroupV2Group(const std::string& name,
+		boost::shared_ptr<CgroupV2Manager> manager);
+	virtual ~CgroupV2Group();
+
+	virtual void UpdatePriority();
+	virtual void MapProcess(pid_t pid);
+	virtual void GetProcessIds(std::set<int>& pids) const;
+
+	virtual void Enable();
+	virtual void Disable();
+
+	virtual MojErr ToJson(MojObject& rep) const;
+
+protected:
+	boost::shared_ptr<CgroupV2Manager> GetCgroupManager() const;
+
+	/* Class the processes were last moved to, or NoClass */
+	unsigned		m_appliedClass;
+
+	std::list<int>	m_processIds;
+};
+
+#endif /* __ACTIVITYMANAGER_CGROUPV2GROUP_H__ */
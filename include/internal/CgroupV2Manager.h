@@ -0,0 +1,123 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_CGROUPV2MANAGER_H__
+#define __ACTIVITYMANAGER_CGROUPV2MANAGER_H__
+
+#include "ContainerManager.h"
+
+#include <list>
+
+/*
+ * Container Manager for the unified (v2) cgroup hierarchy.
+ *
+ * One cgroup is created per scheduling class under the root:
+ *
+ *   <root>/focused
+ *   <root>/unfocused/<priority>	(none, lowest, ... highest)
+ *
+ * Each class is given a cpu.weight, and the lowest classes a cpu.max
+ * quota, once at startup.  A Container's processes are moved by writing
+ * their pids to the cgroup.procs of its class, and only when the
+ * Container's effective (priority, focus) actually changes; a newly
+ * mapped process is written alone.  The class directories are opened
+ * once and kept open.
+ *
+ * The lowest class can be frozen through its cgroup.freeze (see
+ * ContainerManager::FreezePolicy).  Processes moved into it while it is
+ * frozen are frozen by the kernel as they arrive.  It is thawed when the
+ * classes are opened, in case an earlier instance exited while it was
+ * frozen.
+ *
+ * While a CpuPartition is set, each class's cpuset.cpus is written from
+ * it (focused like highest); changing the partition rewrites them in
+ * place, and the processes follow without being moved.
+ *
+ * The root's parent must delegate the cpu controller, and the cpuset
+ * controller for partitioning.  Without cpu, processes are still grouped
+ * but the weights have no effect; without cpuset, the partition cannot be
+ * set.
+ *
+ * Nothing here checks that the root is on a cgroup2 filesystem (see
+ * IsCgroupV2()), so a directory in which the control files already exist
+ * can stand in for one.
+ */
+class CgroupV2Manager : public ContainerManager
+{
+public:
+	CgroupV2Manager(const std::string& root,
+		boost::shared_ptr<MasterResourceManager> master);
+	virtual ~CgroupV2Manager();
+
+	/* True if "path" is on a cgroup2 filesystem */
+	static bool IsCgroupV2(const std::string& path);
+
+	virtual boost::shared_ptr<ResourceContainer> CreateContainer(
+		const std::string& name);
+
+	virtual ActivityPriority_t GetDefaultPriority() const;
+	virtual ActivityPriority_t GetDisabledPriority() const;
+
+	virtual MojErr InfoToJson(MojObject& rep) const;
+
+	virtual bool CanFreeze() const;
+
+	/* False if the classes could not be created */
+	bool IsSupported() const;
+
+	virtual const char *GetCpuPartitionMode() const;
+
+	const std::string& GetRoot() const;
+
+	/* Scheduling classes.  The unfocused classes are indexed by priority. */
+	static const unsigned FocusedClass = MaxActivityPriority;
+	static const unsigned ClassCount = MaxActivityPriority + 1;
+	static const unsigned NoClass = ClassCount;
+
+	static unsigned GetClass(ActivityPriority_t priority, bool focused);
+	std::string GetClassPath(unsigned cls) const;
+
+	/* Write each pid to the class's cgroup.procs.  Pids of processes that
+	 * no longer exist are removed from the list.  Returns false if the
+	 * class is unavailable or any other write failed. */
+	bool MoveProcesses(unsigned cls, std::list<int>& pids);
+
+	/* CPU time used by the class's processes, from usage_usec in its
+	 * cpu.stat */
+	bool ReadUsage(unsigned cls, MojUInt64& usec) const;
+
+protected:
+	virtual bool FreezeLowest(bool frozen);
+	virtual void ApplyCpuPartition();
+
+	bool CreateClass(unsigned cls);
+	bool EnableControllers(const std::string& unfocused,
+		const char *controllers);
+	bool WriteClassCpus();
+
+	static bool WriteControl(int dirfd, const char *control,
+		const char *buf, size_t count, const std::string& path);
+
+	std::string	m_root;
+
+	int			m_classFds[ClassCount];
+	bool		m_supported;
+	bool		m_cpuset;
+};
+
+#endif /* __ACTIVITYMANAGER_CGROUPV2MANAGER_H__ */
@@ -0,0 +1,150 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_CLOCK_H__
+#define __ACTIVITYMANAGER_CLOCK_H__
+
+#include "Base.h"
+
+#include <ctime>
+#include <vector>
+
+class TimeoutBase;
+
+/*
+ * Source of wall-clock time and one-shot timers for the Scheduler,
+ * Schedules and Timeouts.  The process-wide instance defaults to a
+ * TimerfdClock, which multiplexes every Timeout onto a single timerfd
+ * watched from the default main context, or to a GlibClock (one GLib
+ * timeout source per timer) if timerfd is unavailable.  A simulator can
+ * install a virtual clock instead, so days of schedules, yield timeouts
+ * and power lock renewals run in seconds.
+ *
+ * The instance must be replaced before anything reads the time or arms a
+ * Timeout; the two clocks' times and timers do not mix.
+ */
+class Clock
+{
+public:
+	virtual ~Clock() {}
+
+	typedef unsigned long TimerId;
+
+	/* Seconds since the epoch, as time(2) */
+	virtual time_t GetTime() = 0;
+
+	/* Seconds on a clock that never steps, for measuring intervals that
+	 * must survive NTP or the user setting the time.  Only differences
+	 * between two readings mean anything.  The default reads
+	 * CLOCK_MONOTONIC. */
+	virtual time_t GetMonotonicTime();
+
+	/* Call timeout->Fire() once, "seconds" from now.  Never returns 0. */
+	virtual TimerId AddTimer(unsigned seconds, TimeoutBase *timeout) = 0;
+
+	/* Cancel a timer that has not yet fired */
+	virtual void CancelTimer(TimerId timer) = 0;
+
+	/* Move a timer that has not yet fired to "seconds" from now, returning
+	 * its (possibly new) id.  The default cancels and adds. */
+	virtual TimerId RearmTimer(TimerId timer, unsigned seconds,
+		TimeoutBase *timeout);
+
+	static Clock& GetInstance();
+	static void SetInstance(boost::shared_ptr<Clock> clock);
+
+protected:
+	static boost::shared_ptr<Clock>	s_instance;
+};
+
+class GlibClock : public Clock
+{
+public:
+	GlibClock();
+	virtual ~GlibClock();
+
+	virtual time_t GetTime();
+
+	virtual TimerId AddTimer(unsigned seconds, TimeoutBase *timeout);
+	virtual void CancelTimer(TimerId timer);
+};
+
+/*
+ * All timers are kept in one indexed min-heap keyed on their monotonic
+ * deadline, and a single timerfd is programmed for the earliest of them.
+ * Adding, cancelling and re-arming are O(log n) and allocate nothing once
+ * the heap has grown to the daemon's working set; re-arming moves the
+ * entry in place.  Every timer that is due when the timerfd becomes
+ * readable fires in that one wakeup, in deadline order, and the timerfd
+ * is reprogrammed once afterwards rather than once per change.
+ *
+ * Throws std::runtime_error if the timerfd cannot be created.
+ */
+class TimerfdClock : public Clock
+{
+public:
+	TimerfdClock();
+	virtual ~TimerfdClock();
+
+	virtual time_t GetTime();
+
+	virtual TimerId AddTimer(unsigned seconds, TimeoutBase *timeout);
+	virtual void CancelTimer(TimerId timer);
+	virtual TimerId RearmTimer(TimerId timer, unsigned seconds,
+		TimeoutBase *timeout);
+
+	/* Called from the main loop when the timerfd is readable */
+	void Dispatch();
+
+protected:
+	struct Slot {
+		TimeoutBase			*m_timeout;
+		unsigned long long	m_deadline;
+		unsigned long long	m_sequence;
+		unsigned			m_heapIndex;
+		unsigned			m_generation;
+	};
+
+	static unsigned long long NowMs();
+
+	Slot *Lookup(TimerId timer);
+	TimerId MakeId(unsigned slot) const;
+
+	void Schedule(unsigned slot, unsigned seconds);
+	void Remove(unsigned slot);
+
+	bool Before(unsigned a, unsigned b) const;
+	void Place(unsigned index, unsigned slot);
+	void SiftUp(unsigned index);
+	void SiftDown(unsigned index);
+
+	void Reprogram();
+
+	int			m_fd;
+	unsigned	m_watch;
+	bool		m_dispatching;
+
+	unsigned long long	m_programmed;
+	unsigned long long	m_nextSequence;
+
+	std::vector<Slot>		m_slots;
+	std::vector<unsigned>	m_heap;
+	std::vector<unsigned>	m_free;
+};
+
+#endif /* __ACTIVITYMANAGER_CLOCK_H__ */
@@ -20,6 +20,7 @@
 #define __ACTIVITYMANAGER_COMPLETION_H__
 
 #include "Base.h"
+#include "MethodLatency.h"
 
 #include <core/MojServiceMessage.h>
 
@@ -59,6 +60,7 @@ public:
 		, m_category(category)
 		, m_msg(msg)
 		, m_activity(activity)
+		, m_timing(MethodTimer::Capture(msg))
 	{
 	}
 
@@ -66,6 +68,8 @@ public:
 
 	virtual void Complete(bool succeeded)
 	{
+		MethodFinishTimer::Scope timing(m_timing);
+
 		((*m_category.get()).*m_callback)(m_msg, m_payload, m_activity,
 			succeeded);
 	}
@@ -78,6 +82,9 @@ protected:
 	MojRefCountedPtr<MojServiceMessage>	m_msg;
 
 	boost::shared_ptr<Activity>	m_activity;
+
+	/* Latency of the request, if the reply was deferred to here */
+	boost::shared_ptr<MethodPending>	m_timing;
 };
 
 template<class T>
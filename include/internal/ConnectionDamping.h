@@ -0,0 +1,130 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_CONNECTIONDAMPING_H__
+#define __ACTIVITYMANAGER_CONNECTIONDAMPING_H__
+
+#include "Base.h"
+
+#include <ctime>
+
+#include <core/MojObject.h>
+
+/*
+ * Hysteresis for the connection requirements, so a device hovering at the
+ * edge of coverage doesn't start, block, requeue and restart its
+ * connected Activities on every status signal.
+ *
+ * A LinkDamper sits between a link's raw availability and the state its
+ * requirements see:
+ *
+ * - Losing the link is only reported once it has stayed down for
+ *   "holdDown" seconds.  Coming back inside that time is not a flap as far
+ *   as the requirements are concerned.
+ *
+ * - Every raw loss adds "penalty" to the link's flap penalty, which halves
+ *   every "halfLife" seconds.  Once the penalty reaches "suppress", the
+ *   link is reported down, and stays down even when it comes back, until
+ *   the penalty decays to "reuse".  The penalty is capped so no link is
+ *   suppressed for more than "maxSuppress" seconds after its last flap.
+ *
+ * A ConfidenceDebounce reports increases in a link's confidence level
+ * straight away, and decreases once they have lasted "confidenceHold"
+ * seconds.
+ *
+ * Times are the Clock's monotonic time, so a clock step when the network
+ * comes up (NTP) can't stretch suppression past "maxSuppress" or cut a
+ * hold-down short, and the simulator's virtual time still applies.
+ * The settings are process-wide and tunable through devel/connectionDamping;
+ * zero holds and a zero penalty turn damping off.
+ */
+class ConnectionDamping
+{
+public:
+	struct Config {
+		Config();
+
+		unsigned	m_holdDown;			/* Seconds */
+		unsigned	m_penalty;
+		unsigned	m_suppress;
+		unsigned	m_reuse;
+		unsigned	m_halfLife;			/* Seconds */
+		unsigned	m_maxSuppress;		/* Seconds */
+		unsigned	m_confidenceHold;	/* Seconds */
+	};
+
+	static const Config& GetConfig();
+
+	/* Fields missing from "rep" are left unchanged.  The reuse limit must
+	 * be below the suppress limit. */
+	static MojErr ConfigFromJson(const MojObject& rep);
+	static MojErr ConfigToJson(MojObject& rep);
+
+protected:
+	static Config	s_config;
+};
+
+class LinkDamper
+{
+public:
+	LinkDamper();
+
+	/* Raw state from the latest status signal */
+	void SetRaw(bool available, time_t now);
+	bool GetRaw() const { return m_raw; }
+
+	/* State the requirements should see now.  "next" is set to the number
+	 * of seconds until that may change on its own, or 0 if it won't. */
+	bool Evaluate(time_t now, unsigned& next);
+
+	MojErr ToJson(MojObject& rep, time_t now) const;
+
+protected:
+	double DecayedPenalty(time_t now) const;
+
+	bool		m_raw;
+	bool		m_reported;
+	bool		m_suppressed;
+
+	time_t		m_rawChanged;
+
+	double		m_penalty;
+	time_t		m_penaltyTime;
+
+	unsigned	m_flaps;
+	unsigned	m_suppressions;
+};
+
+class ConfidenceDebounce
+{
+public:
+	ConfidenceDebounce(int initial);
+
+	void SetRaw(int confidence, time_t now);
+	int GetRaw() const { return m_raw; }
+
+	/* As LinkDamper::Evaluate */
+	int Evaluate(time_t now, unsigned& next);
+
+protected:
+	int		m_raw;
+	int		m_reported;
+	time_t	m_rawChanged;
+};
+
+#endif /* __ACTIVITYMANAGER_CONNECTIONDAMPING_H__ */
@@ -21,6 +21,8 @@
 
 #include "Requirement.h"
 #include "RequirementManager.h"
+#include "ConnectionDamping.h"
+#include "Timeout.h"
 
 #include <boost/intrusive/set.hpp>
 
@@ -46,6 +48,8 @@ public:
 	virtual void Enable();
 	virtual void Disable();
 
+	virtual MojErr StatusToJson(MojObject& rep) const;
+
 protected:
 	void ConnectionManagerUpdate(MojServiceMessage *msg,
 		const MojObject& response, MojErr err);
@@ -53,6 +57,26 @@ protected:
 	MojErr UpdateWANStatus(const MojObject& response);
 	MojErr UpdateWifiStatus(const MojObject& response);
 
+	/* Bring the requirements in line with what the dampers report now.
+	 * "updated" is set if the link's status changed without its
+	 * availability changing. */
+	void ApplyLink(LinkDamper& damper, bool updated,
+		boost::shared_ptr<RequirementCore>& core,
+		RequirementList& requirements, const char *name, time_t now);
+	void ApplyConfidence(ConfidenceDebounce& debounce, int& confidence,
+		boost::shared_ptr<RequirementCore> *confidenceCores,
+		RequirementList *confidenceLists, const char *name, time_t now);
+	void ApplyInternetConfidence();
+
+	/* Re-evaluate the dampers when the earliest pending hold or suppression
+	 * expires */
+	void NoteRecheck(unsigned seconds);
+	void ScheduleRecheck();
+	void Recheck();
+
+	MojErr LinkToJson(MojObject& rep, const LinkDamper& damper,
+		const ConfidenceDebounce *debounce, int confidence, time_t now) const;
+
 	int GetConfidence(const MojObject& spec) const;
 	int ConfidenceToInt(const MojObject& confidenceObj) const;
 
@@ -97,6 +121,17 @@ protected:
 	boost::shared_ptr<RequirementCore>
 		m_wifiConfidenceCores[ConnectionConfidenceMax];
 
+	LinkDamper	m_internetDamper;
+	LinkDamper	m_wifiDamper;
+	LinkDamper	m_wanDamper;
+
+	ConfidenceDebounce	m_wifiConfidenceDebounce;
+	ConfidenceDebounce	m_wanConfidenceDebounce;
+
+	unsigned	m_nextRecheck;
+
+	boost::shared_ptr<Timeout<ConnectionManagerProxy> >	m_recheckTimeout;
+
 	static MojLogger	s_log;
 };
 
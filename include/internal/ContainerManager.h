@@ -21,6 +21,8 @@
 
 #include "ResourceManager.h"
 #include "ActivityTypes.h"
+#include "Timeout.h"
+#include "CpuPartition.h"
 
 #include <vector>
 #include <map>
@@ -28,6 +30,15 @@
 class ResourceContainer;
 class BusEntity;
 
+/*
+ * Besides weighting containers, a Container Manager can freeze every
+ * container at the lowest priority while foreground work (a focused or
+ * immediate Activity) runs, so background services do not compete with it
+ * for caches and memory bandwidth.  The policy is off by default.  A
+ * freeze lasts until the foreground goes idle, or at most maxFreeze
+ * seconds; after a thaw the containers run for at least minThaw seconds
+ * before they can be frozen again, so they always get some time.
+ */
 class ContainerManager : public ResourceManager
 {
 public:
@@ -36,6 +47,14 @@ public:
 
 	typedef std::vector<BusId> BusIdVec;
 
+	struct ContainerMapping {
+		std::string	m_name;
+		BusIdVec	m_ids;
+		pid_t		m_pid;
+	};
+
+	typedef std::vector<ContainerMapping> ContainerMappingVec;
+
 	virtual boost::shared_ptr<ResourceContainer> CreateContainer(
 		const std::string& name) = 0;
 
@@ -43,18 +62,74 @@ public:
 
 	void MapContainer(const std::string& name, const BusIdVec& ids, pid_t pid);
 
+	/* Apply a batch of mappings, with the same result as mapping them one
+	 * at a time in order, but updating each affected container's priority
+	 * only once, after all the entities have been moved. */
+	void MapContainers(const ContainerMappingVec& mappings);
+
+	/* Repeat every mapping made here on "linked", so the manager of
+	 * another resource sees the same containers and processes */
+	void LinkManager(boost::shared_ptr<ContainerManager> linked);
+
 	virtual void InformEntityUpdated(boost::shared_ptr<BusEntity> entity);
 
 	virtual ActivityPriority_t GetDefaultPriority() const = 0;
 	virtual ActivityPriority_t GetDisabledPriority() const = 0;
 
+	virtual void InformForegroundChanged(bool active);
+
+	virtual void GetProcesses(boost::shared_ptr<BusEntity> entity,
+		std::set<int>& pids) const;
+
 	virtual void Enable();
 	virtual void Disable();
 	virtual bool IsEnabled() const;
 
 	virtual MojErr InfoToJson(MojObject& rep) const;
 
+	struct FreezePolicy {
+		FreezePolicy();
+
+		bool		m_enabled;
+		unsigned	m_maxFreeze;
+		unsigned	m_minThaw;
+	};
+
+	static const unsigned DefaultMaxFreeze = 30;
+	static const unsigned DefaultMinThaw = 10;
+
+	void SetFreezePolicy(const FreezePolicy& policy);
+	const FreezePolicy& GetFreezePolicy() const;
+
+	/* True if the backend can freeze containers */
+	virtual bool CanFreeze() const;
+
+	bool IsFrozen() const;
+
+	MojErr FreezerToJson(MojObject& rep) const;
+
+	/* Pin the Containers to the cores of "partition", live */
+	void SetCpuPartition(const CpuPartition& partition);
+	const CpuPartition& GetCpuPartition() const;
+
+	/* How the backend pins Containers to the partition ("cpuset" or
+	 * "affinity"), or NULL if it cannot */
+	virtual const char *GetCpuPartitionMode() const;
+
+	MojErr CpuPartitionToJson(MojObject& rep) const;
+
 protected:
+	/* Freeze or thaw all containers currently at the lowest priority,
+	 * and any that are moved there while frozen */
+	virtual bool FreezeLowest(bool frozen);
+
+	void UpdateFreeze();
+	void Thaw(time_t now);
+	void ArmFreezeTimeout(unsigned seconds);
+
+	/* Bring the classes and Containers in line with m_partition */
+	virtual void ApplyCpuPartition();
+
 	typedef std::map<boost::shared_ptr<BusEntity>,
 		boost::shared_ptr<ResourceContainer> > EntityContainerMap;
 	typedef std::map<std::string, boost::shared_ptr<ResourceContainer> >
@@ -64,10 +139,24 @@ protected:
 
 	ContainerMap		m_containers;
 
+	std::vector<boost::shared_ptr<ContainerManager> >	m_linked;
+
 	boost::weak_ptr<MasterResourceManager>	m_master;
 
 	bool				m_enabled;
 
+	FreezePolicy		m_freezePolicy;
+	bool				m_foreground;
+	bool				m_frozen;
+
+	/* Clock::GetMonotonicTime(); m_thawedAt is 0 until the first thaw */
+	time_t				m_frozenAt;
+	time_t				m_thawedAt;
+
+	boost::shared_ptr<Timeout<ContainerManager> >	m_freezeTimeout;
+
+	CpuPartition		m_partition;
+
 	static MojLogger	s_log;
 };
 
@@ -21,6 +21,11 @@
 
 #include "ResourceContainer.h"
 #include <list>
+#include <map>
+#include <set>
+#include <sched.h>
+
+class ControlGroupManager;
 
 class ControlGroup : public ResourceContainer
 {
@@ -33,15 +38,32 @@ public:
 
 	virtual void UpdatePriority();
 	virtual void MapProcess(pid_t pid);
+	virtual void GetProcessIds(std::set<int>& pids) const;
 
 	virtual void Enable();
 	virtual void Disable();
 
+	/* Place the processes again after the CPU partition changed */
+	virtual void ApplyPartition();
+
 	virtual MojErr ToJson(MojObject& rep) const;
 
 protected:
 	virtual void SetPriority(ActivityPriority_t priority, bool focused);
 
+	/* Place a newly mapped process alongside the others, which are already
+	 * in place for the current settings */
+	virtual void PlaceProcess(pid_t pid);
+
+	std::string GetClassControlFile(ActivityPriority_t priority,
+		bool focused) const;
+
+	boost::shared_ptr<ControlGroupManager> GetControlGroupManager() const;
+	bool IsPartitioned() const;
+
+	/* True if the processes are placed by priority at all */
+	virtual bool IsManaged() const;
+
 	const std::string& GetRoot() const;
 
 	virtual bool WriteControlFile(const std::string& controlFile,
@@ -50,11 +72,37 @@ protected:
 	ActivityPriority_t	m_currentPriority;
 	bool m_focused;
 
+	/* True once the processes have been placed for the current partition */
+	bool m_placed;
+
 	// list of processes attatched to this container
 	std::list<int> m_processIds;
 
 };
 
+/*
+ * Fallback for when there is no cgroup hierarchy.  Each thread of every
+ * mapped process is given a scheduling policy and nice level for the
+ * Container's priority (SCHED_BATCH for low, SCHED_IDLE for lowest and
+ * none, raised nice levels for focused and highest), and, while the CPUs
+ * are partitioned, pinned to its partition.  Real-time (SCHED_FIFO and
+ * SCHED_RR) threads are left alone.  The threads are found through
+ * /proc/<pid>/task.
+ *
+ * New threads inherit the settings of the thread that created them, but
+ * a thread created while its process was being placed may miss them; the
+ * ControlGroupManager calls Rescan() periodically to place any thread not
+ * seen before.  Threads already placed are only placed again when the
+ * Container's settings change, so one that changes its own priority
+ * keeps it until then.
+ *
+ * Each thread's policy and nice level (and its affinity, once pinned) are
+ * read before it is first placed, and put back while the manager is
+ * disabled and when the Container is destroyed.  Nothing is placed while
+ * the manager is disabled.  A process is known by its start time, so once
+ * it exits none of its threads, nor any that later have its pid, are
+ * touched again.
+ */
 class NullControlGroup : public ControlGroup
 {
 public:
@@ -62,7 +110,81 @@ public:
 		boost::shared_ptr<ContainerManager> manager);
 	virtual ~NullControlGroup();
 
+	virtual void MapProcess(pid_t pid);
+
+	virtual void Disable();
+
+	virtual void ApplyPartition();
+
+	/* Place threads started since the processes were last placed */
+	void Rescan();
+
+	virtual MojErr ToJson(MojObject& rep) const;
+
 protected:
+	virtual bool IsManaged() const;
+
+	virtual void SetPriority(ActivityPriority_t priority, bool focused);
+	virtual void PlaceProcess(pid_t pid);
+
+	/* Place every thread of "pid" not in "placed", which is then updated
+	 * to the process's current threads.  Returns false if the process is
+	 * gone. */
+	bool PlaceThreads(int pid, std::set<int>& placed);
+
+	/* Give the threads of every process back their original settings, and
+	 * forget them until they are placed again */
+	void RestoreAll();
+	void RestoreThreads(int pid);
+
+	/* False if "pid" has exited, or now belongs to a process other than
+	 * the one first seen with it */
+	bool IsSameProcess(int pid);
+
+	struct ThreadOriginal {
+		ThreadOriginal();
+
+		int			m_policy;
+		int			m_nice;
+
+		/* Only read once the thread's affinity is set */
+		bool		m_hasMask;
+		cpu_set_t	m_mask;
+	};
+
+	typedef std::map<int, ThreadOriginal> ThreadOriginalMap;
+
+	struct ProcessOriginal {
+		ProcessOriginal();
+
+		unsigned long long	m_startTime;
+		ThreadOriginalMap	m_threads;
+	};
+
+	/* "inherited" is the original of the thread "tid" took its settings
+	 * from, if it was started after being placed */
+	void PlaceThread(int tid, ThreadOriginalMap& originals,
+		const ThreadOriginal *inherited);
+	static void RestoreThread(int tid, const ThreadOriginal& original);
+
+	typedef std::map<int, std::set<int> > ThreadMap;
+	typedef std::map<int, ProcessOriginal> ProcessOriginalMap;
+
+	/* Threads of each process placed with the current settings */
+	ThreadMap	m_threads;
+
+	/* Settings of each process's threads before they were first placed */
+	ProcessOriginalMap	m_originals;
+
+	cpu_set_t	m_mask;
+	int			m_policy;
+	int			m_nice;
+
+	/* Whether the placement sets the threads' affinity: while the CPUs
+	 * are partitioned, and once more to release them afterwards */
+	bool		m_setAffinity;
+	bool		m_pinned;
+
 	virtual bool WriteControlFile(const std::string& controlFile,
                 const char *buf, size_t count, std::list<int>::iterator current);
 
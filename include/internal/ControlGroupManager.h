@@ -21,6 +21,23 @@
 
 #include "ContainerManager.h"
 
+/*
+ * Container Manager for the cgroup v1 cpuset hierarchy.  Processes are
+ * only moved between its classes while a CpuPartition is set:
+ *
+ *   <root>/focused
+ *   <root>/unfocused/<priority>	(none, lowest, ... highest)
+ *
+ * Each class's cpuset.cpus is then written from the partition (the
+ * "unfocused" parent keeps every CPU), and missing class directories are
+ * created with the root's cpuset.mems.  Changing the partition rewrites
+ * the classes in place, so the pinning follows it live.
+ *
+ * If the root is not a cgroup filesystem, the Containers set the
+ * scheduling policy, nice level and CPU affinity of their processes'
+ * threads instead (see NullControlGroup), and the threads are rescanned
+ * every RescanInterval seconds.
+ */
 class ControlGroupManager : public ContainerManager
 {
 public:
@@ -34,12 +51,35 @@ public:
 	virtual ActivityPriority_t GetDefaultPriority() const;
 	virtual ActivityPriority_t GetDisabledPriority() const;
 
+	virtual MojErr InfoToJson(MojObject& rep) const;
+
 	const std::string& GetRoot() const;
 
+	virtual const char *GetCpuPartitionMode() const;
+
+	static const unsigned RescanInterval = 30;
+
 protected:
+	virtual void ApplyCpuPartition();
+
+	void RescanThreads();
+
+	bool WriteClassCpus();
+	bool PrepareClass(const std::string& path, const std::string& cpus);
+
+	static bool ReadControl(const std::string& path, std::string& value);
+	static bool WriteControl(const std::string& path,
+		const std::string& value);
+
 	std::string	m_root;
 
 	bool	m_supported;
+
+	std::string		m_allCpus;
+	std::string		m_mems;
+	bool			m_classesReady;
+
+	boost::shared_ptr<Timeout<ControlGroupManager> >	m_rescanTimeout;
 };
 
 #endif /* __ACTIVITYMANAGER_CONTROLGROUPMANAGER_H__ */
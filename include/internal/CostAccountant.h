@@ -0,0 +1,145 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_COSTACCOUNTANT_H__
+#define __ACTIVITYMANAGER_COSTACCOUNTANT_H__
+
+#include "Base.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <core/MojObject.h>
+
+/*
+ * Attributes the CPU time and storage I/O of processes to the Activities
+ * running in them.
+ *
+ * Each full sample reads /proc/<pid>/stat and /proc/<pid>/io for every
+ * process of every running Activity.  The growth since the previous sample
+ * is split evenly between the Activities sharing the process.  A process
+ * seen for the first time only sets its baseline, and one no Activity uses
+ * any more is forgotten, so work done between Activities is never charged.
+ * As Activities begin and end only their own processes are read, so that
+ * each is charged for exactly its run.
+ *
+ * When an Activity ends, its cost is added to the totals for its name,
+ * which also keep a moving average per run, so expensive periodic jobs
+ * stand out in "info".
+ */
+class CostAccountant
+{
+public:
+	CostAccountant();
+	virtual ~CostAccountant();
+
+	struct Cost {
+		Cost();
+
+		void Add(const Cost& cost);
+		MojErr ToJson(MojObject& rep) const;
+
+		MojUInt64	m_cpuUsec;
+		MojUInt64	m_readBytes;
+		MojUInt64	m_writeBytes;
+	};
+
+	struct History {
+		History();
+
+		unsigned	m_runs;
+		Cost		m_total;
+		Cost		m_average;
+		Cost		m_last;
+
+		/* Sequence number of the last run, to find the oldest history */
+		unsigned long long	m_sequence;
+	};
+
+	typedef std::map<activityId_t, std::set<int> > ProcessMap;
+
+	void Begin(activityId_t id, const std::string& name);
+	void End(activityId_t id);
+
+	bool IsAccounting() const;
+
+	/* Processes of each running Activity */
+	void Sample(const ProcessMap& processes);
+
+	/* Read only "pids": charge the growth of each to the Activities in
+	 * "processes" sharing it, and take a fresh baseline of any no running
+	 * Activity shares.  Readings of other processes are kept for the
+	 * next full Sample(). */
+	void SampleProcesses(const ProcessMap& processes,
+		const std::set<int>& pids);
+
+	/* Cost so far of the run, or NULL if the Activity is not running */
+	const Cost *GetCost(activityId_t id) const;
+	const History *GetHistory(const std::string& name) const;
+
+	/* Cost of the run, and the history of its name */
+	MojErr ActivityToJson(activityId_t id, const std::string& name,
+		MojObject& rep) const;
+	MojErr ToJson(MojObject& rep) const;
+
+	/* Names with the oldest history are dropped beyond this */
+	static const unsigned MaxHistories = 256;
+
+	/* Weight of the latest run in the moving average is 1/AverageWeight */
+	static const unsigned AverageWeight = 8;
+
+protected:
+	struct Reading {
+		MojUInt64	m_cpuUsec;
+		MojUInt64	m_readBytes;
+		MojUInt64	m_writeBytes;
+	};
+
+	/* Returns false if the process is gone */
+	virtual bool ReadProcess(int pid, Reading& reading) const;
+
+	static MojErr HistoryToJson(const History& history, MojObject& rep);
+
+	struct Running {
+		std::string	m_name;
+		Cost		m_cost;
+	};
+
+	typedef std::map<activityId_t, Running> RunningMap;
+	typedef std::vector<Running *> RunningVec;
+	typedef std::map<int, RunningVec> SharerMap;
+	typedef std::map<int, Reading> ReadingMap;
+	typedef std::map<std::string, History> HistoryMap;
+
+	void GetSharers(const ProcessMap& processes, SharerMap& sharers);
+	static void Charge(const RunningVec& sharers, const Reading& previous,
+		const Reading& reading);
+
+	RunningMap		m_running;
+	ReadingMap		m_readings;
+	HistoryMap		m_histories;
+
+	unsigned long long	m_sequence;
+
+	long	m_ticksPerSecond;
+};
+
+#endif /* __ACTIVITYMANAGER_COSTACCOUNTANT_H__ */
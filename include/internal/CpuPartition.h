@@ -0,0 +1,64 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_CPUPARTITION_H__
+#define __ACTIVITYMANAGER_CPUPARTITION_H__
+
+#include "Base.h"
+#include "ActivityTypes.h"
+
+#include <string>
+#include <sched.h>
+
+#include <core/MojObject.h>
+
+/*
+ * Splits the CPUs of a heterogeneous SoC between the priority classes of
+ * the Containers: focused, highest and high Containers run on the
+ * "performance" cores, low, lowest and none on the "efficiency" cores,
+ * and normal on both.  Each set is a CPU list in the kernel's format,
+ * e.g. "4-7" or "0-1,3".  An empty set leaves its classes unpinned, so
+ * the default (both empty) turns partitioning off.
+ */
+class CpuPartition
+{
+public:
+	CpuPartition();
+
+	bool IsEnabled() const;
+
+	/* CPU list for the class, or an empty string if it may use every CPU */
+	std::string GetCpus(ActivityPriority_t priority, bool focused) const;
+
+	/* Mask for the class.  Every CPU is set if the class is unpinned. */
+	void GetMask(ActivityPriority_t priority, bool focused,
+		cpu_set_t& mask) const;
+
+	/* Fields missing from "rep" are left unchanged.  Returns MojErrInvalidArg
+	 * if a CPU list does not parse. */
+	MojErr FromJson(const MojObject& rep);
+	MojErr ToJson(MojObject& rep) const;
+
+	static bool ParseCpuList(const std::string& list, cpu_set_t& mask);
+
+	std::string	m_performance;
+	std::string	m_efficiency;
+};
+
+#endif /* __ACTIVITYMANAGER_CPUPARTITION_H__ */
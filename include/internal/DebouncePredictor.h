@@ -0,0 +1,157 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_DEBOUNCEPREDICTOR_H__
+#define __ACTIVITYMANAGER_DEBOUNCEPREDICTOR_H__
+
+#include "Base.h"
+
+#include <ctime>
+#include <map>
+#include <string>
+
+#include <core/MojObject.h>
+
+/*
+ * Picks how long power stays locked after an Activity with
+ * "powerDebounce" ends, instead of a fixed PowerActivityDebounceDuration.
+ *
+ * The predictor learns how long it is until the next powered Activity
+ * arrives, both after any release of the power lock (global) and after
+ * each creator's own Activities end (per creator).  Gaps are kept in an
+ * exponentially decayed histogram.  To debounce for a creator, it uses the
+ * creator's histogram if it has enough weight, or the global one if not,
+ * and picks the delay d that minimizes the expected cost of the next gap
+ * g, in seconds awake:
+ *
+ *   g <= d:  g             stayed awake until the next Activity
+ *   g >  d:  d + wakeCost  stayed awake for nothing, then suspended and
+ *                          had to resume
+ *
+ * Each release of the power lock is scored against the next arrival, and
+ * so is the fixed delay it replaces, so the two can be compared through
+ * devel/powerDebounce.
+ *
+ * Times are the Clock's monotonic time, so a clock step (NTP, or the user
+ * setting the time) can't produce a bogus gap.  State is process-wide.
+ */
+class DebouncePredictor
+{
+public:
+	struct Config {
+		Config();
+
+		bool		m_enabled;
+		unsigned	m_wakeCost;			/* Seconds awake one resume costs */
+		unsigned	m_maxDelay;			/* Seconds */
+		unsigned	m_minSamples;
+		unsigned	m_sampleHalfLife;	/* Samples */
+	};
+
+	/* Seconds to keep power locked after an Activity of "creator" with
+	 * "powerDebounce" ends */
+	static unsigned Predict(const std::string& creator);
+
+	/* An Activity of "creator" was given power */
+	static void NoteAcquire(const std::string& creator, time_t now);
+
+	/* An Activity of "creator" with "powerDebounce" gave power up */
+	static void NoteRelease(const std::string& creator, time_t now);
+
+	/* The last holder gave power up.  If any holder asked for a debounce,
+	 * "debounced" is set and power stays locked for "delay" seconds. */
+	static void NoteLockFree(time_t now, bool debounced, unsigned delay);
+
+	static const Config& GetConfig();
+
+	/* Fields missing from "rep" are left unchanged */
+	static MojErr ConfigFromJson(const MojObject& rep);
+	static MojErr ConfigToJson(MojObject& rep);
+
+	/* Performance, the global distribution and each creator's prediction */
+	static MojErr ToJson(MojObject& rep);
+
+	/* Forget everything learned */
+	static void Reset();
+
+	static const unsigned BucketCount = 11;
+
+protected:
+	class Histogram
+	{
+	public:
+		Histogram();
+
+		void Add(double gap, double decay);
+
+		double GetWeight() const { return m_total; }
+
+		/* Delay with the lowest expected cost, and that cost */
+		unsigned Best(const Config& config, double& cost) const;
+		double ExpectedCost(unsigned delay, unsigned wakeCost) const;
+
+		MojErr ToJson(MojObject& rep) const;
+
+		time_t	m_updated;
+
+	protected:
+		double	m_weights[BucketCount];
+		double	m_total;
+	};
+
+	struct CreatorState {
+		CreatorState() : m_awaiting(false), m_released(0) {}
+
+		Histogram	m_gaps;
+
+		/* Released, and awaiting the next arrival */
+		bool		m_awaiting;
+		time_t		m_released;
+	};
+
+	typedef std::map<std::string, CreatorState> CreatorMap;
+
+	static double GetDecay();
+	static void TrimCreators();
+
+	/* Upper bound of each bucket but the last, in seconds */
+	static const unsigned	GapBounds[BucketCount - 1];
+
+	static const unsigned	MaxCreators = 64;
+
+	static Config		s_config;
+	static Histogram	s_global;
+	static CreatorMap	s_creators;
+
+	/* Most recent release of the lock, awaiting the next arrival */
+	static bool			s_lockFreeAwaiting;
+	static time_t		s_lockFree;
+	static bool			s_lockFreeDebounced;
+	static unsigned		s_lockFreeDelay;
+
+	/* Scoring of the chosen delays, and of the fixed delay alongside */
+	static unsigned long long	s_decisions;
+	static unsigned long long	s_hits;
+	static unsigned long long	s_fixedHits;
+	static unsigned long long	s_awakeSeconds;
+	static unsigned long long	s_wastedSeconds;
+	static unsigned long long	s_fixedAwakeSeconds;
+	static unsigned long long	s_fixedWastedSeconds;
+};
+
+#endif /* __ACTIVITYMANAGER_DEBOUNCEPREDICTOR_H__ */
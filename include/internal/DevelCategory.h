@@ -54,6 +54,28 @@ protected:
 	/* Enable or disable priority control */
 	MojErr PriorityControl(MojServiceMessage *msg, MojObject& payload);
 
+	/* Report approximate per-Activity memory footprint */
+	MojErr MemoryUsage(MojServiceMessage *msg, MojObject& payload);
+
+	/* Record the workload to a trace file for later replay */
+	MojErr StartRecording(MojServiceMessage *msg, MojObject& payload);
+	MojErr StopRecording(MojServiceMessage *msg, MojObject& payload);
+
+	/* Zero the metrics reported by "info" */
+	MojErr ResetMetrics(MojServiceMessage *msg, MojObject& payload);
+
+	/* Write the flight recorder ring to a file */
+	MojErr DumpFlightRecorder(MojServiceMessage *msg, MojObject& payload);
+	MojErr ConnectionDampingConfig(MojServiceMessage *msg, MojObject& payload);
+	MojErr BatteryUpdates(MojServiceMessage *msg, MojObject& payload);
+	MojErr PowerDebounce(MojServiceMessage *msg, MojObject& payload);
+
+	/* Freeze the lowest priority containers while foreground work runs */
+	MojErr ContainerFreezer(MojServiceMessage *msg, MojObject& payload);
+
+	/* Pin containers to the performance or efficiency cores by priority */
+	MojErr CpuPartitionConfig(MojServiceMessage *msg, MojObject& payload);
+
 	/* Map processes into containers */
 	MojErr MapProcess(MojServiceMessage *msg, MojObject& payload);
 
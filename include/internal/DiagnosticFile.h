@@ -0,0 +1,50 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_DIAGNOSTICFILE_H__
+#define __ACTIVITYMANAGER_DIAGNOSTICFILE_H__
+
+#include "Base.h"
+
+#include <cstdio>
+#include <string>
+
+/*
+ * Files written on request for offline analysis (workload traces, flight
+ * recorder dumps).  The daemon runs as root and the request may come from
+ * any client of the private bus, so these only ever go into one directory
+ * the daemon owns, under a bare file name, and are never opened through a
+ * symlink or on top of a file that is already there.
+ */
+class DiagnosticFile
+{
+public:
+	static const char *Directory;
+
+	/* Not empty, no '/', and not starting with '.' */
+	static bool IsValidName(const std::string& name);
+
+	/* Create "name" in Directory, creating Directory (mode 0700) first if
+	 * it is missing.  If "replace" is set, a file already there by that
+	 * name is removed first; otherwise it is an error (EEXIST).  "path" is
+	 * set to the full path.  Returns NULL, with errno set, on failure. */
+	static FILE *Create(const std::string& name, bool replace,
+		std::string& path);
+};
+
+#endif /* __ACTIVITYMANAGER_DIAGNOSTICFILE_H__ */
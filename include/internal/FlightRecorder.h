@@ -0,0 +1,150 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_FLIGHTRECORDER_H__
+#define __ACTIVITYMANAGER_FLIGHTRECORDER_H__
+
+#include "Base.h"
+
+#include <string>
+#include <vector>
+
+/*
+ * Always-on record of the last few thousand state transitions, for
+ * diagnosing a device in the field where debug logging is off.
+ *
+ * Events are fixed-size binary records written into a ring; recording one
+ * is a clock read and a handful of stores, with no allocation or locking.
+ * (The daemon is single threaded, and the ring is only read from the main
+ * loop, so there is no concurrent reader to guard against.)
+ *
+ * The ring is written to a file in DiagnosticFile::Directory by
+ * devel/dumpFlightRecorder, or on SIGUSR2 to DefaultDumpName.
+ * loadtest/activitymanager-flightdecode turns a dump into a Chrome trace
+ * (chrome://tracing, ui.perfetto.dev).
+ *
+ * Dump format, all little-endian host order:
+ *
+ *   FlightDumpHeader
+ *   FlightRecord[count], oldest first
+ *   4 string tables (states, queues, reasons, requirements), each a
+ *   MojUInt32 count followed by that many NUL-terminated names
+ */
+
+typedef enum {
+	/* Activity state changed: from/to are ActivityState_t */
+	FlightStateEvent,
+	/* Activity moved to a run queue: "to" is the RunQueueId, or
+	 * FlightNoQueue if it was taken off the run queues */
+	FlightQueueEvent,
+	/* "reason" is the requirement's index in the requirement table */
+	FlightRequirementMetEvent,
+	FlightRequirementUnmetEvent,
+	/* Persist command completed: "to" is 1 on success, "arg" the latency
+	 * in milliseconds */
+	FlightPersistEvent,
+	MaxFlightEvent
+} FlightEventType;
+
+/* What caused a state change or queue move */
+typedef enum {
+	FlightReasonNone,
+	FlightReasonCommand,	/* "arg" is the ActivityCommand_t */
+	FlightReasonSchedule,
+	FlightReasonScheduleDue,
+	FlightReasonTriggered,
+	FlightReasonRequirement,
+	FlightReasonReady,
+	FlightReasonRun,
+	FlightReasonStart,
+	FlightReasonPowerLocked,
+	FlightReasonPowerUnlocked,
+	FlightReasonCallback,
+	FlightReasonRequeue,
+	FlightReasonYield,
+	FlightReasonRestart,
+	FlightReasonEnd,
+	FlightReasonOrphaned,
+	FlightReasonAdopted,
+	FlightReasonUnsubscribed,
+	FlightReasonInitialized,
+	FlightReasonNotReady,
+	FlightReasonEvicted,
+	FlightReasonReleased,
+	MaxFlightReason
+} FlightReason;
+
+struct FlightRecord {
+	MojInt64	m_time;		/* Monotonic, microseconds */
+	MojUInt64	m_activity;
+	MojUInt32	m_arg;
+	MojUInt16	m_reason;
+	MojUInt8	m_type;		/* FlightEventType */
+	MojUInt8	m_from;
+	MojUInt8	m_to;
+	MojUInt8	m_pad[7];
+};
+
+struct FlightDumpHeader {
+	char		m_magic[8];		/* "AMFLIGHT" */
+	MojUInt32	m_version;
+	MojUInt32	m_recordSize;
+	MojUInt64	m_count;
+	MojUInt64	m_dropped;		/* Overwritten before the dump */
+	MojInt64	m_monotonic;	/* Monotonic and wall clock at the time of */
+	MojInt64	m_wall;			/* the dump, microseconds */
+};
+
+class FlightRecorder
+{
+public:
+	/* Must be a power of two */
+	static const unsigned Capacity = 4096;
+	static const MojUInt8 FlightNoQueue = 0xff;
+	static const MojUInt32 DumpVersion = 1;
+
+	static const char *DefaultDumpName;
+
+	static void Record(FlightEventType type, activityId_t id,
+		MojUInt8 from, MojUInt8 to, MojUInt16 reason, MojUInt32 arg = 0);
+
+	/* Index of a requirement name in the dump's requirement table.  A
+	 * string search; Requirement::GetFlightCode() caches the result. */
+	static MojUInt16 GetRequirementCode(const std::string& name);
+
+	/* Write the ring to "name" in DiagnosticFile::Directory, replacing any
+	 * file of that name if "replace" is set.  "path" is set to the full
+	 * path.  Returns the number of records written, or -1 on failure. */
+	static long Dump(const std::string& name, bool replace,
+		std::string& path);
+
+	/* Dump to DefaultDumpName when the daemon receives SIGUSR2 */
+	static void EnableSignalDump();
+
+	static const char *ReasonNames[];
+
+protected:
+	static int SignalDump(void *data);
+
+	static FlightRecord			s_ring[Capacity];
+	static unsigned long long	s_next;
+
+	static std::vector<std::string>	s_requirements;
+};
+
+#endif /* __ACTIVITYMANAGER_FLIGHTRECORDER_H__ */
@@ -122,6 +122,7 @@
 #define MSGID_GET_BUSID_FAIL                            "GET_BUSID_FAIL" /** Failed to retreive bus id from JSON object */
 #define MSGID_CALL_RESP_UNHANDLED_EXCEPTION             "CALL_RESP_UNHANDLED_EXCEPTION" /** Unhandled exception occurred processing response */
 #define MSGID_CALL_RESP_UNKNOWN_EXCEPTION               "CALL_RESP_UNKNOWN_EXCEPTION" /** Unhandled exception of unknown type occurred processing response */
+#define MSGID_CALL_IDENTITY_UNSUPPORTED                 "CALL_IDENTITY_UNSUPPORTED" /** Service can't make public bus or proxied requests */
 #define MSGID_NON_LUNA_BUS_MSG                          "NON_LUNA_BUS_MSG" /** Message did not originate from the Luna Bus--->2 */
 #define MSGID_UNHANDLED_RESP                            "UNHANDLED_RESP" /** Unhandled response */
 #define MSGID_PERSIST_CMD_VALIDATE_EXCEPTION            "PERSIST_CMD_VALIDATE_EXCEPTION" /** unexpected exception during command calidation */
@@ -150,6 +151,24 @@
 #define MSGID_FINISH_ACTVTY_REPLY_ERR                   "FINISH_ACTVTY_REPLY_ERR" /** Failed to generate reply to Complete request */
 #define MSGID_UNHOOK_CMD_NOT_IN_QUEUE                   "UNHOOK_CMD_NOT_IN_QUEUE" /** Request to unhook persistCommand which is not in the queue */
 
+/** CgroupV2Manager.cpp */
+#define MSGID_CGROUP_CREATE_FAIL                        "CGROUP_CREATE_FAIL"  /** Unable to create a cgroup directory */
+#define MSGID_CGROUP_OPEN_FAIL                          "CGROUP_OPEN_FAIL"  /** Unable to open a cgroup directory */
+#define MSGID_CGROUP_CONTROLLER_FAIL                    "CGROUP_CONTROLLER_FAIL"  /** Unable to enable the cpu controller for the class cgroups */
+
+/** ControlGroup.cpp */
+#define MSGID_SET_AFFINITY_FAIL                         "SET_AFFINITY_FAIL"  /** sched_setaffinity() failed for a thread of a mapped process */
+#define MSGID_SET_SCHED_POLICY_FAIL                     "SET_SCHED_POLICY_FAIL"  /** Failed to set the scheduling policy or nice level of a thread of a mapped process */
+
+/** ProcessPolicyManager.cpp */
+#define MSGID_SET_IOPRIO_FAIL                           "SET_IOPRIO_FAIL"  /** ioprio_set() failed for a thread of a mapped process */
+#define MSGID_SET_OOM_SCORE_FAIL                        "SET_OOM_SCORE_FAIL"  /** Failed to write oom_score_adj of a mapped process */
+
+/** Clock.cpp */
+#define MSGID_TIMERFD_UNAVAILABLE                       "TIMERFD_UNAVAILABLE"  /** timerfd could not be created; falling back to GLib timeouts */
+#define MSGID_TIMERFD_READ_FAIL                         "TIMERFD_READ_FAIL"  /** Failed to read expiration count from timerfd */
+#define MSGID_TIMERFD_SET_FAIL                          "TIMERFD_SET_FAIL"  /** Failed to program timerfd */
+
 /** Timeout.cpp */
 #define MSGID_TIMEOUT_EXCEPTION                         "TIMEOUT_EXCEPTION"  /* */
 #define MSGID_TIMEOUT_ERR_UNKNOWN                       "TIMEOUT_ERR_UNKNOWN"  /* */
@@ -194,6 +213,7 @@
 
 /** RequirementManager.cpp */
 #define MSGID_REQ_MANAGER_NOT_FOUND          "REQ_MANAGER_NOT_FOUND" /* No manager found for Requirement */
+#define MSGID_REQ_BATCH_SETTLE_FAIL          "REQ_BATCH_SETTLE_FAIL" /* Exception re-evaluating an Activity at batch commit */
 
 /** PowerdScheduler.cpp */
 #define MSGID_SET_TIMEOUT_PARAM_ERR          "SET_TIMEOUT_PARAM_ERR" /* Error constructing parameters for powerd set timeout call*/
@@ -221,7 +241,7 @@
 #define MSGID_BATTERY_SIG_ENABLE              "BATTERY_SIG_ENABLE" /* Subscription to battery status signal failed, resubscribing */
 #define MSGID_UNKNOW_REQUIREMENT              "UNKNOW_REQUIREMENT"  /* Attempt to instantiate unknown requirement */
 
-/** PowerdPowerActivity.cpp */
+/** PowerdPowerLock.cpp */
 #define MSGID_PWR_LOCK_CREATE_FAIL            "PWR_LOCK_CREATE_FAIL" /* Failed to issue command to create power lock */
 #define MSGID_PWR_LOCK_FAKE_NOTI              "PWR_LOCK_FAKE_NOTI" /* Faking power locked notification */
 #define MSGID_PWR_UNLOCK_CREATE_FAIL          "PWR_LOCK_CREATE_FAIL" /* Failed to issue command to create power unlock */
@@ -240,6 +260,7 @@
 #define MSGID_HOOK_PERSIST_CMD_ERR              "HOOK_PERSIST_CMD_ERR" /* Attempt to hook PersistCommand */
 #define MSGID_REQ_UNMET_OWNER_MISMATCH          "REQ_UNMET_OWNER_MISMATCH" /* Requirement owner mismatch */
 #define MSGID_REQ_MET_OWNER_MISMATCH            "REQ_MET_OWNER_MISMATCH" /* Requirement owner mismatch */
+#define MSGID_RUNNABLE_MISMATCH                 "RUNNABLE_MISMATCH" /* Incremental readiness disagrees with full evaluation */
 
 #define MSGID_CANT_TRIGGER_DIFF_ACTIVITY        "CANT_TRIGGER_DIFF_ACTVTY" /** Can't arm trigger for a different Activity */
 #define MSGID_DISARM_TRIGGER_FOR_ACTIVITY       "DISARM_TRIGGER_FOR_ACTVTY" /** Can't disarm trigger for a different Activity */
@@ -257,6 +278,10 @@
 #define MSGID_RM_ASSOCIATION_NOT_FOUND      "RM_ASSOCIATION_NOTFOUND" /* can't remove association with Entity */
 
 #define MSGID_RM_REQ_NOT_FOUND              "RM_REQ_NOT_FOUND"  /* not found while trying to remove by name */
+
+#define MSGID_TRACE_OPEN_FAIL               "TRACE_OPEN_FAIL"   /* Unable to open workload trace file */
+#define MSGID_TRACE_WRITE_FAIL              "TRACE_WRITE_FAIL"  /* Unable to write workload trace file */
+#define MSGID_FLIGHT_DUMP_FAIL              "FLIGHT_DUMP_FAIL"  /* Unable to write flight recorder dump */
 /** list of logkey ID's */
 
 
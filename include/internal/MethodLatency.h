@@ -0,0 +1,199 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_METHODLATENCY_H__
+#define __ACTIVITYMANAGER_METHODLATENCY_H__
+
+#include "Base.h"
+#include "Metrics.h"
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <core/MojObject.h>
+#include <core/MojServiceMessage.h>
+
+/*
+ * Log-linear latency histogram in the style of HdrHistogram.  Values (in
+ * microseconds) below 32 are counted exactly; above that, each power of two
+ * is split into 16 sub-buckets, so any recorded value is within about 6% of
+ * the value reported for it.  Counts are allocated on the first sample.
+ */
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void Record(MojInt64 us);
+
+	unsigned long long GetCount() const { return m_count; }
+	MojInt64 GetMax() const { return m_max; }
+
+	/* Value at the given percentile (0-100), in microseconds */
+	MojInt64 GetPercentile(double percentile) const;
+
+	void Reset();
+
+	/* count, p50, p99, p999 and max, in milliseconds */
+	MojErr ToJson(MojObject& rep) const;
+
+protected:
+	static const unsigned SubBucketBits = 4;
+	static const unsigned SubBucketCount = 1 << SubBucketBits;
+	static const unsigned MaxValueBits = 40;
+	static const unsigned SlotCount =
+		(MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+	static unsigned GetSlot(MojInt64 us);
+	static MojInt64 GetSlotValue(unsigned slot);
+
+	std::vector<unsigned>	m_slots;
+	unsigned long long		m_count;
+	MojInt64				m_max;
+};
+
+/*
+ * Latency of one category method.  A request passes through up to three
+ * phases:
+ *
+ *   handler - the service method itself (parsing, lookups, state changes)
+ *   persist - waiting for the persist chain, if the reply was deferred
+ *             until it completed
+ *   finish  - the completion that sends the deferred reply, including any
+ *             event fan-out it triggers
+ *
+ * "total" runs from receipt to the end of whichever phase sent the reply.
+ * The slowest requests since reset are kept as exemplars, with the caller
+ * and the size of the request payload.
+ */
+class MethodLatency
+{
+public:
+	static const unsigned ExemplarCount = 5;
+
+	/* Stats for the category method a message was sent to, created on
+	 * first use.  As with Metrics, the reference is stable. */
+	static MethodLatency& Get(MojServiceMessage *msg);
+
+	/* Every method's latency, keyed by "<category>/<method>" */
+	static MojErr AllToJson(MojObject& rep);
+	static void ResetAll();
+
+	MojErr ToJson(MojObject& rep) const;
+	void Reset();
+
+protected:
+	friend class MethodTimer;
+	friend class MethodFinishTimer;
+
+	MethodLatency(const std::string& name);
+
+	struct Exemplar {
+		MojInt64	m_total;
+		MojInt64	m_handler;
+		MojInt64	m_persist;
+		time_t		m_when;
+		std::string	m_caller;
+		size_t		m_payloadSize;
+	};
+
+	void Completed(MojServiceMessage *msg, const MojObject& payload,
+		MojInt64 total, MojInt64 handler, MojInt64 persist);
+
+	MetricsCounter&		m_calls;
+
+	LatencyHistogram	m_handler;
+	LatencyHistogram	m_persist;
+	LatencyHistogram	m_finish;
+	LatencyHistogram	m_total;
+
+	/* Slowest first */
+	std::vector<Exemplar>	m_exemplars;
+
+	typedef std::map<std::string, MethodLatency *> MethodMap;
+
+	static MethodMap	s_methods;
+};
+
+/* Timing of a request whose reply may be deferred to a completion.  The
+ * completion that holds the message holds this as well, so it lasts
+ * exactly as long as the request can still be answered. */
+struct MethodPending {
+	MethodLatency		*m_method;
+	MojServiceMessage	*m_msg;			/* Only compared, never used */
+	MojInt64			m_received;
+	MojInt64			m_handled;		/* 0 unless the reply was deferred */
+};
+
+/* Times a service method from entry until it returns or throws */
+class MethodTimer
+{
+public:
+	MethodTimer(MethodLatency& method, MojServiceMessage *msg,
+		const MojObject& payload);
+	~MethodTimer();
+
+	/* Timing of "msg", if it is the request being handled now, for a
+	 * completion that may send its reply later.  Empty otherwise. */
+	static boost::shared_ptr<MethodPending> Capture(MojServiceMessage *msg);
+
+protected:
+	MethodLatency&		m_method;
+	MojServiceMessage	*m_msg;
+	const MojObject&	m_payload;
+	MojInt64			m_start;
+
+	boost::shared_ptr<MethodPending>	m_pending;
+
+	MethodTimer			*m_outer;
+	static MethodTimer	*s_current;
+};
+
+/* Times the completion of a request deferred by its MethodTimer.  The
+ * completion makes the timing it captured available through a Scope
+ * around its callback. */
+class MethodFinishTimer
+{
+public:
+	MethodFinishTimer(MojServiceMessage *msg, const MojObject& payload);
+	~MethodFinishTimer();
+
+	class Scope
+	{
+	public:
+		Scope(const boost::shared_ptr<MethodPending>& pending);
+		~Scope();
+
+	protected:
+		MethodPending	*m_outer;
+	};
+
+protected:
+	MojServiceMessage	*m_msg;
+	const MojObject&	m_payload;
+	MojInt64			m_start;
+
+	MethodPending		*m_pending;
+
+	static MethodPending	*s_finishing;
+};
+
+#endif /* __ACTIVITYMANAGER_METHODLATENCY_H__ */
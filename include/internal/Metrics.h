@@ -0,0 +1,143 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_METRICS_H__
+#define __ACTIVITYMANAGER_METRICS_H__
+
+#include "Base.h"
+
+#include <map>
+#include <string>
+
+#include <core/MojObject.h>
+#include <core/MojServiceMessage.h>
+
+/*
+ * Lightweight in-process metrics.  Metrics are created by name on first
+ * use and live for the life of the daemon, so call sites look them up once
+ * and keep the reference:
+ *
+ *   static MetricsCounter& s_fired = Metrics::GetCounter("triggers.fired");
+ *   s_fired.Increment();
+ *
+ * Updating a metric is a couple of integer operations.  Everything is
+ * reported by "info" when called with "metrics": true, and zeroed by
+ * devel/resetMetrics.
+ */
+class MetricsCounter
+{
+public:
+	MetricsCounter() : m_value(0) {}
+
+	void Increment(unsigned long long n = 1) { m_value += n; }
+	unsigned long long GetValue() const { return m_value; }
+
+	void Reset() { m_value = 0; }
+
+protected:
+	unsigned long long	m_value;
+};
+
+/* Current level of something, plus the highest level seen since reset */
+class MetricsGauge
+{
+public:
+	MetricsGauge() : m_value(0), m_high(0) {}
+
+	void Set(MojInt64 value)
+	{
+		m_value = value;
+		if (value > m_high) {
+			m_high = value;
+		}
+	}
+
+	void Add(MojInt64 delta) { Set(m_value + delta); }
+
+	MojInt64 GetValue() const { return m_value; }
+	MojInt64 GetHigh() const { return m_high; }
+
+	/* The level itself is still current; only the watermark restarts */
+	void Reset() { m_high = m_value; }
+
+protected:
+	MojInt64	m_value;
+	MojInt64	m_high;
+};
+
+/* Latency histogram with fixed millisecond buckets (1, 2, 5, ... 60000,
+ * and everything above).  Samples are in microseconds. */
+class MetricsHistogram
+{
+public:
+	static const unsigned BucketCount = 16;
+
+	MetricsHistogram();
+
+	void Observe(MojInt64 us);
+
+	unsigned long long GetCount() const { return m_count; }
+
+	void Reset();
+
+	MojErr ToJson(MojObject& rep) const;
+
+protected:
+	static const MojInt64	BucketLimits[BucketCount - 1];
+
+	unsigned long long	m_buckets[BucketCount];
+	unsigned long long	m_count;
+	MojInt64			m_sum;
+	MojInt64			m_max;
+};
+
+class Metrics
+{
+public:
+	static MetricsCounter& GetCounter(const std::string& name);
+	static MetricsGauge& GetGauge(const std::string& name);
+	static MetricsHistogram& GetHistogram(const std::string& name);
+
+	/* "<category>/<method>" a request was sent to; "/create",
+	 * "/devel/run", ... */
+	static std::string GetMethodName(MojServiceMessage *msg);
+
+	/* Monotonic time in microseconds, for measuring latencies */
+	static MojInt64 Now();
+
+	/* Counters are reported with their rate since the last reset */
+	static MojErr ToJson(MojObject& rep);
+
+	/* Zero every metric.  Metrics are never removed, so references held by
+	 * call sites stay valid. */
+	static void Reset();
+
+protected:
+	typedef std::map<std::string, MetricsCounter>	CounterMap;
+	typedef std::map<std::string, MetricsGauge>		GaugeMap;
+	typedef std::map<std::string, MetricsHistogram>	HistogramMap;
+
+	static CounterMap	s_counters;
+	static GaugeMap		s_gauges;
+	static HistogramMap	s_histograms;
+
+	static MojInt64		s_resetTime;
+};
+
+#endif /* __ACTIVITYMANAGER_METRICS_H__ */
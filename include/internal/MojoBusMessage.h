@@ -0,0 +1,87 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_MOJOBUSMESSAGE_H__
+#define __ACTIVITYMANAGER_MOJOBUSMESSAGE_H__
+
+#include "Base.h"
+
+#include <core/MojServiceMessage.h>
+#include <core/MojServiceRequest.h>
+
+/*
+ * Bus routing details for messages that don't come from the Luna Bus.
+ * Implemented alongside MojServiceMessage by in-process stand-ins for the
+ * bus (see loadtest/), so the same caller identification and error
+ * classification paths can be exercised without a hub.
+ */
+class LocalBusMessage
+{
+public:
+	virtual ~LocalBusMessage() {}
+
+	virtual bool IsPublic() const = 0;
+
+	virtual const MojChar *GetAppId() const = 0;
+	virtual const MojChar *GetSenderId() const = 0;
+	virtual const MojChar *GetSenderAddress() const = 0;
+
+	/* For replies, bus-level failures are reported the same way the hub
+	 * reports them: LUNABUS_ERROR_CATEGORY and one of the
+	 * LUNABUS_ERROR_* method names. */
+	virtual const MojChar *GetCategory() const = 0;
+	virtual const MojChar *GetMethod() const = 0;
+};
+
+/*
+ * Outgoing requests for in-process stand-ins for the bus.  The plain
+ * MojService::createRequest() has no way to say which bus a request goes
+ * out on or whom it is made on behalf of, so a stand-in that can carry
+ * those implements this as well; MojoCall refuses to make such requests
+ * through a service that doesn't.
+ */
+class LocalBusService
+{
+public:
+	virtual ~LocalBusService() {}
+
+	/* "proxyRequester" may be NULL */
+	virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut,
+		bool usePublicBus, const MojChar *proxyRequester) = 0;
+};
+
+/*
+ * Accessors that work for either a MojLunaMessage or a LocalBusMessage.
+ * All but IsBusMessage() throw if the message is neither.
+ */
+class MojoBusMessage
+{
+public:
+	static bool IsBusMessage(MojServiceMessage *msg);
+
+	static bool IsPublic(MojServiceMessage *msg);
+
+	static const MojChar *GetAppId(MojServiceMessage *msg);
+	static const MojChar *GetSenderId(MojServiceMessage *msg);
+	static const MojChar *GetSenderAddress(MojServiceMessage *msg);
+
+	static const MojChar *GetCategory(MojServiceMessage *msg);
+	static const MojChar *GetMethod(MojServiceMessage *msg);
+};
+
+#endif /* __ACTIVITYMANAGER_MOJOBUSMESSAGE_H__ */
@@ -47,6 +47,9 @@ protected:
 	MojoURL		m_url;
 	MojObject	m_params;
 
+	/* When the outstanding call was made (Metrics::Now()) */
+	MojInt64	m_called;
+
 	boost::shared_ptr<MojoWeakPtrCall<MojoCallback> >	m_call;
 };
 
@@ -52,8 +52,6 @@ public:
 	static BusId GetBusId(MojServiceMessage *msg);
 	static BusId GetBusId(MojRefCountedPtr<MojServiceMessage> msg);
 
-	static void FixAppId(std::string& appId);
-
 protected:
 	virtual void HandleCancel();
 
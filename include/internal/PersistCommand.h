@@ -69,12 +69,24 @@ protected:
 	void Complete(bool success);
 	void Validate(bool checkTokenValid) const;
 
+	/* Subclass implementations call this as they issue the command to the
+	 * store, so it is timed and counted as outstanding until it completes
+	 * or is destroyed. */
+	void Issued();
+
 protected:
 	boost::shared_ptr<Activity>		m_activity;
 	boost::shared_ptr<Completion>	m_completion;
 
 	boost::shared_ptr<PersistCommand>	m_next;
 
+	/* When the command was issued to the store (Metrics::Now()), or 0 if
+	 * it never was; used to report persist latency on completion. */
+	MojInt64	m_issued;
+
+	/* Set while the command is counted in "persist.outstanding" */
+	bool		m_counted;
+
 	static MojLogger	s_log;
 };
 
@@ -20,17 +20,18 @@
 #define __ACTIVITYMANAGER_POWERDPOWERACTIVITY_H__
 
 #include "PowerActivity.h"
-#include "Timeout.h"
 
-class MojoCall;
 class PowerManager;
+class PowerdPowerLock;
 
+/* An Activity's hold on the PowerdPowerLock shared by every powered
+ * Activity */
 class PowerdPowerActivity : public PowerActivity
 {
 public:
 	PowerdPowerActivity(boost::shared_ptr<PowerManager> manager,
-		boost::shared_ptr<Activity> activity, MojService *service,
-		unsigned long serial);
+		boost::shared_ptr<Activity> activity,
+		boost::shared_ptr<PowerdPowerLock> lock, unsigned long serial);
 	virtual ~PowerdPowerActivity();
 
 	virtual PowerState GetPowerState() const;
@@ -41,34 +42,21 @@ public:
 	unsigned long GetSerial() const;
 
 protected:
-	void PowerLockedNotification(MojServiceMessage *msg,
-		const MojObject& response, MojErr err);
-	void PowerUnlockedNotification(MojServiceMessage *msg,
-		const MojObject& response, MojErr err, bool debounce);
-	void PowerUnlockedNotificationNormal(MojServiceMessage *msg,
-		const MojObject& response, MojErr err);
-	void PowerUnlockedNotificationDebounce(MojServiceMessage *msg,
-		const MojObject& response, MojErr err);
+	friend class PowerdPowerLock;
 
-	void TimeoutNotification();
+	/* Called by the PowerdPowerLock */
+	void LockAcquired();
+	void LockReleased();
 
-	std::string GetRemotePowerActivityName() const;
-
-	MojErr CreateRemotePowerActivity(bool debounce = false);
-	MojErr RemoveRemotePowerActivity();
-
-	static const int	PowerActivityLockDuration;			/* 300 */
-	static const int	PowerActivityLockUpdateInterval;	/* 240 */
-	static const int	PowerActivityDebounceDuration;		/* 12 */
-
-	MojService		*m_service;
+	boost::shared_ptr<PowerdPowerLock>	m_lock;
 
 	unsigned long	m_serial;
 	PowerState		m_currentState;
 	PowerState		m_targetState;
 
-	boost::shared_ptr<MojoCall>	m_call;
-	boost::shared_ptr<Timeout<PowerdPowerActivity> >	m_timeout;
+	/* When the lock was first requested (Metrics::Now()), until powerd
+	 * confirms it */
+	MojInt64		m_lockRequested;
 };
 
 #endif /* __ACTIVITYMANAGER_POWERDPOWERACTIVITY_H__ */
@@ -0,0 +1,135 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_POWERDPOWERLOCK_H__
+#define __ACTIVITYMANAGER_POWERDPOWERLOCK_H__
+
+#include "Base.h"
+#include "Timeout.h"
+
+#include <ctime>
+#include <vector>
+
+#include <core/MojObject.h>
+#include <core/MojService.h>
+
+class MojoCall;
+class PowerdPowerActivity;
+
+/*
+ * The one powerd activity that keeps the device awake for every powered
+ * Activity.  Each PowerdPowerActivity holds a reference to it; powerd is
+ * asked to lock when the first holder arrives, to renew (once, for
+ * everyone) while any holder remains, and to unlock when the last one
+ * leaves.
+ *
+ * Holders are told they are locked once powerd confirms the lock, which is
+ * immediately if it already has.  A holder that leaves while others remain
+ * is told it is unlocked immediately; the last to leave is told once powerd
+ * confirms.  A holder that asks to debounce wants power kept on for a
+ * while after it leaves (PowerActivityDebounceDuration seconds, or as long
+ * as the DebouncePredictor picks); if that is still running when the last
+ * holder leaves, the lock is shortened to what is left of it rather than
+ * removed.
+ *
+ * Without ACTIVITYMANAGER_RENEW_POWER_ACTIVITIES, the lock is only renewed
+ * when a holder has arrived since it was last requested.  Renewals come
+ * PowerActivityLockUpdateInterval seconds after each request, ahead of
+ * the lock's expiry, so a holder that joins a held lock keeps power for
+ * at least PowerActivityLockDuration from when it arrived, as it would
+ * with a lock of its own.  Holders already there share that renewal, so
+ * while newcomers keep arriving, an early holder can keep power for
+ * longer than PowerActivityLockDuration.
+ */
+class PowerdPowerLock : public boost::enable_shared_from_this<PowerdPowerLock>
+{
+public:
+	PowerdPowerLock(MojService *service);
+	virtual ~PowerdPowerLock();
+
+	void Acquire(boost::shared_ptr<PowerdPowerActivity> holder);
+	void Release(boost::shared_ptr<PowerdPowerActivity> holder,
+		bool debounce);
+
+	MojErr ToJson(MojObject& rep) const;
+
+	static const int	PowerActivityLockDuration;			/* 300 */
+	static const int	PowerActivityLockUpdateInterval;	/* 240 */
+	static const int	PowerActivityDebounceDuration;		/* 12 */
+
+protected:
+	enum RemoteState {
+		RemoteUnlocked,
+		RemoteLocking,
+		RemoteLocked,
+		RemoteUnlocking
+	};
+
+	typedef std::vector<boost::weak_ptr<PowerdPowerActivity> > HolderVec;
+
+	/* Issue whatever call brings powerd in line with the holders, unless a
+	 * call is already in flight; its response will call this again. */
+	void Sync();
+
+	MojErr IssueLock();
+	MojErr IssueUnlock();
+
+	void LockResponse(MojServiceMessage *msg, const MojObject& response,
+		MojErr err);
+	void UnlockResponse(MojServiceMessage *msg, const MojObject& response,
+		MojErr err);
+
+	void RenewTimeout();
+
+	void NotifyLocked();
+	void NotifyUnlocked();
+
+	static bool Remove(HolderVec& holders,
+		boost::shared_ptr<PowerdPowerActivity> holder);
+
+	static const char *RemoteStateToString(RemoteState state);
+
+	MojService		*m_service;
+
+	RemoteState		m_remoteState;
+	unsigned		m_holders;
+
+	/* Waiting for powerd to confirm a lock or unlock */
+	HolderVec		m_locking;
+	HolderVec		m_unlocking;
+
+	/* Whether a holder arrived since powerd was last asked to lock */
+	bool			m_acquiredSinceLock;
+
+	/* Monotonic time until which a debouncing holder wants power kept
+	 * on, if any does */
+	bool			m_debouncing;
+	time_t			m_debounceUntil;
+
+	/* Calls made to powerd, and calls one powerd activity per Activity
+	 * would have made on top of them */
+	unsigned long long	m_calls;
+	unsigned long long	m_callsSaved;
+
+	boost::shared_ptr<MojoCall>	m_call;
+	boost::shared_ptr<Timeout<PowerdPowerLock> >	m_timeout;
+
+	static const char	*RemotePowerActivityName;
+};
+
+#endif /* __ACTIVITYMANAGER_POWERDPOWERLOCK_H__ */
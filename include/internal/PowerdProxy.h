@@ -22,8 +22,10 @@
 #include "Base.h"
 #include "PowerManager.h"
 #include "SortedRequirement.h"
+#include "Timeout.h"
 
 class MojoCall;
+class PowerdPowerLock;
 
 class PowerdProxy : public PowerManager
 {
@@ -48,8 +50,25 @@ public:
 	virtual boost::shared_ptr<PowerActivity> CreatePowerActivity(
 		boost::shared_ptr<Activity> activity);
 
+	virtual MojErr StatusToJson(MojObject& rep) const;
+
 	MojInt64 GetBatteryPercent() const;
 
+	/* Activities whose battery requirement stays met through a change in
+	 * the battery level are told the new level only once it has moved
+	 * "step" percent from the level they were last told, and no more often
+	 * than every "interval" seconds.  A change held back only by the
+	 * interval is sent when the interval expires, so a level that then
+	 * stops changing doesn't stay stale.  Requirements are always met or
+	 * unmet as soon as the level crosses their watermark.  0 and 0 sends
+	 * every change. */
+	static void SetBatteryUpdatePolicy(unsigned step, unsigned interval);
+	static unsigned GetBatteryUpdateStep();
+	static unsigned GetBatteryUpdateInterval();
+
+	static const unsigned DefaultBatteryUpdateStep = 5;
+	static const unsigned DefaultBatteryUpdateInterval = 60;
+
 protected:
 	void TriggerChargerStatus();
 	void TriggerBatteryStatus();
@@ -67,6 +86,9 @@ protected:
 	void BatteryStatusSignal(MojServiceMessage *msg,
 		const MojObject& response, MojErr err);
 
+	bool IsBatteryUpdateDue(MojInt64 batteryPercent);
+	void FlushBatteryUpdate();
+
 	boost::shared_ptr<RequirementCore>	m_chargingRequirementCore;
 	boost::shared_ptr<RequirementCore>	m_dockedRequirementCore;
 
@@ -104,8 +126,22 @@ protected:
 	BatteryRequirement::MultiTable	m_batteryRequirements;
 	MojInt64		m_batteryPercent;
 
+	/* Level and (monotonic) time of the last update sent to met battery
+	 * requirements, if any has been sent yet */
+	bool			m_batteryReported;
+	MojInt64		m_batteryReportedPercent;
+	time_t			m_batteryReportedTime;
+
+	boost::shared_ptr<Timeout<PowerdProxy> >	m_batteryUpdateTimeout;
+
+	static unsigned	s_batteryUpdateStep;
+	static unsigned	s_batteryUpdateInterval;
+
 	MojService		*m_service;
 
+	/* Held on behalf of every powered Activity */
+	boost::shared_ptr<PowerdPowerLock>	m_powerLock;
+
 	unsigned long	m_serial;
 };
 
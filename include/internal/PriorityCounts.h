@@ -0,0 +1,81 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_PRIORITYCOUNTS_H__
+#define __ACTIVITYMANAGER_PRIORITYCOUNTS_H__
+
+#include "ActivityTypes.h"
+
+/*
+ * Count of members (Activities of a Bus Entity, or Entities of a Resource
+ * Container) at each priority level, kept separately for focused and
+ * unfocused members.  The aggregate is what sorting all the members would
+ * give: the highest priority among the focused ones if there are any,
+ * otherwise among all of them.  Adding or removing a member is O(1), and
+ * reading the aggregate is a scan of the (six) levels.
+ */
+class PriorityCounts
+{
+public:
+	PriorityCounts()
+	{
+		for (unsigned i = 0; i < 2; i++) {
+			m_totals[i] = 0;
+			for (unsigned j = 0; j < MaxActivityPriority; j++) {
+				m_counts[i][j] = 0;
+			}
+		}
+	}
+
+	void Add(ActivityPriority_t priority, bool focused)
+	{
+		m_counts[focused ? 1 : 0][priority]++;
+		m_totals[focused ? 1 : 0]++;
+	}
+
+	void Remove(ActivityPriority_t priority, bool focused)
+	{
+		unsigned row = focused ? 1 : 0;
+		if (m_counts[row][priority]) {
+			m_counts[row][priority]--;
+			m_totals[row]--;
+		}
+	}
+
+	/* ActivityPriorityNone if there are no members */
+	ActivityPriority_t GetPriority() const
+	{
+		unsigned row = m_totals[1] ? 1 : 0;
+		for (int i = MaxActivityPriority - 1; i > ActivityPriorityNone; i--) {
+			if (m_counts[row][i]) {
+				return (ActivityPriority_t)i;
+			}
+		}
+
+		return ActivityPriorityNone;
+	}
+
+	bool IsFocused() const { return m_totals[1] != 0; }
+	bool IsEmpty() const { return !m_totals[0] && !m_totals[1]; }
+
+protected:
+	unsigned	m_counts[2][MaxActivityPriority];
+	unsigned	m_totals[2];
+};
+
+#endif /* __ACTIVITYMANAGER_PRIORITYCOUNTS_H__ */
@@ -0,0 +1,76 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_PROBES_H__
+#define __ACTIVITYMANAGER_PROBES_H__
+
+/*
+ * Static tracepoints (USDT) on the Activity lifecycle and scheduling paths,
+ * for attaching perf or bpftrace to a production build:
+ *
+ *   bpftrace -e 'usdt:/usr/sbin/activitymanager:activitymanager:persist_complete
+ *       { @us[arg1] = hist(arg2); }'
+ *
+ * Probes are only built when configured with -DACTIVITYMANAGER_ENABLE_USDT=ON
+ * (which needs <sys/sdt.h>).  Otherwise they compile away and their
+ * arguments are never evaluated.  When built in, an unattached probe is a
+ * single nop, so arguments must stay cheap to compute.
+ *
+ * Provider "activitymanager".  Activity ids are always the first argument;
+ * times are microseconds unless noted.
+ *
+ *   activity_schedule(id)
+ *   activity_run(id)
+ *   activity_end(id, requeue)
+ *   activity_ready(id, queue)              queue: ActivityManager::RunQueueId
+ *   check_ready_queue(startedInteractive, startedBackground, running)
+ *   schedule_due(id, startTime, curTime)   seconds since the epoch
+ *   trigger_fire(id)
+ *   callback_call(id, serial)
+ *   callback_response(id, serial, err, latency)
+ *   persist_issue(id)
+ *   persist_complete(id, success, latency)
+ *   power_begin(id, serial)
+ *   power_end(id, serial, debounce)
+ *   power_locked(id, serial, latency)
+ */
+
+#ifdef ACTIVITYMANAGER_USDT
+
+#include <sys/sdt.h>
+
+#define AM_PROBE1(name, a1) \
+	DTRACE_PROBE1(activitymanager, name, a1)
+#define AM_PROBE2(name, a1, a2) \
+	DTRACE_PROBE2(activitymanager, name, a1, a2)
+#define AM_PROBE3(name, a1, a2, a3) \
+	DTRACE_PROBE3(activitymanager, name, a1, a2, a3)
+#define AM_PROBE4(name, a1, a2, a3, a4) \
+	DTRACE_PROBE4(activitymanager, name, a1, a2, a3, a4)
+
+#else
+
+#define AM_PROBE1(name, a1) do {} while (0)
+#define AM_PROBE2(name, a1, a2) do {} while (0)
+#define AM_PROBE3(name, a1, a2, a3) do {} while (0)
+#define AM_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+
+#endif /* ACTIVITYMANAGER_USDT */
+
+#endif /* __ACTIVITYMANAGER_PROBES_H__ */
@@ -0,0 +1,69 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_PROCESSPOLICYGROUP_H__
+#define __ACTIVITYMANAGER_PROCESSPOLICYGROUP_H__
+
+#include "ResourceContainer.h"
+
+#include <map>
+
+class ProcessPolicyManager;
+
+class ProcessPolicyGroup : public ResourceContainer
+{
+public:
+	ProcessPolicyGroup(const std::string& name,
+		boost::shared_ptr<ProcessPolicyManager> manager);
+	virtual ~ProcessPolicyGroup();
+
+	virtual void UpdatePriority();
+	virtual void MapProcess(pid_t pid);
+	virtual void GetProcessIds(std::set<int>& pids) const;
+
+	virtual void Enable();
+	virtual void Disable();
+
+	virtual MojErr ToJson(MojObject& rep) const;
+
+	/* Drop "pid", which is being mapped into another container, restoring
+	 * its original value */
+	void ReleaseProcess(pid_t pid);
+
+	static const int Unapplied;
+
+protected:
+	boost::shared_ptr<ProcessPolicyManager> GetPolicyManager() const;
+
+	/* Bring every process to m_value.  Processes that are gone are
+	 * dropped. */
+	void ApplyAll();
+
+	/* Give every process its original value back */
+	void RestoreAll();
+
+	/* Value the container's processes should have, or Unapplied */
+	int		m_value;
+
+	/* Value each process last received */
+	typedef std::map<int, int> ProcessValueMap;
+	ProcessValueMap	m_processes;
+};
+
+#endif /* __ACTIVITYMANAGER_PROCESSPOLICYGROUP_H__ */
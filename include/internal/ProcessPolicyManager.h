@@ -0,0 +1,138 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef __ACTIVITYMANAGER_PROCESSPOLICYMANAGER_H__
+#define __ACTIVITYMANAGER_PROCESSPOLICYMANAGER_H__
+
+#include "ContainerManager.h"
+
+#include <map>
+
+/*
+ * Container Manager that sets a per-process policy from the same
+ * effective priority and focus the CPU containers use:
+ *
+ * - PolicyIo sets the I/O scheduling class and level of every thread with
+ *   ioprio_set().  Focused containers get best-effort level 0, lowest
+ *   containers best-effort level 7.
+ * - PolicyMemory writes /proc/<pid>/oom_score_adj, so background services
+ *   are killed before the foreground when memory runs out.
+ *
+ * It is registered with the Master Resource Manager as "io" or "memory",
+ * and linked to the CPU Container Manager so it sees the same mappings.
+ * Only changes cost syscalls: each container remembers the value it last
+ * applied, and each process the value it last received.
+ *
+ * A process's own value is read before it is first changed.  It gets
+ * that value back while the manager is disabled, and when it is mapped
+ * into another container, before that container applies its own.  A
+ * process that started with a negative oom_score_adj (the compositor,
+ * say) or in the real-time I/O class is never changed.
+ *
+ * The process's start time is read along with its value.  A pid whose
+ * start time has changed was reused by a new process after the old one
+ * exited; the old process is forgotten rather than its value written to
+ * the new one.
+ */
+class ProcessPolicyManager : public ContainerManager
+{
+public:
+	enum Policy {
+		PolicyIo,
+		PolicyMemory
+	};
+
+	ProcessPolicyManager(Policy policy,
+		boost::shared_ptr<MasterResourceManager> master);
+	virtual ~ProcessPolicyManager();
+
+	virtual boost::shared_ptr<ResourceContainer> CreateContainer(
+		const std::string& name);
+
+	virtual ActivityPriority_t GetDefaultPriority() const;
+	virtual ActivityPriority_t GetDisabledPriority() const;
+
+	virtual MojErr InfoToJson(MojObject& rep) const;
+
+	Policy GetPolicy() const;
+	const char *GetPolicyName() const;
+
+	/* Key the value is reported under: "ioPriority" or "oomScoreAdj" */
+	const char *GetValueName() const;
+
+	/* Encoded ioprio, or oom_score_adj, for the class */
+	int GetValue(ActivityPriority_t priority, bool focused) const;
+
+	MojErr ValueToJson(MojObject& rep, int value) const;
+
+	/* Returns false if the process no longer exists */
+	bool Apply(pid_t pid, int value) const;
+
+	/* The value "pid" had before anything here changed it, read the first
+	 * time it is asked for.  Returns false if the process no longer
+	 * exists, including if its pid has been reused. */
+	bool GetOriginal(pid_t pid, int& original);
+
+	/* False if the process whose original value was read for "pid" has
+	 * exited and the pid now belongs to another */
+	bool IsSameProcess(pid_t pid) const;
+
+	/* True if a process that started with "original" must be left alone */
+	bool IsExempt(int original) const;
+
+	/* Give "pid" its original value back.  Returns false if the process
+	 * no longer exists, which also forgets it. */
+	bool Restore(pid_t pid);
+
+	/* "pid" is being mapped into "container".  If another container had
+	 * it, that one restores it and lets it go. */
+	void ClaimProcess(pid_t pid, const std::string& container);
+
+	/* "pid" has exited */
+	void ForgetProcess(pid_t pid);
+
+	/* In clock ticks since boot.  Returns false if the process no longer
+	 * exists. */
+	static bool GetStartTime(pid_t pid, unsigned long long& start);
+
+protected:
+	static bool SetIoPriority(pid_t pid, int ioprio);
+	static bool SetOomScoreAdj(pid_t pid, int adj);
+
+	static bool GetIoPriority(pid_t pid, int& ioprio);
+	static bool GetOomScoreAdj(pid_t pid, int& adj);
+
+	Policy	m_policy;
+
+	struct ProcessState {
+		ProcessState();
+
+		std::string	m_container;
+		int			m_original;
+		bool		m_hasOriginal;
+
+		/* Start time of the process the original was read from */
+		unsigned long long	m_startTime;
+	};
+
+	typedef std::map<int, ProcessState> ProcessStateMap;
+	ProcessStateMap	m_processStates;
+};
+
+#endif /* __ACTIVITYMANAGER_PROCESSPOLICYMANAGER_H__ */
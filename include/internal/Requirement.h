@@ -45,9 +45,15 @@ public:
 
 	virtual const std::string& GetName() const = 0;
 
+	/* Index of the name in the flight recorder's requirement table, looked
+	 * up on first use rather than on every transition */
+	MojUInt16 GetFlightCode();
+
 	virtual MojErr ToJson(MojObject& rep, unsigned flags) const = 0;
 
 protected:
+	static const MojUInt16 FlightCodeUnresolved = 0xffff;
+
 	typedef boost::intrusive::list_member_hook<
 		boost::intrusive::link_mode<
 			boost::intrusive::auto_unlink> >	RequirementListItem;
@@ -57,7 +63,8 @@ protected:
 
 	boost::weak_ptr<Activity>	m_activity;
 
-	bool	m_met;
+	MojUInt16	m_flightCode;
+	bool		m_met;
 };
 
 class ListedRequirement : public Requirement
@@ -24,6 +24,7 @@
 
 #include <set>
 #include <map>
+#include <vector>
 
 class Activity;
 class MasterRequirementManager;
@@ -50,7 +51,28 @@ public:
 	virtual void Enable();
 	virtual void Disable();
 
+	/* Add anything worth reporting through "info" to "rep" */
+	virtual MojErr StatusToJson(MojObject& rep) const;
+
+	/* Requirement transitions made while a batch is open only update each
+	 * Activity's bookkeeping.  When the outermost batch commits, each
+	 * affected Activity is re-evaluated once and generates one update
+	 * event, and the ready queue is checked once for the lot.  Batches
+	 * nest.  The batch is process-wide; prefer RequirementBatch, which
+	 * commits even if a transition throws. */
+	static void BeginBatch();
+	static void CommitBatch();
+	static bool IsBatching();
+
+	/* Called by Activities with a transition pending in the open batch */
+	static void AddToBatch(boost::shared_ptr<Activity> activity);
+
 protected:
+	typedef std::vector<boost::shared_ptr<Activity> > ActivityVec;
+
+	static unsigned		s_batchDepth;
+	static ActivityVec	s_batchActivities;
+
 	typedef boost::intrusive::member_hook<ListedRequirement,
 		ListedRequirement::RequirementListItem,
 		&ListedRequirement::m_managerListItem> RequirementListOption;
@@ -78,6 +100,8 @@ public:
 	virtual void Enable();
 	virtual void Disable();
 
+	virtual MojErr StatusToJson(MojObject& rep) const;
+
 	virtual void AddManager(boost::shared_ptr<RequirementManager> manager);
 	virtual void RemoveManager(boost::shared_ptr<RequirementManager> manager);
 
@@ -92,4 +116,15 @@ protected:
 	static MojLogger	s_log;
 };
 
+class RequirementBatch
+{
+public:
+	RequirementBatch() { RequirementManager::BeginBatch(); }
+	~RequirementBatch() { RequirementManager::CommitBatch(); }
+
+private:
+	RequirementBatch(const RequirementBatch& copy);
+	RequirementBatch& operator=(const RequirementBatch& copy);
+};
+
 #endif /* __ACTIVITYMANAGER_REQUIREMENTMANAGER_H__ */
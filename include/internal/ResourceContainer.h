@@ -21,7 +21,9 @@
 
 #include "Base.h"
 #include "ActivityTypes.h"
+#include "PriorityCounts.h"
 
+#include <map>
 #include <set>
 
 class BusEntity;
@@ -37,11 +39,18 @@ public:
 	void AddEntity(boost::shared_ptr<BusEntity> entity);
 	void RemoveEntity(boost::shared_ptr<BusEntity> entity);
 
+	/* Recount an Entity whose priority or focus changed.  Returns true if
+	 * that changed the priority or focus of the container. */
+	bool UpdateEntity(boost::shared_ptr<BusEntity> entity);
+
 	const std::string& GetName() const;
 
 	virtual void UpdatePriority() = 0;
 	virtual void MapProcess(pid_t pid) = 0;
 
+	/* Add the processes mapped into the container */
+	virtual void GetProcessIds(std::set<int>& pids) const;
+
 	ActivityPriority_t GetPriority() const;
 	bool IsFocused() const;
 
@@ -53,13 +62,18 @@ public:
 	void PushJson(MojObject& array) const;
 
 protected:
-	static bool EntityPriorityCompare(const boost::shared_ptr<BusEntity>& x,
-		const boost::shared_ptr<BusEntity>& y);
+	/* What an Entity is currently counted as in m_counts */
+	struct EntityLevel {
+		ActivityPriority_t	m_priority;
+		bool				m_focused;
+	};
 
-	typedef std::set<boost::shared_ptr<BusEntity> > EntitySet;
+	typedef std::map<boost::shared_ptr<BusEntity>, EntityLevel> EntityMap;
 
 	/* A service might use multiple names on the bus */
-	EntitySet	m_entities;
+	EntityMap	m_entities;
+
+	PriorityCounts	m_counts;
 
 	std::string	m_name;
 
@@ -20,8 +20,11 @@
 #define __ACTIVITYMANAGER_RESOURCEMANAGER_H__
 
 #include "Base.h"
+#include "CostAccountant.h"
+#include "Timeout.h"
 
 #include <map>
+#include <set>
 
 class Activity;
 class BusId;
@@ -35,6 +38,15 @@ public:
 
 	virtual void InformEntityUpdated(boost::shared_ptr<BusEntity> entity) = 0;
 
+	/* A focused or immediate Activity started running, or the last one
+	 * stopped.  Ignored unless overridden. */
+	virtual void InformForegroundChanged(bool active);
+
+	/* Add the processes the manager has mapped for the Entity.  None
+	 * unless overridden. */
+	virtual void GetProcesses(boost::shared_ptr<BusEntity> entity,
+		std::set<int>& pids) const;
+
 	virtual void Enable() = 0;
 	virtual void Disable() = 0;
 	virtual bool IsEnabled() const = 0;
@@ -65,6 +77,10 @@ public:
 	boost::shared_ptr<BusEntity> GetEntity(const BusId& id);
 
 	virtual void InformEntityUpdated(boost::shared_ptr<BusEntity> entity);
+	virtual void InformForegroundChanged(bool active);
+
+	virtual void GetProcesses(boost::shared_ptr<BusEntity> entity,
+		std::set<int>& pids) const;
 
 	virtual void Enable();
 	virtual void Disable();
@@ -72,7 +88,22 @@ public:
 
 	virtual MojErr InfoToJson(MojObject& rep) const;
 
+	/* CPU and I/O cost of the Activity's current run, and the history of
+	 * its name, as sampled from the processes of its subscribers */
+	MojErr CostToJson(boost::shared_ptr<Activity> activity,
+		MojObject& rep) const;
+	const CostAccountant& GetCosts() const;
+
+	static const unsigned CostSampleInterval = 10;
+
 protected:
+	void BeginCost(boost::shared_ptr<Activity> activity);
+	void EndCost(boost::shared_ptr<Activity> activity);
+	void SampleCosts();
+	void GetCostProcesses(CostAccountant::ProcessMap& processes);
+	void GetActivityProcesses(boost::shared_ptr<Activity> activity,
+		std::set<int>& pids) const;
+
 	typedef std::map<std::string, boost::shared_ptr<ResourceManager> >
 		ResourceManagerMap;
 	typedef std::map<BusId, boost::shared_ptr<BusEntity> > EntityMap;
@@ -81,6 +112,15 @@ protected:
 	EntityMap			m_entities;
 
 	bool	m_enabled;
+	bool	m_foreground;
+
+	typedef std::map<activityId_t, boost::weak_ptr<Activity> > ActivityMap;
+
+	/* Activities whose cost is being accounted */
+	ActivityMap			m_costActivities;
+	CostAccountant		m_costs;
+
+	boost::shared_ptr<Timeout<MasterResourceManager> >	m_costTimeout;
 
 	static MojLogger	s_log;
 };
@@ -37,7 +37,7 @@ class PersistProxy;
 class MasterRequirementManager;
 class MasterResourceManager;
 class PowerManager;
-class ControlGroupManager;
+class ContainerManager;
 class LunaBusProxy;
 
 class ActivityManagerApp : public MojReactorApp<MojGmainReactor>
@@ -70,7 +70,7 @@ private:
 	boost::shared_ptr<MojoJsonConverter>	m_json;
 	boost::shared_ptr<PersistProxy>			m_db;
 	boost::shared_ptr<PowerManager>			m_powerManager;
-	boost::shared_ptr<ControlGroupManager>	m_controlGroupManager;
+	boost::shared_ptr<ContainerManager>	m_containerManager;
 #ifndef TARGET_DESKTOP
 	boost::shared_ptr<LunaBusProxy>			m_busProxy;
 #endif
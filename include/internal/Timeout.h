@@ -20,7 +20,7 @@
 #define __ACTIVITYMANAGER_TIMEOUT_H__
 
 #include "Base.h"
-#include "glib.h"
+#include "Clock.h"
 
 class TimeoutBase
 {
@@ -28,15 +28,21 @@ public:
 	TimeoutBase(unsigned seconds);
 	virtual ~TimeoutBase();
 
+	/* Arming an armed Timeout moves it rather than adding another timer */
 	void Arm();
+	void Arm(unsigned seconds);
 	void Cancel();
 
+	bool IsArmed() const;
+
+	/* Called by the Clock when the timer expires */
+	void Fire();
+
 protected:
 	virtual void WakeupTimeout() = 0;
-	static gboolean StaticWakeupTimeout(gpointer data);
 
-	unsigned	m_seconds;
-	GSource		*m_timeout;
+	unsigned		m_seconds;
+	Clock::TimerId	m_timer;
 
 	static MojLogger	s_log;
 };
@@ -0,0 +1,92 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_WORKLOADRECORDER_H__
+#define __ACTIVITYMANAGER_WORKLOADRECORDER_H__
+
+#include "Base.h"
+
+#include <cstdio>
+#include <string>
+
+#include <core/MojObject.h>
+#include <core/MojServiceMessage.h>
+
+class ActivityManager;
+class MojoURL;
+
+/*
+ * Captures the daemon's workload so it can be replayed later against the
+ * in-process bus (see loadtest/activitymanager-replay).  Two things are
+ * recorded: every request into a category handler, and every update that
+ * arrives on a subscription the daemon holds (connection status, powerd
+ * signals, db watches, ...).  One-shot replies are not recorded; the
+ * replay's stand-in services answer those themselves.
+ *
+ * The trace is one compact JSON object per line.  "t" is milliseconds
+ * since recording started:
+ *
+ *   {"k":"start","w":<epoch ms>,"a":[<Activity>, ...]}
+ *   {"k":"call","t":12,"c":"/","m":"create","s":"com.palm.app","st":1,"p":{}}
+ *   {"k":"id","t":12,"i":<activityId assigned by the preceding create>}
+ *   {"k":"signal","t":40,"u":"palm://...","q":{<params>},"p":{},"e":0}
+ *   {"k":"end","t":90,"a":[{"activityId","name","creator","state"}, ...]}
+ *
+ * "st" is the caller's BusIdType.  The start record holds the full JSON
+ * of each Activity that already existed, so the replay can recreate it;
+ * the end record holds the final state the replay is compared against.
+ *
+ * Recording is off unless started through the devel category, and costs a
+ * single test per request while off.  Traces are written to a new file in
+ * DiagnosticFile::Directory.
+ */
+class WorkloadRecorder
+{
+public:
+	/* "name" is a bare file name, which must not exist yet.  Returns
+	 * MojErrInvalidArg for a bad name and MojErrExists if it does. */
+	static MojErr Start(const std::string& name,
+		boost::shared_ptr<ActivityManager> am);
+	static MojErr Stop(boost::shared_ptr<ActivityManager> am);
+
+	static bool IsRecording() { return s_file != NULL; }
+
+	static const std::string& GetPath();
+	static unsigned long long GetRecordCount();
+
+	static void RecordCall(MojServiceMessage *msg, const MojObject& payload);
+	static void RecordActivityId(activityId_t id);
+	static void RecordSignal(const MojoURL& url, const MojObject& params,
+		const MojObject& response, MojErr err);
+
+	/* Identity and state of every Activity, as written in the end record.
+	 * If "full" is set, the complete Activity JSON is included as well. */
+	static MojErr ActivitiesToJson(boost::shared_ptr<ActivityManager> am,
+		MojObject& rep, bool full);
+
+protected:
+	static MojInt64 GetElapsed();
+	static void Write(MojObject& record);
+
+	static FILE					*s_file;
+	static std::string			s_path;
+	static MojInt64				s_start;
+	static unsigned long long	s_records;
+};
+
+#endif /* __ACTIVITYMANAGER_WORKLOADRECORDER_H__ */
@@ -0,0 +1,296 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * Drives CgroupV2Manager against a cgroup tree faked up in a temporary
+ * directory, and checks what it wrote to the control files.  The control
+ * files are regular files here, so each open writes from the start of the
+ * file; the test empties cgroup.procs and cpuset.cpus after reading them
+ * so every check only sees the writes of the step before.
+ *
+ * Usage: activitymanager-cgroupv2-test
+ *
+ * Exits non-zero, naming the first failed check, if anything is off.
+ */
+
+#include "CgroupV2Manager.h"
+#include "ResourceManager.h"
+#include "BusId.h"
+#include "Metrics.h"
+#include "VirtualClock.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ftw.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TestService = "com.palm.cgrouptest";
+
+static void Check(bool condition, const std::string& what)
+{
+	if (!condition) {
+		throw std::runtime_error(what);
+	}
+}
+
+static std::string ClassPath(const std::string& root, unsigned cls)
+{
+	if (cls == CgroupV2Manager::FocusedClass) {
+		return root + "/focused";
+	} else {
+		return root + "/unfocused/" + ActivityPriorityNames[cls];
+	}
+}
+
+static void MakeDirectory(const std::string& path)
+{
+	if ((mkdir(path.c_str(), 0755) < 0) && (errno != EEXIST)) {
+		throw std::runtime_error("Unable to create " + path + ": " +
+			strerror(errno));
+	}
+}
+
+static void WriteFile(const std::string& path, const std::string& contents)
+{
+	FILE *file = fopen(path.c_str(), "w");
+	if (!file) {
+		throw std::runtime_error("Unable to create " + path + ": " +
+			strerror(errno));
+	}
+
+	fputs(contents.c_str(), file);
+	fclose(file);
+}
+
+static std::string ReadFile(const std::string& path)
+{
+	FILE *file = fopen(path.c_str(), "r");
+	if (!file) {
+		throw std::runtime_error("Unable to read " + path + ": " +
+			strerror(errno));
+	}
+
+	std::string contents;
+	char buf[256];
+	size_t length;
+	while ((length = fread(buf, 1, sizeof(buf), file)) > 0) {
+		contents.append(buf, length);
+	}
+
+	fclose(file);
+	return contents;
+}
+
+/* What was written to a class's control file since the last call */
+static std::string TakeControl(const std::string& root, unsigned cls,
+	const char *control)
+{
+	std::string path = ClassPath(root, cls) + "/" + control;
+	std::string contents = ReadFile(path);
+	WriteFile(path, "");
+	return contents;
+}
+
+static std::string TakeProcs(const std::string& root, unsigned cls)
+{
+	return TakeControl(root, cls, "cgroup.procs");
+}
+
+/* The files the kernel would provide, with the lowest class left frozen
+ * as if by an instance that died */
+static void CreateTree(const std::string& root)
+{
+	MakeDirectory(root + "/unfocused");
+	WriteFile(root + "/cgroup.subtree_control", "");
+	WriteFile(root + "/unfocused/cgroup.subtree_control", "");
+
+	for (unsigned cls = 0; cls < CgroupV2Manager::ClassCount; cls++) {
+		std::string path = ClassPath(root, cls);
+		MakeDirectory(path);
+		WriteFile(path + "/cgroup.procs", "");
+		WriteFile(path + "/cpu.weight", "");
+		WriteFile(path + "/cpu.max", "");
+		WriteFile(path + "/cpuset.cpus", "");
+	}
+
+	WriteFile(ClassPath(root, ActivityPriorityLowest) + "/cgroup.freeze", "1");
+}
+
+static int RemoveEntry(const char *path, const struct stat *sb, int flag,
+	struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void RunTest(const std::string& root)
+{
+	CreateTree(root);
+
+	boost::shared_ptr<VirtualClock> clock =
+		boost::make_shared<VirtualClock>(1000000);
+	Clock::SetInstance(clock);
+
+	boost::shared_ptr<MasterResourceManager> master =
+		boost::make_shared<MasterResourceManager>();
+	boost::shared_ptr<CgroupV2Manager> manager =
+		boost::make_shared<CgroupV2Manager>(root, master);
+
+	MetricsCounter& moves = Metrics::GetCounter("cgroup.moves");
+
+	/* Startup */
+	Check(manager->CanFreeze(), "classes opened");
+	Check(ReadFile(root + "/cgroup.subtree_control") == "+cpu +cpuset",
+		"controllers enabled for the classes");
+	Check(ReadFile(ClassPath(root, ActivityPriorityLowest) + "/cpu.weight") ==
+		"25", "lowest class weight");
+	Check(ReadFile(ClassPath(root, ActivityPriorityLowest) + "/cpu.max") ==
+		"20000 100000", "lowest class quota");
+	Check(ReadFile(ClassPath(root, CgroupV2Manager::FocusedClass) +
+		"/cpu.weight") == "1000", "focused class weight");
+	Check(ReadFile(ClassPath(root, ActivityPriorityLowest) +
+		"/cgroup.freeze") == "0", "lowest class thawed at startup");
+	Check(TakeControl(root, ActivityPriorityLowest, "cpuset.cpus") == "\n",
+		"any stale partition cleared at startup");
+
+	/* A disabled manager puts everything at its disabled priority */
+	ContainerManager::BusIdVec ids;
+	manager->MapContainer(TestService, ids, 1001);
+	Check(TakeProcs(root, ActivityPriorityHigh) == "1001\n",
+		"first process moved to the disabled priority");
+	Check(moves.GetValue() == 1, "first move counted");
+
+	/* A second process is written alone */
+	manager->MapContainer(TestService, ids, 1002);
+	Check(TakeProcs(root, ActivityPriorityHigh) == "1002\n",
+		"only the new process moved");
+
+	/* Mapping it again costs nothing */
+	manager->MapContainer(TestService, ids, 1002);
+	Check(TakeProcs(root, ActivityPriorityHigh).empty(),
+		"remapped process not moved again");
+	Check(moves.GetValue() == 2, "no move counted for a remapping");
+
+	/* Enabling drops the container to the default priority */
+	manager->Enable();
+	Check(TakeProcs(root, ActivityPriorityLow) == "1001\n1002\n",
+		"container moved to the default priority");
+	Check(TakeProcs(root, ActivityPriorityHigh).empty(),
+		"nothing else written");
+	Check(moves.GetValue() == 4, "both processes counted");
+
+	std::list<int> pids(1, 1001);
+	Check(manager->MoveProcesses(CgroupV2Manager::FocusedClass, pids),
+		"move to the focused class");
+	Check(TakeProcs(root, CgroupV2Manager::FocusedClass) == "1001\n",
+		"process moved to the focused class");
+
+	/* The partition is rewritten in place, without moving anything */
+	const char *mode = manager->GetCpuPartitionMode();
+	Check(mode && (strcmp(mode, "cpuset") == 0), "partitioned by cpuset");
+
+	CpuPartition partition;
+	partition.m_performance = "4-7";
+	partition.m_efficiency = "0-3";
+	manager->SetCpuPartition(partition);
+	Check(TakeControl(root, CgroupV2Manager::FocusedClass, "cpuset.cpus") ==
+		"4-7", "focused class on the performance cores");
+	Check(TakeControl(root, ActivityPriorityHigh, "cpuset.cpus") == "4-7",
+		"high class on the performance cores");
+	Check(TakeControl(root, ActivityPriorityNormal, "cpuset.cpus") ==
+		"4-7,0-3", "normal class on every core");
+	Check(TakeControl(root, ActivityPriorityLow, "cpuset.cpus") == "0-3",
+		"low class on the efficiency cores");
+	Check(TakeProcs(root, ActivityPriorityLow).empty(),
+		"no process moved for a partition change");
+
+	manager->SetCpuPartition(CpuPartition());
+	Check(TakeControl(root, ActivityPriorityLow, "cpuset.cpus") == "\n",
+		"partition cleared");
+
+	/* Freezing follows the foreground, within maxFreeze and minThaw */
+	std::string freeze = ClassPath(root, ActivityPriorityLowest) +
+		"/cgroup.freeze";
+
+	ContainerManager::FreezePolicy policy;
+	policy.m_enabled = true;
+	policy.m_maxFreeze = 30;
+	policy.m_minThaw = 10;
+	manager->SetFreezePolicy(policy);
+	Check(ReadFile(freeze) == "0", "not frozen without foreground work");
+
+	manager->InformForegroundChanged(true);
+	Check(manager->IsFrozen() && (ReadFile(freeze) == "1"),
+		"frozen for foreground work");
+
+	clock->Advance();
+	Check(!manager->IsFrozen() && (ReadFile(freeze) == "0"),
+		"thawed after maxFreeze");
+
+	clock->Advance();
+	Check(manager->IsFrozen() && (ReadFile(freeze) == "1"),
+		"frozen again after minThaw");
+
+	manager->InformForegroundChanged(false);
+	Check(!manager->IsFrozen() && (ReadFile(freeze) == "0"),
+		"thawed when the foreground went idle");
+
+	/* A failed write is reported, and not counted as a move */
+	std::string procs = ClassPath(root, ActivityPriorityNormal) +
+		"/cgroup.procs";
+	unlink(procs.c_str());
+	Check(symlink("/dev/full", procs.c_str()) == 0, "link to /dev/full");
+
+	unsigned long long before = moves.GetValue();
+	pids.assign(1, 1003);
+	Check(!manager->MoveProcesses(ActivityPriorityNormal, pids),
+		"failed write reported");
+	Check(pids.size() == 1, "process kept after a failed write");
+	Check(moves.GetValue() == before, "failed write not counted");
+
+	manager.reset();
+	Clock::SetInstance(boost::shared_ptr<Clock>());
+}
+
+int main(int argc, char **argv)
+{
+	char root[] = "/tmp/activitymanager-cgroupv2.XXXXXX";
+	if (!mkdtemp(root)) {
+		fprintf(stderr, "Unable to create a temporary directory: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	int ret = 0;
+
+	try {
+		RunTest(root);
+		printf("CgroupV2Manager: all checks passed\n");
+	} catch (const std::exception& except) {
+		fprintf(stderr, "CgroupV2Manager check failed: %s\n", except.what());
+		ret = 1;
+	}
+
+	nftw(root, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+	return ret;
+}
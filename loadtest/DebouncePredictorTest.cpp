@@ -0,0 +1,168 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * Feeds DebouncePredictor gaps from known distributions and checks the
+ * debounce it picks.  With the default wake cost of 8 seconds and the gaps
+ * taken at the middle of their histogram bucket, the expected cost in
+ * seconds awake of each delay can be worked out by hand; the cases below
+ * note it.
+ *
+ * Usage: activitymanager-debounce-test
+ *
+ * Exits non-zero, naming the first failed check, if anything is off.
+ */
+
+#include "DebouncePredictor.h"
+#include "PowerdPowerLock.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const unsigned Fixed =
+	(unsigned)PowerdPowerLock::PowerActivityDebounceDuration;
+
+static void Check(bool condition, const std::string& what)
+{
+	if (!condition) {
+		throw std::runtime_error(what);
+	}
+}
+
+/* Monotonic time of the simulated powerd calls */
+static time_t s_now = 1000;
+
+/* An Activity of "creator" with "powerDebounce" ends, leaving nothing
+ * else holding power, and the next one of "creator" arrives "gap" seconds
+ * later.  Each cycle adds a sample to the global histogram and to the
+ * creator's. */
+static void Cycle(const std::string& creator, unsigned gap)
+{
+	DebouncePredictor::NoteRelease(creator, s_now);
+	DebouncePredictor::NoteLockFree(s_now, true,
+		DebouncePredictor::Predict(creator));
+
+	s_now += gap;
+	DebouncePredictor::NoteAcquire(creator, s_now);
+
+	/* Time the Activity itself ran */
+	s_now += 30;
+}
+
+static void Feed(const std::string& creator, const std::vector<unsigned>& gaps)
+{
+	for (std::vector<unsigned>::const_iterator gap = gaps.begin();
+		gap != gaps.end(); ++gap) {
+		Cycle(creator, *gap);
+	}
+}
+
+static void CheckPredict(const std::string& creator, unsigned expected,
+	const std::string& what)
+{
+	unsigned delay = DebouncePredictor::Predict(creator);
+
+	char buf[64];
+	snprintf(buf, sizeof(buf), " (expected %u, got %u)", expected, delay);
+	Check(delay == expected, what + buf);
+}
+
+static void RunTest()
+{
+	MojObject config(MojObject::TypeObject);
+	config.putBool(_T("enabled"), true);
+	config.putInt(_T("wakeCost"), 8);
+	config.putInt(_T("maxDelay"), 32);
+	config.putInt(_T("minSamples"), 4);
+	/* Long enough that the samples count nearly equally */
+	config.putInt(_T("sampleHalfLife"), 10000);
+	Check(DebouncePredictor::ConfigFromJson(config) == MojErrNone,
+		"configured");
+
+	DebouncePredictor::Reset();
+
+	/* Too few samples: the fixed delay */
+	Feed("a", std::vector<unsigned>(3, 3));
+	CheckPredict("a", Fixed, "fixed delay below minSamples");
+
+	/* Every gap in (2, 4]: waiting 4s costs 3s awake against 8s for a
+	 * resume, and no longer delay does better.  (The samples decay a
+	 * little, so four weigh just under minSamples.) */
+	Feed("a", std::vector<unsigned>(2, 3));
+	CheckPredict("a", 4, "short gaps debounced to cover them");
+
+	/* Every gap in (8, 12]: covering them costs 10s awake, more than the
+	 * 8s resume, so don't debounce at all */
+	DebouncePredictor::Reset();
+	Feed("b", std::vector<unsigned>(8, 10));
+	CheckPredict("b", 0, "gaps dearer to wait for than to resume");
+
+	/* Gaps past maxDelay can't be covered; any delay is wasted */
+	DebouncePredictor::Reset();
+	Feed("c", std::vector<unsigned>(8, 40));
+	CheckPredict("c", 0, "gaps beyond maxDelay");
+
+	/* Half at 3s, half at 40s: 4s costs 3/2 + (4 + 8)/2 = 7.5, beating
+	 * 8 for no delay and 9.5 for 8s */
+	DebouncePredictor::Reset();
+	std::vector<unsigned> mixed;
+	for (unsigned i = 0; i < 8; i++) {
+		mixed.push_back((i % 2) ? 40 : 3);
+	}
+	Feed("d", mixed);
+	CheckPredict("d", 4, "mixed gaps");
+
+	/* A creator with enough samples of its own uses them; a new one gets
+	 * the global distribution, which "d" just shaped */
+	Feed("e", std::vector<unsigned>(8, 10));
+	CheckPredict("e", 0, "creator's own gaps");
+	CheckPredict("f", 0, "global gaps for an unknown creator");
+
+	DebouncePredictor::Reset();
+	Feed("d", mixed);
+	CheckPredict("f", 4, "global gaps after a reset");
+
+	/* 0 is a valid monotonic time; a release then still awaits the next
+	 * arrival */
+	DebouncePredictor::Reset();
+	s_now = 0;
+	Feed("g", std::vector<unsigned>(5, 3));
+	CheckPredict("g", 4, "samples taken from time 0");
+
+	MojObject disabled(MojObject::TypeObject);
+	disabled.putBool(_T("enabled"), false);
+	Check(DebouncePredictor::ConfigFromJson(disabled) == MojErrNone,
+		"disabled");
+	CheckPredict("g", Fixed, "fixed delay when disabled");
+}
+
+int main(int argc, char **argv)
+{
+	try {
+		RunTest();
+		printf("DebouncePredictor: all checks passed\n");
+	} catch (const std::exception& except) {
+		fprintf(stderr, "DebouncePredictor check failed: %s\n",
+			except.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,506 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "FakeBus.h"
+
+#include <ctime>
+#include <stdexcept>
+
+#include <glib.h>
+#include <luna/MojLunaMessage.h>
+
+/* Carries the payload the daemon writes for an outgoing request */
+class FakeBusRequest : public MojServiceRequest
+{
+public:
+	FakeBusRequest(MojService *service, bool isPublic,
+		const MojChar *requester)
+		: MojServiceRequest(service)
+		, m_public(isPublic)
+		, m_requester(requester ? requester : "")
+	{
+	}
+
+	virtual ~FakeBusRequest() {}
+
+	virtual MojObjectVisitor& writer()
+	{
+		return m_writer;
+	}
+
+	const MojObject& GetPayload() const
+	{
+		return m_writer.object();
+	}
+
+	bool IsPublic() const { return m_public; }
+	const std::string& GetRequester() const { return m_requester; }
+
+protected:
+	MojObjectBuilder	m_writer;
+	bool				m_public;
+	std::string			m_requester;
+};
+
+FakeBusMessage::FakeBusMessage(MojService *service, Token token,
+	const std::string& category, const std::string& method,
+	const MojObject& payload, const BusId& sender, bool isPublic,
+	ResponseCallback callback)
+	: MojServiceMessage(service, token)
+	, m_category(category)
+	, m_method(method)
+	, m_payload(payload)
+	, m_public(isPublic)
+	, m_callback(callback)
+	, m_replies(0)
+{
+	switch (sender.GetType()) {
+	case BusApp:
+		m_appId = sender.GetId();
+		break;
+	case BusService:
+		m_senderId = sender.GetId();
+		break;
+	default:
+		m_senderAddress = sender.GetId();
+		break;
+	}
+}
+
+FakeBusMessage::FakeBusMessage(MojService *service, Token token,
+	const MojObject& payload, const char *errorMethod)
+	: MojServiceMessage(service, token)
+	, m_payload(payload)
+	, m_public(false)
+	, m_replies(0)
+{
+	if (errorMethod) {
+		m_category = LUNABUS_ERROR_CATEGORY;
+		m_method = errorMethod;
+	}
+}
+
+FakeBusMessage::~FakeBusMessage()
+{
+}
+
+const MojChar *FakeBusMessage::method() const
+{
+	return NullIfEmpty(m_method);
+}
+
+const MojChar *FakeBusMessage::category() const
+{
+	return NullIfEmpty(m_category);
+}
+
+const MojChar *FakeBusMessage::appId() const
+{
+	return NullIfEmpty(m_appId);
+}
+
+MojErr FakeBusMessage::payload(MojObjectVisitor& visitor) const
+{
+	return m_payload.visit(visitor);
+}
+
+MojObjectVisitor& FakeBusMessage::writer()
+{
+	return m_writer;
+}
+
+bool FakeBusMessage::IsPublic() const
+{
+	return m_public;
+}
+
+const MojChar *FakeBusMessage::GetAppId() const
+{
+	return NullIfEmpty(m_appId);
+}
+
+const MojChar *FakeBusMessage::GetSenderId() const
+{
+	return NullIfEmpty(m_senderId);
+}
+
+const MojChar *FakeBusMessage::GetSenderAddress() const
+{
+	return NullIfEmpty(m_senderAddress);
+}
+
+const MojChar *FakeBusMessage::GetCategory() const
+{
+	return NullIfEmpty(m_category);
+}
+
+const MojChar *FakeBusMessage::GetMethod() const
+{
+	return NullIfEmpty(m_method);
+}
+
+unsigned FakeBusMessage::GetReplyCount() const
+{
+	return m_replies;
+}
+
+MojErr FakeBusMessage::replyImpl()
+{
+	m_replies++;
+
+	if (m_callback) {
+		m_callback(m_writer.object());
+	}
+
+	return m_writer.reset();
+}
+
+const MojChar *FakeBusMessage::NullIfEmpty(const std::string& str)
+{
+	return str.empty() ? NULL : str.c_str();
+}
+
+FakeBusCall::FakeBusCall(FakeBusService *bus, MojServiceRequest *req,
+	const std::string& service, const std::string& method,
+	const MojObject& payload, bool isPublic, const std::string& requester)
+	: m_bus(bus)
+	, m_req(req)
+	, m_service(service)
+	, m_method(method)
+	, m_payload(payload)
+	, m_requester(requester)
+	, m_public(isPublic)
+	, m_cancelled(false)
+{
+}
+
+FakeBusCall::~FakeBusCall()
+{
+}
+
+const std::string& FakeBusCall::GetService() const
+{
+	return m_service;
+}
+
+const std::string& FakeBusCall::GetMethod() const
+{
+	return m_method;
+}
+
+const MojObject& FakeBusCall::GetPayload() const
+{
+	return m_payload;
+}
+
+bool FakeBusCall::IsPublic() const
+{
+	return m_public;
+}
+
+const std::string& FakeBusCall::GetRequester() const
+{
+	return m_requester;
+}
+
+bool FakeBusCall::IsSubscription() const
+{
+	if ((m_service == "com.palm.lunabus") && (m_method == "signal/addmatch")) {
+		return true;
+	}
+
+	bool subscribe = false;
+	m_payload.get(_T("subscribe"), subscribe);
+	return subscribe;
+}
+
+bool FakeBusCall::IsCancelled() const
+{
+	return m_cancelled;
+}
+
+void FakeBusCall::Reply(const MojObject& response, unsigned delayMs)
+{
+	m_bus->Post(delayMs, boost::bind(&FakeBusService::DeliverReply, m_bus,
+		shared_from_this(), response, (const char *)NULL));
+}
+
+void FakeBusCall::ReplySuccess(unsigned delayMs)
+{
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, true);
+	Reply(response, delayMs);
+}
+
+void FakeBusCall::ReplyError(MojErr err, const char *errorText,
+	unsigned delayMs)
+{
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, false);
+	response.putInt(MojServiceMessage::ErrorCodeKey, (MojInt64)err);
+	response.putString(MojServiceMessage::ErrorTextKey, errorText);
+	Reply(response, delayMs);
+}
+
+void FakeBusCall::ReplyBusError(const char *errorMethod, unsigned delayMs)
+{
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, false);
+	response.putString(MojServiceMessage::ErrorTextKey, errorMethod);
+	m_bus->Post(delayMs, boost::bind(&FakeBusService::DeliverReply, m_bus,
+		shared_from_this(), response, errorMethod));
+}
+
+FakeBusService::FakeBusService()
+	: m_nextToken(1)
+	, m_requestCount(0)
+	, m_replyCount(0)
+{
+}
+
+FakeBusService::~FakeBusService()
+{
+}
+
+void FakeBusService::AddEndpoint(const std::string& service,
+	boost::shared_ptr<FakeBusEndpoint> endpoint)
+{
+	m_endpoints[service] = endpoint;
+}
+
+void FakeBusService::SetDefaultEndpoint(
+	boost::shared_ptr<FakeBusEndpoint> endpoint)
+{
+	m_defaultEndpoint = endpoint;
+}
+
+MojErr FakeBusService::Call(const std::string& category,
+	const std::string& method, const MojObject& payload, const BusId& sender,
+	bool isPublic, FakeBusMessage::ResponseCallback callback)
+{
+	MojRefCountedPtr<FakeBusMessage> msg(new FakeBusMessage(this,
+		m_nextToken++, category, method, payload, sender, isPublic,
+		callback));
+	MojAllocCheck(msg.get());
+
+	m_requestCount++;
+
+	Post(0, boost::bind(&FakeBusService::DispatchCall, this, msg));
+
+	return MojErrNone;
+}
+
+unsigned FakeBusService::Publish(const std::string& service,
+	const std::string& method, const MojObject& params,
+	const MojObject& response)
+{
+	unsigned published = 0;
+
+	for (CallMap::iterator iter = m_calls.begin(); iter != m_calls.end();
+		++iter) {
+		boost::shared_ptr<FakeBusCall> call = iter->second;
+		if (!call->IsSubscription() || (call->m_service != service) ||
+			(call->m_method != method) || !(call->m_payload == params)) {
+			continue;
+		}
+
+		call->Reply(response);
+		published++;
+	}
+
+	return published;
+}
+
+void FakeBusService::Post(unsigned delayMs, Event event)
+{
+	m_events.insert(EventQueue::value_type(
+		Now() + ((MojInt64)delayMs * 1000000LL), event));
+}
+
+bool FakeBusService::RunOnce()
+{
+	bool busy = false;
+
+	MojInt64 now = Now();
+	while (!m_events.empty() && (m_events.begin()->first <= now)) {
+		Event event = m_events.begin()->second;
+		m_events.erase(m_events.begin());
+		event();
+		busy = true;
+	}
+
+	if (g_main_context_iteration(NULL, FALSE)) {
+		busy = true;
+	}
+
+	return busy;
+}
+
+void FakeBusService::RunUntilIdle()
+{
+	while (RunOnce() || HasPending()) {
+	}
+}
+
+bool FakeBusService::HasPending() const
+{
+	return !m_events.empty();
+}
+
+MojInt64 FakeBusService::Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((MojInt64)ts.tv_sec * 1000000000LL) + (MojInt64)ts.tv_nsec;
+}
+
+unsigned long long FakeBusService::GetRequestCount() const
+{
+	return m_requestCount;
+}
+
+unsigned long long FakeBusService::GetReplyCount() const
+{
+	return m_replyCount;
+}
+
+MojErr FakeBusService::open(const MojChar *serviceName)
+{
+	return MojErrNone;
+}
+
+MojErr FakeBusService::close()
+{
+	m_calls.clear();
+	m_events.clear();
+	return MojErrNone;
+}
+
+MojErr FakeBusService::dispatch()
+{
+	RunOnce();
+	return MojErrNone;
+}
+
+MojErr FakeBusService::createRequest(
+	MojRefCountedPtr<MojServiceRequest>& reqOut)
+{
+	return createRequest(reqOut, false, NULL);
+}
+
+MojErr FakeBusService::createRequest(
+	MojRefCountedPtr<MojServiceRequest>& reqOut, bool usePublicBus,
+	const MojChar *proxyRequester)
+{
+	reqOut.reset(new FakeBusRequest(this, usePublicBus, proxyRequester));
+	MojAllocCheck(reqOut.get());
+
+	return MojErrNone;
+}
+
+MojErr FakeBusService::sendImpl(MojServiceRequest *req,
+	const MojChar *service, const MojChar *method, Token& tokenOut)
+{
+	FakeBusRequest *fakeReq = static_cast<FakeBusRequest *>(req);
+
+	tokenOut = m_nextToken++;
+
+	boost::shared_ptr<FakeBusCall> call = boost::make_shared<FakeBusCall>(
+		this, req, service, method, fakeReq->GetPayload(),
+		fakeReq->IsPublic(), fakeReq->GetRequester());
+	m_calls[req] = call;
+
+	Post(0, boost::bind(&FakeBusService::DeliverCall, this, call));
+
+	return MojErrNone;
+}
+
+MojErr FakeBusService::cancelImpl(MojServiceRequest *req)
+{
+	CallMap::iterator found = m_calls.find(req);
+	if (found != m_calls.end()) {
+		found->second->m_cancelled = true;
+		m_calls.erase(found);
+	}
+
+	return MojErrNone;
+}
+
+MojErr FakeBusService::enableSubscriptionImpl(MojServiceMessage *msg)
+{
+	return MojErrNone;
+}
+
+void FakeBusService::DeliverReply(boost::shared_ptr<FakeBusCall> call,
+	MojObject response, const char *errorMethod)
+{
+	if (call->m_cancelled) {
+		return;
+	}
+
+	MojErr err = MojErrNone;
+	if (errorMethod) {
+		err = MojErrInternal;
+	} else {
+		bool returnValue = true;
+		response.get(MojServiceMessage::ReturnValueKey, returnValue);
+		if (!returnValue) {
+			MojInt64 errorCode = MojErrUnknown;
+			bool found = false;
+			response.get(MojServiceMessage::ErrorCodeKey, errorCode, found);
+			err = (MojErr)errorCode;
+		}
+	}
+
+	/* A single reply completes anything that isn't a subscription */
+	if (!call->IsSubscription()) {
+		call->m_cancelled = true;
+		m_calls.erase(call->m_req.get());
+	}
+
+	MojRefCountedPtr<FakeBusMessage> msg(new FakeBusMessage(this,
+		call->m_req->token(), response, errorMethod));
+
+	m_replyCount++;
+
+	dispatchReply(call->m_req.get(), msg.get(), response, err);
+}
+
+void FakeBusService::DeliverCall(boost::shared_ptr<FakeBusCall> call)
+{
+	if (call->m_cancelled) {
+		return;
+	}
+
+	EndpointMap::iterator found = m_endpoints.find(call->m_service);
+	if (found != m_endpoints.end()) {
+		found->second->HandleCall(call);
+	} else if (m_defaultEndpoint) {
+		m_defaultEndpoint->HandleCall(call);
+	} else {
+		call->ReplyBusError(LUNABUS_ERROR_SERVICE_NOT_EXIST);
+	}
+}
+
+void FakeBusService::DispatchCall(MojRefCountedPtr<FakeBusMessage> msg)
+{
+	MojErr err = dispatchMessage(msg.get());
+	if (err) {
+		msg->replyError(err);
+	}
+}
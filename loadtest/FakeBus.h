@@ -0,0 +1,250 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_FAKEBUS_H__
+#define __ACTIVITYMANAGER_FAKEBUS_H__
+
+#include "Base.h"
+#include "BusId.h"
+#include "MojoBusMessage.h"
+
+#include <core/MojObjectBuilder.h>
+#include <core/MojService.h>
+#include <core/MojServiceMessage.h>
+#include <core/MojServiceRequest.h>
+
+#include <map>
+#include <string>
+
+#include <boost/function.hpp>
+
+class FakeBusService;
+
+/*
+ * In-process stand-in for the Luna Bus.
+ *
+ * FakeBusService implements the MojService interface, so MojoCall, the
+ * subscription code and the proxies run unmodified against it.  Outgoing
+ * requests are routed by service name to FakeBusEndpoints, which reply
+ * (possibly after a scripted latency) through the FakeBusCall they are
+ * handed.  Incoming requests are injected with FakeBusService::Call() and
+ * dispatched to the registered category handlers exactly as the hub would.
+ *
+ * Everything runs on one thread from a simple timed event queue, pumped by
+ * RunOnce().  The default GLib context is iterated from the same loop so
+ * the daemon's own Timeouts still fire.
+ */
+
+/* Message carrying either a request to the daemon or a reply to one of the
+ * daemon's outgoing calls */
+class FakeBusMessage : public MojServiceMessage, public LocalBusMessage
+{
+public:
+	typedef boost::function<void (const MojObject& response)>
+		ResponseCallback;
+
+	/* Request into one of the daemon's categories */
+	FakeBusMessage(MojService *service, Token token,
+		const std::string& category, const std::string& method,
+		const MojObject& payload, const BusId& sender, bool isPublic,
+		ResponseCallback callback);
+
+	/* Reply to an outgoing request.  If errorMethod is set, the reply is a
+	 * bus-level failure (LUNABUS_ERROR_*) */
+	FakeBusMessage(MojService *service, Token token,
+		const MojObject& payload, const char *errorMethod);
+
+	virtual ~FakeBusMessage();
+
+	using MojServiceMessage::payload;
+
+	virtual const MojChar *method() const;
+	virtual const MojChar *category() const;
+	virtual const MojChar *appId() const;
+	virtual MojErr payload(MojObjectVisitor& visitor) const;
+	virtual MojObjectVisitor& writer();
+
+	virtual bool IsPublic() const;
+	virtual const MojChar *GetAppId() const;
+	virtual const MojChar *GetSenderId() const;
+	virtual const MojChar *GetSenderAddress() const;
+	virtual const MojChar *GetCategory() const;
+	virtual const MojChar *GetMethod() const;
+
+	unsigned GetReplyCount() const;
+
+protected:
+	virtual MojErr replyImpl();
+
+	static const MojChar *NullIfEmpty(const std::string& str);
+
+	std::string	m_category;
+	std::string	m_method;
+	MojObject	m_payload;
+
+	std::string	m_appId;
+	std::string	m_senderId;
+	std::string	m_senderAddress;
+	bool		m_public;
+
+	ResponseCallback	m_callback;
+	MojObjectBuilder	m_writer;
+	unsigned			m_replies;
+};
+
+/* Request made by the daemon, as seen by a fake service */
+class FakeBusCall : public boost::enable_shared_from_this<FakeBusCall>
+{
+public:
+	FakeBusCall(FakeBusService *bus, MojServiceRequest *req,
+		const std::string& service, const std::string& method,
+		const MojObject& payload, bool isPublic,
+		const std::string& requester);
+	virtual ~FakeBusCall();
+
+	const std::string& GetService() const;
+	const std::string& GetMethod() const;
+	const MojObject& GetPayload() const;
+
+	/* The bus the request went out on, and the caller it was made on
+	 * behalf of ("" if none) */
+	bool IsPublic() const;
+	const std::string& GetRequester() const;
+
+	/* True if the request payload has "subscribe": true, or the request is
+	 * a signal registration, which also stays open until cancelled */
+	bool IsSubscription() const;
+	bool IsCancelled() const;
+
+	void Reply(const MojObject& response, unsigned delayMs = 0);
+	void ReplySuccess(unsigned delayMs = 0);
+	void ReplyError(MojErr err, const char *errorText, unsigned delayMs = 0);
+
+	/* Fail the way the hub does, i.e. LUNABUS_ERROR_SERVICE_NOT_EXIST */
+	void ReplyBusError(const char *errorMethod, unsigned delayMs = 0);
+
+protected:
+	friend class FakeBusService;
+
+	FakeBusService	*m_bus;
+
+	MojRefCountedPtr<MojServiceRequest>	m_req;
+
+	std::string	m_service;
+	std::string	m_method;
+	MojObject	m_payload;
+	std::string	m_requester;
+
+	bool		m_public;
+	bool		m_cancelled;
+};
+
+class FakeBusEndpoint
+{
+public:
+	virtual ~FakeBusEndpoint() {}
+
+	virtual void HandleCall(boost::shared_ptr<FakeBusCall> call) = 0;
+};
+
+class FakeBusService : public MojService, public LocalBusService
+{
+public:
+	FakeBusService();
+	virtual ~FakeBusService();
+
+	/* Route requests addressed to "service" to the given endpoint.  Requests
+	 * to services without an endpoint go to the default, or fail with
+	 * LUNABUS_ERROR_SERVICE_NOT_EXIST if there is none. */
+	void AddEndpoint(const std::string& service,
+		boost::shared_ptr<FakeBusEndpoint> endpoint);
+	void SetDefaultEndpoint(boost::shared_ptr<FakeBusEndpoint> endpoint);
+
+	/* Inject a request into one of the daemon's categories */
+	MojErr Call(const std::string& category, const std::string& method,
+		const MojObject& payload, const BusId& sender, bool isPublic,
+		FakeBusMessage::ResponseCallback callback);
+
+	/* Deliver an update to every open subscription the daemon holds on
+	 * service/method whose request payload was exactly "params".  Returns
+	 * the number of subscriptions updated. */
+	unsigned Publish(const std::string& service, const std::string& method,
+		const MojObject& params, const MojObject& response);
+
+	/* Event queue */
+	typedef boost::function<void ()> Event;
+
+	void Post(unsigned delayMs, Event event);
+
+	/* Run everything that is due.  Returns false if there was nothing to
+	 * do, in either the queue or GLib. */
+	bool RunOnce();
+	void RunUntilIdle();
+
+	/* True if events are queued, due or not */
+	bool HasPending() const;
+
+	static MojInt64 Now();
+
+	/* Statistics */
+	unsigned long long GetRequestCount() const;
+	unsigned long long GetReplyCount() const;
+
+	/* MojService */
+	virtual MojErr open(const MojChar *serviceName);
+	virtual MojErr close();
+	virtual MojErr dispatch();
+	virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut);
+
+	/* LocalBusService.  There is only one bus; the bus and requester are
+	 * passed on to the endpoint through the FakeBusCall. */
+	virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut,
+		bool usePublicBus, const MojChar *proxyRequester);
+
+protected:
+	friend class FakeBusCall;
+
+	virtual MojErr sendImpl(MojServiceRequest *req, const MojChar *service,
+		const MojChar *method, Token& tokenOut);
+	virtual MojErr cancelImpl(MojServiceRequest *req);
+	virtual MojErr enableSubscriptionImpl(MojServiceMessage *msg);
+
+	void DeliverReply(boost::shared_ptr<FakeBusCall> call,
+		MojObject response, const char *errorMethod);
+	void DeliverCall(boost::shared_ptr<FakeBusCall> call);
+	void DispatchCall(MojRefCountedPtr<FakeBusMessage> msg);
+
+	typedef std::map<std::string, boost::shared_ptr<FakeBusEndpoint> >
+		EndpointMap;
+	typedef std::multimap<MojInt64, Event> EventQueue;
+	typedef std::map<MojServiceRequest *, boost::shared_ptr<FakeBusCall> >
+		CallMap;
+
+	EndpointMap	m_endpoints;
+	boost::shared_ptr<FakeBusEndpoint>	m_defaultEndpoint;
+
+	EventQueue	m_events;
+	CallMap		m_calls;
+
+	Token		m_nextToken;
+
+	unsigned long long	m_requestCount;
+	unsigned long long	m_replyCount;
+};
+
+#endif /* __ACTIVITYMANAGER_FAKEBUS_H__ */
@@ -0,0 +1,128 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "FakeDaemon.h"
+
+#include "Activity.h"
+#include "ActivityCategory.h"
+#include "ActivityManager.h"
+#include "ConnectionManagerProxy.h"
+#include "DefaultRequirementManager.h"
+#include "GlibScheduler.h"
+#include "MojoDBProxy.h"
+#include "MojoJsonConverter.h"
+#include "MojoTriggerManager.h"
+#include "PowerdProxy.h"
+#include "RequirementManager.h"
+#include "ResourceManager.h"
+
+#include <stdexcept>
+
+FakeDaemon::FakeDaemon()
+	: m_db8(boost::make_shared<FakeDb8>())
+	, m_powerd(boost::make_shared<FakePowerd>())
+	, m_connectionManager(boost::make_shared<FakeConnectionManager>())
+	, m_ack(boost::make_shared<FakeAckService>())
+{
+	m_bus.AddEndpoint("com.palm.db", m_db8);
+	m_bus.AddEndpoint("com.palm.power", m_powerd);
+	m_bus.AddEndpoint("com.palm.connectionmanager", m_connectionManager);
+	m_bus.SetDefaultEndpoint(m_ack);
+}
+
+FakeDaemon::~FakeDaemon()
+{
+	m_bus.close();
+}
+
+void FakeDaemon::Init()
+{
+	m_resourceManager = boost::make_shared<MasterResourceManager>();
+	m_am = boost::make_shared<ActivityManager>(m_resourceManager);
+
+	m_requirementManager = boost::make_shared<MasterRequirementManager>();
+	m_requirementManager->AddManager(
+		boost::make_shared<DefaultRequirementManager>());
+
+	/* The fake device runs on UTC */
+	m_scheduler = boost::make_shared<GlibScheduler>();
+	m_scheduler->SetLocalOffset(0);
+
+	m_powerManager = boost::make_shared<PowerdProxy>(&m_bus);
+	m_requirementManager->AddManager(m_powerManager);
+
+	m_triggerManager = boost::make_shared<MojoTriggerManager>(&m_bus);
+	m_json = boost::make_shared<MojoJsonConverter>(&m_bus, m_am, m_scheduler,
+		m_triggerManager, m_requirementManager, m_powerManager);
+	m_db = boost::make_shared<MojoDBProxy>((ActivityManagerApp *)NULL,
+		&m_bus, m_am, m_json);
+
+	m_requirementManager->AddManager(
+		boost::make_shared<ConnectionManagerProxy>(&m_bus));
+
+	m_handler.reset(new ActivityCategoryHandler(m_db, m_json, m_am,
+		m_triggerManager, m_powerManager, m_resourceManager,
+		boost::shared_ptr<ContainerManager>(), m_requirementManager));
+
+	MojErr err = m_handler->Init();
+	if (err) {
+		throw std::runtime_error("Failed to initialize category handler");
+	}
+
+	err = m_bus.addCategory(_T("/"), m_handler.get());
+	if (err) {
+		throw std::runtime_error("Failed to register category handler");
+	}
+
+	/* Equivalent of ActivityManagerApp::ready() */
+	m_requirementManager->Enable();
+	m_scheduler->Enable();
+	m_am->Enable(ActivityManager::ENABLE_MASK);
+
+	m_bus.RunUntilIdle();
+}
+
+FakeBusService& FakeDaemon::GetBus()
+{
+	return m_bus;
+}
+
+boost::shared_ptr<FakeDb8> FakeDaemon::GetDb8()
+{
+	return m_db8;
+}
+
+boost::shared_ptr<FakePowerd> FakeDaemon::GetPowerd()
+{
+	return m_powerd;
+}
+
+boost::shared_ptr<FakeConnectionManager> FakeDaemon::GetConnectionManager()
+{
+	return m_connectionManager;
+}
+
+boost::shared_ptr<ActivityManager> FakeDaemon::GetActivityManager()
+{
+	return m_am;
+}
+
+boost::shared_ptr<Scheduler> FakeDaemon::GetScheduler()
+{
+	return m_scheduler;
+}
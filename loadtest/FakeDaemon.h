@@ -0,0 +1,85 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_FAKEDAEMON_H__
+#define __ACTIVITYMANAGER_FAKEDAEMON_H__
+
+#include "FakeBus.h"
+#include "FakeServices.h"
+
+#include <boost/scoped_ptr.hpp>
+
+class ActivityCategoryHandler;
+class ActivityManager;
+class MasterRequirementManager;
+class MasterResourceManager;
+class MojoJsonConverter;
+class MojoTriggerManager;
+class PersistProxy;
+class PowerManager;
+class Scheduler;
+
+/*
+ * The daemon's object graph, wired to FakeBusService and the fake db8,
+ * powerd and connectionmanager.  Same as ActivityManagerApp, with the
+ * device-specific pieces (cgroups, bus proxy, system manager, telephony)
+ * left out.
+ *
+ * The fake services and the bus are created up front, so latencies and
+ * extra endpoints can be configured before Init() brings the daemon up.
+ */
+class FakeDaemon
+{
+public:
+	FakeDaemon();
+	virtual ~FakeDaemon();
+
+	/* Build the daemon, register the "/" category, enable the managers,
+	 * and let the proxies' initial queries and subscriptions settle. */
+	void Init();
+
+	FakeBusService& GetBus();
+
+	boost::shared_ptr<FakeDb8> GetDb8();
+	boost::shared_ptr<FakePowerd> GetPowerd();
+	boost::shared_ptr<FakeConnectionManager> GetConnectionManager();
+
+	boost::shared_ptr<ActivityManager> GetActivityManager();
+	boost::shared_ptr<Scheduler> GetScheduler();
+
+protected:
+	FakeBusService	m_bus;
+
+	boost::shared_ptr<FakeDb8>					m_db8;
+	boost::shared_ptr<FakePowerd>				m_powerd;
+	boost::shared_ptr<FakeConnectionManager>	m_connectionManager;
+	boost::shared_ptr<FakeAckService>			m_ack;
+
+	boost::shared_ptr<MasterResourceManager>	m_resourceManager;
+	boost::shared_ptr<ActivityManager>			m_am;
+	boost::shared_ptr<MasterRequirementManager>	m_requirementManager;
+	boost::shared_ptr<Scheduler>				m_scheduler;
+	boost::shared_ptr<PowerManager>				m_powerManager;
+	boost::shared_ptr<MojoTriggerManager>		m_triggerManager;
+	boost::shared_ptr<MojoJsonConverter>		m_json;
+	boost::shared_ptr<PersistProxy>				m_db;
+
+	boost::scoped_ptr<ActivityCategoryHandler>	m_handler;
+};
+
+#endif /* __ACTIVITYMANAGER_FAKEDAEMON_H__ */
@@ -0,0 +1,353 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "FakeServices.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <luna/MojLunaMessage.h>
+
+FakeServiceEndpoint::FakeServiceEndpoint()
+	: m_baseMs(0)
+	, m_jitterMs(0)
+{
+}
+
+FakeServiceEndpoint::~FakeServiceEndpoint()
+{
+}
+
+void FakeServiceEndpoint::SetLatency(unsigned baseMs, unsigned jitterMs)
+{
+	m_baseMs = baseMs;
+	m_jitterMs = jitterMs;
+}
+
+const FakeServiceEndpoint::CallCounts& FakeServiceEndpoint::GetCallCounts()
+	const
+{
+	return m_callCounts;
+}
+
+void FakeServiceEndpoint::HandleCall(boost::shared_ptr<FakeBusCall> call)
+{
+	m_callCounts[call->GetService() + "/" + call->GetMethod()]++;
+	HandleMethod(call);
+}
+
+unsigned FakeServiceEndpoint::GetLatency() const
+{
+	if (!m_jitterMs) {
+		return m_baseMs;
+	}
+
+	return m_baseMs + (unsigned)(::random() % m_jitterMs);
+}
+
+void FakeAckService::HandleMethod(boost::shared_ptr<FakeBusCall> call)
+{
+	call->ReplySuccess(GetLatency());
+}
+
+FakeDb8::FakeDb8()
+	: m_nextId(1)
+	, m_nextRev(1)
+{
+}
+
+FakeDb8::~FakeDb8()
+{
+}
+
+void FakeDb8::Put(const MojObject& object)
+{
+	MojInt64 rev;
+	Store(object, false, rev);
+}
+
+size_t FakeDb8::GetObjectCount() const
+{
+	return m_objects.size();
+}
+
+void FakeDb8::HandleMethod(boost::shared_ptr<FakeBusCall> call)
+{
+	const std::string& method = call->GetMethod();
+
+	if (method == "put") {
+		HandlePut(call, false);
+	} else if (method == "merge") {
+		HandlePut(call, true);
+	} else if (method == "del") {
+		HandleDel(call);
+	} else if (method == "find") {
+		HandleFind(call);
+	} else {
+		call->ReplyBusError(LUNABUS_ERROR_UNKNOWN_METHOD, GetLatency());
+	}
+}
+
+void FakeDb8::HandlePut(boost::shared_ptr<FakeBusCall> call, bool merge)
+{
+	MojObject objects;
+	if (!call->GetPayload().get(_T("objects"), objects)) {
+		call->ReplyError(MojErrInvalidArg, "objects required", GetLatency());
+		return;
+	}
+
+	MojObject results(MojObject::TypeArray);
+	for (MojObject::ConstArrayIterator iter = objects.arrayBegin();
+		iter != objects.arrayEnd(); ++iter) {
+		MojInt64 rev;
+		std::string id = Store(*iter, merge, rev);
+
+		MojObject result;
+		result.putString(_T("id"), id.c_str());
+		result.putInt(_T("rev"), rev);
+		results.push(result);
+	}
+
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, true);
+	response.put(_T("results"), results);
+	call->Reply(response, GetLatency());
+}
+
+void FakeDb8::HandleDel(boost::shared_ptr<FakeBusCall> call)
+{
+	MojObject results(MojObject::TypeArray);
+
+	MojObject ids;
+	if (call->GetPayload().get(_T("ids"), ids)) {
+		for (MojObject::ConstArrayIterator iter = ids.arrayBegin();
+			iter != ids.arrayEnd(); ++iter) {
+			MojString id;
+			iter->stringValue(id);
+
+			ObjectMap::iterator found = m_objects.find(id.data());
+			if (found == m_objects.end()) {
+				continue;
+			}
+
+			m_objects.erase(found);
+
+			MojObject result;
+			result.putString(_T("id"), id);
+			result.putInt(_T("rev"), m_nextRev++);
+			results.push(result);
+		}
+	}
+
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, true);
+	response.put(_T("results"), results);
+	call->Reply(response, GetLatency());
+}
+
+void FakeDb8::HandleFind(boost::shared_ptr<FakeBusCall> call)
+{
+	MojObject query;
+	call->GetPayload().get(_T("query"), query);
+
+	MojString from;
+	bool found = false;
+	query.get(_T("from"), from, found);
+
+	MojObject results(MojObject::TypeArray);
+	for (ObjectMap::const_iterator iter = m_objects.begin();
+		iter != m_objects.end(); ++iter) {
+		if (found) {
+			MojString kind;
+			bool hasKind = false;
+			iter->second.get(_T("_kind"), kind, hasKind);
+			if (!hasKind || (kind != from)) {
+				continue;
+			}
+		}
+
+		results.push(iter->second);
+	}
+
+	MojObject response;
+	response.putBool(MojServiceMessage::ReturnValueKey, true);
+	response.put(_T("results"), results);
+	call->Reply(response, GetLatency());
+}
+
+std::string FakeDb8::Store(const MojObject& object, bool merge,
+	MojInt64& revOut)
+{
+	std::string id;
+
+	MojString existingId;
+	bool found = false;
+	object.get(_T("_id"), existingId, found);
+	if (found) {
+		id = existingId.data();
+	} else {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "++fake%llu", m_nextId++);
+		id = buf;
+	}
+
+	revOut = m_nextRev++;
+
+	ObjectMap::iterator existing = m_objects.find(id);
+	if (merge && (existing != m_objects.end())) {
+		for (MojObject::ConstIterator iter = object.begin();
+			iter != object.end(); ++iter) {
+			existing->second.put(iter.key(), iter.value());
+		}
+		existing->second.putInt(_T("_rev"), revOut);
+	} else {
+		MojObject stored(object);
+		stored.putString(_T("_id"), id.c_str());
+		stored.putInt(_T("_rev"), revOut);
+		m_objects[id] = stored;
+	}
+
+	return id;
+}
+
+FakePowerd::FakePowerd()
+	: m_active(0)
+	, m_maxActive(0)
+{
+}
+
+FakePowerd::~FakePowerd()
+{
+}
+
+unsigned FakePowerd::GetActivePowerActivities() const
+{
+	return m_active;
+}
+
+unsigned FakePowerd::GetMaxPowerActivities() const
+{
+	return m_maxActive;
+}
+
+void FakePowerd::HandleMethod(boost::shared_ptr<FakeBusCall> call)
+{
+	const std::string& method = call->GetMethod();
+
+	MojString id;
+	bool found = false;
+	call->GetPayload().get(_T("id"), id, found);
+
+	if (method == "com/palm/power/activityStart") {
+		if (found && (m_powerActivities[id.data()]++ == 0)) {
+			m_active++;
+			if (m_active > m_maxActive) {
+				m_maxActive = m_active;
+			}
+		}
+		call->ReplySuccess(GetLatency());
+	} else if (method == "com/palm/power/activityEnd") {
+		if (found) {
+			std::map<std::string, unsigned>::iterator iter =
+				m_powerActivities.find(id.data());
+			if (iter != m_powerActivities.end()) {
+				m_powerActivities.erase(iter);
+				m_active--;
+			}
+		}
+		call->ReplySuccess(GetLatency());
+	} else if (method == "com/palm/power/batteryStatusQuery") {
+		MojObject response;
+		response.putBool(MojServiceMessage::ReturnValueKey, true);
+		response.putInt(_T("percent"), 80);
+		response.putInt(_T("percent_ui"), 80);
+		call->Reply(response, GetLatency());
+	} else if (method == "com/palm/power/chargerStatusQuery") {
+		MojObject response;
+		response.putBool(MojServiceMessage::ReturnValueKey, true);
+		response.putBool(_T("Connected"), false);
+		call->Reply(response, GetLatency());
+	} else {
+		/* timeout/set, timeout/clear, ... */
+		call->ReplySuccess(GetLatency());
+	}
+}
+
+FakeConnectionManager::FakeConnectionManager()
+{
+	InjectConnected(true);
+}
+
+FakeConnectionManager::~FakeConnectionManager()
+{
+}
+
+void FakeConnectionManager::InjectStatus(const MojObject& status)
+{
+	m_status = status;
+	m_status.putBool(MojServiceMessage::ReturnValueKey, true);
+
+	std::list<boost::weak_ptr<FakeBusCall> >::iterator iter =
+		m_subscribers.begin();
+	while (iter != m_subscribers.end()) {
+		boost::shared_ptr<FakeBusCall> call = iter->lock();
+		if (!call || call->IsCancelled()) {
+			iter = m_subscribers.erase(iter);
+			continue;
+		}
+
+		call->Reply(m_status, GetLatency());
+		++iter;
+	}
+}
+
+void FakeConnectionManager::InjectConnected(bool connected)
+{
+	const MojChar *state = connected ? _T("connected") : _T("disconnected");
+
+	MojObject wifi;
+	wifi.putString(_T("state"), state);
+	if (connected) {
+		wifi.putString(_T("ipAddress"), _T("10.0.0.2"));
+		wifi.putString(_T("ssid"), _T("loadtest"));
+	}
+
+	MojObject wan;
+	wan.putString(_T("state"), _T("disconnected"));
+
+	MojObject status;
+	status.putBool(_T("isInternetConnectionAvailable"), connected);
+	status.put(_T("wifi"), wifi);
+	status.put(_T("wan"), wan);
+
+	InjectStatus(status);
+}
+
+void FakeConnectionManager::HandleMethod(boost::shared_ptr<FakeBusCall> call)
+{
+	if (call->GetMethod() != "getstatus") {
+		call->ReplyBusError(LUNABUS_ERROR_UNKNOWN_METHOD, GetLatency());
+		return;
+	}
+
+	if (call->IsSubscription()) {
+		m_subscribers.push_back(call);
+	}
+
+	call->Reply(m_status, GetLatency());
+}
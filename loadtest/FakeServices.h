@@ -0,0 +1,138 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_FAKESERVICES_H__
+#define __ACTIVITYMANAGER_FAKESERVICES_H__
+
+#include "FakeBus.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+/*
+ * Scripted stand-ins for the services the daemon talks to.  Each keeps a
+ * count of calls per method, and replies after a configurable latency of
+ * base + [0, jitter) milliseconds.
+ */
+class FakeServiceEndpoint : public FakeBusEndpoint
+{
+public:
+	FakeServiceEndpoint();
+	virtual ~FakeServiceEndpoint();
+
+	void SetLatency(unsigned baseMs, unsigned jitterMs = 0);
+
+	typedef std::map<std::string, unsigned long long> CallCounts;
+	const CallCounts& GetCallCounts() const;
+
+	virtual void HandleCall(boost::shared_ptr<FakeBusCall> call);
+
+protected:
+	virtual void HandleMethod(boost::shared_ptr<FakeBusCall> call) = 0;
+
+	unsigned GetLatency() const;
+
+	unsigned	m_baseMs;
+	unsigned	m_jitterMs;
+
+	CallCounts	m_callCounts;
+};
+
+/* Acknowledges anything: signal/addmatch, configurator, callbacks */
+class FakeAckService : public FakeServiceEndpoint
+{
+protected:
+	virtual void HandleMethod(boost::shared_ptr<FakeBusCall> call);
+};
+
+/*
+ * Enough of com.palm.db for the persistence paths: put, merge and del by
+ * id, and find by kind.  Queries other than {"from": kind} are not
+ * interpreted.
+ */
+class FakeDb8 : public FakeServiceEndpoint
+{
+public:
+	FakeDb8();
+	virtual ~FakeDb8();
+
+	/* Seed the store, e.g. with Activities to load at start-up */
+	void Put(const MojObject& object);
+
+	size_t GetObjectCount() const;
+
+protected:
+	virtual void HandleMethod(boost::shared_ptr<FakeBusCall> call);
+
+	void HandlePut(boost::shared_ptr<FakeBusCall> call, bool merge);
+	void HandleDel(boost::shared_ptr<FakeBusCall> call);
+	void HandleFind(boost::shared_ptr<FakeBusCall> call);
+
+	std::string Store(const MojObject& object, bool merge, MojInt64& revOut);
+
+	typedef std::map<std::string, MojObject> ObjectMap;
+
+	ObjectMap			m_objects;
+	unsigned long long	m_nextId;
+	MojInt64			m_nextRev;
+};
+
+/*
+ * com.palm.power: activity start/end, timeouts, and battery/charger
+ * queries.  Tracks the number of outstanding power activities.
+ */
+class FakePowerd : public FakeServiceEndpoint
+{
+public:
+	FakePowerd();
+	virtual ~FakePowerd();
+
+	unsigned GetActivePowerActivities() const;
+	unsigned GetMaxPowerActivities() const;
+
+protected:
+	virtual void HandleMethod(boost::shared_ptr<FakeBusCall> call);
+
+	std::map<std::string, unsigned>	m_powerActivities;
+	unsigned	m_active;
+	unsigned	m_maxActive;
+};
+
+/*
+ * com.palm.connectionmanager/getstatus.  Subscribers get the current
+ * status immediately, and again whenever InjectStatus() is called.
+ */
+class FakeConnectionManager : public FakeServiceEndpoint
+{
+public:
+	FakeConnectionManager();
+	virtual ~FakeConnectionManager();
+
+	void InjectStatus(const MojObject& status);
+	void InjectConnected(bool connected);
+
+protected:
+	virtual void HandleMethod(boost::shared_ptr<FakeBusCall> call);
+
+	MojObject	m_status;
+
+	std::list<boost::weak_ptr<FakeBusCall> >	m_subscribers;
+};
+
+#endif /* __ACTIVITYMANAGER_FAKESERVICES_H__ */
@@ -0,0 +1,426 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * Converts a flight recorder dump (devel/dumpFlightRecorder, or SIGUSR2) to
+ * the Chrome trace event format, for chrome://tracing or ui.perfetto.dev.
+ *
+ * Three processes appear in the timeline, each with a track per Activity:
+ *
+ *   "Activity state"  a span per state, with instant events for each
+ *                     requirement met or unmet
+ *   "Run queues"      a span per run queue residency, plus a counter track
+ *                     of each queue's depth
+ *   "Persist"         a span per completed persist command
+ *
+ * The recorder only notes the queue an Activity moved to, so the queue it
+ * left is taken from the Activity's previous queue event.  Depths only
+ * count Activities seen entering the queue within the dump, so they are a
+ * lower bound until the oldest entries have cycled through.
+ *
+ * Timestamps are microseconds since the oldest event in the dump; the wall
+ * clock time of that event is in the trace's metadata.
+ *
+ * Usage: activitymanager-flightdecode <dump> [<output>]
+ *
+ * The trace is written to stdout if no output file is given.
+ */
+
+#include "FlightRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::string> NameTable;
+
+struct FlightDump {
+	FlightDumpHeader			m_header;
+	std::vector<FlightRecord>	m_records;
+
+	NameTable	m_states;
+	NameTable	m_queues;
+	NameTable	m_reasons;
+	NameTable	m_requirements;
+};
+
+/* Where an Activity's open spans began */
+struct ActivityTrack {
+	ActivityTrack()
+		: m_stateStart(-1)
+		, m_state(0)
+		, m_queueStart(-1)
+		, m_queue(FlightRecorder::FlightNoQueue)
+	{
+	}
+
+	MojInt64	m_stateStart;
+	unsigned	m_state;
+	MojInt64	m_queueStart;
+	unsigned	m_queue;
+};
+
+enum {
+	StatePid = 1,
+	QueuePid = 2,
+	PersistPid = 3
+};
+
+static void ReadNames(FILE *file, NameTable& names)
+{
+	MojUInt32 count;
+	if (fread(&count, sizeof(count), 1, file) != 1) {
+		throw std::runtime_error("Truncated name table");
+	}
+
+	for (MojUInt32 i = 0; i < count; i++) {
+		std::string name;
+		int c;
+		while ((c = fgetc(file)) != 0) {
+			if (c == EOF) {
+				throw std::runtime_error("Truncated name table");
+			}
+			name += (char)c;
+		}
+		names.push_back(name);
+	}
+}
+
+static void ReadDump(const char *path, FlightDump& dump)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		throw std::runtime_error(std::string("Unable to open ") + path);
+	}
+
+	try {
+		if (fread(&dump.m_header, sizeof(dump.m_header), 1, file) != 1) {
+			throw std::runtime_error("Truncated header");
+		}
+
+		if (memcmp(dump.m_header.m_magic, "AMFLIGHT",
+			sizeof(dump.m_header.m_magic)) != 0) {
+			throw std::runtime_error("Not a flight recorder dump");
+		}
+
+		if ((dump.m_header.m_version != FlightRecorder::DumpVersion) ||
+			(dump.m_header.m_recordSize != sizeof(FlightRecord))) {
+			throw std::runtime_error("Unsupported dump version");
+		}
+
+		dump.m_records.resize((size_t)dump.m_header.m_count);
+		if (!dump.m_records.empty() && (fread(&dump.m_records[0],
+			sizeof(FlightRecord), dump.m_records.size(), file) !=
+				dump.m_records.size())) {
+			throw std::runtime_error("Truncated event records");
+		}
+
+		ReadNames(file, dump.m_states);
+		ReadNames(file, dump.m_queues);
+		ReadNames(file, dump.m_reasons);
+		ReadNames(file, dump.m_requirements);
+	} catch (...) {
+		fclose(file);
+		throw;
+	}
+
+	fclose(file);
+}
+
+static std::string Name(const NameTable& names, unsigned index)
+{
+	if (index < names.size()) {
+		return names[index];
+	}
+
+	char buf[16];
+	snprintf(buf, sizeof(buf), "#%u", index);
+	return buf;
+}
+
+/* Names come from the daemon's own tables, but requirement names may be
+ * anything a caller sent */
+static std::string Quote(const std::string& str)
+{
+	std::string quoted("\"");
+	for (std::string::const_iterator iter = str.begin(); iter != str.end();
+		++iter) {
+		if ((*iter == '"') || (*iter == '\\')) {
+			quoted += '\\';
+			quoted += *iter;
+		} else if ((unsigned char)*iter < 0x20) {
+			quoted += ' ';
+		} else {
+			quoted += *iter;
+		}
+	}
+	quoted += '"';
+	return quoted;
+}
+
+class TraceWriter
+{
+public:
+	TraceWriter(FILE *out)
+		: m_out(out)
+		, m_first(true)
+	{
+		fputs("{\"traceEvents\":[\n", m_out);
+	}
+
+	void Span(unsigned pid, MojUInt64 tid, const std::string& name,
+		MojInt64 start, MojInt64 end, const std::string& args)
+	{
+		Begin();
+		fprintf(m_out, "{\"ph\":\"X\",\"pid\":%u,\"tid\":%llu,\"name\":%s,"
+			"\"ts\":%lld,\"dur\":%lld,\"args\":{%s}}", pid,
+			(unsigned long long)tid, Quote(name).c_str(), (long long)start,
+			(long long)(end - start), args.c_str());
+	}
+
+	void Instant(unsigned pid, MojUInt64 tid, const std::string& name,
+		MojInt64 time, const std::string& args)
+	{
+		Begin();
+		fprintf(m_out, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%llu,"
+			"\"name\":%s,\"ts\":%lld,\"args\":{%s}}", pid,
+			(unsigned long long)tid, Quote(name).c_str(), (long long)time,
+			args.c_str());
+	}
+
+	void Counter(unsigned pid, const std::string& name, MojInt64 time,
+		long value)
+	{
+		Begin();
+		fprintf(m_out, "{\"ph\":\"C\",\"pid\":%u,\"name\":%s,\"ts\":%lld,"
+			"\"args\":{\"depth\":%ld}}", pid, Quote(name).c_str(),
+			(long long)time, value);
+	}
+
+	void ProcessName(unsigned pid, const char *name)
+	{
+		Begin();
+		fprintf(m_out, "{\"ph\":\"M\",\"pid\":%u,\"name\":\"process_name\","
+			"\"args\":{\"name\":\"%s\"}}", pid, name);
+	}
+
+	void ThreadName(unsigned pid, MojUInt64 tid)
+	{
+		Begin();
+		fprintf(m_out, "{\"ph\":\"M\",\"pid\":%u,\"tid\":%llu,"
+			"\"name\":\"thread_name\",\"args\":{\"name\":\"Activity %llu\"}}",
+			pid, (unsigned long long)tid, (unsigned long long)tid);
+	}
+
+	void End(const FlightDump& dump, MojInt64 origin)
+	{
+		MojInt64 originWall = dump.m_header.m_wall -
+			(dump.m_header.m_monotonic - origin);
+
+		fprintf(m_out, "\n],\"displayTimeUnit\":\"ms\",\"metadata\":{"
+			"\"originWallUs\":%lld,\"events\":%llu,\"dropped\":%llu}}\n",
+			(long long)originWall,
+			(unsigned long long)dump.m_header.m_count,
+			(unsigned long long)dump.m_header.m_dropped);
+	}
+
+protected:
+	void Begin()
+	{
+		if (!m_first) {
+			fputs(",\n", m_out);
+		}
+		m_first = false;
+	}
+
+	FILE	*m_out;
+	bool	m_first;
+};
+
+static std::string ReasonArgs(const FlightDump& dump,
+	const FlightRecord& record)
+{
+	std::string args = "\"reason\":" +
+		Quote(Name(dump.m_reasons, record.m_reason));
+
+	if (record.m_reason == FlightReasonCommand) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), ",\"command\":%u",
+			(unsigned)record.m_arg);
+		args += buf;
+	}
+
+	return args;
+}
+
+static void Decode(const FlightDump& dump, FILE *out)
+{
+	TraceWriter writer(out);
+
+	writer.ProcessName(StatePid, "Activity state");
+	writer.ProcessName(QueuePid, "Run queues");
+	writer.ProcessName(PersistPid, "Persist");
+
+	if (dump.m_records.empty()) {
+		writer.End(dump, dump.m_header.m_monotonic);
+		return;
+	}
+
+	MojInt64 origin = dump.m_records.front().m_time;
+	MojInt64 end = dump.m_header.m_monotonic - origin;
+
+	typedef std::map<MojUInt64, ActivityTrack> TrackMap;
+	TrackMap tracks;
+
+	std::vector<long> depth(dump.m_queues.size(), 0);
+
+	for (std::vector<FlightRecord>::const_iterator iter =
+		dump.m_records.begin(); iter != dump.m_records.end(); ++iter) {
+		const FlightRecord& record = *iter;
+		MojInt64 time = record.m_time - origin;
+
+		TrackMap::iterator found = tracks.find(record.m_activity);
+		if (found == tracks.end()) {
+			found = tracks.insert(TrackMap::value_type(record.m_activity,
+				ActivityTrack())).first;
+			writer.ThreadName(StatePid, record.m_activity);
+			writer.ThreadName(QueuePid, record.m_activity);
+			writer.ThreadName(PersistPid, record.m_activity);
+		}
+
+		ActivityTrack& track = found->second;
+
+		switch (record.m_type) {
+		case FlightStateEvent:
+			/* An Activity first seen mid-flight has been in its old state
+			 * since at least the start of the dump */
+			if ((track.m_stateStart >= 0) || (record.m_from != 0)) {
+				writer.Span(StatePid, record.m_activity,
+					Name(dump.m_states, record.m_from),
+					(track.m_stateStart >= 0) ? track.m_stateStart : 0,
+					time, "");
+			}
+			writer.Instant(StatePid, record.m_activity,
+				Name(dump.m_states, record.m_from) + " -> " +
+				Name(dump.m_states, record.m_to), time,
+				ReasonArgs(dump, record));
+			track.m_stateStart = time;
+			track.m_state = record.m_to;
+			break;
+
+		case FlightQueueEvent:
+			if (track.m_queue != FlightRecorder::FlightNoQueue) {
+				writer.Span(QueuePid, record.m_activity,
+					Name(dump.m_queues, track.m_queue), track.m_queueStart,
+					time, "");
+
+				if (track.m_queue < depth.size()) {
+					writer.Counter(QueuePid,
+						Name(dump.m_queues, track.m_queue), time,
+						--depth[track.m_queue]);
+				}
+			}
+
+			track.m_queue = record.m_to;
+			track.m_queueStart = time;
+
+			if (track.m_queue < depth.size()) {
+				writer.Counter(QueuePid, Name(dump.m_queues, track.m_queue),
+					time, ++depth[track.m_queue]);
+			}
+			break;
+
+		case FlightRequirementMetEvent:
+		case FlightRequirementUnmetEvent:
+			writer.Instant(StatePid, record.m_activity,
+				std::string((record.m_type == FlightRequirementMetEvent) ?
+					"met: " : "unmet: ") +
+				Name(dump.m_requirements, record.m_reason), time, "");
+			break;
+
+		case FlightPersistEvent: {
+			MojInt64 latency = (MojInt64)record.m_arg * 1000LL;
+			writer.Span(PersistPid, record.m_activity,
+				record.m_to ? "persist" : "persist (failed)",
+				(time > latency) ? (time - latency) : 0, time, "");
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	/* Close whatever is still open at the time of the dump */
+	for (TrackMap::const_iterator iter = tracks.begin();
+		iter != tracks.end(); ++iter) {
+		const ActivityTrack& track = iter->second;
+
+		if (track.m_stateStart >= 0) {
+			writer.Span(StatePid, iter->first,
+				Name(dump.m_states, track.m_state), track.m_stateStart, end,
+				"");
+		}
+
+		if (track.m_queue != FlightRecorder::FlightNoQueue) {
+			writer.Span(QueuePid, iter->first,
+				Name(dump.m_queues, track.m_queue), track.m_queueStart, end,
+				"");
+		}
+	}
+
+	writer.End(dump, origin);
+}
+
+int main(int argc, char **argv)
+{
+	if ((argc < 2) || (argc > 3)) {
+		fprintf(stderr, "Usage: %s <dump> [<output>]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *out = stdout;
+
+	try {
+		FlightDump dump;
+		ReadDump(argv[1], dump);
+
+		if (argc > 2) {
+			out = fopen(argv[2], "w");
+			if (!out) {
+				throw std::runtime_error(std::string("Unable to open ") +
+					argv[2]);
+			}
+		}
+
+		Decode(dump, out);
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Decode failed: %s\n", except.what());
+		return 1;
+	}
+
+	if ((out != stdout) && (fclose(out) != 0)) {
+		fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+
+	return 0;
+}
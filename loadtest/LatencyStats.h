@@ -0,0 +1,71 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_LATENCYSTATS_H__
+#define __ACTIVITYMANAGER_LATENCYSTATS_H__
+
+#include "Base.h"
+
+#include <algorithm>
+#include <vector>
+
+/* Latency samples in nanoseconds, summarized once a run is over */
+class LatencyStats {
+public:
+	void Add(MojInt64 ns)
+	{
+		m_samples.push_back(ns);
+	}
+
+	size_t GetCount() const
+	{
+		return m_samples.size();
+	}
+
+	/* Sorts in place; call once the run is over */
+	MojInt64 GetPercentile(double pct)
+	{
+		if (m_samples.empty()) {
+			return 0;
+		}
+
+		std::sort(m_samples.begin(), m_samples.end());
+		size_t index = (size_t)(pct * (double)(m_samples.size() - 1) / 100.0);
+		return m_samples[index];
+	}
+
+	double GetMean() const
+	{
+		if (m_samples.empty()) {
+			return 0.0;
+		}
+
+		double total = 0.0;
+		for (std::vector<MojInt64>::const_iterator iter = m_samples.begin();
+			iter != m_samples.end(); ++iter) {
+			total += (double)*iter;
+		}
+
+		return total / (double)m_samples.size();
+	}
+
+protected:
+	std::vector<MojInt64>	m_samples;
+};
+
+#endif /* __ACTIVITYMANAGER_LATENCYSTATS_H__ */
@@ -0,0 +1,449 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * End-to-end load generator.  Runs the real ActivityCategoryHandler,
+ * ActivityManager, scheduler and proxies against FakeBusService in a single
+ * process, and drives create -> callback -> complete cycles through it.
+ *
+ * Usage: activitymanager-loadtest [options]
+ *   --cycles=<n>             Total cycles to run (default 10000)
+ *   --concurrency=<n>        Cycles kept in flight (default 16)
+ *   --persist                Make Activities persistent (exercises db8)
+ *   --power                  Make Activities hold power (exercises powerd)
+ *   --db-latency=<ms>        Fake db8 reply latency
+ *   --power-latency=<ms>     Fake powerd reply latency
+ *   --callback-latency=<ms>  Time the fake client spends "working"
+ *   --jitter=<ms>            Random extra latency added to all of the above
+ *   --timeout=<secs>         Abort if the run takes longer (default 600)
+ *   --format=console|json
+ */
+
+#include "FakeDaemon.h"
+#include "LatencyStats.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <unistd.h>
+
+#include <boost/lexical_cast.hpp>
+
+static const char *LoadTestServiceName = "com.palm.loadtest";
+
+struct LoadTestOptions {
+	LoadTestOptions()
+		: m_cycles(10000)
+		, m_concurrency(16)
+		, m_persist(false)
+		, m_power(false)
+		, m_dbLatency(0)
+		, m_powerLatency(0)
+		, m_callbackLatency(0)
+		, m_jitter(0)
+		, m_timeout(600)
+		, m_json(false)
+	{
+	}
+
+	unsigned	m_cycles;
+	unsigned	m_concurrency;
+	bool		m_persist;
+	bool		m_power;
+	unsigned	m_dbLatency;
+	unsigned	m_powerLatency;
+	unsigned	m_callbackLatency;
+	unsigned	m_jitter;
+	unsigned	m_timeout;
+	bool		m_json;
+};
+
+class LoadTest;
+
+/* Receives the Activity callbacks the daemon makes to the fake client */
+class LoadTestClient : public FakeBusEndpoint
+{
+public:
+	LoadTestClient(LoadTest *test) : m_test(test) {}
+
+	virtual void HandleCall(boost::shared_ptr<FakeBusCall> call);
+
+protected:
+	LoadTest	*m_test;
+};
+
+class LoadTest
+{
+public:
+	LoadTest(const LoadTestOptions& options);
+	virtual ~LoadTest();
+
+	void Init();
+	int Run();
+	void Report();
+
+	void CallbackReceived(boost::shared_ptr<FakeBusCall> call);
+
+protected:
+	void StartCycle();
+	void CreateResponse(unsigned cycle, MojInt64 sent,
+		const MojObject& response);
+	void SendComplete(unsigned cycle, MojInt64 activityId);
+	void CompleteResponse(unsigned cycle, MojInt64 sent,
+		const MojObject& response);
+	void FinishCycle(unsigned cycle, bool succeeded);
+
+	void PrintConsole();
+	void PrintJson();
+
+	LoadTestOptions	m_options;
+
+	FakeDaemon		m_daemon;
+	FakeBusService&	m_bus;
+
+	BusId	m_client;
+
+	unsigned	m_started;
+	unsigned	m_finished;
+	unsigned	m_failed;
+
+	std::map<unsigned, MojInt64>	m_cycleStart;
+
+	LatencyStats	m_createLatency;
+	LatencyStats	m_completeLatency;
+	LatencyStats	m_callbackLatency;
+	LatencyStats	m_cycleLatency;
+
+	MojInt64	m_runStart;
+	MojInt64	m_runEnd;
+};
+
+LoadTest::LoadTest(const LoadTestOptions& options)
+	: m_options(options)
+	, m_bus(m_daemon.GetBus())
+	, m_client(LoadTestServiceName, BusService)
+	, m_started(0)
+	, m_finished(0)
+	, m_failed(0)
+	, m_runStart(0)
+	, m_runEnd(0)
+{
+}
+
+LoadTest::~LoadTest()
+{
+}
+
+void LoadTest::Init()
+{
+	m_daemon.GetDb8()->SetLatency(m_options.m_dbLatency, m_options.m_jitter);
+	m_daemon.GetPowerd()->SetLatency(m_options.m_powerLatency,
+		m_options.m_jitter);
+
+	m_bus.AddEndpoint(LoadTestServiceName,
+		boost::make_shared<LoadTestClient>(this));
+
+	m_daemon.Init();
+}
+
+int LoadTest::Run()
+{
+	m_runStart = FakeBusService::Now();
+	MojInt64 deadline = m_runStart +
+		((MojInt64)m_options.m_timeout * 1000000000LL);
+
+	while ((m_started < m_options.m_concurrency) &&
+		(m_started < m_options.m_cycles)) {
+		StartCycle();
+	}
+
+	while (m_finished < m_options.m_cycles) {
+		if (!m_bus.RunOnce()) {
+			if (FakeBusService::Now() > deadline) {
+				fprintf(stderr, "Timed out with %u of %u cycles finished\n",
+					m_finished, m_options.m_cycles);
+				break;
+			}
+
+			/* Waiting on scripted latency; don't spin the CPU that the
+			 * daemon code is being measured on. */
+			usleep(50);
+		}
+	}
+
+	m_runEnd = FakeBusService::Now();
+
+	return (m_finished == m_options.m_cycles) && !m_failed ? 0 : 1;
+}
+
+void LoadTest::StartCycle()
+{
+	unsigned cycle = m_started++;
+
+	MojObject type;
+	type.putBool(_T("background"), true);
+	type.putBool(_T("persist"), m_options.m_persist);
+	type.putBool(_T("power"), m_options.m_power);
+
+	MojObject params;
+	params.putInt(_T("cycle"), (MojInt64)cycle);
+
+	MojObject callback;
+	callback.putString(_T("method"),
+		(std::string("palm://") + LoadTestServiceName + "/run").c_str());
+	callback.put(_T("params"), params);
+
+	MojObject activity;
+	activity.putString(_T("name"), ("loadtest." +
+		boost::lexical_cast<std::string>(cycle)).c_str());
+	activity.putString(_T("description"), _T("Load test Activity"));
+	activity.put(_T("type"), type);
+	activity.put(_T("callback"), callback);
+
+	MojObject payload;
+	payload.put(_T("activity"), activity);
+	payload.putBool(_T("start"), true);
+
+	MojInt64 now = FakeBusService::Now();
+	m_cycleStart[cycle] = now;
+
+	m_bus.Call("/", "create", payload, m_client, false,
+		boost::bind(&LoadTest::CreateResponse, this, cycle, now, _1));
+}
+
+void LoadTest::CreateResponse(unsigned cycle, MojInt64 sent,
+	const MojObject& response)
+{
+	m_createLatency.Add(FakeBusService::Now() - sent);
+
+	bool returnValue = false;
+	response.get(MojServiceMessage::ReturnValueKey, returnValue);
+	if (!returnValue) {
+		FinishCycle(cycle, false);
+	}
+}
+
+void LoadTestClient::HandleCall(boost::shared_ptr<FakeBusCall> call)
+{
+	m_test->CallbackReceived(call);
+}
+
+/* The daemon has run the Activity's callback */
+void LoadTest::CallbackReceived(boost::shared_ptr<FakeBusCall> call)
+{
+	const MojObject& payload = call->GetPayload();
+
+	MojInt64 cycle = 0;
+	bool found = false;
+	payload.get(_T("cycle"), cycle, found);
+
+	MojObject activityInfo;
+	MojInt64 activityId = 0;
+	bool foundId = false;
+	if (payload.get(_T("$activity"), activityInfo)) {
+		activityInfo.get(_T("activityId"), activityId, foundId);
+	}
+
+	if (!found || !foundId) {
+		call->ReplyError(MojErrInvalidArg, "Missing cycle or activityId");
+		return;
+	}
+
+	std::map<unsigned, MojInt64>::const_iterator start =
+		m_cycleStart.find((unsigned)cycle);
+	if (start != m_cycleStart.end()) {
+		m_callbackLatency.Add(FakeBusService::Now() - start->second);
+	}
+
+	call->ReplySuccess();
+
+	m_bus.Post(m_options.m_callbackLatency, boost::bind(
+		&LoadTest::SendComplete, this, (unsigned)cycle, activityId));
+}
+
+void LoadTest::SendComplete(unsigned cycle, MojInt64 activityId)
+{
+	MojObject payload;
+	payload.putInt(_T("activityId"), activityId);
+
+	m_bus.Call("/", "complete", payload, m_client, false,
+		boost::bind(&LoadTest::CompleteResponse, this, cycle,
+			FakeBusService::Now(), _1));
+}
+
+void LoadTest::CompleteResponse(unsigned cycle, MojInt64 sent,
+	const MojObject& response)
+{
+	m_completeLatency.Add(FakeBusService::Now() - sent);
+
+	bool returnValue = false;
+	response.get(MojServiceMessage::ReturnValueKey, returnValue);
+	FinishCycle(cycle, returnValue);
+}
+
+void LoadTest::FinishCycle(unsigned cycle, bool succeeded)
+{
+	std::map<unsigned, MojInt64>::iterator start = m_cycleStart.find(cycle);
+	if (start == m_cycleStart.end()) {
+		return;
+	}
+
+	if (succeeded) {
+		m_cycleLatency.Add(FakeBusService::Now() - start->second);
+	} else {
+		m_failed++;
+	}
+
+	m_cycleStart.erase(start);
+	m_finished++;
+
+	if (m_started < m_options.m_cycles) {
+		StartCycle();
+	}
+}
+
+void LoadTest::Report()
+{
+	if (m_options.m_json) {
+		PrintJson();
+	} else {
+		PrintConsole();
+	}
+}
+
+static void PrintStatsConsole(const char *name, LatencyStats& stats)
+{
+	fprintf(stdout, "%-10s %8zu %10.1f %10.1f %10.1f %10.1f\n", name,
+		stats.GetCount(), stats.GetMean() / 1000.0,
+		(double)stats.GetPercentile(50.0) / 1000.0,
+		(double)stats.GetPercentile(99.0) / 1000.0,
+		(double)stats.GetPercentile(100.0) / 1000.0);
+}
+
+void LoadTest::PrintConsole()
+{
+	double seconds = (double)(m_runEnd - m_runStart) / 1e9;
+
+	fprintf(stdout, "Cycles: %u finished, %u failed in %.3f s "
+		"(%.1f cycles/s)\n", m_finished, m_failed, seconds,
+		(seconds > 0.0) ? (double)m_finished / seconds : 0.0);
+	fprintf(stdout, "Bus: %llu requests in, %llu replies out\n",
+		m_bus.GetRequestCount(), m_bus.GetReplyCount());
+	fprintf(stdout, "Fake db8 objects remaining: %zu, peak power "
+		"activities: %u\n\n", m_daemon.GetDb8()->GetObjectCount(),
+		m_daemon.GetPowerd()->GetMaxPowerActivities());
+
+	fprintf(stdout, "%-10s %8s %10s %10s %10s %10s\n", "Latency", "Count",
+		"Mean(us)", "p50(us)", "p99(us)", "Max(us)");
+	PrintStatsConsole("create", m_createLatency);
+	PrintStatsConsole("callback", m_callbackLatency);
+	PrintStatsConsole("complete", m_completeLatency);
+	PrintStatsConsole("cycle", m_cycleLatency);
+}
+
+static void PrintStatsJson(const char *name, LatencyStats& stats, bool last)
+{
+	fprintf(stdout, "    \"%s\": {\"count\": %zu, \"mean_ns\": %.0f, "
+		"\"p50_ns\": %lld, \"p99_ns\": %lld, \"max_ns\": %lld}%s\n", name,
+		stats.GetCount(), stats.GetMean(),
+		(long long)stats.GetPercentile(50.0),
+		(long long)stats.GetPercentile(99.0),
+		(long long)stats.GetPercentile(100.0), last ? "" : ",");
+}
+
+void LoadTest::PrintJson()
+{
+	double seconds = (double)(m_runEnd - m_runStart) / 1e9;
+
+	fprintf(stdout, "{\n");
+	fprintf(stdout, "  \"cycles\": %u,\n", m_finished);
+	fprintf(stdout, "  \"failed\": %u,\n", m_failed);
+	fprintf(stdout, "  \"seconds\": %.6f,\n", seconds);
+	fprintf(stdout, "  \"cycles_per_second\": %.3f,\n",
+		(seconds > 0.0) ? (double)m_finished / seconds : 0.0);
+	fprintf(stdout, "  \"bus_requests\": %llu,\n", m_bus.GetRequestCount());
+	fprintf(stdout, "  \"bus_replies\": %llu,\n", m_bus.GetReplyCount());
+	fprintf(stdout, "  \"peak_power_activities\": %u,\n",
+		m_daemon.GetPowerd()->GetMaxPowerActivities());
+	fprintf(stdout, "  \"latency\": {\n");
+	PrintStatsJson("create", m_createLatency, false);
+	PrintStatsJson("callback", m_callbackLatency, false);
+	PrintStatsJson("complete", m_completeLatency, false);
+	PrintStatsJson("cycle", m_cycleLatency, true);
+	fprintf(stdout, "  }\n}\n");
+}
+
+static bool ParseUnsigned(const char *arg, const char *prefix,
+	unsigned& value)
+{
+	size_t len = strlen(prefix);
+	if (strncmp(arg, prefix, len) != 0) {
+		return false;
+	}
+
+	value = (unsigned)strtoul(arg + len, NULL, 10);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	LoadTestOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (ParseUnsigned(arg, "--cycles=", options.m_cycles) ||
+			ParseUnsigned(arg, "--concurrency=", options.m_concurrency) ||
+			ParseUnsigned(arg, "--db-latency=", options.m_dbLatency) ||
+			ParseUnsigned(arg, "--power-latency=", options.m_powerLatency) ||
+			ParseUnsigned(arg, "--callback-latency=",
+				options.m_callbackLatency) ||
+			ParseUnsigned(arg, "--jitter=", options.m_jitter) ||
+			ParseUnsigned(arg, "--timeout=", options.m_timeout)) {
+			continue;
+		} else if (strcmp(arg, "--persist") == 0) {
+			options.m_persist = true;
+		} else if (strcmp(arg, "--power") == 0) {
+			options.m_power = true;
+		} else if (strcmp(arg, "--format=json") == 0) {
+			options.m_json = true;
+		} else if (strcmp(arg, "--format=console") == 0) {
+			options.m_json = false;
+		} else {
+			fprintf(stderr, "Unknown option \"%s\"\n", arg);
+			return 1;
+		}
+	}
+
+	if (!options.m_concurrency) {
+		options.m_concurrency = 1;
+	}
+
+	try {
+		LoadTest test(options);
+		test.Init();
+		int result = test.Run();
+		test.Report();
+		return result;
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Load test failed: %s\n", except.what());
+		return 1;
+	}
+}
@@ -0,0 +1,758 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * Replays a workload trace recorded with devel/startRecording.  The real
+ * ActivityCategoryHandler, ActivityManager, scheduler and proxies run
+ * against FakeBusService, as in the load tester; recorded requests are
+ * injected as if from their original callers, and recorded subscription
+ * updates are delivered to whichever of the daemon's subscriptions match.
+ *
+ * Activity ids differ between the recording and the replay, so the ids in
+ * replayed requests are mapped onto the ones the replay assigned.  A
+ * request that names an Activity whose create hasn't been answered yet
+ * waits for the answer.
+ *
+ * Only requests to the "/" category are replayed.  Activities that existed
+ * when recording started are recreated from the start record before
+ * anything else.  That recreation is approximate: they are created afresh,
+ * so (for example) triggers that had already fired will be armed again.
+ *
+ * At the end the final state of each Activity is compared with the state
+ * recorded when recording stopped.
+ *
+ * Usage: activitymanager-replay [options] <trace>
+ *   --speed=<n>              Replay at n times the recorded pace (default 1)
+ *   --speed=max              Replay as fast as the daemon will go
+ *   --db-latency=<ms>        Fake db8 reply latency
+ *   --power-latency=<ms>     Fake powerd reply latency
+ *   --jitter=<ms>            Random extra latency added to the above
+ *   --settle=<secs>          Time allowed to go idle after the last record
+ *                            (default 5)
+ *   --format=console|json
+ *
+ * Exits with 0 if every Activity ended in its recorded state.
+ */
+
+#include "FakeDaemon.h"
+#include "LatencyStats.h"
+
+#include "ActivityManager.h"
+#include "MojoObjectWrapper.h"
+#include "MojoURL.h"
+#include "WorkloadRecorder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+struct ReplayOptions {
+	ReplayOptions()
+		: m_speed(1.0)
+		, m_dbLatency(0)
+		, m_powerLatency(0)
+		, m_jitter(0)
+		, m_settle(5)
+		, m_json(false)
+	{
+	}
+
+	/* 0 replays as fast as possible */
+	double		m_speed;
+	unsigned	m_dbLatency;
+	unsigned	m_powerLatency;
+	unsigned	m_jitter;
+	unsigned	m_settle;
+	bool		m_json;
+
+	std::string	m_trace;
+};
+
+/* Id the replay assigned to an Activity, once its create is answered */
+struct ReplayId {
+	ReplayId() : m_id(0), m_resolved(false) {}
+
+	MojInt64	m_id;
+	bool		m_resolved;
+};
+
+struct ReplayRequest {
+	ReplayRequest(const std::string& method, boost::shared_ptr<ReplayId> id)
+		: m_method(method)
+		, m_sent(FakeBusService::Now())
+		, m_replied(false)
+		, m_id(id)
+	{
+	}
+
+	std::string	m_method;
+	MojInt64	m_sent;
+	bool		m_replied;
+
+	boost::shared_ptr<ReplayId>	m_id;
+};
+
+class Replay
+{
+public:
+	Replay(const ReplayOptions& options);
+	virtual ~Replay();
+
+	void Load();
+	void Init();
+	int Run();
+	void Report();
+
+protected:
+	void Seed(const MojObject& activities);
+	void ReplayCall(const MojObject& record);
+	void ReplaySignal(const MojObject& record);
+
+	void Send(const std::string& method, MojObject& payload,
+		const BusId& sender, bool isPublic, boost::shared_ptr<ReplayId> id);
+	void RequestResponse(boost::shared_ptr<ReplayRequest> request,
+		const MojObject& response);
+
+	bool MapActivityId(MojObject& payload);
+
+	void WaitUntil(MojInt64 when);
+	void Settle();
+	void Diff();
+
+	void PrintConsole();
+	void PrintJson();
+
+	typedef std::map<MojInt64, boost::shared_ptr<ReplayId> > IdMap;
+	typedef std::map<std::string, LatencyStats> MethodStats;
+	typedef std::map<std::string, unsigned> MethodCounts;
+	typedef std::map<std::string, std::string> StateMap;
+
+	ReplayOptions	m_options;
+
+	FakeDaemon		m_daemon;
+	FakeBusService&	m_bus;
+
+	std::vector<MojObject>	m_records;
+	MojObject				m_startActivities;
+	MojObject				m_endActivities;
+	bool					m_hasEnd;
+
+	IdMap	m_ids;
+	boost::shared_ptr<ReplayId>	m_lastCreate;
+
+	MethodStats		m_latency;
+	MethodCounts	m_failures;
+
+	unsigned	m_seeded;
+	unsigned	m_requests;
+	unsigned	m_skipped;
+	unsigned	m_unresolved;
+	unsigned	m_signals;
+	unsigned	m_undelivered;
+
+	unsigned	m_matched;
+	std::vector<std::string>	m_differ;
+	std::vector<std::string>	m_missing;
+	std::vector<std::string>	m_extra;
+
+	MojInt64	m_runStart;
+	MojInt64	m_runEnd;
+};
+
+Replay::Replay(const ReplayOptions& options)
+	: m_options(options)
+	, m_bus(m_daemon.GetBus())
+	, m_startActivities(MojObject::TypeArray)
+	, m_endActivities(MojObject::TypeArray)
+	, m_hasEnd(false)
+	, m_seeded(0)
+	, m_requests(0)
+	, m_skipped(0)
+	, m_unresolved(0)
+	, m_signals(0)
+	, m_undelivered(0)
+	, m_matched(0)
+	, m_runStart(0)
+	, m_runEnd(0)
+{
+}
+
+Replay::~Replay()
+{
+}
+
+void Replay::Load()
+{
+	std::ifstream trace(m_options.m_trace.c_str());
+	if (!trace) {
+		throw std::runtime_error("Unable to open " + m_options.m_trace);
+	}
+
+	std::string line;
+	unsigned lineNumber = 0;
+	while (std::getline(trace, line)) {
+		lineNumber++;
+		if (line.empty()) {
+			continue;
+		}
+
+		MojObject record;
+		MojErr err = record.fromJson(line.c_str());
+		if (err) {
+			throw std::runtime_error("Malformed record at line " +
+				boost::lexical_cast<std::string>(lineNumber));
+		}
+
+		MojString kind;
+		bool found = false;
+		record.get(_T("k"), kind, found);
+
+		if (found && (kind == "start")) {
+			record.get(_T("a"), m_startActivities);
+		} else if (found && (kind == "end")) {
+			record.get(_T("a"), m_endActivities);
+			m_hasEnd = true;
+		} else {
+			m_records.push_back(record);
+		}
+	}
+}
+
+void Replay::Init()
+{
+	m_daemon.GetDb8()->SetLatency(m_options.m_dbLatency, m_options.m_jitter);
+	m_daemon.GetPowerd()->SetLatency(m_options.m_powerLatency,
+		m_options.m_jitter);
+
+	m_daemon.Init();
+}
+
+int Replay::Run()
+{
+	Seed(m_startActivities);
+
+	m_runStart = FakeBusService::Now();
+
+	for (std::vector<MojObject>::const_iterator iter = m_records.begin();
+		iter != m_records.end(); ++iter) {
+		MojString kind;
+		bool found = false;
+		iter->get(_T("k"), kind, found);
+
+		if (found && (kind == "id")) {
+			/* Follows the create that assigned it */
+			MojInt64 recordedId = 0;
+			bool foundId = false;
+			iter->get(_T("i"), recordedId, foundId);
+			if (foundId && m_lastCreate) {
+				m_ids[recordedId] = m_lastCreate;
+			}
+			m_lastCreate.reset();
+			continue;
+		}
+
+		m_lastCreate.reset();
+
+		if (m_options.m_speed > 0.0) {
+			MojInt64 t = 0;
+			iter->get(_T("t"), t, found);
+			WaitUntil(m_runStart +
+				(MojInt64)((double)t * 1000000.0 / m_options.m_speed));
+		} else {
+			m_bus.RunOnce();
+		}
+
+		if (kind == "call") {
+			ReplayCall(*iter);
+		} else if (kind == "signal") {
+			ReplaySignal(*iter);
+		}
+	}
+
+	Settle();
+
+	m_runEnd = FakeBusService::Now();
+
+	Diff();
+
+	return (m_hasEnd && m_differ.empty() && m_missing.empty() &&
+		m_extra.empty()) ? 0 : 1;
+}
+
+/* Recreate the Activities that existed when recording started */
+void Replay::Seed(const MojObject& activities)
+{
+	for (MojObject::ConstArrayIterator iter = activities.arrayBegin();
+		iter != activities.arrayEnd(); ++iter) {
+		MojObject activity;
+		if (!iter->get(_T("activity"), activity)) {
+			continue;
+		}
+
+		activity.del(_T("activityId"));
+		activity.del(_T("_id"));
+		activity.del(_T("_rev"));
+		activity.del(_T("_kind"));
+
+		MojObject creator;
+		iter->get(_T("creator"), creator);
+
+		MojString id;
+		bool found = false;
+		BusIdType type = BusAnon;
+		creator.get(_T("appId"), id, found);
+		if (found) {
+			type = BusApp;
+		} else {
+			creator.get(_T("serviceId"), id, found);
+			if (found) {
+				type = BusService;
+			} else {
+				creator.get(_T("anonId"), id, found);
+			}
+		}
+
+		MojString state;
+		iter->get(_T("state"), state, found);
+
+		MojObject payload;
+		payload.put(_T("activity"), activity);
+		payload.putBool(_T("start"), !found || (state != "init"));
+		payload.putBool(_T("replace"), true);
+		payload.putBool(_T("subscribe"), !activity.contains(_T("callback")));
+
+		boost::shared_ptr<ReplayId> replayId =
+			boost::make_shared<ReplayId>();
+
+		MojInt64 recordedId = 0;
+		iter->get(_T("activityId"), recordedId, found);
+		if (found) {
+			m_ids[recordedId] = replayId;
+		}
+
+		Send(std::string(), payload, BusId(id.data(), type), false, replayId);
+		m_seeded++;
+	}
+
+	Settle();
+}
+
+void Replay::ReplayCall(const MojObject& record)
+{
+	MojString category;
+	bool found = false;
+	record.get(_T("c"), category, found);
+	if (!found || (category != "/")) {
+		m_skipped++;
+		return;
+	}
+
+	MojString method;
+	record.get(_T("m"), method, found);
+
+	MojString sender;
+	record.get(_T("s"), sender, found);
+
+	MojInt64 type = BusAnon;
+	record.get(_T("st"), type, found);
+
+	bool isPublic = false;
+	record.get(_T("pub"), isPublic);
+
+	MojObject payload;
+	record.get(_T("p"), payload);
+
+	if (!MapActivityId(payload)) {
+		m_unresolved++;
+	}
+
+	boost::shared_ptr<ReplayId> replayId;
+	if (method == "create") {
+		replayId = boost::make_shared<ReplayId>();
+		m_lastCreate = replayId;
+	}
+
+	Send(method.data(), payload, BusId(sender.data(), (BusIdType)type),
+		isPublic, replayId);
+	m_requests++;
+}
+
+void Replay::ReplaySignal(const MojObject& record)
+{
+	MojString url;
+	bool found = false;
+	record.get(_T("u"), url, found);
+
+	MojObject params;
+	record.get(_T("q"), params);
+
+	MojObject response;
+	record.get(_T("p"), response);
+
+	MojoURL target(url);
+
+	m_signals++;
+	if (!m_bus.Publish(target.GetTargetService().data(),
+		target.GetMethod().data(), params, response)) {
+		m_undelivered++;
+	}
+}
+
+void Replay::Send(const std::string& method, MojObject& payload,
+	const BusId& sender, bool isPublic, boost::shared_ptr<ReplayId> id)
+{
+	/* An empty method marks one of the creates made by Seed(), which
+	 * aren't part of the measured workload */
+	boost::shared_ptr<ReplayRequest> request =
+		boost::make_shared<ReplayRequest>(method, id);
+
+	m_bus.Call("/", method.empty() ? "create" : method, payload, sender,
+		isPublic, boost::bind(&Replay::RequestResponse, this, request, _1));
+}
+
+void Replay::RequestResponse(boost::shared_ptr<ReplayRequest> request,
+	const MojObject& response)
+{
+	if (request->m_id && !request->m_id->m_resolved) {
+		bool found = false;
+		response.get(_T("activityId"), request->m_id->m_id, found);
+		request->m_id->m_resolved = found;
+	}
+
+	if (request->m_replied) {
+		return;
+	}
+
+	request->m_replied = true;
+
+	if (request->m_method.empty()) {
+		return;
+	}
+
+	m_latency[request->m_method].Add(FakeBusService::Now() - request->m_sent);
+
+	bool returnValue = false;
+	response.get(MojServiceMessage::ReturnValueKey, returnValue);
+	if (!returnValue) {
+		m_failures[request->m_method]++;
+	}
+}
+
+/* Rewrite the request's activityId to the one the replay assigned,
+ * waiting for the create to be answered if need be.  Returns false if
+ * that doesn't happen. */
+bool Replay::MapActivityId(MojObject& payload)
+{
+	MojInt64 recordedId = 0;
+	bool found = false;
+	payload.get(_T("activityId"), recordedId, found);
+	if (!found) {
+		return true;
+	}
+
+	IdMap::const_iterator mapped = m_ids.find(recordedId);
+	if (mapped == m_ids.end()) {
+		return false;
+	}
+
+	boost::shared_ptr<ReplayId> id = mapped->second;
+
+	MojInt64 deadline = FakeBusService::Now() +
+		((MojInt64)m_options.m_settle * 1000000000LL);
+	while (!id->m_resolved && (FakeBusService::Now() < deadline)) {
+		if (!m_bus.RunOnce()) {
+			usleep(50);
+		}
+	}
+
+	if (!id->m_resolved) {
+		return false;
+	}
+
+	payload.putInt(_T("activityId"), id->m_id);
+	return true;
+}
+
+void Replay::WaitUntil(MojInt64 when)
+{
+	do {
+		if (!m_bus.RunOnce() && (FakeBusService::Now() < when)) {
+			usleep(50);
+		}
+	} while (FakeBusService::Now() < when);
+}
+
+void Replay::Settle()
+{
+	MojInt64 deadline = FakeBusService::Now() +
+		((MojInt64)m_options.m_settle * 1000000000LL);
+
+	while (FakeBusService::Now() < deadline) {
+		if (!m_bus.RunOnce()) {
+			if (!m_bus.HasPending()) {
+				break;
+			}
+
+			usleep(50);
+		}
+	}
+}
+
+static std::string ActivityKey(const MojObject& activity)
+{
+	MojObject creator;
+	activity.get(_T("creator"), creator);
+
+	MojString name;
+	bool found = false;
+	activity.get(_T("name"), name, found);
+
+	return MojoObjectJson(creator).str() + " " + name.data();
+}
+
+static void ActivityStates(const MojObject& activities, std::map<std::string,
+	std::string>& states)
+{
+	for (MojObject::ConstArrayIterator iter = activities.arrayBegin();
+		iter != activities.arrayEnd(); ++iter) {
+		MojString state;
+		bool found = false;
+		iter->get(_T("state"), state, found);
+
+		states[ActivityKey(*iter)] = state.data();
+	}
+}
+
+void Replay::Diff()
+{
+	if (!m_hasEnd) {
+		return;
+	}
+
+	MojObject replayed(MojObject::TypeArray);
+	MojErr err = WorkloadRecorder::ActivitiesToJson(
+		m_daemon.GetActivityManager(), replayed, false);
+	if (err) {
+		throw std::runtime_error("Failed to collect final Activity state");
+	}
+
+	StateMap recordedStates;
+	StateMap replayedStates;
+	ActivityStates(m_endActivities, recordedStates);
+	ActivityStates(replayed, replayedStates);
+
+	for (StateMap::const_iterator iter = recordedStates.begin();
+		iter != recordedStates.end(); ++iter) {
+		StateMap::const_iterator found = replayedStates.find(iter->first);
+		if (found == replayedStates.end()) {
+			m_missing.push_back(iter->first);
+		} else if (found->second != iter->second) {
+			m_differ.push_back(iter->first + ": recorded " + iter->second +
+				", replayed " + found->second);
+		} else {
+			m_matched++;
+		}
+	}
+
+	for (StateMap::const_iterator iter = replayedStates.begin();
+		iter != replayedStates.end(); ++iter) {
+		if (recordedStates.find(iter->first) == recordedStates.end()) {
+			m_extra.push_back(iter->first + ": " + iter->second);
+		}
+	}
+}
+
+void Replay::Report()
+{
+	if (m_options.m_json) {
+		PrintJson();
+	} else {
+		PrintConsole();
+	}
+}
+
+static void PrintListConsole(const char *title,
+	const std::vector<std::string>& list)
+{
+	for (std::vector<std::string>::const_iterator iter = list.begin();
+		iter != list.end(); ++iter) {
+		fprintf(stdout, "  %s %s\n", title, iter->c_str());
+	}
+}
+
+void Replay::PrintConsole()
+{
+	double seconds = (double)(m_runEnd - m_runStart) / 1e9;
+
+	fprintf(stdout, "Replayed %u requests (%u skipped, %u with unmapped "
+		"activity ids) and %u signals (%u undelivered) in %.3f s\n",
+		m_requests, m_skipped, m_unresolved, m_signals, m_undelivered,
+		seconds);
+	fprintf(stdout, "Seeded %u Activities from the start of the trace\n\n",
+		m_seeded);
+
+	fprintf(stdout, "%-24s %8s %6s %10s %10s %10s %10s\n", "Method", "Count",
+		"Failed", "Mean(us)", "p50(us)", "p99(us)", "Max(us)");
+	for (MethodStats::iterator iter = m_latency.begin();
+		iter != m_latency.end(); ++iter) {
+		LatencyStats& stats = iter->second;
+		fprintf(stdout, "%-24s %8zu %6u %10.1f %10.1f %10.1f %10.1f\n",
+			iter->first.c_str(), stats.GetCount(), m_failures[iter->first],
+			stats.GetMean() / 1000.0,
+			(double)stats.GetPercentile(50.0) / 1000.0,
+			(double)stats.GetPercentile(99.0) / 1000.0,
+			(double)stats.GetPercentile(100.0) / 1000.0);
+	}
+
+	if (!m_hasEnd) {
+		fprintf(stdout, "\nTrace has no end record; final state not "
+			"compared\n");
+		return;
+	}
+
+	fprintf(stdout, "\nFinal state: %u matched, %zu differ, %zu missing, "
+		"%zu extra\n", m_matched, m_differ.size(), m_missing.size(),
+		m_extra.size());
+	PrintListConsole("differ: ", m_differ);
+	PrintListConsole("missing:", m_missing);
+	PrintListConsole("extra:  ", m_extra);
+}
+
+static void PrintListJson(const char *name,
+	const std::vector<std::string>& list, bool last)
+{
+	MojObject array(MojObject::TypeArray);
+	for (std::vector<std::string>::const_iterator iter = list.begin();
+		iter != list.end(); ++iter) {
+		array.pushString(iter->c_str());
+	}
+
+	fprintf(stdout, "    \"%s\": %s%s\n", name,
+		MojoObjectJson(array).c_str(), last ? "" : ",");
+}
+
+void Replay::PrintJson()
+{
+	double seconds = (double)(m_runEnd - m_runStart) / 1e9;
+
+	fprintf(stdout, "{\n");
+	fprintf(stdout, "  \"requests\": %u,\n", m_requests);
+	fprintf(stdout, "  \"skipped\": %u,\n", m_skipped);
+	fprintf(stdout, "  \"unmapped_ids\": %u,\n", m_unresolved);
+	fprintf(stdout, "  \"signals\": %u,\n", m_signals);
+	fprintf(stdout, "  \"undelivered_signals\": %u,\n", m_undelivered);
+	fprintf(stdout, "  \"seeded\": %u,\n", m_seeded);
+	fprintf(stdout, "  \"seconds\": %.6f,\n", seconds);
+	fprintf(stdout, "  \"latency\": {");
+
+	bool first = true;
+	for (MethodStats::iterator iter = m_latency.begin();
+		iter != m_latency.end(); ++iter) {
+		LatencyStats& stats = iter->second;
+		fprintf(stdout, "%s\n    \"%s\": {\"count\": %zu, \"failed\": %u, "
+			"\"mean_ns\": %.0f, \"p50_ns\": %lld, \"p99_ns\": %lld, "
+			"\"max_ns\": %lld}", first ? "" : ",", iter->first.c_str(),
+			stats.GetCount(), m_failures[iter->first], stats.GetMean(),
+			(long long)stats.GetPercentile(50.0),
+			(long long)stats.GetPercentile(99.0),
+			(long long)stats.GetPercentile(100.0));
+		first = false;
+	}
+
+	fprintf(stdout, "\n  }");
+
+	if (m_hasEnd) {
+		fprintf(stdout, ",\n  \"final_state\": {\n");
+		fprintf(stdout, "    \"matched\": %u,\n", m_matched);
+		PrintListJson("differ", m_differ, false);
+		PrintListJson("missing", m_missing, false);
+		PrintListJson("extra", m_extra, true);
+		fprintf(stdout, "  }");
+	}
+
+	fprintf(stdout, "\n}\n");
+}
+
+static bool ParseUnsigned(const char *arg, const char *prefix,
+	unsigned& value)
+{
+	size_t len = strlen(prefix);
+	if (strncmp(arg, prefix, len) != 0) {
+		return false;
+	}
+
+	value = (unsigned)strtoul(arg + len, NULL, 10);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	ReplayOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (ParseUnsigned(arg, "--db-latency=", options.m_dbLatency) ||
+			ParseUnsigned(arg, "--power-latency=", options.m_powerLatency) ||
+			ParseUnsigned(arg, "--jitter=", options.m_jitter) ||
+			ParseUnsigned(arg, "--settle=", options.m_settle)) {
+			continue;
+		} else if (strcmp(arg, "--speed=max") == 0) {
+			options.m_speed = 0.0;
+		} else if (strncmp(arg, "--speed=", 8) == 0) {
+			options.m_speed = strtod(arg + 8, NULL);
+			if (options.m_speed <= 0.0) {
+				fprintf(stderr, "Speed must be positive, or \"max\"\n");
+				return 1;
+			}
+		} else if (strcmp(arg, "--format=json") == 0) {
+			options.m_json = true;
+		} else if (strcmp(arg, "--format=console") == 0) {
+			options.m_json = false;
+		} else if ((arg[0] != '-') && options.m_trace.empty()) {
+			options.m_trace = arg;
+		} else {
+			fprintf(stderr, "Unknown option \"%s\"\n", arg);
+			return 1;
+		}
+	}
+
+	if (options.m_trace.empty()) {
+		fprintf(stderr, "Usage: %s [options] <trace>\n", argv[0]);
+		return 1;
+	}
+
+	try {
+		Replay replay(options);
+		replay.Load();
+		replay.Init();
+		int result = replay.Run();
+		replay.Report();
+		return result;
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Replay failed: %s\n", except.what());
+		return 1;
+	}
+}
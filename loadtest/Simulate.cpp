@@ -0,0 +1,556 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * Scheduling simulator.  Runs the real ActivityManager, Scheduler and
+ * IntervalSchedule code against FakeBusService, with a VirtualClock
+ * installed in place of time(2) and GLib timers, so a week of interval
+ * Activities runs in seconds.  Each Activity's callback "works" for a
+ * fixed virtual time and then completes, after which the interval
+ * schedule requeues it.
+ *
+ * Reports device wakes (distinct instants at which any of the daemon's
+ * timers fired) and how well timers coalesce onto them, latency to start
+ * (how long after its nominal slot each run actually began), and how much
+ * of the background concurrency limit was in use.
+ *
+ * Usage: activitymanager-sim [options]
+ *   --days=<n>               Virtual days to simulate (default 7)
+ *   --activities=<n>         Interval Activities to create (default 50)
+ *   --intervals=<list>       Comma separated intervals, assigned round robin
+ *                            (default 15m,1h,6h,1d)
+ *   --precise                Use precise schedules rather than smart ones
+ *   --spread=<secs>          With --precise, start each schedule at a random
+ *                            offset of up to this much (default 0)
+ *   --work=<secs>            Virtual time each run takes (default 20)
+ *   --work-jitter=<secs>     Random extra work time (default 0)
+ *   --concurrency=<n>        Background concurrency level (default: the
+ *                            daemon's own)
+ *   --power                  Make Activities hold power
+ *   --seed=<n>               Random seed (default 1)
+ *   --format=console|json
+ */
+
+#include "FakeDaemon.h"
+#include "LatencyStats.h"
+#include "VirtualClock.h"
+
+#include "ActivityManager.h"
+#include "IntervalSchedule.h"
+#include "Scheduler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+static const char *SimServiceName = "com.palm.sim";
+
+/* 2013-01-01 00:00:00 UTC */
+static const time_t SimEpoch = 1356998400;
+
+static const unsigned SecondsPerDay = 24 * 60 * 60;
+
+struct SimOptions {
+	SimOptions()
+		: m_days(7)
+		, m_activities(50)
+		, m_precise(false)
+		, m_spread(0)
+		, m_work(20)
+		, m_workJitter(0)
+		, m_concurrency(0)
+		, m_power(false)
+		, m_seed(1)
+		, m_json(false)
+	{
+	}
+
+	unsigned	m_days;
+	unsigned	m_activities;
+
+	std::vector<std::string>	m_intervals;
+
+	bool		m_precise;
+	unsigned	m_spread;
+	unsigned	m_work;
+	unsigned	m_workJitter;
+	unsigned	m_concurrency;
+	bool		m_power;
+	unsigned	m_seed;
+	bool		m_json;
+};
+
+struct SimActivity {
+	SimActivity()
+		: m_interval(0)
+		, m_anchor(0)
+		, m_id(0)
+		, m_created(false)
+	{
+	}
+
+	std::string	m_intervalStr;
+	unsigned	m_interval;
+
+	/* Nominal slots are m_anchor + k * m_interval */
+	time_t		m_anchor;
+
+	MojInt64	m_id;
+	bool		m_created;
+};
+
+class Simulation;
+
+/* Receives the Activity callbacks the daemon makes to the simulated client */
+class SimClient : public FakeBusEndpoint
+{
+public:
+	SimClient(Simulation *sim) : m_sim(sim) {}
+
+	virtual void HandleCall(boost::shared_ptr<FakeBusCall> call);
+
+protected:
+	Simulation	*m_sim;
+};
+
+class Simulation
+{
+public:
+	Simulation(const SimOptions& options);
+	virtual ~Simulation();
+
+	void Init();
+	int Run();
+	void Report();
+
+	void CallbackReceived(boost::shared_ptr<FakeBusCall> call);
+
+protected:
+	void CreateActivity(unsigned index);
+	void CreateResponse(unsigned index, const MojObject& response);
+	void Complete(unsigned index);
+
+	void Account(time_t now);
+
+	unsigned long long GetPowerActivityCount();
+
+	void PrintConsole();
+	void PrintJson();
+
+	SimOptions	m_options;
+
+	boost::shared_ptr<VirtualClock>	m_clock;
+
+	FakeDaemon		m_daemon;
+	FakeBusService&	m_bus;
+
+	BusId	m_client;
+
+	std::vector<SimActivity>	m_activities;
+
+	time_t		m_start;
+	time_t		m_end;
+	time_t		m_lastAccount;
+
+	unsigned	m_concurrencyLevel;
+	unsigned	m_created;
+	unsigned long long	m_runs;
+	unsigned long long	m_completed;
+
+	unsigned	m_running;
+	unsigned	m_peakRunning;
+	double		m_runningSeconds;
+
+	LatencyStats	m_startLatency;
+
+	MojInt64	m_realStart;
+	MojInt64	m_realEnd;
+};
+
+Simulation::Simulation(const SimOptions& options)
+	: m_options(options)
+	, m_clock(boost::make_shared<VirtualClock>(SimEpoch))
+	, m_bus(m_daemon.GetBus())
+	, m_client(SimServiceName, BusService)
+	, m_start(SimEpoch)
+	, m_end(SimEpoch + ((time_t)options.m_days * SecondsPerDay))
+	, m_lastAccount(SimEpoch)
+	, m_concurrencyLevel(ActivityManager::DefaultBackgroundConcurrencyLevel)
+	, m_created(0)
+	, m_runs(0)
+	, m_completed(0)
+	, m_running(0)
+	, m_peakRunning(0)
+	, m_runningSeconds(0.0)
+	, m_realStart(0)
+	, m_realEnd(0)
+{
+	/* Before anything reads the time or arms a Timeout */
+	Clock::SetInstance(m_clock);
+}
+
+Simulation::~Simulation()
+{
+}
+
+void Simulation::Init()
+{
+	srandom(m_options.m_seed);
+
+	m_bus.AddEndpoint(SimServiceName, boost::make_shared<SimClient>(this));
+
+	m_daemon.Init();
+
+	if (m_options.m_concurrency) {
+		m_daemon.GetActivityManager()->SetBackgroundConcurrencyLevel(
+			m_options.m_concurrency);
+		m_concurrencyLevel = m_options.m_concurrency;
+	}
+
+	time_t smartBase = m_daemon.GetScheduler()->GetSmartBaseTime();
+
+	m_activities.resize(m_options.m_activities);
+	for (unsigned i = 0; i < m_options.m_activities; i++) {
+		SimActivity& activity = m_activities[i];
+
+		activity.m_intervalStr =
+			m_options.m_intervals[i % m_options.m_intervals.size()];
+		activity.m_interval = IntervalSchedule::StringToInterval(
+			activity.m_intervalStr.c_str(), !m_options.m_precise);
+
+		if (!m_options.m_precise) {
+			activity.m_anchor = smartBase;
+		} else if (m_options.m_spread) {
+			activity.m_anchor = m_start +
+				(time_t)(::random() % m_options.m_spread);
+		} else {
+			activity.m_anchor = m_start;
+		}
+	}
+}
+
+int Simulation::Run()
+{
+	m_realStart = FakeBusService::Now();
+
+	for (unsigned i = 0; i < m_activities.size(); i++) {
+		CreateActivity(i);
+	}
+
+	m_bus.RunUntilIdle();
+
+	while (m_clock->HasEvents() && (m_clock->GetNextEventTime() <= m_end)) {
+		Account(m_clock->GetNextEventTime());
+		m_clock->Advance();
+		m_bus.RunUntilIdle();
+	}
+
+	Account(m_end);
+
+	m_realEnd = FakeBusService::Now();
+
+	return (m_created == m_activities.size()) ? 0 : 1;
+}
+
+void Simulation::CreateActivity(unsigned index)
+{
+	const SimActivity& activity = m_activities[index];
+
+	MojObject schedule;
+	schedule.putString(_T("interval"), activity.m_intervalStr.c_str());
+	if (m_options.m_precise) {
+		schedule.putBool(_T("precise"), true);
+		schedule.putString(_T("start"),
+			Scheduler::TimeToString(activity.m_anchor, true).c_str());
+	}
+
+	MojObject type;
+	type.putBool(_T("background"), true);
+	type.putBool(_T("power"), m_options.m_power);
+
+	MojObject params;
+	params.putInt(_T("index"), (MojInt64)index);
+
+	MojObject callback;
+	callback.putString(_T("method"),
+		(std::string("palm://") + SimServiceName + "/run").c_str());
+	callback.put(_T("params"), params);
+
+	MojObject spec;
+	spec.putString(_T("name"), ("sim." +
+		boost::lexical_cast<std::string>(index)).c_str());
+	spec.putString(_T("description"), _T("Simulated interval Activity"));
+	spec.put(_T("type"), type);
+	spec.put(_T("schedule"), schedule);
+	spec.put(_T("callback"), callback);
+
+	MojObject payload;
+	payload.put(_T("activity"), spec);
+	payload.putBool(_T("start"), true);
+
+	m_bus.Call("/", "create", payload, m_client, false,
+		boost::bind(&Simulation::CreateResponse, this, index, _1));
+}
+
+void Simulation::CreateResponse(unsigned index, const MojObject& response)
+{
+	SimActivity& activity = m_activities[index];
+
+	bool found = false;
+	response.get(_T("activityId"), activity.m_id, found);
+	if (found && !activity.m_created) {
+		activity.m_created = true;
+		m_created++;
+	}
+}
+
+void SimClient::HandleCall(boost::shared_ptr<FakeBusCall> call)
+{
+	m_sim->CallbackReceived(call);
+}
+
+/* The daemon has started a run of one of the Activities */
+void Simulation::CallbackReceived(boost::shared_ptr<FakeBusCall> call)
+{
+	MojInt64 index = 0;
+	bool found = false;
+	call->GetPayload().get(_T("index"), index, found);
+	if (!found || (index < 0) || ((size_t)index >= m_activities.size())) {
+		call->ReplyError(MojErrInvalidArg, "Missing or invalid index");
+		return;
+	}
+
+	call->ReplySuccess();
+
+	const SimActivity& activity = m_activities[(size_t)index];
+
+	time_t now = m_clock->GetTime();
+	time_t late = (now - activity.m_anchor) % (time_t)activity.m_interval;
+	if (late < 0) {
+		late += (time_t)activity.m_interval;
+	}
+	m_startLatency.Add((MojInt64)late * 1000000000LL);
+
+	Account(now);
+	m_runs++;
+	if (++m_running > m_peakRunning) {
+		m_peakRunning = m_running;
+	}
+
+	unsigned work = m_options.m_work;
+	if (m_options.m_workJitter) {
+		work += (unsigned)(::random() % m_options.m_workJitter);
+	}
+
+	m_clock->Post(work, boost::bind(&Simulation::Complete, this,
+		(unsigned)index));
+}
+
+void Simulation::Complete(unsigned index)
+{
+	Account(m_clock->GetTime());
+	m_running--;
+	m_completed++;
+
+	MojObject payload;
+	payload.putInt(_T("activityId"), m_activities[index].m_id);
+
+	m_bus.Call("/", "complete", payload, m_client, false,
+		FakeBusMessage::ResponseCallback());
+}
+
+/* Integrate the number of running Activities over virtual time */
+void Simulation::Account(time_t now)
+{
+	if (now > m_lastAccount) {
+		m_runningSeconds += (double)m_running * (double)(now - m_lastAccount);
+		m_lastAccount = now;
+	}
+}
+
+unsigned long long Simulation::GetPowerActivityCount()
+{
+	const FakeServiceEndpoint::CallCounts& counts =
+		m_daemon.GetPowerd()->GetCallCounts();
+	FakeServiceEndpoint::CallCounts::const_iterator found =
+		counts.find("com.palm.power/com/palm/power/activityStart");
+
+	return (found != counts.end()) ? found->second : 0;
+}
+
+void Simulation::Report()
+{
+	if (m_options.m_json) {
+		PrintJson();
+	} else {
+		PrintConsole();
+	}
+}
+
+void Simulation::PrintConsole()
+{
+	double virtualSeconds = (double)(m_end - m_start);
+	double realSeconds = (double)(m_realEnd - m_realStart) / 1e9;
+	double meanRunning = m_runningSeconds / virtualSeconds;
+	unsigned long long wakes = m_clock->GetWakes();
+	unsigned long long fires = m_clock->GetTimerFires();
+
+	fprintf(stdout, "Simulated %u days in %.3f s (%.0fx)\n", m_options.m_days,
+		realSeconds, (realSeconds > 0.0) ? virtualSeconds / realSeconds : 0.0);
+	fprintf(stdout, "Activities: %u created of %zu, %llu runs, %llu "
+		"completed\n", m_created, m_activities.size(), m_runs, m_completed);
+	fprintf(stdout, "Power activities started: %llu\n\n",
+		GetPowerActivityCount());
+
+	fprintf(stdout, "Wakes: %llu (%.1f per day), %llu timer fires, "
+		"%.2f fires per wake\n", wakes,
+		(double)wakes / (double)m_options.m_days, fires,
+		wakes ? (double)fires / (double)wakes : 0.0);
+	fprintf(stdout, "Latency to start (s): mean %.1f, p50 %.1f, p99 %.1f, "
+		"max %.1f\n", m_startLatency.GetMean() / 1e9,
+		(double)m_startLatency.GetPercentile(50.0) / 1e9,
+		(double)m_startLatency.GetPercentile(99.0) / 1e9,
+		(double)m_startLatency.GetPercentile(100.0) / 1e9);
+
+	if (m_concurrencyLevel) {
+		fprintf(stdout, "Concurrency: level %u, mean %.3f running, peak %u, "
+			"%.1f%% utilized\n", m_concurrencyLevel, meanRunning,
+			m_peakRunning, 100.0 * meanRunning / (double)m_concurrencyLevel);
+	} else {
+		fprintf(stdout, "Concurrency: unlimited, mean %.3f running, "
+			"peak %u\n", meanRunning, m_peakRunning);
+	}
+}
+
+void Simulation::PrintJson()
+{
+	double virtualSeconds = (double)(m_end - m_start);
+	double realSeconds = (double)(m_realEnd - m_realStart) / 1e9;
+	double meanRunning = m_runningSeconds / virtualSeconds;
+	unsigned long long wakes = m_clock->GetWakes();
+	unsigned long long fires = m_clock->GetTimerFires();
+
+	fprintf(stdout, "{\n");
+	fprintf(stdout, "  \"days\": %u,\n", m_options.m_days);
+	fprintf(stdout, "  \"real_seconds\": %.6f,\n", realSeconds);
+	fprintf(stdout, "  \"activities\": %zu,\n", m_activities.size());
+	fprintf(stdout, "  \"created\": %u,\n", m_created);
+	fprintf(stdout, "  \"runs\": %llu,\n", m_runs);
+	fprintf(stdout, "  \"completed\": %llu,\n", m_completed);
+	fprintf(stdout, "  \"power_activities\": %llu,\n",
+		GetPowerActivityCount());
+	fprintf(stdout, "  \"wakes\": %llu,\n", wakes);
+	fprintf(stdout, "  \"timer_fires\": %llu,\n", fires);
+	fprintf(stdout, "  \"fires_per_wake\": %.3f,\n",
+		wakes ? (double)fires / (double)wakes : 0.0);
+	fprintf(stdout, "  \"start_latency\": {\"count\": %zu, \"mean_s\": %.1f, "
+		"\"p50_s\": %.1f, \"p99_s\": %.1f, \"max_s\": %.1f},\n",
+		m_startLatency.GetCount(), m_startLatency.GetMean() / 1e9,
+		(double)m_startLatency.GetPercentile(50.0) / 1e9,
+		(double)m_startLatency.GetPercentile(99.0) / 1e9,
+		(double)m_startLatency.GetPercentile(100.0) / 1e9);
+	fprintf(stdout, "  \"concurrency\": {\"level\": %u, \"mean_running\": "
+		"%.3f, \"peak_running\": %u, \"utilization\": %.4f}\n}\n",
+		m_concurrencyLevel, meanRunning, m_peakRunning,
+		m_concurrencyLevel ? meanRunning / (double)m_concurrencyLevel : 0.0);
+}
+
+static bool ParseUnsigned(const char *arg, const char *prefix,
+	unsigned& value)
+{
+	size_t len = strlen(prefix);
+	if (strncmp(arg, prefix, len) != 0) {
+		return false;
+	}
+
+	value = (unsigned)strtoul(arg + len, NULL, 10);
+	return true;
+}
+
+static void ParseList(const char *list, std::vector<std::string>& values)
+{
+	values.clear();
+
+	std::string remaining(list);
+	while (!remaining.empty()) {
+		std::string::size_type comma = remaining.find(',');
+		std::string value = remaining.substr(0, comma);
+		if (!value.empty()) {
+			values.push_back(value);
+		}
+
+		if (comma == std::string::npos) {
+			break;
+		}
+
+		remaining.erase(0, comma + 1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	SimOptions options;
+	ParseList("15m,1h,6h,1d", options.m_intervals);
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (ParseUnsigned(arg, "--days=", options.m_days) ||
+			ParseUnsigned(arg, "--activities=", options.m_activities) ||
+			ParseUnsigned(arg, "--spread=", options.m_spread) ||
+			ParseUnsigned(arg, "--work=", options.m_work) ||
+			ParseUnsigned(arg, "--work-jitter=", options.m_workJitter) ||
+			ParseUnsigned(arg, "--concurrency=", options.m_concurrency) ||
+			ParseUnsigned(arg, "--seed=", options.m_seed)) {
+			continue;
+		} else if (strncmp(arg, "--intervals=", 12) == 0) {
+			ParseList(arg + 12, options.m_intervals);
+		} else if (strcmp(arg, "--precise") == 0) {
+			options.m_precise = true;
+		} else if (strcmp(arg, "--power") == 0) {
+			options.m_power = true;
+		} else if (strcmp(arg, "--format=json") == 0) {
+			options.m_json = true;
+		} else if (strcmp(arg, "--format=console") == 0) {
+			options.m_json = false;
+		} else {
+			fprintf(stderr, "Unknown option \"%s\"\n", arg);
+			return 1;
+		}
+	}
+
+	if (!options.m_days || options.m_intervals.empty()) {
+		fprintf(stderr, "Need at least one day and one interval\n");
+		return 1;
+	}
+
+	try {
+		Simulation sim(options);
+		sim.Init();
+		int result = sim.Run();
+		sim.Report();
+		return result;
+	} catch (const std::exception& except) {
+		fprintf(stderr, "Simulation failed: %s\n", except.what());
+		return 1;
+	}
+}
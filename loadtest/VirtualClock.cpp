@@ -0,0 +1,125 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "VirtualClock.h"
+#include "Timeout.h"
+
+VirtualClock::VirtualClock(time_t start)
+	: m_now(start)
+	, m_nextTimer(1)
+	, m_timerFires(0)
+	, m_wakes(0)
+	, m_lastWake((time_t)-1)
+{
+}
+
+VirtualClock::~VirtualClock()
+{
+}
+
+time_t VirtualClock::GetTime()
+{
+	return m_now;
+}
+
+/* Virtual time only ever moves forward */
+time_t VirtualClock::GetMonotonicTime()
+{
+	return m_now;
+}
+
+Clock::TimerId VirtualClock::AddTimer(unsigned seconds, TimeoutBase *timeout)
+{
+	Entry entry;
+	entry.m_timer = m_nextTimer++;
+	entry.m_timeout = timeout;
+
+	m_timers[entry.m_timer] = m_events.insert(
+		EventQueue::value_type(m_now + (time_t)seconds, entry));
+
+	return entry.m_timer;
+}
+
+void VirtualClock::CancelTimer(TimerId timer)
+{
+	TimerMap::iterator found = m_timers.find(timer);
+	if (found != m_timers.end()) {
+		m_events.erase(found->second);
+		m_timers.erase(found);
+	}
+}
+
+void VirtualClock::Post(unsigned seconds, Event event)
+{
+	Entry entry;
+	entry.m_timer = 0;
+	entry.m_timeout = NULL;
+	entry.m_event = event;
+
+	m_events.insert(EventQueue::value_type(m_now + (time_t)seconds, entry));
+}
+
+bool VirtualClock::HasEvents() const
+{
+	return !m_events.empty();
+}
+
+time_t VirtualClock::GetNextEventTime() const
+{
+	return m_events.empty() ? m_now : m_events.begin()->first;
+}
+
+void VirtualClock::Advance()
+{
+	if (m_events.empty()) {
+		return;
+	}
+
+	m_now = m_events.begin()->first;
+
+	while (!m_events.empty() && (m_events.begin()->first <= m_now)) {
+		Entry entry = m_events.begin()->second;
+		m_events.erase(m_events.begin());
+
+		if (entry.m_timeout) {
+			m_timers.erase(entry.m_timer);
+			m_timerFires++;
+
+			/* Timers armed by work done at the instant of a wake fire in
+			 * the same wake */
+			if (m_lastWake != m_now) {
+				m_lastWake = m_now;
+				m_wakes++;
+			}
+
+			entry.m_timeout->Fire();
+		} else {
+			entry.m_event();
+		}
+	}
+}
+
+unsigned long long VirtualClock::GetTimerFires() const
+{
+	return m_timerFires;
+}
+
+unsigned long long VirtualClock::GetWakes() const
+{
+	return m_wakes;
+}
@@ -0,0 +1,85 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef __ACTIVITYMANAGER_VIRTUALCLOCK_H__
+#define __ACTIVITYMANAGER_VIRTUALCLOCK_H__
+
+#include "Clock.h"
+
+#include <map>
+
+#include <boost/function.hpp>
+
+/*
+ * Discrete-event clock for simulation.  Time only moves when Advance() is
+ * called, and then jumps straight to the next pending event, so the
+ * daemon's Timeouts and Scheduler wakeups cost nothing to wait for.
+ *
+ * Timers armed through the Clock interface are the daemon's; each distinct
+ * instant at which at least one of them fires is counted as a wake of the
+ * device.  Events posted with Post() belong to the simulation itself and
+ * are not counted.
+ */
+class VirtualClock : public Clock
+{
+public:
+	VirtualClock(time_t start);
+	virtual ~VirtualClock();
+
+	virtual time_t GetTime();
+	virtual time_t GetMonotonicTime();
+
+	virtual TimerId AddTimer(unsigned seconds, TimeoutBase *timeout);
+	virtual void CancelTimer(TimerId timer);
+
+	typedef boost::function<void ()> Event;
+
+	void Post(unsigned seconds, Event event);
+
+	bool HasEvents() const;
+	time_t GetNextEventTime() const;
+
+	/* Move time to the next event, and run everything due at that instant,
+	 * including anything the events themselves arm for "now". */
+	void Advance();
+
+	unsigned long long GetTimerFires() const;
+	unsigned long long GetWakes() const;
+
+protected:
+	struct Entry {
+		TimerId		m_timer;
+		TimeoutBase	*m_timeout;
+		Event		m_event;
+	};
+
+	typedef std::multimap<time_t, Entry> EventQueue;
+	typedef std::map<TimerId, EventQueue::iterator> TimerMap;
+
+	time_t		m_now;
+	TimerId		m_nextTimer;
+
+	EventQueue	m_events;
+	TimerMap	m_timers;
+
+	unsigned long long	m_timerFires;
+	unsigned long long	m_wakes;
+	time_t				m_lastWake;
+};
+
+#endif /* __ACTIVITYMANAGER_VIRTUALCLOCK_H__ */
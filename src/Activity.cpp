@@ -26,7 +26,10 @@
 #include "Schedule.h"
 #include "ActivityJson.h"
 #include "Requirement.h"
+#include "RequirementManager.h"
 #include "ActivityAutoAssociation.h"
+#include "FlightRecorder.h"
+#include "Probes.h"
 #include "Logging.h"
 #include <stdexcept>
 #include <functional>
@@ -36,16 +39,16 @@ MojLogger Activity::s_log(_T("activitymanager.activity"));
 
 Activity::Activity(activityId_t id, boost::weak_ptr<ActivityManager> am)
 	: m_id(id)
+	, m_priority(ActivityBackgroundPriority)
+	, m_bus(PublicBus)
 	, m_persistent(false)
 	, m_explicit(false)
 	, m_immediate(false)
-	, m_priority(ActivityBackgroundPriority)
 	, m_useSimpleType(true) /* Background */
 	, m_focused(false)
 	, m_continuous(false)
 	, m_userInitiated(false)
 	, m_powerDebounce(false)
-	, m_bus(PublicBus)
 	, m_initialized(false)
 	, m_scheduled(false)
 	, m_ready(false)
@@ -56,6 +59,10 @@ Activity::Activity(activityId_t id, boost::weak_ptr<ActivityManager> am)
 	, m_requeue(false)
 	, m_yielding(false)
 	, m_released(true)
+	, m_flightState(ActivityInit)
+	, m_readiness(ReadyTriggered | ReadyScheduleDue)
+	, m_batched(false)
+	, m_unmetCount(0)
 	, m_intCommand(ActivityNoCommand)
 	, m_extCommand(ActivityNoCommand)
 	, m_sentCommand(ActivityNoCommand)
@@ -146,6 +153,8 @@ void Activity::SendCommand(ActivityCommand_t command, bool internal)
 				"a final command to this Activity");
 		}
 		m_intCommand = command;
+		SetReadiness(ReadyCommand,
+			ComputeNextExternalCommand() == ActivityStartCommand);
 	} else {
 		if ((command == ActivityStartCommand) && !m_initialized &&
 			!m_ending) {
@@ -160,6 +169,8 @@ void Activity::SendCommand(ActivityCommand_t command, bool internal)
 		}
 
 		m_extCommand = command;
+		SetReadiness(ReadyCommand,
+			ComputeNextExternalCommand() == ActivityStartCommand);
 	}
 
 	/* If the Activity is already ending, don't do anything. */
@@ -188,6 +199,8 @@ void Activity::SendCommand(ActivityCommand_t command, bool internal)
 			BroadcastCommand(sendCommand);
 		}
 	}
+
+	NoteState(FlightReasonCommand, command);
 }
 
 MojErr Activity::AddSubscription(boost::shared_ptr<Subscription> sub)
@@ -254,6 +267,8 @@ MojErr Activity::RemoveSubscription(boost::shared_ptr<Subscription> sub)
 			m_id,actor.GetString().c_str());
 	}
 
+	NoteState(FlightReasonUnsubscribed);
+
 	/* If all subscriptions by that subscriber are gone, now... */
 	if (m_subscribers.find(actor) == m_subscribers.end()) {
 		/* Only if running.  If not running, the Activity Manager will
@@ -265,32 +280,37 @@ MojErr Activity::RemoveSubscription(boost::shared_ptr<Subscription> sub)
 		}
 	}
 
-	AdopterQueue::iterator adopter = m_adopters.begin();
-	for (; adopter != m_adopters.end(); ++adopter) {
-		if (sub == adopter->lock())
-			break;
-	}
+	if (m_coldState) {
+		AdopterQueue& adopters = m_coldState->m_adopters;
 
-	if (adopter != m_adopters.end()) {
-		m_adopters.erase(adopter);
-	}
+		AdopterQueue::iterator adopter = adopters.begin();
+		for (; adopter != adopters.end(); ++adopter) {
+			if (sub == adopter->lock())
+				break;
+		}
+
+		if (adopter != adopters.end()) {
+			adopters.erase(adopter);
+		}
 
-	if (m_releasedParent.lock() == sub) {
-		m_releasedParent.reset();
+		if (m_coldState->m_releasedParent.lock() == sub) {
+			m_coldState->m_releasedParent.reset();
+		}
 	}
 
 	if (m_parent.lock() == sub) {
 		m_parent.reset();
 
-		if (m_adopters.empty()) {
+		if (PeekColdState().m_adopters.empty()) {
 			/* If there are no remaining subscribers, just let Abandoned clean
 			 * up and call EndActivity. */
 			if (!m_subscriptions.empty()) {
 				Orphaned();
 			}
 		} else {
-			m_parent = m_adopters.front().lock();
-			m_adopters.pop_front();
+			AdopterQueue& adopters = m_coldState->m_adopters;
+			m_parent = adopters.front().lock();
+			adopters.pop_front();
 
 			m_parent.lock()->QueueEvent(ActivityOrphanEvent);
 		}
@@ -367,6 +387,7 @@ void Activity::UnplugAllSubscriptions()
 void Activity::SetTrigger(boost::shared_ptr<Trigger> trigger)
 {
 	m_trigger = trigger;
+	UpdateTriggerReadiness();
 }
 
 boost::shared_ptr<Trigger> Activity::GetTrigger() const
@@ -377,6 +398,7 @@ boost::shared_ptr<Trigger> Activity::GetTrigger() const
 void Activity::ClearTrigger()
 {
 	m_trigger.reset();
+	SetReadiness(ReadyTriggered, true);
 }
 
 bool Activity::HasTrigger() const
@@ -390,6 +412,8 @@ void Activity::Triggered(boost::shared_ptr<Trigger> trigger)
 	LOG_AM_DEBUG("[Activity %llu] Triggered", m_id);
 
 	if (m_trigger == trigger) {
+		SetReadiness(ReadyTriggered, true);
+
 		if (!m_running && !m_ready && IsRunnable()) {
 			RequestRunActivity();
 		}
@@ -450,11 +474,13 @@ void Activity::CallbackSucceeded(boost::shared_ptr<Callback> callback)
 void Activity::SetSchedule(boost::shared_ptr<Schedule> schedule)
 {
 	m_schedule = schedule;
+	UpdateScheduleReadiness();
 }
 
 void Activity::ClearSchedule()
 {
 	m_schedule.reset();
+	SetReadiness(ReadyScheduleDue, true);
 }
 
 void Activity::Scheduled()
@@ -462,6 +488,8 @@ void Activity::Scheduled()
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("[Activity %llu] Scheduled", m_id);
 
+	UpdateScheduleReadiness();
+
 	if (!m_running && !m_ready && IsRunnable()) {
 		RequestRunActivity();
 	}
@@ -490,18 +518,25 @@ void Activity::AddRequirement(boost::shared_ptr<Requirement> requirement)
 		throw std::runtime_error("Requirement owner mismatch");
 	}
 
-	m_requirements[requirement->GetName()] = requirement;
+	RequirementVec::iterator found = FindRequirement(requirement->GetName());
+	if (found != m_requirements.end()) {
+		/* The replaced Requirement would unlink itself when released, but
+		 * the unmet count has to hear about it */
+		UnlinkRequirement(**found);
+		*found = requirement;
+	} else {
+		m_requirements.push_back(requirement);
+	}
 
 	if (requirement->m_activityListItem.is_linked()) {
 		LOG_AM_DEBUG("Found linked requirement adding [Requirement %s] to [Activity %llu]",
 			requirement->GetName().c_str(), m_id);
-		requirement->m_activityListItem.unlink();
+		UnlinkRequirement(*requirement);
 	}
 
-	if (requirement->IsMet()) {
-		m_metRequirements.push_back(*requirement);
-	} else {
-		m_unmetRequirements.push_back(*requirement);
+	LinkRequirement(*requirement);
+
+	if (!requirement->IsMet()) {
 
 		if (!m_running && m_ready) {
 			m_ready = false;
@@ -527,7 +562,7 @@ void Activity::RemoveRequirement(boost::shared_ptr<Requirement> requirement)
 		LOG_AM_DEBUG("Found unlinked requirement removing [Requirement %s] from [Activity %llu]",
 			requirement->GetName().c_str(), m_id);
 	} else {
-		requirement->m_activityListItem.unlink();
+		UnlinkRequirement(*requirement);
 	}
 
 	if (!m_running && !m_ready && IsRunnable()) {
@@ -541,7 +576,7 @@ void Activity::RemoveRequirement(const std::string& name)
 	LOG_AM_DEBUG("[Activity %llu] removing [Requirement %s] by name",
 		m_id, name.c_str());
 
-	RequirementMap::iterator found = m_requirements.find(name);
+	RequirementVec::iterator found = FindRequirement(name);
 	if (found == m_requirements.end()) {
 		LOG_AM_WARNING(MSGID_RM_REQ_NOT_FOUND , 2,
 			PMLOGKFV("Activity","%llu",m_id),
@@ -550,11 +585,11 @@ void Activity::RemoveRequirement(const std::string& name)
 		return;
 	}
 
-	if (found->second->m_activityListItem.is_linked()) {
-		found->second->m_activityListItem.unlink();
+	if ((*found)->m_activityListItem.is_linked()) {
+		UnlinkRequirement(**found);
 	} else {
 		LOG_AM_DEBUG("Found unlinked requirement removing [Requirement %s] from [Activity %llu] by name",
-			found->second->GetName().c_str(), m_id);
+			(*found)->GetName().c_str(), m_id);
 	}
 
 	m_requirements.erase(found);
@@ -566,8 +601,7 @@ void Activity::RemoveRequirement(const std::string& name)
 
 bool Activity::IsRequirementSet(const std::string& name) const
 {
-	RequirementMap::const_iterator found = m_requirements.find(name);
-	return (found != m_requirements.end());
+	return (FindRequirement(name) != m_requirements.end());
 }
 
 bool Activity::HasRequirements() const
@@ -590,21 +624,33 @@ void Activity::RequirementMet(boost::shared_ptr<Requirement> requirement)
 		throw std::runtime_error("Requirement owner mismatch");
 	}
 
+	/* The Requirement is already marked met, so it's unlinked from the
+	 * unmet list by hand */
 	if (requirement->m_activityListItem.is_linked()) {
 		requirement->m_activityListItem.unlink();
+		m_unmetCount--;
 	} else {
 		LOG_AM_DEBUG("Found unlinked requirement marking [Requirement %s] as met for [Activity %llu]",
 			requirement->GetName().c_str(), m_id);
 	}
 
-	m_metRequirements.push_back(*requirement);
+	LinkRequirement(*requirement);
+
+	FlightRecorder::Record(FlightRequirementMetEvent, m_id, 0, 0,
+		requirement->GetFlightCode());
+	NoteState(FlightReasonRequirement);
+
+	if (RequirementManager::IsBatching()) {
+		DeferToBatch();
+		return;
+	}
 
 	/* Not obvious from here it'll be time to start.
 	 * XXX use plug/unplug and the fact that an event will only be queued
 	 * if another isn't already... */
 	BroadcastEvent(ActivityUpdateEvent);
 
-	if (m_unmetRequirements.empty()) {
+	if (m_unmetCount == 0) {
 		LOG_AM_DEBUG("[Activity %llu] All requirements met", m_id);
 
 		if (!m_running && !m_ready && IsRunnable()) {
@@ -628,6 +674,7 @@ void Activity::RequirementUnmet(boost::shared_ptr<Requirement> requirement)
 		throw std::runtime_error("Requirement owner mismatch");
 	}
 
+	/* Likewise, unlinked from the met list */
 	if (requirement->m_activityListItem.is_linked()) {
 		requirement->m_activityListItem.unlink();
 	} else {
@@ -635,10 +682,20 @@ void Activity::RequirementUnmet(boost::shared_ptr<Requirement> requirement)
 			requirement->GetName().c_str(), m_id);
 	}
 
-	m_unmetRequirements.push_back(*requirement);
+	LinkRequirement(*requirement);
+
+	FlightRecorder::Record(FlightRequirementUnmetEvent, m_id, 0, 0,
+		requirement->GetFlightCode());
+	NoteState(FlightReasonRequirement);
+
+	if (RequirementManager::IsBatching()) {
+		DeferToBatch();
+		return;
+	}
 
 	if (!m_running && m_ready) {
 		m_ready = false;
+		NoteState(FlightReasonNotReady);
 		m_am.lock()->InformActivityNotReady(shared_from_this());
 	}
 
@@ -657,9 +714,49 @@ void Activity::RequirementUpdated(boost::shared_ptr<Requirement> requirement)
 		throw std::runtime_error("Requirement owner mismatch");
 	}
 
+	if (RequirementManager::IsBatching()) {
+		DeferToBatch();
+		return;
+	}
+
 	BroadcastEvent(ActivityUpdateEvent);
 }
 
+void Activity::DeferToBatch()
+{
+	if (!m_batched) {
+		m_batched = true;
+		RequirementManager::AddToBatch(shared_from_this());
+	}
+}
+
+/* Requirement changes batched since the last commit all land at once: one
+ * update event, and one decision about whether the Activity is ready */
+void Activity::RequirementsSettled()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("[Activity %llu] Requirements settled, %u unmet", m_id,
+		m_unmetCount);
+
+	m_batched = false;
+
+	if (m_unmetCount) {
+		if (!m_running && m_ready) {
+			m_ready = false;
+			NoteState(FlightReasonNotReady);
+			m_am.lock()->InformActivityNotReady(shared_from_this());
+		}
+
+		BroadcastEvent(ActivityUpdateEvent);
+	} else {
+		BroadcastEvent(ActivityUpdateEvent);
+
+		if (!m_running && !m_ready && IsRunnable()) {
+			RequestRunActivity();
+		}
+	}
+}
+
 void Activity::SetParent(boost::shared_ptr<Subscription> sub)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
@@ -683,7 +780,7 @@ MojErr Activity::Adopt(boost::shared_ptr<Subscription> sub, bool wait, bool *ado
 		sub->GetSubscriber().GetString().c_str(),
 		wait ? "and willing to wait" : "");
 
-	m_adopters.push_back(sub);
+	GetColdState().m_adopters.push_back(sub);
 
 	if (!m_parent.expired()) {
 		if (adopted)
@@ -730,14 +827,14 @@ MojErr Activity::Release(const BusId& caller)
 		return MojErrAccessDenied;
 	}
 
-	m_releasedParent = m_parent;
+	GetColdState().m_releasedParent = m_parent;
 	m_parent.reset();
 	m_released = true;
 
 	LOG_AM_DEBUG("[Activity %llu] Released by %s", m_id,
 		caller.GetString().c_str());
 
-	if (!m_adopters.empty()) {
+	if (!m_coldState->m_adopters.empty()) {
 		DoAdopt();
 	}
 
@@ -884,7 +981,17 @@ boost::shared_ptr<PersistCommand> Activity::GetHookedPersistCommand()
 
 void Activity::SetPriority(ActivityPriority_t priority)
 {
+	if (m_priority == priority) {
+		return;
+	}
+
 	m_priority = priority;
+
+	/* Entities count their Activities by priority */
+	const EntityAssociationSet& associations =
+		PeekColdState().m_associations;
+	std::for_each(associations.begin(), associations.end(),
+		boost::mem_fn(&ActivitySetAutoAssociation::Reassociate));
 }
 
 ActivityPriority_t Activity::GetPriority() const
@@ -901,7 +1008,9 @@ void Activity::SetFocus(bool focused)
 	m_focused = focused;
 
 	/* Focus changed, update the sorting of all the Associations */
-	std::for_each(m_associations.begin(), m_associations.end(),
+	const EntityAssociationSet& associations =
+		PeekColdState().m_associations;
+	std::for_each(associations.begin(), associations.end(),
 		boost::mem_fn(&ActivitySetAutoAssociation::Reassociate));
 
 	if (focused) {
@@ -973,17 +1082,20 @@ bool Activity::IsUserInitiated() const
 
 void Activity::SetPowerActivity(boost::shared_ptr<PowerActivity> powerActivity)
 {
-	m_powerActivity = powerActivity;
+	if (!powerActivity && !m_coldState)
+		return;
+
+	GetColdState().m_powerActivity = powerActivity;
 }
 
 boost::shared_ptr<PowerActivity> Activity::GetPowerActivity()
 {
-	return m_powerActivity;
+	return PeekColdState().m_powerActivity;
 }
 
 bool Activity::IsPowerActivity() const
 {
-	return m_powerActivity;
+	return PeekColdState().m_powerActivity;
 }
 
 void Activity::PowerLockedNotification()
@@ -992,7 +1104,7 @@ void Activity::PowerLockedNotification()
 	LOG_AM_DEBUG("[Activity %llu] Received notification that power has been successfully locked on",
 		m_id);
 
-	m_powerActivity->GetManager()->ConfirmPowerActivityBegin(
+	m_coldState->m_powerActivity->GetManager()->ConfirmPowerActivityBegin(
 		shared_from_this());
 
 	if (!m_ending) {
@@ -1006,7 +1118,7 @@ void Activity::PowerUnlockedNotification()
 	LOG_AM_DEBUG("[Activity %llu] Received notification that power has been successfully unlocked",
 		m_id);
 
-	m_powerActivity->GetManager()->ConfirmPowerActivityEnd(
+	m_coldState->m_powerActivity->GetManager()->ConfirmPowerActivityEnd(
 		shared_from_this());
 
 	if (m_ending) {
@@ -1042,7 +1154,7 @@ void Activity::AddEntityAssociation(
 	LOG_AM_DEBUG("[Activity %llu] adding association with [Entity %s]",
 		m_id, association->GetTargetName().c_str());
 
-	m_associations.insert(association);
+	GetColdState().m_associations.insert(association);
 }
 
 void Activity::RemoveEntityAssociation(
@@ -1052,8 +1164,8 @@ void Activity::RemoveEntityAssociation(
 	LOG_AM_DEBUG("[Activity %llu] removing association with [Entity %s]",
 		m_id, association->GetTargetName().c_str());
 
-	EntityAssociationSet::iterator found = m_associations.find(association);
-	if (found == m_associations.end()) {
+	if (!m_coldState || (m_coldState->m_associations.find(association) ==
+		m_coldState->m_associations.end())) {
 		LOG_AM_WARNING(MSGID_RM_ASSOCIATION_NOT_FOUND,2,
 			PMLOGKFV("Activity","%llu",m_id),
 			PMLOGKS("Entity",association->GetTargetName().c_str()),
@@ -1061,7 +1173,7 @@ void Activity::RemoveEntityAssociation(
 		return;
 	}
 
-	m_associations.erase(found);
+	m_coldState->m_associations.erase(association);
 }
 
 /*
@@ -1135,10 +1247,10 @@ void Activity::RestartActivity()
 
 	/* If there are any associations, drop them. */
 	/* XXX Consider whether to share this code with the Requeue logic */
-	if (!m_associations.empty()) {
+	if (!PeekColdState().m_associations.empty()) {
 		LOG_AM_DEBUG("[Activity %llu] still has associations when restarting... clearing",
 			m_id);
-		m_associations.clear();
+		m_coldState->m_associations.clear();
 	}
 
 	if (m_focused) {
@@ -1158,6 +1270,9 @@ void Activity::RestartActivity()
 	m_intCommand = ActivityNoCommand;
 	m_extCommand = ActivityNoCommand;
 	m_sentCommand = ActivityNoCommand;
+	SetReadiness(ReadyCommand, false);
+
+	NoteState(FlightReasonRestart);
 
 	/* Re-issue start command */
 	SendCommand(ActivityStartCommand);
@@ -1179,16 +1294,22 @@ void Activity::ScheduleActivity()
 	LOG_AM_DEBUG("[Activity %llu] Received permission to schedule",
 		m_id);
 
+	AM_PROBE1(activity_schedule, m_id);
+
 	if (m_trigger) {
 		m_trigger->Arm(shared_from_this());
+		UpdateTriggerReadiness();
 	}
 
 	if (m_schedule) {
 		m_schedule->Queue();
+		UpdateScheduleReadiness();
 	}
 
 	m_scheduled = true;
 
+	NoteState(FlightReasonSchedule);
+
 	if (IsRunnable()) {
 		RequestRunActivity();
 	}
@@ -1201,6 +1322,8 @@ void Activity::RequestRunActivity()
 		m_id);
 
 	m_ready = true;
+	NoteState(FlightReasonReady);
+
 	m_am.lock()->InformActivityReady(shared_from_this());
 }
 
@@ -1209,16 +1332,20 @@ void Activity::RunActivity()
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("[Activity %llu] Received permission to run", m_id);
 
+	AM_PROBE1(activity_run, m_id);
+
 	m_running = true;
+	NoteState(FlightReasonRun);
 
-	if (m_powerActivity && (m_powerActivity->GetPowerState() !=
+	boost::shared_ptr<PowerActivity> powerActivity = GetPowerActivity();
+	if (powerActivity && (powerActivity->GetPowerState() !=
 		PowerActivity::PowerLocked)) {
 		LOG_AM_DEBUG("[Activity %llu] Requesting power be locked on",
 			m_id);
 
 		/* Request power be locked on, wait to actually start Activity until
 		 * the power callback informs the Activity this has been accomplished */
-		m_powerActivity->GetManager()->RequestBeginPowerActivity(
+		powerActivity->GetManager()->RequestBeginPowerActivity(
 			shared_from_this());
 	} else {
 		DoRunActivity();
@@ -1248,11 +1375,14 @@ void Activity::RequeueActivity()
 	m_requeue = false;
 	m_yielding = false;
 
+	NoteState(FlightReasonRequeue);
+
 	if (IsRunnable()) {
 		RequestRunActivity();
 	} else {
 		/* Requirements aren't met, or the Activity is paused. */
 		m_ready = false;
+		NoteState(FlightReasonNotReady);
 		m_am.lock()->InformActivityNotReady(shared_from_this());
 	}
 }
@@ -1284,20 +1414,26 @@ void Activity::EndActivity()
 
 	if (!m_ending) {
 		m_ending = true;
+		NoteState(m_yielding ? FlightReasonYield : FlightReasonEnd);
+
 		m_am.lock()->InformActivityEnding(shared_from_this());
 	}
 
 	bool requeue = ShouldRequeue();
 
+	AM_PROBE2(activity_end, m_id, requeue);
+
 	/* Don't play with the trigger or schedule if requeuing... we want to
 	 * save that state. */
 	if (!requeue) {
 		if (m_trigger && m_trigger->IsArmed(shared_from_this())) {
 			m_trigger->Disarm(shared_from_this());
+			UpdateTriggerReadiness();
 		}
 
 		if (m_schedule && m_schedule->IsQueued()) {
 			m_schedule->UnQueue();
+			UpdateScheduleReadiness();
 		}
 	}
 
@@ -1312,9 +1448,10 @@ void Activity::EndActivity()
 		 * Note: Power unlock shouldn't be initiated until after all the
 		 * subscribers exit
 		 */
-		if (m_powerActivity && (m_powerActivity->GetPowerState() !=
+		boost::shared_ptr<PowerActivity> powerActivity = GetPowerActivity();
+		if (powerActivity && (powerActivity->GetPowerState() !=
 			PowerActivity::PowerUnlocked)) {
-			m_powerActivity->GetManager()->RequestEndPowerActivity(
+			powerActivity->GetManager()->RequestEndPowerActivity(
 				shared_from_this());
 		} else if (m_persistCommands.empty()) {
 			/* Don't move on to restarting (a potentially updated Activity)
@@ -1350,6 +1487,26 @@ void Activity::EndActivity()
  * ending already)
  */
 bool Activity::IsRunnable() const
+{
+	bool runnable = m_scheduled && !m_ending && (m_readiness == ReadyAll) &&
+		(m_unmetCount == 0);
+
+#ifdef MOJ_DEBUG
+	bool computed = ComputeRunnable();
+	if (runnable != computed) {
+		LOG_AM_ERROR(MSGID_RUNNABLE_MISMATCH, 3,
+			PMLOGKFV("Activity", "%llu", m_id),
+			PMLOGKFV("readiness", "%u", (unsigned)m_readiness),
+			PMLOGKFV("unmet", "%u", m_unmetCount),
+			"Incremental readiness disagrees with full evaluation");
+		return computed;
+	}
+#endif
+
+	return runnable;
+}
+
+bool Activity::ComputeRunnable() const
 {
 	if (m_scheduled && !m_ending) {
 		if (ComputeNextExternalCommand() != ActivityStartCommand)
@@ -1370,6 +1527,52 @@ bool Activity::IsRunnable() const
 	return false;
 }
 
+void Activity::SetReadiness(unsigned bit, bool ready)
+{
+	unsigned readiness = m_readiness;
+
+	if (ready) {
+		readiness |= bit;
+	} else {
+		readiness &= ~bit;
+	}
+
+	m_readiness = readiness & ReadyAll;
+}
+
+void Activity::UpdateTriggerReadiness()
+{
+	SetReadiness(ReadyTriggered,
+		!m_trigger || m_trigger->IsTriggered(shared_from_this()));
+}
+
+void Activity::UpdateScheduleReadiness()
+{
+	SetReadiness(ReadyScheduleDue, !m_schedule || m_schedule->IsScheduled());
+}
+
+/* Requirements live on the met or unmet list according to IsMet() at the
+ * time they were linked; these keep m_unmetCount in step */
+void Activity::LinkRequirement(Requirement& requirement)
+{
+	if (requirement.IsMet()) {
+		m_metRequirements.push_back(requirement);
+	} else {
+		m_unmetRequirements.push_back(requirement);
+		m_unmetCount++;
+	}
+}
+
+void Activity::UnlinkRequirement(Requirement& requirement)
+{
+	if (requirement.m_activityListItem.is_linked()) {
+		requirement.m_activityListItem.unlink();
+		if (!requirement.IsMet()) {
+			m_unmetCount--;
+		}
+	}
+}
+
 bool Activity::IsRunning() const
 {
 	if (m_running && !m_ending) {
@@ -1446,18 +1649,18 @@ void Activity::DoAdopt()
 	LOG_AM_DEBUG("[Activity %llu] Attempting to find new parent",
 		m_id);
 
-	if (m_adopters.empty())
+	if (PeekColdState().m_adopters.empty())
 		throw std::runtime_error("No parents available for adoption");
 
 	/* If the old parent is still waiting for notification of the adoption,
 	 * inform them and drop the reference */
-	if (!m_releasedParent.expired()) {
-		m_releasedParent.lock()->QueueEvent(ActivityAdoptedEvent);
-		m_releasedParent.reset();
+	if (!m_coldState->m_releasedParent.expired()) {
+		m_coldState->m_releasedParent.lock()->QueueEvent(ActivityAdoptedEvent);
+		m_coldState->m_releasedParent.reset();
 	}
 
-	m_parent = m_adopters.front();
-	m_adopters.pop_front();
+	m_parent = m_coldState->m_adopters.front();
+	m_coldState->m_adopters.pop_front();
 
 	m_parent.lock()->QueueEvent(ActivityOrphanEvent);
 
@@ -1467,6 +1670,8 @@ void Activity::DoAdopt()
 	}
 	m_ending = false;
 
+	NoteState(FlightReasonAdopted);
+
 	LOG_AM_DEBUG("[Activity %llu] Adopted by %s", m_id,
 		m_parent.lock()->GetSubscriber().GetString().c_str());
 }
@@ -1481,6 +1686,7 @@ void Activity::DoRunActivity()
 	m_am.lock()->InformActivityRunning(shared_from_this());
 
 	BroadcastCommand(ActivityStartCommand);
+	NoteState(FlightReasonStart);
 
 	if (m_callback) {
 		DoCallback();
@@ -1560,6 +1766,20 @@ ActivityState_t Activity::GetState() const
 	return ActivityInit;
 }
 
+void Activity::NoteState(FlightReason reason, MojUInt32 arg)
+{
+	ActivityState_t state = GetState();
+	if (state == (ActivityState_t)m_flightState) {
+		return;
+	}
+
+	FlightRecorder::Record(FlightStateEvent, m_id, (MojUInt8)m_flightState,
+		(MojUInt8)state, (MojUInt16)reason, arg);
+
+	/* MaxActivityState fits the 4 bits */
+	m_flightState = (unsigned)state & 0xF;
+}
+
 MojErr Activity::IdentityToJson(MojObject& rep) const
 {
 	/* Populate a JSON object with the minimal but important identifying
@@ -1710,9 +1930,10 @@ MojErr Activity::ToJson(MojObject& rep, unsigned flags) const
 			err = rep.put(_T("subscribers"), subscriberArray);
 			MojErrCheck(err);
 
+			const AdopterQueue& adopters = PeekColdState().m_adopters;
 			MojObject adopterArray(MojObject::TypeArray);
 			for (AdopterQueue::const_iterator iter =
-				m_adopters.begin(); iter != m_adopters.end(); ++iter) {
+				adopters.begin(); iter != adopters.end(); ++iter) {
 				MojObject subscriber(MojObject::TypeObject);
 
 				err = iter->lock()->GetSubscriber().ToJson(subscriber);
@@ -1848,7 +2069,7 @@ MojErr Activity::TypeToJson(MojObject& rep, unsigned flags) const
 		MojErrCheck(err);
 	}
 
-	if (m_powerActivity) {
+	if (IsPowerActivity()) {
 		err = rep.putBool(_T("power"), true);
 		MojErrCheck(err);
 	}
@@ -1995,3 +2216,84 @@ void Activity::PushIdentityJson(MojObject& array) const
 			"object");
 	}
 }
+
+Activity::MemoryUsage::MemoryUsage()
+	: m_object(0)
+	, m_strings(0)
+	, m_requirements(0)
+	, m_persistCommands(0)
+	, m_coldState(0)
+	, m_coldStateCount(0)
+{
+}
+
+void Activity::AccumulateMemoryUsage(MemoryUsage& usage) const
+{
+	/* Approximate: list and set nodes are counted as the payload plus a
+	 * pair of links, and strings by their reserved capacity.  Only storage
+	 * the Activity owns is counted; the Subscriptions linked into it belong
+	 * to their callers, and the creator's id is shared with every other
+	 * BusId naming it. */
+	static const size_t nodeOverhead = 2 * sizeof(void *);
+
+	usage.m_object += sizeof(Activity);
+
+	usage.m_strings += m_name.capacity() + m_description.capacity() +
+		m_metadata.capacity() + m_creator.GetMemoryShare();
+
+	usage.m_requirements += m_requirements.capacity() *
+		sizeof(RequirementVec::value_type);
+
+	usage.m_persistCommands += m_persistCommands.size() *
+		(sizeof(CommandQueue::value_type) + nodeOverhead);
+
+	if (m_coldState) {
+		usage.m_coldStateCount++;
+		usage.m_coldState += sizeof(ColdState) +
+			m_coldState->m_adopters.size() *
+				(sizeof(AdopterQueue::value_type) + nodeOverhead) +
+			m_coldState->m_associations.size() *
+				(sizeof(EntityAssociationSet::value_type) + 2 * nodeOverhead);
+	}
+}
+
+Activity::ColdState& Activity::GetColdState()
+{
+	if (!m_coldState) {
+		m_coldState.reset(new ColdState);
+	}
+
+	return *m_coldState;
+}
+
+const Activity::ColdState& Activity::PeekColdState() const
+{
+	/* Activities that never needed the cold state share an empty one */
+	static const ColdState empty;
+
+	return m_coldState ? *m_coldState : empty;
+}
+
+Activity::RequirementVec::iterator Activity::FindRequirement(
+	const std::string& name)
+{
+	RequirementVec::iterator iter = m_requirements.begin();
+	for (; iter != m_requirements.end(); ++iter) {
+		if ((*iter)->GetName() == name)
+			break;
+	}
+
+	return iter;
+}
+
+Activity::RequirementVec::const_iterator Activity::FindRequirement(
+	const std::string& name) const
+{
+	RequirementVec::const_iterator iter = m_requirements.begin();
+	for (; iter != m_requirements.end(); ++iter) {
+		if ((*iter)->GetName() == name)
+			break;
+	}
+
+	return iter;
+}
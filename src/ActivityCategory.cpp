@@ -32,12 +32,11 @@
 #include "Completion.h"
 #include "ResourceManager.h"
 #include "ContainerManager.h"
+#include "RequirementManager.h"
+#include "MojoBusMessage.h"
+#include "MethodLatency.h"
 #include "Logging.h"
 
-#ifdef ACTIVITYMANAGER_USE_PUBLIC_BUS
-#include <luna/MojLunaMessage.h>
-#endif
-
 #include <stdexcept>
 
 /*!
@@ -121,7 +120,8 @@ ActivityCategoryHandler::ActivityCategoryHandler(
 	boost::shared_ptr<MojoTriggerManager> triggerManager,
 	boost::shared_ptr<PowerManager> powerManager,
 	boost::shared_ptr<MasterResourceManager> resourceManager,
-	boost::shared_ptr<ContainerManager> containerManager)
+	boost::shared_ptr<ContainerManager> containerManager,
+	boost::shared_ptr<MasterRequirementManager> requirementManager)
 	: m_db(db)
 	, m_json(json)
 	, m_am(am)
@@ -129,6 +129,7 @@ ActivityCategoryHandler::ActivityCategoryHandler(
 	, m_powerManager(powerManager)
 	, m_resourceManager(resourceManager)
 	, m_containerManager(containerManager)
+	, m_requirementManager(requirementManager)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Constructing");
@@ -264,7 +265,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::CreateActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Create: Message from %s: %s",
@@ -291,14 +292,13 @@ ActivityCategoryHandler::CreateActivity(MojServiceMessage *msg, MojObject& paylo
 
 	try {
 #ifdef ACTIVITYMANAGER_USE_PUBLIC_BUS
-		MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-		if (!lunaMsg) {
+		if (!MojoBusMessage::IsBusMessage(msg)) {
 			throw std::invalid_argument("Non-Luna Message passed in to "
 				"Create");
 		}
 
-		Activity::BusType bus = lunaMsg->isPublic() ? Activity::PublicBus :
-			Activity::PrivateBus;
+		Activity::BusType bus = MojoBusMessage::IsPublic(msg) ?
+			Activity::PublicBus : Activity::PrivateBus;
 #else
 		Activity::BusType bus = Activity::PrivateBus;
 #endif
@@ -309,6 +309,9 @@ ActivityCategoryHandler::CreateActivity(MojServiceMessage *msg, MojObject& paylo
 		if (act->GetCreator().GetType() == BusNull) {
 			act->SetCreator(MojoSubscription::GetBusId(msg));
 		}
+
+		/* Lets a replay map the ids in later requests onto its own */
+		WorkloadRecorder::RecordActivityId(act->GetId());
 	} catch (const std::exception& except) {
 		err = msg->replyError(MojErrNoMem, except.what());
 		MojErrCheck(err);
@@ -404,7 +407,7 @@ ActivityCategoryHandler::FinishCreateActivity(
 	MojRefCountedPtr<MojServiceMessage> msg, const MojObject& payload,
 	boost::shared_ptr<Activity> act, bool succeeded)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHODFINISH_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Create finishing: Message from %s: [Activity %llu]: %s",
@@ -539,7 +542,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::JoinActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Join: Message from %s: %s",
@@ -652,7 +655,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::MonitorActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Monitor: Message from %s: %s",
@@ -764,7 +767,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::ReleaseActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Release: Message from %s: %s",
@@ -897,7 +900,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AdoptActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Adopt: Message from %s: %s",
@@ -1040,7 +1043,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::CompleteActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Complete: Message from %s: %s",
@@ -1108,7 +1111,7 @@ ActivityCategoryHandler::FinishCompleteActivity(
 	MojRefCountedPtr<MojServiceMessage> msg, const MojObject& payload,
 	boost::shared_ptr<Activity> act, bool succeeded)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHODFINISH_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Complete finishing: Message from %s: [Activity %llu]: %s",
@@ -1194,7 +1197,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::ScheduleActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Schedule: Message from %s: %s",
@@ -1294,7 +1297,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::StartActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Start: Message from %s: %s",
@@ -1394,7 +1397,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::StopActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Stop: Message from %s: %s",
@@ -1439,7 +1442,7 @@ ActivityCategoryHandler::FinishStopActivity(
 	MojRefCountedPtr<MojServiceMessage> msg, const MojObject& payload,
 	boost::shared_ptr<Activity> act, bool succeeded)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHODFINISH_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Stop finishing: Message from %s: [Activity %llu]: %s",
@@ -1528,7 +1531,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::CancelActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Cancel: Message from %s: %s",
@@ -1573,7 +1576,7 @@ ActivityCategoryHandler::FinishCancelActivity(
 	MojRefCountedPtr<MojServiceMessage> msg, const MojObject& payload,
 	boost::shared_ptr<Activity> act, bool succeeded)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHODFINISH_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Cancel finishing: Message from %s: [Activity %llu] : %s",
@@ -1657,7 +1660,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::PauseActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Pause: Message from %s: %s",
@@ -1752,7 +1755,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::FocusActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Focus: Message from %s: %s",
@@ -1843,7 +1846,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::UnfocusActivity(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Unfocus: Message from %s: %s",
@@ -1939,7 +1942,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AddFocus(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2145,7 +2148,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::ListActivities(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("List: Message from %s: %s",
@@ -2260,7 +2263,11 @@ Get details of an activity.
 
 \param errorCode Code for the error in case the call was not succesful.
 \param errorText Describes the error if the call was not succesful.
-\param activity The activity object.
+\param activity The activity object.  If the Activity is running, or
+                another with its name has run, "cost" holds the CPU time
+                and storage I/O of its subscribers' processes: "current"
+                for this run, and "runs", "total", "average" and "last"
+                over the runs of its name.
 \param returnValue Indicates if the call was succesful.
 
 \subsection com_palm_activitymanager_get_details_examples Examples:
@@ -2314,7 +2321,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::GetActivityDetails(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Details: Message from %s: %s",
@@ -2358,6 +2365,15 @@ ActivityCategoryHandler::GetActivityDetails(MojServiceMessage *msg, MojObject& p
 	err = act->ToJson(rep, flags);
 	MojErrCheck(err);
 
+	MojObject cost(MojObject::TypeObject);
+	err = m_resourceManager->CostToJson(act, cost);
+	MojErrCheck(err);
+
+	if (cost.size()) {
+		err = rep.put(_T("cost"), cost);
+		MojErrCheck(err);
+	}
+
 	MojObject reply;
 
 	err = reply.putBool(MojServiceMessage::ReturnValueKey, true);
@@ -2420,7 +2436,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AssociateApp(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2480,7 +2496,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::DissociateApp(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2540,7 +2556,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AssociateService(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2600,7 +2616,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::DissociateService(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2660,7 +2676,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AssociateProcess(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2720,7 +2736,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::DissociateProcess(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2780,7 +2796,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::AssociateNetworkFlow(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2840,7 +2856,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::DissociateNetworkFlow(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -2917,20 +2933,19 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::MapProcess(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 	MojErr err;
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("MapProcess: %s",
 		MojoObjectJson(payload).c_str());
 
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
+	if (!MojoBusMessage::IsBusMessage(msg)) {
 		throw std::invalid_argument("Non-Luna Message passed in to "
 			"MapProcess");
 	}
 
-	if (lunaMsg->isPublic()) {
+	if (MojoBusMessage::IsPublic(msg)) {
 		err = msg->replyError(MojErrAccessDenied, _T("Process mapping "
 			"requests must originate from private bus"));
 		MojErrCheck(err);
@@ -3037,7 +3052,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::UnmapProcess(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -3064,13 +3079,27 @@ Get activity manager related information:
 \li Activity Manager state:  Run queues and leaked Activities.
 \li List of Activities for which power is currently locked.
 \li State of the Resource Manager(s).
+\li State of the requirement managers, such as the connectivity seen by the
+    internet, wifi and wan requirements and how it is being damped.
+\li Optionally, the daemon's metrics.
 
 \subsection com_palm_activitymanager_info_syntax Syntax:
 \code
 {
+    "metrics": boolean
 }
 \endcode
 
+\param metrics Set to true to also return the metrics collected since the
+               last devel/resetMetrics: request counts per method, persist,
+               trigger, callback and power lock statistics, scheduler wakes
+               and run queue depths.  Histograms are in milliseconds.
+               "methods" has the latency of each method by phase: the
+               handler itself, waiting on the persist chain, and the
+               completion that replies (for methods that defer their reply
+               until the Activity is persisted), plus the slowest requests
+               with their caller and request payload size.
+
 \subsection com_palm_activitymanager_info_examples Examples:
 \code
 luna-send -i -f luna://com.palm.activitymanager/info '{ }'
@@ -3079,6 +3108,45 @@ luna-send -i -f luna://com.palm.activitymanager/info '{ }'
 Example response for a succesful call:
 \code
 {
+    "connectivity": {
+        "damping": {
+            "confidenceHold": 5,
+            "halfLife": 60,
+            "holdDown": 10,
+            "maxSuppress": 600,
+            "penalty": 1000,
+            "reuseLimit": 750,
+            "suppressLimit": 2500
+        },
+        "internet": {
+            "available": true,
+            "confidence": "excellent",
+            "flaps": 1,
+            "penalty": 912,
+            "raw": true,
+            "suppressed": false,
+            "suppressions": 0
+        },
+        "wan": {
+            "available": true,
+            "confidence": "fair",
+            "flaps": 0,
+            "penalty": 0,
+            "raw": true,
+            "suppressed": false,
+            "suppressions": 0
+        },
+        "wifi": {
+            "available": true,
+            "confidence": "excellent",
+            "flaps": 3,
+            "heldFor": 4,
+            "penalty": 2730,
+            "raw": false,
+            "suppressed": false,
+            "suppressions": 0
+        }
+    },
     "queues": [
         {
             "activities": [
@@ -3177,12 +3245,116 @@ Example response for a succesful call:
     }
 }
 \endcode
+
+Excerpt of the response with "metrics": true:
+\code
+{
+    ...
+    "metrics": {
+        "counters": {
+            "calls/create": {
+                "count": 212,
+                "rate": 0.0589
+            },
+            ...
+            "persist.issued": {
+                "count": 431,
+                "rate": 0.1197
+            },
+            "scheduler.wakes": {
+                "count": 38,
+                "rate": 0.0106
+            },
+            "triggers.fired": {
+                "count": 57,
+                "rate": 0.0158
+            }
+        },
+        "elapsed": 3600.2,
+        "gauges": {
+            "persist.outstanding": {
+                "high": 6,
+                "value": 0
+            }
+        },
+        "histograms": {
+            "persist.latency": {
+                "buckets": {
+                    "10": 212,
+                    "20": 180,
+                    "50": 39
+                },
+                "count": 431,
+                "maxMs": 48.2,
+                "meanMs": 11.7
+            },
+            ...
+        },
+        "methods": {
+            "/create": {
+                "finish": {
+                    "count": 212,
+                    "max": 3.1,
+                    "p50": 0.41,
+                    "p99": 1.9,
+                    "p999": 3.1
+                },
+                "handler": {
+                    "count": 212,
+                    "max": 4.2,
+                    "p50": 0.63,
+                    "p99": 2.8,
+                    "p999": 4.2
+                },
+                "persist": {
+                    "count": 212,
+                    "max": 48.5,
+                    "p50": 9.8,
+                    "p99": 39,
+                    "p999": 48.5
+                },
+                "slowest": [
+                    {
+                        "caller": "com.palm.service.contacts.linker",
+                        "handler": 1.2,
+                        "payloadSize": 412,
+                        "persist": 48.5,
+                        "total": 51.9,
+                        "when": 1381266102
+                    },
+                    ...
+                ],
+                "total": {
+                    "count": 212,
+                    "max": 51.9,
+                    "p50": 11,
+                    "p99": 42,
+                    "p999": 51.9
+                }
+            },
+            ...
+        },
+        "queueDepths": {
+            "background": 1,
+            "backgroundInteractive": 0,
+            "ended": 0,
+            "immediate": 0,
+            "initialized": 0,
+            "longBackground": 0,
+            "ready": 0,
+            "readyInteractive": 0,
+            "scheduled": 14
+        }
+    },
+    ...
+}
+\endcode
 */
 
 MojErr
 ActivityCategoryHandler::Info(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -3202,6 +3374,39 @@ ActivityCategoryHandler::Info(MojServiceMessage *msg, MojObject& payload)
 	err = m_resourceManager->InfoToJson(reply);
 	MojErrCheck(err);
 
+	/* Get the state of the Requirement Managers, such as connectivity */
+	err = m_requirementManager->StatusToJson(reply);
+	MojErrCheck(err);
+
+	bool metrics = false;
+	payload.get(_T("metrics"), metrics);
+
+	if (metrics) {
+		MojObject metricsJson(MojObject::TypeObject);
+
+		err = Metrics::ToJson(metricsJson);
+		MojErrCheck(err);
+
+		MojObject queues(MojObject::TypeObject);
+
+		err = m_am->QueueDepthsToJson(queues);
+		MojErrCheck(err);
+
+		err = metricsJson.put(_T("queueDepths"), queues);
+		MojErrCheck(err);
+
+		MojObject methods(MojObject::TypeObject);
+
+		err = MethodLatency::AllToJson(methods);
+		MojErrCheck(err);
+
+		err = metricsJson.put(_T("methods"), methods);
+		MojErrCheck(err);
+
+		err = reply.put(_T("metrics"), metricsJson);
+		MojErrCheck(err);
+	}
+
 	err = msg->reply(reply);
 	MojErrCheck(err);
 
@@ -3265,7 +3470,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::Enable(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -3341,7 +3546,7 @@ Example response for a failed call:
 MojErr
 ActivityCategoryHandler::Disable(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
@@ -3379,12 +3584,11 @@ ActivityCategoryHandler::LookupActivity(MojServiceMessage *msg, MojObject& paylo
 bool
 ActivityCategoryHandler::IsPublicMessage(MojServiceMessage *msg) const
 {
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
+	if (!MojoBusMessage::IsBusMessage(msg)) {
 		throw std::invalid_argument("Non-Luna Message");
 	}
 
-	return lunaMsg->isPublic();
+	return MojoBusMessage::IsPublic(msg);
 }
 
 bool
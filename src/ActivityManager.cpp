@@ -18,6 +18,7 @@
 
 #include "ActivityManager.h"
 #include "ResourceManager.h"
+#include "Probes.h"
 #include "Logging.h"
 
 #include <boost/iterator/transform_iterator.hpp>
@@ -45,6 +46,9 @@ ActivityManager::ActivityManager(boost::shared_ptr<MasterResourceManager>
 	, m_backgroundInteractiveConcurrencyLevel
 		(DefaultBackgroundInteractiveConcurrencyLevel)
 	, m_yieldTimeoutSeconds(DefaultBackgroundInteractiveYieldSeconds)
+	, m_readyQueueHolds(0)
+	, m_readyQueueCheckPending(false)
+	, m_foreground(false)
 	, m_resourceManager(resourceManager)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
@@ -293,6 +297,8 @@ MojErr ActivityManager::FocusActivity(boost::shared_ptr<Activity> act)
 		oldFocused.pop_front();
 	}
 
+	UpdateForeground();
+
 	return MojErrNone;
 }
 
@@ -317,6 +323,8 @@ MojErr ActivityManager::UnfocusActivity(boost::shared_ptr<Activity> act)
 			    "activity not on focus list while removing focus");
 	}
 
+	UpdateForeground();
+
 	return MojErrNone;
 }
 
@@ -344,6 +352,8 @@ MojErr ActivityManager::AddFocus(boost::shared_ptr<Activity> source,
 	m_resourceManager->UpdateAssociations(target);
 	m_focusedActivities.push_back(*target);
 
+	UpdateForeground();
+
 	return MojErrNone;
 }
 
@@ -434,7 +444,7 @@ void ActivityManager::EvictBackgroundActivity(
 
 	if (iter != m_runQueue[RunQueueBackground].end()) {
 		act->m_runQueueItem.unlink();
-		m_runQueue[RunQueueLongBackground].push_back(*act);
+		QueueActivity(*act, RunQueueLongBackground, FlightReasonEvicted);
 	} else {
 		LOG_AM_ERROR(MSGID_ACTIVITY_NOT_ON_BACKGRND_Q, 1, PMLOGKFV("Activity","%llu",act->GetId()), "");
 		throw std::runtime_error("Activity not on background queue");
@@ -451,7 +461,7 @@ void ActivityManager::EvictAllBackgroundActivities()
 	while (!m_runQueue[RunQueueBackground].empty()) {
 		Activity& act = m_runQueue[RunQueueBackground].front();
 		act.m_runQueueItem.unlink();
-		m_runQueue[RunQueueLongBackground].push_back(act);
+		QueueActivity(act, RunQueueLongBackground, FlightReasonEvicted);
 	}
 
 	CheckReadyQueue();
@@ -509,6 +519,65 @@ void ActivityManager::RunAllReadyActivities()
 	}
 }
 
+MojErr ActivityManager::MemoryUsageToJson(MojObject& rep) const
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err = MojErrNone;
+
+	/* Include Activities that are still being torn down (or leaked), since
+	 * they still occupy memory */
+	Activity::MemoryUsage usage;
+	size_t count = 0;
+
+	for (ActivityIdTable::const_iterator iter = m_idTable.begin();
+		iter != m_idTable.end(); ++iter) {
+		iter->AccumulateMemoryUsage(usage);
+		count++;
+	}
+
+	size_t total = usage.m_object + usage.m_strings + usage.m_requirements +
+		usage.m_persistCommands + usage.m_coldState;
+
+	MojObject components(MojObject::TypeObject);
+
+	err = components.putInt(_T("object"), (MojInt64)usage.m_object);
+	MojErrCheck(err);
+
+	err = components.putInt(_T("strings"), (MojInt64)usage.m_strings);
+	MojErrCheck(err);
+
+	err = components.putInt(_T("requirements"),
+		(MojInt64)usage.m_requirements);
+	MojErrCheck(err);
+
+	err = components.putInt(_T("persistCommands"),
+		(MojInt64)usage.m_persistCommands);
+	MojErrCheck(err);
+
+	err = components.putInt(_T("coldState"), (MojInt64)usage.m_coldState);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("activities"), (MojInt64)count);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("coldStateAllocated"),
+		(MojInt64)usage.m_coldStateCount);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("totalBytes"), (MojInt64)total);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("bytesPerActivity"),
+		(MojInt64)(count ? (total / count) : 0));
+	MojErrCheck(err);
+
+	err = rep.put(_T("components"), components);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 #endif /* ACTIVITYMANAGER_DEVELOPER_METHODS */
 
 void ActivityManager::InformActivityInitialized(
@@ -527,10 +596,10 @@ void ActivityManager::InformActivityInitialized(
 	/* If the Activity Manager isn't enabled yet, just queue the Activities.
 	 * otherwise, schedule them immediately. */
 	if (IsEnabled()) {
-		m_runQueue[RunQueueScheduled].push_back(*act);
+		QueueActivity(*act, RunQueueScheduled, FlightReasonSchedule);
 		act->ScheduleActivity();
 	} else {
-		m_runQueue[RunQueueInitialized].push_back(*act);
+		QueueActivity(*act, RunQueueInitialized, FlightReasonInitialized);
 	}
 }
 
@@ -539,6 +608,10 @@ void ActivityManager::InformActivityReady(boost::shared_ptr<Activity> act)
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("[Activity %llu] Now ready to run", act->GetId());
 
+	AM_PROBE2(activity_ready, act->GetId(), act->IsImmediate() ?
+		RunQueueImmediate : (act->IsUserInitiated() ?
+			RunQueueReadyInteractive : RunQueueReady));
+
 	if (act->m_runQueueItem.is_linked()) {
 		act->m_runQueueItem.unlink();
 	} else {
@@ -547,13 +620,14 @@ void ActivityManager::InformActivityReady(boost::shared_ptr<Activity> act)
 	}
 
 	if (act->IsImmediate()) {
-		m_runQueue[RunQueueImmediate].push_back(*act);
+		QueueActivity(*act, RunQueueImmediate, FlightReasonReady);
 		RunActivity(*act);
 	} else {
 		if (act->IsUserInitiated()) {
-			m_runQueue[RunQueueReadyInteractive].push_back(*act);
+			QueueActivity(*act, RunQueueReadyInteractive,
+				FlightReasonReady);
 		} else {
-			m_runQueue[RunQueueReady].push_back(*act);
+			QueueActivity(*act, RunQueueReady, FlightReasonReady);
 		}
 
 		CheckReadyQueue();
@@ -573,7 +647,7 @@ void ActivityManager::InformActivityNotReady(boost::shared_ptr<Activity> act)
 			act->GetId());
 	}
 
-	m_runQueue[RunQueueScheduled].push_back(*act);
+	QueueActivity(*act, RunQueueScheduled, FlightReasonNotReady);
 }
 
 void ActivityManager::InformActivityRunning(boost::shared_ptr<Activity> act)
@@ -602,7 +676,7 @@ void ActivityManager::InformActivityEnd(boost::shared_ptr<Activity> act)
 		act->m_runQueueItem.unlink();
 	}
 
-	m_runQueue[RunQueueEnded].push_back(*act);
+	QueueActivity(*act, RunQueueEnded, FlightReasonEnd);
 
 	m_resourceManager->Dissociate(act);
 
@@ -642,7 +716,7 @@ void ActivityManager::ScheduleAllActivities()
 		LOG_AM_DEBUG("Granting [Activity %llu] permission to schedule",
 			act.GetId());
 
-		m_runQueue[RunQueueScheduled].push_back(act);
+		QueueActivity(act, RunQueueScheduled, FlightReasonSchedule);
 		act.ScheduleActivity();
 	}
 }
@@ -655,6 +729,11 @@ void ActivityManager::EvictQueue(boost::shared_ptr<Activity> act)
 		LOG_AM_DEBUG("[Activity %llu] evicted from run queue on release",
 			act->GetId());
 		act->m_runQueueItem.unlink();
+
+		FlightRecorder::Record(FlightQueueEvent, act->GetId(), 0,
+			FlightRecorder::FlightNoQueue, FlightReasonReleased);
+
+		UpdateForeground();
 	}
 }
 
@@ -678,7 +757,7 @@ void ActivityManager::RunReadyBackgroundActivity(Activity& act)
 		LOG_AM_WARNING(MSGID_ATTEMPT_RUN_BACKGRND_ACTIVITY, 1, PMLOGKFV("Activity","%llu",act.GetId()), "");
 	}
 
-	m_runQueue[RunQueueBackground].push_back(act);
+	QueueActivity(act, RunQueueBackground, FlightReasonRun);
 
 	RunActivity(act);
 }
@@ -696,7 +775,7 @@ void ActivityManager::RunReadyBackgroundInteractiveActivity(Activity& act)
 			 act.GetId());
 	}
 
-	m_runQueue[RunQueueBackgroundInteractive].push_back(act);
+	QueueActivity(act, RunQueueBackgroundInteractive, FlightReasonRun);
 
 	RunActivity(act);
 }
@@ -707,12 +786,36 @@ unsigned ActivityManager::GetRunningBackgroundActivitiesCount() const
 		m_runQueue[RunQueueBackgroundInteractive].size());
 }
 
+void ActivityManager::HoldReadyQueue()
+{
+	m_readyQueueHolds++;
+}
+
+void ActivityManager::ReleaseReadyQueue()
+{
+	if (!m_readyQueueHolds) {
+		throw std::runtime_error("Ready queue is not held");
+	}
+
+	if (--m_readyQueueHolds == 0 && m_readyQueueCheckPending) {
+		m_readyQueueCheckPending = false;
+		CheckReadyQueue();
+	}
+}
+
 void ActivityManager::CheckReadyQueue()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (m_readyQueueHolds) {
+		m_readyQueueCheckPending = true;
+		return;
+	}
+
 	LOG_AM_DEBUG("Checking to see if more background Activities can run");
 
-	bool ranInteractive = false;
+	unsigned ranInteractive = 0;
+	unsigned ranBackground = 0;
 
 	while (((GetRunningBackgroundActivitiesCount()
 				< m_backgroundInteractiveConcurrencyLevel) ||
@@ -721,17 +824,19 @@ void ActivityManager::CheckReadyQueue()
 			&& !m_runQueue[RunQueueReadyInteractive].empty()) {
 		RunReadyBackgroundInteractiveActivity(
 			m_runQueue[RunQueueReadyInteractive].front());
-		ranInteractive = true;
+		ranInteractive++;
 	}
 
 	if (!m_runQueue[RunQueueReadyInteractive].empty()) {
 		if (ranInteractive) {
 			UpdateYieldTimeout();
-		} else if (!m_interactiveYieldTimeout) {
+		} else if (!m_interactiveYieldTimeout ||
+			!m_interactiveYieldTimeout->IsArmed()) {
 			UpdateYieldTimeout();
 		}
 	} else {
-		if (m_interactiveYieldTimeout) {
+		if (m_interactiveYieldTimeout &&
+			m_interactiveYieldTimeout->IsArmed()) {
 			CancelYieldTimeout();
 		}
 	}
@@ -741,14 +846,29 @@ void ActivityManager::CheckReadyQueue()
 			(m_backgroundConcurrencyLevel == UnlimitedBackgroundConcurrency))
 			&& !m_runQueue[RunQueueReady].empty()) {
 		RunReadyBackgroundActivity(m_runQueue[RunQueueReady].front());
+		ranBackground++;
 	}
+
+	AM_PROBE3(check_ready_queue, ranInteractive, ranBackground,
+		GetRunningBackgroundActivitiesCount());
+}
+
+void ActivityManager::QueueActivity(Activity& act, RunQueueId queue,
+	FlightReason reason)
+{
+	m_runQueue[queue].push_back(act);
+
+	FlightRecorder::Record(FlightQueueEvent, act.GetId(), 0, (MojUInt8)queue,
+		(MojUInt16)reason);
+
+	UpdateForeground();
 }
 
 void ActivityManager::UpdateYieldTimeout()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
-	if (!m_interactiveYieldTimeout) {
+	if (!m_interactiveYieldTimeout || !m_interactiveYieldTimeout->IsArmed()) {
 		LOG_AM_DEBUG("Arming background interactive yield timeout for %u seconds",
 			m_yieldTimeoutSeconds);
 	} else {
@@ -756,10 +876,15 @@ void ActivityManager::UpdateYieldTimeout()
 			m_yieldTimeoutSeconds);
 	}
 
-	m_interactiveYieldTimeout = boost::make_shared<Timeout<ActivityManager> >
-		(shared_from_this(), m_yieldTimeoutSeconds,
-			&ActivityManager::InteractiveYieldTimeout);
-	m_interactiveYieldTimeout->Arm();
+	/* The Timeout is kept once created, so re-arming it only moves its
+	 * timer */
+	if (!m_interactiveYieldTimeout) {
+		m_interactiveYieldTimeout = boost::make_shared<Timeout<ActivityManager> >
+			(shared_from_this(), m_yieldTimeoutSeconds,
+				&ActivityManager::InteractiveYieldTimeout);
+	}
+
+	m_interactiveYieldTimeout->Arm(m_yieldTimeoutSeconds);
 }
 
 void ActivityManager::CancelYieldTimeout()
@@ -767,7 +892,24 @@ void ActivityManager::CancelYieldTimeout()
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Cancelling background interactive yield timeout");
 
-	m_interactiveYieldTimeout.reset();
+	if (m_interactiveYieldTimeout) {
+		m_interactiveYieldTimeout->Cancel();
+	}
+}
+
+void ActivityManager::UpdateForeground()
+{
+	bool foreground = !m_focusedActivities.empty() ||
+		!m_runQueue[RunQueueImmediate].empty();
+
+	if (foreground == m_foreground) {
+		return;
+	}
+
+	LOG_AM_DEBUG("Foreground is now %s", foreground ? "active" : "idle");
+
+	m_foreground = foreground;
+	m_resourceManager->InformForegroundChanged(foreground);
 }
 
 void ActivityManager::InteractiveYieldTimeout()
@@ -937,3 +1079,15 @@ MojErr ActivityManager::InfoToJson(MojObject& rep) const
 	return MojErrNone;
 }
 
+MojErr ActivityManager::QueueDepthsToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	for (int i = 0; i < RunQueueMax; i++) {
+		err = rep.putInt(RunQueueNames[i], (MojInt64)m_runQueue[i].size());
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
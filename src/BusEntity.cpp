@@ -25,7 +25,9 @@
 MojLogger BusEntity::s_log(_T("activitymanager.entity"));
 
 BusEntity::BusEntity(const BusId& id)
-	: m_id(id)
+	: m_reportedPriority(ActivityPriorityNone)
+	, m_reportedFocused(false)
+	, m_id(id)
 {
 }
 
@@ -48,10 +50,11 @@ void BusEntity::AssociateActivity(boost::shared_ptr<Activity> activity)
 			activity->GetId(), m_id.GetString().c_str());
 		/* Don't throw here.  Be resilient. */
 	} else {
-		boost::shared_ptr<ActivitySetAutoAssociation> association =
+		boost::shared_ptr<BusEntityAssociation> association =
 			boost::make_shared<BusEntityAssociation>(activity,
 				shared_from_this());
 		m_associations.insert(*association);
+		CountActivity(*association);
 		activity->AddEntityAssociation(association);
 	}
 }
@@ -75,6 +78,7 @@ void BusEntity::DissociateActivity(boost::shared_ptr<Activity> activity)
 				ActivityAutoAssociation>(found->shared_from_this());
 
 		m_associations.erase(found);
+		UncountActivity(static_cast<BusEntityAssociation&>(*association));
 
 		activity->RemoveEntityAssociation(association);
 	}
@@ -87,20 +91,27 @@ std::string BusEntity::GetName() const
 
 ActivityPriority_t BusEntity::GetPriority() const
 {
-	if (m_associations.empty()) {
-		return ActivityPriorityNone;
-	} else {
-		return m_associations.begin()->GetActivity()->GetPriority();
-	}
+	return m_counts.GetPriority();
 }
 
 bool BusEntity::IsFocused() const
 {
-	if (m_associations.empty()) {
+	return m_counts.IsFocused();
+}
+
+bool BusEntity::ConsumeChange()
+{
+	ActivityPriority_t priority = GetPriority();
+	bool focused = IsFocused();
+
+	if ((priority == m_reportedPriority) && (focused == m_reportedFocused)) {
 		return false;
-	} else {
-		return m_associations.begin()->GetActivity()->IsFocused();
 	}
+
+	m_reportedPriority = priority;
+	m_reportedFocused = focused;
+
+	return true;
 }
 
 
@@ -165,6 +176,11 @@ void BusEntity::ReassociateActivity(
 			m_id.GetString().c_str());
 	}
 
+	BusEntityAssociation& entityAssociation =
+		static_cast<BusEntityAssociation&>(*association);
+	UncountActivity(entityAssociation);
+	CountActivity(entityAssociation);
+
 	std::pair<ActivityAssociations::iterator, bool> result =
 		m_associations.insert(*association);
 	if (!result.second) {
@@ -174,6 +190,26 @@ void BusEntity::ReassociateActivity(
 	}
 }
 
+void BusEntity::CountActivity(BusEntityAssociation& association)
+{
+	boost::shared_ptr<const Activity> activity = association.GetActivity();
+
+	association.m_countedPriority = activity->GetPriority();
+	association.m_countedFocused = activity->IsFocused();
+	association.m_counted = true;
+
+	m_counts.Add(association.m_countedPriority, association.m_countedFocused);
+}
+
+void BusEntity::UncountActivity(BusEntityAssociation& association)
+{
+	if (association.m_counted) {
+		m_counts.Remove(association.m_countedPriority,
+			association.m_countedFocused);
+		association.m_counted = false;
+	}
+}
+
 bool BusEntity::ActivityPriorityCompare(
 	const boost::shared_ptr<const Activity>& x,
 	const boost::shared_ptr<const Activity>& y)
@@ -223,12 +259,23 @@ bool BusEntity::ActivityAssociationComp::operator()(
 BusEntity::BusEntityAssociation::BusEntityAssociation(
 	boost::shared_ptr<Activity> activity, boost::shared_ptr<BusEntity> entity)
 	: ActivitySetAutoAssociation(activity)
+	, m_countedPriority(ActivityPriorityNone)
+	, m_countedFocused(false)
+	, m_counted(false)
 	, m_entity(entity)
 {
 }
 
 BusEntity::BusEntityAssociation::~BusEntityAssociation()
 {
+	/* The Activity went away without being dissociated; the auto unlink
+	 * takes it out of the set, but it must come out of the counts too. */
+	if (m_counted) {
+		boost::shared_ptr<BusEntity> entity = m_entity.lock();
+		if (entity) {
+			entity->UncountActivity(*this);
+		}
+	}
 }
 
 bool BusEntity::BusEntityAssociation::operator<(
@@ -19,42 +19,220 @@
 #include "BusId.h"
 #include "Subscriber.h"
 
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_set.hpp>
+
+struct BusId::Symbol {
+	Symbol(const char *id, size_t length, BusIdType type, unsigned handle)
+		: m_id(id, length)
+		, m_string(BusId::GetString(m_id, type))
+		, m_type(type)
+		, m_handle(handle)
+		, m_refs(0)
+	{
+	}
+
+	std::string	m_id;
+	std::string	m_string;
+	BusIdType	m_type;
+	unsigned	m_handle;
+	unsigned	m_refs;
+};
+
+/* Key used to probe the symbol table without building a std::string */
+struct BusIdSymbolKey {
+	BusIdSymbolKey(const char *id, size_t length, BusIdType type)
+		: m_id(id), m_length(length), m_type(type) {}
+
+	const char	*m_id;
+	size_t		m_length;
+	BusIdType	m_type;
+};
+
+struct BusIdSymbolHash {
+	std::size_t operator()(const char *id, size_t length,
+		BusIdType type) const
+	{
+		std::size_t seed = 0;
+		boost::hash_combine(seed, (int)type);
+		boost::hash_range(seed, id, id + length);
+		return seed;
+	}
+
+	std::size_t operator()(const BusId::Symbol *symbol) const
+	{
+		return (*this)(symbol->m_id.data(), symbol->m_id.length(),
+			symbol->m_type);
+	}
+
+	std::size_t operator()(const BusIdSymbolKey& key) const
+	{
+		return (*this)(key.m_id, key.m_length, key.m_type);
+	}
+};
+
+struct BusIdSymbolEqual {
+	bool operator()(const BusId::Symbol *lhs, const BusId::Symbol *rhs) const
+	{
+		return lhs == rhs;
+	}
+
+	bool operator()(const BusIdSymbolKey& key, const BusId::Symbol *symbol) const
+	{
+		return (key.m_type == symbol->m_type) &&
+			(symbol->m_id.length() == key.m_length) &&
+			(symbol->m_id.compare(0, key.m_length, key.m_id,
+				key.m_length) == 0);
+	}
+
+	bool operator()(const BusId::Symbol *symbol, const BusIdSymbolKey& key) const
+	{
+		return (*this)(key, symbol);
+	}
+};
+
+typedef boost::unordered_set<BusId::Symbol *, BusIdSymbolHash,
+	BusIdSymbolEqual> SymbolTable;
+
+/* Built on first use, so BusIds constructed during static initialization
+ * in other modules find the table ready, and never destroyed, so BusIds
+ * with static storage duration can still release their symbols during
+ * exit, whatever order the destructors run in. */
+static SymbolTable& GetSymbolTable()
+{
+	static SymbolTable *table = new SymbolTable;
+	return *table;
+}
+
+static unsigned s_nextHandle = 1;
+
+BusId::Symbol *BusId::GetNullSymbol()
+{
+	/* Never released, so never removed, and likewise never destroyed */
+	static Symbol *nullSymbol = new Symbol("", 0, BusNull, 0);
+	return nullSymbol;
+}
+
+BusId::Symbol *BusId::Intern(const char *id, size_t length, BusIdType type)
+{
+	if (!id) {
+		throw std::runtime_error("Attempt to create BusId from NULL id");
+	}
+
+	if (type == BusNull) {
+		return GetNullSymbol();
+	}
+
+	SymbolTable& table = GetSymbolTable();
+	BusIdSymbolKey key(id, length, type);
+
+	SymbolTable::iterator found = table.find(key,
+		BusIdSymbolHash(), BusIdSymbolEqual());
+	if (found != table.end()) {
+		return *found;
+	}
+
+	Symbol *symbol = new Symbol(id, length, type, s_nextHandle++);
+	table.insert(symbol);
+
+	return symbol;
+}
+
+size_t BusId::GetSymbolCount()
+{
+	return GetSymbolTable().size();
+}
+
+void BusId::Retain() const
+{
+	if (m_symbol == GetNullSymbol())
+		return;
+
+	m_symbol->m_refs++;
+}
+
+void BusId::Release() const
+{
+	if (m_symbol == GetNullSymbol())
+		return;
+
+	if (--m_symbol->m_refs == 0) {
+		GetSymbolTable().erase(m_symbol);
+		delete m_symbol;
+	}
+}
+
 BusId::BusId()
-	: m_type(BusNull)
+	: m_symbol(GetNullSymbol())
 {
+	Retain();
+}
+
+BusId::BusId(const BusId& rhs)
+	: m_symbol(rhs.m_symbol)
+{
+	Retain();
 }
 
 BusId::BusId(const std::string& id, BusIdType type)
-	: m_id(id)
-	, m_type(type)
+	: m_symbol(Intern(id.data(), id.length(), type))
 {
+	Retain();
 }
 
 BusId::BusId(const char *id, BusIdType type)
-	: m_id(id)
-	, m_type(type)
+	: m_symbol(Intern(id, id ? strlen(id) : 0, type))
+{
+	Retain();
+}
+
+BusId::BusId(const char *id, size_t length, BusIdType type)
+	: m_symbol(Intern(id, length, type))
 {
+	Retain();
 }
 
 BusId::BusId(const Subscriber& subscriber)
-	: m_id(subscriber.m_id.m_id)
-	, m_type(subscriber.m_id.m_type)
+	: m_symbol(subscriber.m_id.m_symbol)
 {
+	Retain();
+}
+
+BusId::~BusId()
+{
+	Release();
 }
 
 BusIdType BusId::GetType() const
 {
-	return m_type;
+	return m_symbol->m_type;
+}
+
+const std::string& BusId::GetId() const
+{
+	return m_symbol->m_id;
+}
+
+unsigned BusId::GetHandle() const
+{
+	return m_symbol->m_handle;
 }
 
-std::string BusId::GetId() const
+const std::string& BusId::GetString() const
 {
-	return m_id;
+	return m_symbol->m_string;
 }
 
-std::string BusId::GetString() const
+size_t BusId::GetMemoryShare() const
 {
-	return GetString(m_id.c_str(), m_type);
+	if ((m_symbol == GetNullSymbol()) || !m_symbol->m_refs)
+		return 0;
+
+	return (sizeof(Symbol) + m_symbol->m_id.capacity() +
+		m_symbol->m_string.capacity()) / m_symbol->m_refs;
 }
 
 std::string BusId::GetString(const std::string& id,
@@ -79,43 +257,51 @@ MojErr BusId::ToJson(MojObject& rep) const
 {
 	MojErr err = MojErrNone;
 
-	if (m_type == BusApp) {
-		err = rep.putString(_T("appId"), m_id.c_str());
+	if (m_symbol->m_type == BusApp) {
+		err = rep.putString(_T("appId"), m_symbol->m_id.c_str());
 		MojErrCheck(err);
-	} else if (m_type == BusService) {
-		err = rep.putString(_T("serviceId"), m_id.c_str());
+	} else if (m_symbol->m_type == BusService) {
+		err = rep.putString(_T("serviceId"), m_symbol->m_id.c_str());
 		MojErrCheck(err);
 	} else {
-		err = rep.putString(_T("anonId"), m_id.c_str());
+		err = rep.putString(_T("anonId"), m_symbol->m_id.c_str());
 	}
 
 	return MojErrNone;
 }
 
-BusId& BusId::operator=(const Subscriber& rhs)
+BusId& BusId::operator=(const BusId& rhs)
 {
-	m_id = rhs.m_id.m_id;
-	m_type = rhs.m_id.m_type;
+	if (m_symbol != rhs.m_symbol) {
+		rhs.Retain();
+		Release();
+		m_symbol = rhs.m_symbol;
+	}
 
 	return *this;
 }
 
+BusId& BusId::operator=(const Subscriber& rhs)
+{
+	return (*this = rhs.m_id);
+}
+
 bool BusId::operator<(const BusId& rhs) const
 {
-	if (m_type != rhs.m_type)
-		return (m_type < rhs.m_type);
+	if (m_symbol->m_type != rhs.m_symbol->m_type)
+		return (m_symbol->m_type < rhs.m_symbol->m_type);
 	else
-		return (m_id < rhs.m_id);
+		return (m_symbol->m_handle < rhs.m_symbol->m_handle);
 }
 
 bool BusId::operator!=(const BusId& rhs) const
 {
-	return ((m_id != rhs.m_id) || (m_type != rhs.m_type));
+	return (m_symbol != rhs.m_symbol);
 }
 
 bool BusId::operator==(const BusId& rhs) const
 {
-	return ((m_id == rhs.m_id) && (m_type == rhs.m_type));
+	return (m_symbol == rhs.m_symbol);
 }
 
 bool BusId::operator!=(const Subscriber& rhs) const
@@ -138,3 +324,7 @@ bool BusId::operator==(const std::string& rhs) const
 	return (GetString() == rhs);
 }
 
+std::size_t hash_value(const BusId& id)
+{
+	return boost::hash_value(id.GetHandle());
+}
@@ -106,7 +106,7 @@ Example response for a failed call:
 MojErr
 CallbackCategoryHandler::ScheduledWakeup(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Callback: ScheduledWakeup");
@@ -123,7 +123,7 @@ CallbackCategoryHandler::ScheduledWakeup(MojServiceMessage *msg, MojObject &payl
 MojErr
 CallbackCategoryHandler::SchedulerTest(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Callback: Scheduler Test Start: %s",
@@ -0,0 +1,136 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "CgroupV2Group.h"
+#include "CgroupV2Manager.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <algorithm>
+
+CgroupV2Group::CgroupV2Group(const std::string& name,
+	boost::shared_ptr<CgroupV2Manager> manager)
+	: ResourceContainer(name, manager)
+	, m_appliedClass(CgroupV2Manager::NoClass)
+{
+}
+
+CgroupV2Group::~CgroupV2Group()
+{
+}
+
+void CgroupV2Group::UpdatePriority()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	ActivityPriority_t priority = GetPriority();
+	bool focused = IsFocused();
+
+	unsigned cls = CgroupV2Manager::GetClass(priority, focused);
+
+	/* Entity updates arrive far more often than the container's effective
+	 * class changes; only a change costs any writes. */
+	if (cls == m_appliedClass) {
+		static MetricsCounter& s_skipped =
+			Metrics::GetCounter("cgroup.updatesSkipped");
+		s_skipped.Increment();
+		return;
+	}
+
+	LOG_AM_DEBUG("Moving [Container %s] to [%s,%s]", m_name.c_str(),
+		ActivityPriorityNames[priority], focused ? "focused" : "unfocused");
+
+	if (!m_processIds.empty() &&
+		!GetCgroupManager()->MoveProcesses(cls, m_processIds)) {
+		LOG_AM_WARNING(MSGID_CONTAINER_PRIORITY_CHANGE_FAIL, 3,
+			PMLOGKS("container", m_name.c_str()),
+			PMLOGKS("Priority", ActivityPriorityNames[priority]),
+			PMLOGKS("focus", focused ? "focused" : "unfocused"), "");
+		return;
+	}
+
+	m_appliedClass = cls;
+}
+
+void CgroupV2Group::MapProcess(pid_t pid)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("Mapping [pid %d] into [Container %s]", (int)pid,
+		m_name.c_str());
+
+	if (std::find(m_processIds.begin(), m_processIds.end(), (int)pid) !=
+		m_processIds.end()) {
+		return;
+	}
+
+	m_processIds.push_back((int)pid);
+
+	if (m_appliedClass == CgroupV2Manager::NoClass) {
+		UpdatePriority();
+		return;
+	}
+
+	/* The rest of the container is already in place */
+	std::list<int> added(1, (int)pid);
+	GetCgroupManager()->MoveProcesses(m_appliedClass, added);
+	if (added.empty()) {
+		m_processIds.pop_back();
+	}
+}
+
+void CgroupV2Group::GetProcessIds(std::set<int>& pids) const
+{
+	pids.insert(m_processIds.begin(), m_processIds.end());
+}
+
+void CgroupV2Group::Enable()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	UpdatePriority();
+}
+
+void CgroupV2Group::Disable()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	UpdatePriority();
+}
+
+MojErr CgroupV2Group::ToJson(MojObject& rep) const
+{
+	MojErr err = rep.putString(_T("path"),
+		GetCgroupManager()->GetClassPath(m_appliedClass).c_str());
+	MojErrCheck(err);
+
+	MojObject processes(MojObject::TypeArray);
+	for (std::list<int>::const_iterator iter = m_processIds.begin();
+		iter != m_processIds.end(); ++iter) {
+		err = processes.push(MojObject((MojInt64)*iter));
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("processes"), processes);
+	MojErrCheck(err);
+
+	return ResourceContainer::ToJson(rep);
+}
+
+boost::shared_ptr<CgroupV2Manager> CgroupV2Group::GetCgroupManager() const
+{
+	return boost::dynamic_pointer_cast<CgroupV2Manager, ContainerManager>
+		(m_manager.lock());
+}
@@ -0,0 +1,425 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "CgroupV2Manager.h"
+#include "CgroupV2Group.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#ifdef MOJ_LINUX
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef CGROUP2_SUPER_MAGIC
+#define CGROUP2_SUPER_MAGIC	0x63677270
+#endif
+
+/* Relative shares of the classes, and a hard cap for the two lowest so
+ * they cannot soak up idle CPU that foreground work is about to need. */
+static const struct {
+	unsigned	m_weight;
+	const char	*m_max;
+} ClassSettings[CgroupV2Manager::ClassCount] = {
+	{ 10,	"5000 100000"	},	/* none */
+	{ 25,	"20000 100000"	},	/* lowest */
+	{ 50,	"max"			},	/* low */
+	{ 100,	"max"			},	/* normal */
+	{ 200,	"max"			},	/* high */
+	{ 400,	"max"			},	/* highest */
+	{ 1000,	"max"			}	/* focused */
+};
+
+CgroupV2Manager::CgroupV2Manager(const std::string& root,
+	boost::shared_ptr<MasterResourceManager> master)
+	: ContainerManager(master)
+	, m_root(root)
+	, m_supported(false)
+	, m_cpuset(false)
+{
+	for (unsigned i = 0; i < ClassCount; i++) {
+		m_classFds[i] = -1;
+	}
+
+	std::string unfocused = m_root + "/unfocused";
+
+	if (((mkdir(m_root.c_str(), 0755) < 0) && (errno != EEXIST)) ||
+		((mkdir(unfocused.c_str(), 0755) < 0) && (errno != EEXIST))) {
+		LOG_AM_ERROR(MSGID_CGROUP_CREATE_FAIL, 2,
+			PMLOGKS("path", m_root.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return;
+	}
+
+	/* Processes may only live in the leaves, so both inner cgroups just
+	 * pass the controllers down.  Enabling a controller that is not
+	 * delegated fails the whole write, so try cpu alone if cpuset is
+	 * missing. */
+	if (EnableControllers(unfocused, "+cpu +cpuset")) {
+		m_cpuset = true;
+	} else if (EnableControllers(unfocused, "+cpu")) {
+		LOG_AM_WARNING(MSGID_CGROUP_CONTROLLER_FAIL, 1,
+			PMLOGKS("path", m_root.c_str()),
+			"cpuset controller not delegated; CPUs cannot be partitioned");
+	} else {
+		LOG_AM_WARNING(MSGID_CGROUP_CONTROLLER_FAIL, 1,
+			PMLOGKS("path", m_root.c_str()),
+			"cpu controller not delegated; classes will not be weighted");
+	}
+
+	for (unsigned i = 0; i < ClassCount; i++) {
+		if (!CreateClass(i)) {
+			return;
+		}
+	}
+
+	m_supported = true;
+
+	/* A previous instance that died while the lowest class was frozen
+	 * left it that way; nothing is frozen until UpdateFreeze() says so. */
+	FreezeLowest(false);
+
+	/* Likewise, undo any partition an earlier instance left behind */
+	if (m_cpuset) {
+		WriteClassCpus();
+	}
+}
+
+CgroupV2Manager::~CgroupV2Manager()
+{
+	/* Never leave services frozen behind us */
+	if (IsFrozen()) {
+		FreezeLowest(false);
+	}
+
+	for (unsigned i = 0; i < ClassCount; i++) {
+		if (m_classFds[i] >= 0) {
+			close(m_classFds[i]);
+		}
+	}
+}
+
+bool CgroupV2Manager::IsCgroupV2(const std::string& path)
+{
+#ifdef MOJ_LINUX
+	struct statfs cgroupstat;
+
+	if (statfs(path.c_str(), &cgroupstat)) {
+		return false;
+	}
+
+	return (cgroupstat.f_type == CGROUP2_SUPER_MAGIC);
+#else
+	return false;
+#endif
+}
+
+boost::shared_ptr<ResourceContainer> CgroupV2Manager::CreateContainer(
+	const std::string& name)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("Creating [Container %s]", name.c_str());
+
+	return boost::make_shared<CgroupV2Group>(name,
+		boost::dynamic_pointer_cast<CgroupV2Manager, ResourceManager>
+			(shared_from_this()));
+}
+
+ActivityPriority_t CgroupV2Manager::GetDefaultPriority() const
+{
+	return ActivityPriorityLow;
+}
+
+ActivityPriority_t CgroupV2Manager::GetDisabledPriority() const
+{
+	return ActivityPriorityHigh;
+}
+
+MojErr CgroupV2Manager::InfoToJson(MojObject& rep) const
+{
+	MojObject cgroup(MojObject::TypeObject);
+
+	MojErr err = cgroup.putString(_T("root"), m_root.c_str());
+	MojErrCheck(err);
+
+	err = cgroup.putBool(_T("supported"), m_supported);
+	MojErrCheck(err);
+
+	/* CPU time each class has used, from its cpu.stat */
+	MojObject usage(MojObject::TypeObject);
+	for (unsigned cls = 0; cls < ClassCount; cls++) {
+		MojUInt64 usec;
+		if (ReadUsage(cls, usec)) {
+			err = usage.putInt((cls == FocusedClass) ? _T("focused") :
+				ActivityPriorityNames[cls], (MojInt64)usec);
+			MojErrCheck(err);
+		}
+	}
+
+	err = cgroup.put(_T("usageUsec"), usage);
+	MojErrCheck(err);
+
+	MojObject partition(MojObject::TypeObject);
+	err = CpuPartitionToJson(partition);
+	MojErrCheck(err);
+
+	err = cgroup.put(_T("cpuPartition"), partition);
+	MojErrCheck(err);
+
+	err = rep.put(_T("cgroup"), cgroup);
+	MojErrCheck(err);
+
+	return ContainerManager::InfoToJson(rep);
+}
+
+bool CgroupV2Manager::IsSupported() const
+{
+	return m_supported;
+}
+
+const char *CgroupV2Manager::GetCpuPartitionMode() const
+{
+	return (m_supported && m_cpuset) ? "cpuset" : NULL;
+}
+
+bool CgroupV2Manager::CanFreeze() const
+{
+	return m_supported && (m_classFds[ActivityPriorityLowest] >= 0);
+}
+
+bool CgroupV2Manager::FreezeLowest(bool frozen)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!CanFreeze()) {
+		return false;
+	}
+
+	return WriteControl(m_classFds[ActivityPriorityLowest], "cgroup.freeze",
+		frozen ? "1" : "0", 1, GetClassPath(ActivityPriorityLowest));
+}
+
+void CgroupV2Manager::ApplyCpuPartition()
+{
+	/* The processes stay where they are; only their classes change */
+	if (m_supported && m_cpuset) {
+		WriteClassCpus();
+	}
+}
+
+bool CgroupV2Manager::ReadUsage(unsigned cls, MojUInt64& usec) const
+{
+	if (cls >= ClassCount) {
+		return false;
+	}
+
+	int fd = openat(m_classFds[cls], "cpu.stat", O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	char buf[512];
+	ssize_t length = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (length <= 0) {
+		return false;
+	}
+	buf[length] = '\0';
+
+	unsigned long long value;
+	if (sscanf(buf, "usage_usec %llu", &value) != 1) {
+		return false;
+	}
+
+	usec = (MojUInt64)value;
+	return true;
+}
+
+const std::string& CgroupV2Manager::GetRoot() const
+{
+	return m_root;
+}
+
+unsigned CgroupV2Manager::GetClass(ActivityPriority_t priority, bool focused)
+{
+	return focused ? FocusedClass : (unsigned)priority;
+}
+
+std::string CgroupV2Manager::GetClassPath(unsigned cls) const
+{
+	if (cls == FocusedClass) {
+		return m_root + "/focused";
+	} else if (cls < FocusedClass) {
+		return m_root + "/unfocused/" + ActivityPriorityNames[cls];
+	} else {
+		return m_root;
+	}
+}
+
+bool CgroupV2Manager::MoveProcesses(unsigned cls, std::list<int>& pids)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!m_supported || (cls >= ClassCount)) {
+		return false;
+	}
+
+	static MetricsCounter& s_moves = Metrics::GetCounter("cgroup.moves");
+
+	std::string path = GetClassPath(cls);
+
+	int fd = openat(m_classFds[cls], "cgroup.procs", O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		LOG_AM_ERROR(MSGID_CONTROL_FILE_OPEN_FAIL, 2,
+			PMLOGKS("control_file", path.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return false;
+	}
+
+	/* cgroup.procs takes one pid per write, but the file only needs to be
+	 * opened once for all of them. */
+	bool success = true;
+	char buf[16];
+
+	std::list<int>::iterator pid = pids.begin();
+	while (pid != pids.end()) {
+		int length = snprintf(buf, sizeof(buf), "%d\n", *pid);
+
+		ssize_t ret = write(fd, buf, (size_t)length);
+		if ((ret < 0) && (errno == ESRCH)) {
+			LOG_AM_WARNING(MSGID_INEXISTENT_PROCESS_WRITTEN, 2,
+				PMLOGKFV("Process", "%d", *pid),
+				PMLOGKS("control_file", path.c_str()),
+				"Process to be written to file doesn't exist");
+			pid = pids.erase(pid);
+			continue;
+		} else if (ret != (ssize_t)length) {
+			LOG_AM_ERROR(MSGID_WRITE_TO_CONTROL_FILE_FAIL, 2,
+				PMLOGKS("control_file", path.c_str()),
+				PMLOGKS("Reason", (ret < 0) ? strerror(errno) : "short write"),
+				"");
+			success = false;
+		} else {
+			s_moves.Increment();
+		}
+
+		++pid;
+	}
+
+	close(fd);
+
+	return success;
+}
+
+bool CgroupV2Manager::CreateClass(unsigned cls)
+{
+	std::string path = GetClassPath(cls);
+
+	if ((mkdir(path.c_str(), 0755) < 0) && (errno != EEXIST)) {
+		LOG_AM_ERROR(MSGID_CGROUP_CREATE_FAIL, 2,
+			PMLOGKS("path", path.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return false;
+	}
+
+	m_classFds[cls] = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (m_classFds[cls] < 0) {
+		LOG_AM_ERROR(MSGID_CGROUP_OPEN_FAIL, 2,
+			PMLOGKS("path", path.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return false;
+	}
+
+	/* Without the cpu controller these files do not exist; that was
+	 * already reported. */
+	char buf[16];
+	int length = snprintf(buf, sizeof(buf), "%u", ClassSettings[cls].m_weight);
+	WriteControl(m_classFds[cls], "cpu.weight", buf, (size_t)length, path);
+	WriteControl(m_classFds[cls], "cpu.max", ClassSettings[cls].m_max,
+		strlen(ClassSettings[cls].m_max), path);
+
+	return true;
+}
+
+/* Turn the controllers on for the classes under the root and under
+ * "unfocused" */
+bool CgroupV2Manager::EnableControllers(const std::string& unfocused,
+	const char *controllers)
+{
+	return WriteControl(AT_FDCWD, (m_root + "/cgroup.subtree_control").c_str(),
+			controllers, strlen(controllers), m_root) &&
+		WriteControl(AT_FDCWD,
+			(unfocused + "/cgroup.subtree_control").c_str(), controllers,
+			strlen(controllers), unfocused);
+}
+
+/* Write every class's cpuset.cpus from the partition.  An empty list
+ * makes a class use every CPU its parent has. */
+bool CgroupV2Manager::WriteClassCpus()
+{
+	bool success = true;
+
+	for (unsigned cls = 0; cls < ClassCount; cls++) {
+		std::string cpus = (cls == FocusedClass) ?
+			m_partition.GetCpus(ActivityPriorityHighest, true) :
+			m_partition.GetCpus((ActivityPriority_t)cls, false);
+		if (cpus.empty()) {
+			cpus = "\n";
+		}
+
+		if (!WriteControl(m_classFds[cls], "cpuset.cpus", cpus.c_str(),
+				cpus.length(), GetClassPath(cls))) {
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+bool CgroupV2Manager::WriteControl(int dirfd, const char *control,
+	const char *buf, size_t count, const std::string& path)
+{
+	int fd = openat(dirfd, control, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		LOG_AM_DEBUG("Unable to open %s in %s: %s", control, path.c_str(),
+			strerror(errno));
+		return false;
+	}
+
+	ssize_t ret = write(fd, buf, count);
+	if (ret != (ssize_t)count) {
+		LOG_AM_ERROR(MSGID_WRITE_TO_CONTROL_FILE_FAIL, 2,
+			PMLOGKS("control_file", control),
+			PMLOGKS("Reason", (ret < 0) ? strerror(errno) : "short write"),
+			"");
+		close(fd);
+		return false;
+	}
+
+	close(fd);
+	return true;
+}
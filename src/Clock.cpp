@@ -0,0 +1,418 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "Clock.h"
+#include "Timeout.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include <glib.h>
+
+boost::shared_ptr<Clock> Clock::s_instance;
+
+Clock& Clock::GetInstance()
+{
+	if (!s_instance) {
+		try {
+			s_instance = boost::make_shared<TimerfdClock>();
+		} catch (const std::exception& except) {
+			LOG_AM_WARNING(MSGID_TIMERFD_UNAVAILABLE, 1,
+				PMLOGKS("reason", except.what()),
+				"Using a GLib timeout source per timer");
+			s_instance = boost::make_shared<GlibClock>();
+		}
+	}
+
+	return *s_instance;
+}
+
+void Clock::SetInstance(boost::shared_ptr<Clock> clock)
+{
+	s_instance = clock;
+}
+
+time_t Clock::GetMonotonicTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec;
+}
+
+Clock::TimerId Clock::RearmTimer(TimerId timer, unsigned seconds,
+	TimeoutBase *timeout)
+{
+	if (timer) {
+		CancelTimer(timer);
+	}
+
+	return AddTimer(seconds, timeout);
+}
+
+static gboolean GlibClockTimeout(gpointer data)
+{
+	static_cast<TimeoutBase *>(data)->Fire();
+
+	return false;
+}
+
+GlibClock::GlibClock()
+{
+}
+
+GlibClock::~GlibClock()
+{
+}
+
+time_t GlibClock::GetTime()
+{
+	return time(NULL);
+}
+
+Clock::TimerId GlibClock::AddTimer(unsigned seconds, TimeoutBase *timeout)
+{
+	GSource *source = g_timeout_source_new_seconds((guint)seconds);
+	g_source_set_callback(source, GlibClockTimeout, timeout, NULL);
+	guint id = g_source_attach(source, g_main_context_default());
+	g_source_unref(source);
+
+	return (TimerId)id;
+}
+
+void GlibClock::CancelTimer(TimerId timer)
+{
+	GSource *source = g_main_context_find_source_by_id(
+		g_main_context_default(), (guint)timer);
+	if (source && !g_source_is_destroyed(source)) {
+		g_source_destroy(source);
+	}
+}
+
+/* Low bits of a TimerId are the slot + 1, so an id is never 0; the rest
+ * are the slot's generation, so a stale id never matches a reused slot. */
+static const unsigned TimerSlotBits = 20;
+static const unsigned TimerSlotMask = (1U << TimerSlotBits) - 1;
+static const unsigned TimerGenerationMask = 0xfff;
+
+static const unsigned NotInHeap = (unsigned)-1;
+
+static gboolean TimerfdClockReadable(GIOChannel *channel,
+	GIOCondition condition, gpointer data)
+{
+	static_cast<TimerfdClock *>(data)->Dispatch();
+
+	return true;
+}
+
+TimerfdClock::TimerfdClock()
+	: m_fd(-1)
+	, m_watch(0)
+	, m_dispatching(false)
+	, m_programmed(0)
+	, m_nextSequence(0)
+{
+	m_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_fd < 0) {
+		throw std::runtime_error(std::string("timerfd_create: ") +
+			strerror(errno));
+	}
+
+	GIOChannel *channel = g_io_channel_unix_new(m_fd);
+	m_watch = g_io_add_watch(channel, G_IO_IN, TimerfdClockReadable, this);
+	g_io_channel_unref(channel);
+}
+
+TimerfdClock::~TimerfdClock()
+{
+	if (m_watch) {
+		g_source_remove(m_watch);
+	}
+
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+}
+
+time_t TimerfdClock::GetTime()
+{
+	return time(NULL);
+}
+
+Clock::TimerId TimerfdClock::AddTimer(unsigned seconds, TimeoutBase *timeout)
+{
+	unsigned slot;
+
+	if (!m_free.empty()) {
+		slot = m_free.back();
+		m_free.pop_back();
+	} else {
+		slot = (unsigned)m_slots.size();
+		if (slot >= TimerSlotMask) {
+			throw std::runtime_error("Too many timers armed");
+		}
+
+		Slot entry;
+		entry.m_generation = 0;
+		m_slots.push_back(entry);
+	}
+
+	m_slots[slot].m_timeout = timeout;
+	m_slots[slot].m_heapIndex = NotInHeap;
+
+	Schedule(slot, seconds);
+
+	return MakeId(slot);
+}
+
+void TimerfdClock::CancelTimer(TimerId timer)
+{
+	Slot *entry = Lookup(timer);
+	if (!entry) {
+		return;
+	}
+
+	Remove((unsigned)((timer & TimerSlotMask) - 1));
+	Reprogram();
+}
+
+Clock::TimerId TimerfdClock::RearmTimer(TimerId timer, unsigned seconds,
+	TimeoutBase *timeout)
+{
+	Slot *entry = Lookup(timer);
+	if (!entry || (entry->m_timeout != timeout)) {
+		return AddTimer(seconds, timeout);
+	}
+
+	Schedule((unsigned)((timer & TimerSlotMask) - 1), seconds);
+
+	return timer;
+}
+
+void TimerfdClock::Dispatch()
+{
+	static MetricsCounter& s_wakeups = Metrics::GetCounter("timers.wakeups");
+	s_wakeups.Increment();
+
+	uint64_t expirations;
+	if (read(m_fd, &expirations, sizeof(expirations)) < 0) {
+		if (errno != EAGAIN) {
+			LOG_AM_ERROR(MSGID_TIMERFD_READ_FAIL, 1,
+				PMLOGKS("error", strerror(errno)), "");
+		}
+	}
+
+	/* The timerfd may have fired for a deadline that has since moved, so
+	 * force it to be reprogrammed below. */
+	m_programmed = 0;
+	m_dispatching = true;
+
+	/* Timers armed by the callbacks wait for the next wakeup, even if they
+	 * are already due, so a Timeout re-armed for 0 seconds cannot starve
+	 * the main loop. */
+	unsigned long long now = NowMs();
+	unsigned long long lastSequence = m_nextSequence;
+
+	while (!m_heap.empty()) {
+		unsigned slot = m_heap[0];
+		if ((m_slots[slot].m_deadline > now) ||
+			(m_slots[slot].m_sequence >= lastSequence)) {
+			break;
+		}
+
+		TimeoutBase *timeout = m_slots[slot].m_timeout;
+		Remove(slot);
+
+		/* May add, cancel, re-arm or delete any Timeout, including this
+		 * one */
+		timeout->Fire();
+	}
+
+	m_dispatching = false;
+	Reprogram();
+}
+
+unsigned long long TimerfdClock::NowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((unsigned long long)ts.tv_sec * 1000ULL) +
+		((unsigned long long)ts.tv_nsec / 1000000ULL);
+}
+
+TimerfdClock::Slot *TimerfdClock::Lookup(TimerId timer)
+{
+	unsigned slot = (unsigned)(timer & TimerSlotMask);
+	if ((slot == 0) || (slot > m_slots.size())) {
+		return NULL;
+	}
+
+	Slot *entry = &m_slots[slot - 1];
+	if (!entry->m_timeout || (entry->m_heapIndex == NotInHeap) ||
+		(entry->m_generation != (unsigned)(timer >> TimerSlotBits))) {
+		return NULL;
+	}
+
+	return entry;
+}
+
+Clock::TimerId TimerfdClock::MakeId(unsigned slot) const
+{
+	return ((TimerId)m_slots[slot].m_generation << TimerSlotBits) |
+		(TimerId)(slot + 1);
+}
+
+void TimerfdClock::Schedule(unsigned slot, unsigned seconds)
+{
+	Slot& entry = m_slots[slot];
+
+	entry.m_deadline = NowMs() + ((unsigned long long)seconds * 1000ULL);
+	entry.m_sequence = m_nextSequence++;
+
+	if (entry.m_heapIndex == NotInHeap) {
+		m_heap.push_back(slot);
+		entry.m_heapIndex = (unsigned)(m_heap.size() - 1);
+		SiftUp(entry.m_heapIndex);
+	} else {
+		SiftUp(entry.m_heapIndex);
+		SiftDown(entry.m_heapIndex);
+	}
+
+	Reprogram();
+}
+
+void TimerfdClock::Remove(unsigned slot)
+{
+	Slot& entry = m_slots[slot];
+	unsigned index = entry.m_heapIndex;
+	unsigned last = m_heap.back();
+
+	m_heap.pop_back();
+	if (index < m_heap.size()) {
+		Place(index, last);
+		SiftUp(index);
+		SiftDown(m_slots[last].m_heapIndex);
+	}
+
+	entry.m_timeout = NULL;
+	entry.m_heapIndex = NotInHeap;
+	entry.m_generation = (entry.m_generation + 1) & TimerGenerationMask;
+
+	m_free.push_back(slot);
+}
+
+bool TimerfdClock::Before(unsigned a, unsigned b) const
+{
+	const Slot& first = m_slots[a];
+	const Slot& second = m_slots[b];
+
+	if (first.m_deadline != second.m_deadline) {
+		return first.m_deadline < second.m_deadline;
+	}
+
+	return first.m_sequence < second.m_sequence;
+}
+
+void TimerfdClock::Place(unsigned index, unsigned slot)
+{
+	m_heap[index] = slot;
+	m_slots[slot].m_heapIndex = index;
+}
+
+void TimerfdClock::SiftUp(unsigned index)
+{
+	unsigned slot = m_heap[index];
+
+	while (index > 0) {
+		unsigned parent = (index - 1) / 2;
+		if (!Before(slot, m_heap[parent])) {
+			break;
+		}
+
+		Place(index, m_heap[parent]);
+		index = parent;
+	}
+
+	Place(index, slot);
+}
+
+void TimerfdClock::SiftDown(unsigned index)
+{
+	unsigned slot = m_heap[index];
+	unsigned size = (unsigned)m_heap.size();
+
+	while (true) {
+		unsigned child = (index * 2) + 1;
+		if (child >= size) {
+			break;
+		}
+
+		if (((child + 1) < size) && Before(m_heap[child + 1], m_heap[child])) {
+			child++;
+		}
+
+		if (!Before(m_heap[child], slot)) {
+			break;
+		}
+
+		Place(index, m_heap[child]);
+		index = child;
+	}
+
+	Place(index, slot);
+}
+
+void TimerfdClock::Reprogram()
+{
+	/* Dispatch reprograms once after the whole batch has fired */
+	if (m_dispatching) {
+		return;
+	}
+
+	unsigned long long deadline = 0;
+	if (!m_heap.empty()) {
+		deadline = m_slots[m_heap[0]].m_deadline;
+	}
+
+	if (deadline == m_programmed) {
+		return;
+	}
+
+	/* An all-zero value disarms the timerfd; a deadline already in the past
+	 * makes it readable at once. */
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = (time_t)(deadline / 1000ULL);
+	spec.it_value.tv_nsec = (long)((deadline % 1000ULL) * 1000000ULL);
+
+	if (timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+		LOG_AM_ERROR(MSGID_TIMERFD_SET_FAIL, 1,
+			PMLOGKS("error", strerror(errno)), "");
+		return;
+	}
+
+	m_programmed = deadline;
+}
@@ -0,0 +1,285 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "ConnectionDamping.h"
+#include "Logging.h"
+
+#include <cmath>
+
+ConnectionDamping::Config ConnectionDamping::s_config;
+
+ConnectionDamping::Config::Config()
+	: m_holdDown(10)
+	, m_penalty(1000)
+	, m_suppress(2500)
+	, m_reuse(750)
+	, m_halfLife(30)
+	, m_maxSuppress(120)
+	, m_confidenceHold(5)
+{
+}
+
+const ConnectionDamping::Config& ConnectionDamping::GetConfig()
+{
+	return s_config;
+}
+
+static MojErr GetConfigValue(const MojObject& rep, const MojChar *key,
+	unsigned& value)
+{
+	MojUInt32 newValue;
+	bool found = false;
+
+	MojErr err = rep.get(key, newValue, found);
+	MojErrCheck(err);
+
+	if (found) {
+		value = (unsigned)newValue;
+	}
+
+	return MojErrNone;
+}
+
+MojErr ConnectionDamping::ConfigFromJson(const MojObject& rep)
+{
+	MojErr err;
+	Config config = s_config;
+
+	err = GetConfigValue(rep, _T("holdDown"), config.m_holdDown);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("penalty"), config.m_penalty);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("suppressLimit"), config.m_suppress);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("reuseLimit"), config.m_reuse);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("halfLife"), config.m_halfLife);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("maxSuppress"), config.m_maxSuppress);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("confidenceHold"), config.m_confidenceHold);
+	MojErrCheck(err);
+
+	if (config.m_reuse >= config.m_suppress) {
+		return MojErrInvalidArg;
+	}
+
+	s_config = config;
+
+	LOG_AM_DEBUG("Connection damping: hold down %us, penalty %u, suppress "
+		"%u, reuse %u, half life %us, max suppress %us, confidence hold %us",
+		s_config.m_holdDown, s_config.m_penalty, s_config.m_suppress,
+		s_config.m_reuse, s_config.m_halfLife, s_config.m_maxSuppress,
+		s_config.m_confidenceHold);
+
+	return MojErrNone;
+}
+
+MojErr ConnectionDamping::ConfigToJson(MojObject& rep)
+{
+	MojErr err;
+
+	err = rep.putInt(_T("holdDown"), (MojInt64)s_config.m_holdDown);
+	MojErrCheck(err);
+	err = rep.putInt(_T("penalty"), (MojInt64)s_config.m_penalty);
+	MojErrCheck(err);
+	err = rep.putInt(_T("suppressLimit"), (MojInt64)s_config.m_suppress);
+	MojErrCheck(err);
+	err = rep.putInt(_T("reuseLimit"), (MojInt64)s_config.m_reuse);
+	MojErrCheck(err);
+	err = rep.putInt(_T("halfLife"), (MojInt64)s_config.m_halfLife);
+	MojErrCheck(err);
+	err = rep.putInt(_T("maxSuppress"), (MojInt64)s_config.m_maxSuppress);
+	MojErrCheck(err);
+	err = rep.putInt(_T("confidenceHold"),
+		(MojInt64)s_config.m_confidenceHold);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+/* Links start out down, as do the requirement cores they feed */
+LinkDamper::LinkDamper()
+	: m_raw(false)
+	, m_reported(false)
+	, m_suppressed(false)
+	, m_rawChanged(0)
+	, m_penalty(0.0)
+	, m_penaltyTime(0)
+	, m_flaps(0)
+	, m_suppressions(0)
+{
+}
+
+void LinkDamper::SetRaw(bool available, time_t now)
+{
+	if (available == m_raw) {
+		return;
+	}
+
+	m_raw = available;
+	m_rawChanged = now;
+
+	if (available) {
+		return;
+	}
+
+	const ConnectionDamping::Config& config = ConnectionDamping::GetConfig();
+
+	m_flaps++;
+
+	if (!config.m_penalty || !config.m_halfLife) {
+		m_penalty = 0.0;
+		return;
+	}
+
+	/* Cap the penalty at the level that decays to the reuse limit in
+	 * maxSuppress seconds */
+	double maxPenalty = (double)config.m_reuse *
+		pow(2.0, (double)config.m_maxSuppress / (double)config.m_halfLife);
+
+	m_penalty = DecayedPenalty(now) + (double)config.m_penalty;
+	if (m_penalty > maxPenalty) {
+		m_penalty = maxPenalty;
+	}
+	m_penaltyTime = now;
+
+	if (!m_suppressed && (m_penalty >= (double)config.m_suppress)) {
+		LOG_AM_DEBUG("Link suppressed after %u flaps, penalty %.0f",
+			m_flaps, m_penalty);
+		m_suppressed = true;
+		m_suppressions++;
+	}
+}
+
+bool LinkDamper::Evaluate(time_t now, unsigned& next)
+{
+	const ConnectionDamping::Config& config = ConnectionDamping::GetConfig();
+
+	next = 0;
+
+	if (m_suppressed) {
+		double penalty = DecayedPenalty(now);
+		if (penalty < (double)config.m_reuse) {
+			LOG_AM_DEBUG("Link no longer suppressed, penalty %.0f", penalty);
+			m_suppressed = false;
+		} else {
+			if (m_raw) {
+				double remaining = ceil((double)config.m_halfLife *
+					(log(penalty / (double)config.m_reuse) / log(2.0)));
+				next = (remaining < 1.0) ? 1 : (unsigned)remaining;
+			}
+
+			m_reported = false;
+			return false;
+		}
+	}
+
+	if (m_raw) {
+		m_reported = true;
+	} else if (m_reported) {
+		unsigned down = (now > m_rawChanged) ?
+			(unsigned)(now - m_rawChanged) : 0;
+
+		if (down < config.m_holdDown) {
+			next = config.m_holdDown - down;
+		} else {
+			m_reported = false;
+		}
+	}
+
+	return m_reported;
+}
+
+MojErr LinkDamper::ToJson(MojObject& rep, time_t now) const
+{
+	MojErr err;
+
+	err = rep.putBool(_T("raw"), m_raw);
+	MojErrCheck(err);
+	err = rep.putBool(_T("available"), m_reported);
+	MojErrCheck(err);
+	err = rep.putBool(_T("suppressed"), m_suppressed);
+	MojErrCheck(err);
+	err = rep.putInt(_T("penalty"), (MojInt64)DecayedPenalty(now));
+	MojErrCheck(err);
+	err = rep.putInt(_T("flaps"), (MojInt64)m_flaps);
+	MojErrCheck(err);
+	err = rep.putInt(_T("suppressions"), (MojInt64)m_suppressions);
+	MojErrCheck(err);
+
+	if ((m_raw != m_reported) && (now > m_rawChanged)) {
+		err = rep.putInt(_T("heldFor"), (MojInt64)(now - m_rawChanged));
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+double LinkDamper::DecayedPenalty(time_t now) const
+{
+	unsigned halfLife = ConnectionDamping::GetConfig().m_halfLife;
+
+	if ((m_penalty == 0.0) || !halfLife) {
+		return 0.0;
+	}
+
+	if (now <= m_penaltyTime) {
+		return m_penalty;
+	}
+
+	return m_penalty * pow(0.5,
+		(double)(now - m_penaltyTime) / (double)halfLife);
+}
+
+ConfidenceDebounce::ConfidenceDebounce(int initial)
+	: m_raw(initial)
+	, m_reported(initial)
+	, m_rawChanged(0)
+{
+}
+
+void ConfidenceDebounce::SetRaw(int confidence, time_t now)
+{
+	if (confidence != m_raw) {
+		m_raw = confidence;
+		m_rawChanged = now;
+	}
+}
+
+int ConfidenceDebounce::Evaluate(time_t now, unsigned& next)
+{
+	next = 0;
+
+	if (m_raw >= m_reported) {
+		m_reported = m_raw;
+		return m_reported;
+	}
+
+	unsigned hold = ConnectionDamping::GetConfig().m_confidenceHold;
+	unsigned lower = (now > m_rawChanged) ?
+		(unsigned)(now - m_rawChanged) : 0;
+
+	if (lower < hold) {
+		next = hold - lower;
+	} else {
+		m_reported = m_raw;
+	}
+
+	return m_reported;
+}
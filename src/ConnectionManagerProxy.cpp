@@ -19,6 +19,7 @@
 #include "ConnectionManagerProxy.h"
 #include "Activity.h"
 #include "MojoCall.h"
+#include "Clock.h"
 #include "Logging.h"
 
 #include <core/MojServiceRequest.h>
@@ -32,6 +33,9 @@ ConnectionManagerProxy::ConnectionManagerProxy(MojService *service)
 	, m_internetConfidence(ConnectionConfidenceUnknown)
 	, m_wifiConfidence(ConnectionConfidenceUnknown)
 	, m_wanConfidence(ConnectionConfidenceUnknown)
+	, m_wifiConfidenceDebounce(ConnectionConfidenceUnknown)
+	, m_wanConfidenceDebounce(ConnectionConfidenceUnknown)
+	, m_nextRecheck(0)
 {
 	m_internetRequirementCore = boost::make_shared<RequirementCore>
 		("internet", true);
@@ -187,6 +191,76 @@ void ConnectionManagerProxy::Disable()
 	LOG_AM_DEBUG("Disabling Connection Manager Proxy");
 
 	m_call.reset();
+	m_recheckTimeout.reset();
+}
+
+MojErr ConnectionManagerProxy::StatusToJson(MojObject& rep) const
+{
+	MojErr err;
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+
+	MojObject connectivity(MojObject::TypeObject);
+
+	MojObject internet(MojObject::TypeObject);
+	err = LinkToJson(internet, m_internetDamper, NULL, m_internetConfidence,
+		now);
+	MojErrCheck(err);
+	err = connectivity.put(_T("internet"), internet);
+	MojErrCheck(err);
+
+	MojObject wifi(MojObject::TypeObject);
+	err = LinkToJson(wifi, m_wifiDamper, &m_wifiConfidenceDebounce,
+		m_wifiConfidence, now);
+	MojErrCheck(err);
+	err = connectivity.put(_T("wifi"), wifi);
+	MojErrCheck(err);
+
+	MojObject wan(MojObject::TypeObject);
+	err = LinkToJson(wan, m_wanDamper, &m_wanConfidenceDebounce,
+		m_wanConfidence, now);
+	MojErrCheck(err);
+	err = connectivity.put(_T("wan"), wan);
+	MojErrCheck(err);
+
+	MojObject damping(MojObject::TypeObject);
+	err = ConnectionDamping::ConfigToJson(damping);
+	MojErrCheck(err);
+	err = connectivity.put(_T("damping"), damping);
+	MojErrCheck(err);
+
+	err = rep.put(_T("connectivity"), connectivity);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr ConnectionManagerProxy::LinkToJson(MojObject& rep,
+	const LinkDamper& damper, const ConfidenceDebounce *debounce,
+	int confidence, time_t now) const
+{
+	MojErr err;
+
+	err = damper.ToJson(rep, now);
+	MojErrCheck(err);
+
+	const MojString& confidenceName =
+		((confidence < 0) || (confidence >= ConnectionConfidenceMax)) ?
+		ConnectionConfidenceUnknownName :
+		ConnectionConfidenceNames[confidence];
+	err = rep.putString(_T("confidence"), confidenceName);
+	MojErrCheck(err);
+
+	if (debounce && (debounce->GetRaw() != confidence)) {
+		int raw = debounce->GetRaw();
+		const MojString& rawName =
+			((raw < 0) || (raw >= ConnectionConfidenceMax)) ?
+			ConnectionConfidenceUnknownName :
+			ConnectionConfidenceNames[raw];
+		err = rep.putString(_T("rawConfidence"), rawName);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
 }
 
 /*
@@ -232,37 +306,111 @@ void ConnectionManagerProxy::ConnectionManagerUpdate(MojServiceMessage *msg,
 	LOG_AM_DEBUG("Update from Connection Manager: %s",
 		MojoObjectJson(response).c_str());
 
+	/* A single status change can flip the internet, wifi, wan and
+	 * confidence requirements of every Activity; settle them together */
+	RequirementBatch batch;
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+	m_nextRecheck = 0;
+
 	bool isInternetConnectionAvailable = false;
 	response.get(_T("isInternetConnectionAvailable"),
 		isInternetConnectionAvailable);
 
 	bool updated = m_internetRequirementCore->SetCurrentValue(response);
 
-	if (isInternetConnectionAvailable) {
-		if (!m_internetRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("Internet connection is now available");
-			m_internetRequirementCore->Met();
-			std::for_each(m_internetRequirements.begin(),
-				m_internetRequirements.end(),
+	m_internetDamper.SetRaw(isInternetConnectionAvailable, now);
+	ApplyLink(m_internetDamper, updated, m_internetRequirementCore,
+		m_internetRequirements, "Internet", now);
+
+	UpdateWifiStatus(response);
+	UpdateWANStatus(response);
+
+	ApplyInternetConfidence();
+
+	ScheduleRecheck();
+}
+
+/* Time-driven half of the damping: a hold-down or suppression expired with
+ * no new status from the Connection Manager */
+void ConnectionManagerProxy::Recheck()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	RequirementBatch batch;
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+	m_nextRecheck = 0;
+
+	ApplyLink(m_internetDamper, false, m_internetRequirementCore,
+		m_internetRequirements, "Internet", now);
+	ApplyLink(m_wifiDamper, false, m_wifiRequirementCore,
+		m_wifiRequirements, "Wifi", now);
+	ApplyLink(m_wanDamper, false, m_wanRequirementCore,
+		m_wanRequirements, "WAN", now);
+
+	ApplyConfidence(m_wifiConfidenceDebounce, m_wifiConfidence,
+		m_wifiConfidenceCores, m_wifiConfidenceRequirements, "Wifi", now);
+	ApplyConfidence(m_wanConfidenceDebounce, m_wanConfidence,
+		m_wanConfidenceCores, m_wanConfidenceRequirements, "WAN", now);
+
+	ApplyInternetConfidence();
+
+	ScheduleRecheck();
+}
+
+void ConnectionManagerProxy::ApplyLink(LinkDamper& damper, bool updated,
+	boost::shared_ptr<RequirementCore>& core, RequirementList& requirements,
+	const char *name, time_t now)
+{
+	unsigned next;
+	bool available = damper.Evaluate(now, next);
+	NoteRecheck(next);
+
+	if (available != damper.GetRaw()) {
+		LOG_AM_DEBUG("%s connection is %s, but reported as %s for at least "
+			"%u more seconds", name, damper.GetRaw() ? "up" : "down",
+			available ? "up" : "down", next);
+	}
+
+	if (available) {
+		if (!core->IsMet()) {
+			LOG_AM_DEBUG("%s connection is now available", name);
+			core->Met();
+			std::for_each(requirements.begin(), requirements.end(),
 				boost::mem_fn(&Requirement::Met));
 		} else if (updated) {
-			std::for_each(m_internetRequirements.begin(),
-				m_internetRequirements.end(),
+			std::for_each(requirements.begin(), requirements.end(),
 				boost::mem_fn(&Requirement::Updated));
 		}
 	} else {
-		if (m_internetRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("Internet connection is no longer available");
-			m_internetRequirementCore->Unmet();
-			std::for_each(m_internetRequirements.begin(),
-				m_internetRequirements.end(),
+		if (core->IsMet()) {
+			LOG_AM_DEBUG("%s connection is no longer available", name);
+			core->Unmet();
+			std::for_each(requirements.begin(), requirements.end(),
 				boost::mem_fn(&Requirement::Unmet));
 		}
 	}
+}
 
-	UpdateWifiStatus(response);
-	UpdateWANStatus(response);
+void ConnectionManagerProxy::ApplyConfidence(ConfidenceDebounce& debounce,
+	int& confidence, boost::shared_ptr<RequirementCore> *confidenceCores,
+	RequirementList *confidenceLists, const char *name, time_t now)
+{
+	unsigned next;
+	int reported = debounce.Evaluate(now, next);
+	NoteRecheck(next);
+
+	if (confidence != reported) {
+		confidence = reported;
+		LOG_AM_DEBUG("%s confidence level changed to %d", name, confidence);
+		UpdateConfidenceRequirements(confidenceCores, confidenceLists,
+			confidence);
+	}
+}
 
+void ConnectionManagerProxy::ApplyInternetConfidence()
+{
 	int maxConfidence = (m_wifiConfidence > m_wanConfidence) ?
 		m_wifiConfidence : m_wanConfidence;
 	if (m_internetConfidence != maxConfidence) {
@@ -274,6 +422,35 @@ void ConnectionManagerProxy::ConnectionManagerUpdate(MojServiceMessage *msg,
 	}
 }
 
+void ConnectionManagerProxy::NoteRecheck(unsigned seconds)
+{
+	if (seconds && (!m_nextRecheck || (seconds < m_nextRecheck))) {
+		m_nextRecheck = seconds;
+	}
+}
+
+void ConnectionManagerProxy::ScheduleRecheck()
+{
+	if (!m_nextRecheck) {
+		if (m_recheckTimeout) {
+			m_recheckTimeout->Cancel();
+		}
+		return;
+	}
+
+	LOG_AM_DEBUG("Rechecking connection damping in %u seconds",
+		m_nextRecheck);
+
+	if (!m_recheckTimeout) {
+		m_recheckTimeout = boost::make_shared<Timeout<ConnectionManagerProxy> >(
+			boost::dynamic_pointer_cast<ConnectionManagerProxy,
+				RequirementManager>(shared_from_this()), m_nextRecheck,
+			&ConnectionManagerProxy::Recheck);
+	}
+
+	m_recheckTimeout->Arm(m_nextRecheck);
+}
+
 MojErr ConnectionManagerProxy::UpdateWifiStatus(const MojObject& response)
 {
 	MojErr err;
@@ -307,32 +484,15 @@ MojErr ConnectionManagerProxy::UpdateWifiStatus(const MojObject& response)
 		LOG_AM_WARNING(MSGID_WIFI_STATUS_UNKNOWN, 0, "Wifi status not returned by Connection Manager");
 	}
 
-	if (wifiAvailable) {
-		if (!m_wifiRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("Wifi connection is now available");
-			m_wifiRequirementCore->Met();
-			std::for_each(m_wifiRequirements.begin(), m_wifiRequirements.end(),
-				boost::mem_fn(&Requirement::Met));
-		} else if (updated) {
-			std::for_each(m_wifiRequirements.begin(), m_wifiRequirements.end(),
-				boost::mem_fn(&Requirement::Updated));
-		}
-	} else {
-		if (m_wifiRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("Wifi connection is no longer available");
-			m_wifiRequirementCore->Unmet();
-			std::for_each(m_wifiRequirements.begin(), m_wifiRequirements.end(),
-				boost::mem_fn(&Requirement::Unmet));
-		}
-	}
+	time_t now = Clock::GetInstance().GetMonotonicTime();
 
-	if (m_wifiConfidence != (int)confidence) {
-		m_wifiConfidence = (int)confidence;
-		LOG_AM_DEBUG("Wifi confidence level changed to %d",
-			m_wifiConfidence);
-		UpdateConfidenceRequirements(m_wifiConfidenceCores,
-			m_wifiConfidenceRequirements, m_wifiConfidence);
-	}
+	m_wifiDamper.SetRaw(wifiAvailable, now);
+	ApplyLink(m_wifiDamper, updated, m_wifiRequirementCore,
+		m_wifiRequirements, "Wifi", now);
+
+	m_wifiConfidenceDebounce.SetRaw((int)confidence, now);
+	ApplyConfidence(m_wifiConfidenceDebounce, m_wifiConfidence,
+		m_wifiConfidenceCores, m_wifiConfidenceRequirements, "Wifi", now);
 
 	return MojErrNone;
 }
@@ -377,32 +537,15 @@ MojErr ConnectionManagerProxy::UpdateWANStatus(const MojObject& response)
 		}
 	}
 
-	if (wanAvailable) {
-		if (!m_wanRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("WAN connection is now available");
-			m_wanRequirementCore->Met();
-			std::for_each(m_wanRequirements.begin(), m_wanRequirements.end(),
-				boost::mem_fn(&Requirement::Met));
-		} else if (updated) {
-			std::for_each(m_wanRequirements.begin(), m_wanRequirements.end(),
-				boost::mem_fn(&Requirement::Updated));
-		}
-	} else {
-		if (m_wanRequirementCore->IsMet()) {
-			LOG_AM_DEBUG("WAN connection is no longer available");
-			m_wanRequirementCore->Unmet();
-			std::for_each(m_wanRequirements.begin(), m_wanRequirements.end(),
-				boost::mem_fn(&Requirement::Unmet));
-		}
-	}
+	time_t now = Clock::GetInstance().GetMonotonicTime();
 
-	if (m_wanConfidence != (int)confidence) {
-		m_wanConfidence = (int)confidence;
-		LOG_AM_DEBUG("WAN confidence level changed to %d",
-			m_wanConfidence);
-		UpdateConfidenceRequirements(m_wanConfidenceCores,
-			m_wanConfidenceRequirements, m_wanConfidence);
-	}
+	m_wanDamper.SetRaw(wanAvailable, now);
+	ApplyLink(m_wanDamper, updated, m_wanRequirementCore,
+		m_wanRequirements, "WAN", now);
+
+	m_wanConfidenceDebounce.SetRaw((int)confidence, now);
+	ApplyConfidence(m_wanConfidenceDebounce, m_wanConfidence,
+		m_wanConfidenceCores, m_wanConfidenceRequirements, "WAN", now);
 
 	return MojErrNone;
 }
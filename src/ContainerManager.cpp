@@ -20,14 +20,22 @@
 #include "ResourceContainer.h"
 #include "BusId.h"
 #include "BusEntity.h"
+#include "Clock.h"
+#include "Metrics.h"
 #include "Logging.h"
 
+#include <set>
+
 MojLogger ContainerManager::s_log(_T("activitymanager.resourcecontainermanager"));
 
 ContainerManager::ContainerManager(
 	boost::shared_ptr<MasterResourceManager> master)
 	: m_master(master)
 	, m_enabled(false)
+	, m_foreground(false)
+	, m_frozen(false)
+	, m_frozenAt(0)
+	, m_thawedAt(0)
 {
 }
 
@@ -64,22 +72,62 @@ boost::shared_ptr<ResourceContainer> ContainerManager::GetContainer(
  */
 void ContainerManager::MapContainer(
 	const std::string& name, const BusIdVec& ids, pid_t pid)
+{
+	ContainerMappingVec mappings(1);
+	mappings[0].m_name = name;
+	mappings[0].m_ids = ids;
+	mappings[0].m_pid = pid;
+
+	MapContainers(mappings);
+}
+
+void ContainerManager::MapContainers(const ContainerMappingVec& mappings)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
-	LOG_AM_DEBUG("Mapping pid %d into [Container %s]",
-		(int)pid, name.c_str());
+	LOG_AM_DEBUG("Mapping %u services into containers",
+		(unsigned)mappings.size());
+
+	typedef std::map<BusId, boost::shared_ptr<ResourceContainer> >
+		IdContainerMap;
+	typedef std::set<boost::shared_ptr<ResourceContainer> > ContainerSet;
 
 	/* Do not invalidate old Entities.  Just leave them in whatever container
 	 * they were last in.  Move existing ones (and, of course, new ones) into
-	 * whatever container is requested here */
-
-	/* First, get the container. */
-	boost::shared_ptr<ResourceContainer> container = GetContainer(name);
+	 * whatever container is requested here.
+	 *
+	 * A name can appear in several mappings of the batch (services sharing
+	 * a name in allNames); as when mapping one at a time, the last one
+	 * wins.  So first settle on one container per name, and the set of
+	 * containers whose priority has to be fixed. */
+	IdContainerMap targets;
+	ContainerSet updated;
+
+	std::vector<boost::shared_ptr<ResourceContainer> > containers;
+	containers.reserve(mappings.size());
+
+	for (ContainerMappingVec::const_iterator iter = mappings.begin();
+		iter != mappings.end(); ++iter) {
+		LOG_AM_DEBUG("Mapping pid %d into [Container %s]",
+			(int)iter->m_pid, iter->m_name.c_str());
+
+		boost::shared_ptr<ResourceContainer> container =
+			GetContainer(iter->m_name);
+		containers.push_back(container);
+		updated.insert(container);
+
+		for (BusIdVec::const_iterator id = iter->m_ids.begin();
+			id != iter->m_ids.end(); ++id) {
+			targets[*id] = container;
+		}
+	}
 
 	/* Associate the bus entities */
-	for (BusIdVec::const_iterator iter = ids.begin(); iter != ids.end();
-		++iter) {
-		boost::shared_ptr<BusEntity> entity = m_master.lock()->GetEntity(*iter);
+	boost::shared_ptr<MasterResourceManager> master = m_master.lock();
+
+	for (IdContainerMap::const_iterator iter = targets.begin();
+		iter != targets.end(); ++iter) {
+		boost::shared_ptr<BusEntity> entity = master->GetEntity(iter->first);
+		const boost::shared_ptr<ResourceContainer>& container = iter->second;
 
 		/* If it's currently mapped to a container, and it's a different
 		 * container, unmap and remap.  Otherwise, if it's the same container,
@@ -87,14 +135,14 @@ void ContainerManager::MapContainer(
 		EntityContainerMap::iterator eiter = m_entityContainers.find(entity);
 		if (eiter != m_entityContainers.end()) {
 			if (eiter->second != container) {
-				/* Remove the entity from the current container, and
-				 * update its priority as Activities may have been
+				/* Remove the entity from the current container; its
+				 * priority is updated below, as Activities may have been
 				 * associated. */
 				eiter->second->RemoveEntity(entity);
-				eiter->second->UpdatePriority();
+				updated.insert(eiter->second);
 
 				container->AddEntity(entity);
-				m_entityContainers[entity] = container;
+				eiter->second = container;
 			} /* else it's already in the correct container */
 		} else {
 			container->AddEntity(entity);
@@ -102,12 +150,24 @@ void ContainerManager::MapContainer(
 		}
 	}
 
-	/* Fix the priority of the container (the entities may already have
-	 * existed, and may have live Activities */
-	container->UpdatePriority();
+	/* Fix the priority of the containers (the entities may already have
+	 * existed, and may have live Activities) */
+	std::for_each(updated.begin(), updated.end(),
+		boost::mem_fn(&ResourceContainer::UpdatePriority));
+
+	/* Now map the PIDs */
+	for (size_t i = 0; i < mappings.size(); i++) {
+		containers[i]->MapProcess(mappings[i].m_pid);
+	}
 
-	/* Now map the PID */
-	container->MapProcess(pid);
+	std::for_each(m_linked.begin(), m_linked.end(),
+		boost::bind(&ContainerManager::MapContainers, _1,
+			boost::cref(mappings)));
+}
+
+void ContainerManager::LinkManager(boost::shared_ptr<ContainerManager> linked)
+{
+	m_linked.push_back(linked);
 }
 
 void ContainerManager::InformEntityUpdated(boost::shared_ptr<BusEntity> entity)
@@ -120,6 +180,9 @@ void ContainerManager::InformEntityUpdated(boost::shared_ptr<BusEntity> entity)
 	if (citer == m_entityContainers.end()) {
 		LOG_AM_DEBUG("No container currently mapped for [BusId %s]",
 			entity->GetName().c_str());
+	} else if (!citer->second->UpdateEntity(entity)) {
+		LOG_AM_DEBUG("[Container %s] unchanged by update of [BusId %s]",
+			citer->second->GetName().c_str(), entity->GetName().c_str());
 	} else {
 		citer->second->UpdatePriority();
 		LOG_AM_DEBUG("[BusId %s] priority is now \"%s\"",
@@ -128,6 +191,15 @@ void ContainerManager::InformEntityUpdated(boost::shared_ptr<BusEntity> entity)
 	}
 }
 
+void ContainerManager::GetProcesses(boost::shared_ptr<BusEntity> entity,
+	std::set<int>& pids) const
+{
+	EntityContainerMap::const_iterator found = m_entityContainers.find(entity);
+	if (found != m_entityContainers.end()) {
+		found->second->GetProcessIds(pids);
+	}
+}
+
 void ContainerManager::Enable()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
@@ -143,6 +215,8 @@ void ContainerManager::Enable()
 	std::for_each(m_containers.begin(), m_containers.end(),
 		boost::bind(&ResourceContainer::Enable,
 			boost::bind(&ContainerMap::value_type::second, _1)));
+
+	UpdateFreeze();
 }
 
 void ContainerManager::Disable()
@@ -160,6 +234,8 @@ void ContainerManager::Disable()
 	std::for_each(m_containers.begin(), m_containers.end(),
 		boost::bind(&ResourceContainer::Disable,
 			boost::bind(&ContainerMap::value_type::second, _1)));
+
+	UpdateFreeze();
 }
 
 bool ContainerManager::IsEnabled() const
@@ -201,3 +277,196 @@ MojErr ContainerManager::InfoToJson(MojObject& rep) const
 	return MojErrNone;
 }
 
+ContainerManager::FreezePolicy::FreezePolicy()
+	: m_enabled(false)
+	, m_maxFreeze(DefaultMaxFreeze)
+	, m_minThaw(DefaultMinThaw)
+{
+}
+
+void ContainerManager::InformForegroundChanged(bool active)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	m_foreground = active;
+	UpdateFreeze();
+}
+
+void ContainerManager::SetFreezePolicy(const FreezePolicy& policy)
+{
+	m_freezePolicy = policy;
+	if (!m_freezePolicy.m_maxFreeze) {
+		m_freezePolicy.m_maxFreeze = 1;
+	}
+
+	UpdateFreeze();
+}
+
+const ContainerManager::FreezePolicy& ContainerManager::GetFreezePolicy() const
+{
+	return m_freezePolicy;
+}
+
+bool ContainerManager::CanFreeze() const
+{
+	return false;
+}
+
+bool ContainerManager::IsFrozen() const
+{
+	return m_frozen;
+}
+
+MojErr ContainerManager::FreezerToJson(MojObject& rep) const
+{
+	MojErr err = rep.putBool(_T("enabled"), m_freezePolicy.m_enabled);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("maxFreeze"), (MojInt64)m_freezePolicy.m_maxFreeze);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("minThaw"), (MojInt64)m_freezePolicy.m_minThaw);
+	MojErrCheck(err);
+
+	err = rep.putBool(_T("supported"), CanFreeze());
+	MojErrCheck(err);
+
+	err = rep.putBool(_T("foreground"), m_foreground);
+	MojErrCheck(err);
+
+	err = rep.putBool(_T("frozen"), m_frozen);
+	MojErrCheck(err);
+
+	if (m_frozen) {
+		err = rep.putInt(_T("frozenFor"),
+			(MojInt64)(Clock::GetInstance().GetMonotonicTime() - m_frozenAt));
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+bool ContainerManager::FreezeLowest(bool frozen)
+{
+	return false;
+}
+
+void ContainerManager::UpdateFreeze()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+
+	bool wanted = m_freezePolicy.m_enabled && m_enabled && m_foreground &&
+		CanFreeze();
+
+	if (m_frozen) {
+		if (!wanted) {
+			LOG_AM_DEBUG("Thawing lowest priority containers");
+			Thaw(now);
+		} else if ((now - m_frozenAt) >= (time_t)m_freezePolicy.m_maxFreeze) {
+			static MetricsCounter& s_forced =
+				Metrics::GetCounter("containers.forcedThaws");
+			s_forced.Increment();
+
+			LOG_AM_DEBUG("Lowest priority containers frozen for %u seconds; "
+				"thawing for at least %u", m_freezePolicy.m_maxFreeze,
+				m_freezePolicy.m_minThaw);
+			Thaw(now);
+			ArmFreezeTimeout(m_freezePolicy.m_minThaw);
+		} else {
+			ArmFreezeTimeout((unsigned)(m_frozenAt +
+				m_freezePolicy.m_maxFreeze - now));
+		}
+	} else if (wanted) {
+		/* Never freeze again before the containers have had minThaw
+		 * seconds to run */
+		if (m_thawedAt &&
+			((now - m_thawedAt) < (time_t)m_freezePolicy.m_minThaw)) {
+			ArmFreezeTimeout((unsigned)(m_thawedAt +
+				m_freezePolicy.m_minThaw - now));
+			return;
+		}
+
+		LOG_AM_DEBUG("Freezing lowest priority containers");
+
+		if (!FreezeLowest(true)) {
+			return;
+		}
+
+		static MetricsCounter& s_freezes =
+			Metrics::GetCounter("containers.freezes");
+		s_freezes.Increment();
+
+		m_frozen = true;
+		m_frozenAt = now;
+		ArmFreezeTimeout(m_freezePolicy.m_maxFreeze);
+	} else if (m_freezeTimeout) {
+		m_freezeTimeout->Cancel();
+	}
+}
+
+void ContainerManager::Thaw(time_t now)
+{
+	FreezeLowest(false);
+
+	static MetricsCounter& s_frozenSeconds =
+		Metrics::GetCounter("containers.frozenSeconds");
+	s_frozenSeconds.Increment((unsigned long long)(now - m_frozenAt));
+
+	m_frozen = false;
+	m_thawedAt = now;
+
+	if (m_freezeTimeout) {
+		m_freezeTimeout->Cancel();
+	}
+}
+
+void ContainerManager::ArmFreezeTimeout(unsigned seconds)
+{
+	if (!m_freezeTimeout) {
+		m_freezeTimeout = boost::make_shared<Timeout<ContainerManager> >(
+			boost::dynamic_pointer_cast<ContainerManager, ResourceManager>(
+				shared_from_this()), seconds, &ContainerManager::UpdateFreeze);
+	}
+
+	m_freezeTimeout->Arm(seconds);
+}
+
+void ContainerManager::SetCpuPartition(const CpuPartition& partition)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("CPU partition is now performance [%s], efficiency [%s]",
+		partition.m_performance.c_str(), partition.m_efficiency.c_str());
+
+	m_partition = partition;
+	ApplyCpuPartition();
+}
+
+const CpuPartition& ContainerManager::GetCpuPartition() const
+{
+	return m_partition;
+}
+
+const char *ContainerManager::GetCpuPartitionMode() const
+{
+	return NULL;
+}
+
+MojErr ContainerManager::CpuPartitionToJson(MojObject& rep) const
+{
+	MojErr err = m_partition.ToJson(rep);
+	MojErrCheck(err);
+
+	const char *mode = GetCpuPartitionMode();
+	if (mode) {
+		err = rep.putString(_T("mode"), mode);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+void ContainerManager::ApplyCpuPartition()
+{
+}
@@ -18,9 +18,19 @@
 
 #include "ControlGroup.h"
 #include "ControlGroupManager.h"
+#include "Metrics.h"
+#include "ProcessPolicyManager.h"
 #include "Logging.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -30,6 +40,7 @@ ControlGroup::ControlGroup(const std::string& name,
 	: ResourceContainer(name, manager)
 	, m_currentPriority(ActivityPriorityLow)
 	, m_focused(false)
+	, m_placed(false)
 {
 }
 
@@ -46,41 +57,63 @@ void ControlGroup::Init()
 		m_name.c_str());
 }
 
+/* Processes are only moved between the classes while the CPUs are
+ * partitioned; otherwise the Container is bookkeeping only. */
 void ControlGroup::UpdatePriority()
 {
-	// UNCOMMENT TO ENABLE CGROUPS HANDLING FROM ACTIVITYMANAGER
-
-	/*
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
+	if (!IsManaged()) {
+		return;
+	}
+
 	ActivityPriority_t priority = GetPriority();
 	bool focused = IsFocused();
 
-	if ((m_currentPriority != priority) || (m_focused != focused)) {
-		MojLogDebug(s_log, _T("Updating priority for [Container %s] to "
-			"[%s,%s] from [%s,%s]"), m_name.c_str(),
+	if (!m_placed || (m_currentPriority != priority) ||
+		(m_focused != focused)) {
+		LOG_AM_DEBUG("Updating priority for [Container %s] to [%s,%s] "
+			"from [%s,%s]", m_name.c_str(),
 			ActivityPriorityNames[priority], focused ? "focused" : "unfocused",
 			ActivityPriorityNames[m_currentPriority],
 			m_focused ? "focused" : "unfocused");
 		SetPriority(priority, focused);
 	}
-	*/
 }
 
 void ControlGroup::MapProcess(pid_t pid)
 {
-	// UNCOMMENT TO ENABLE CGROUPS HANDLING FROM ACTIVITYMANAGER
-	/*
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
-	MojLogDebug(s_log, _T("Mapping [pid %d] into [Container %s]"),
-		(int)pid, m_name.c_str());
-	
-	// Store all pids for containter
+	LOG_AM_DEBUG("Mapping [pid %d] into [Container %s]", (int)pid,
+		m_name.c_str());
+
+	if (std::find(m_processIds.begin(), m_processIds.end(), (int)pid) !=
+		m_processIds.end()) {
+		return;
+	}
+
+	// Store all pids for containter, so they can be placed once the CPUs
+	// are partitioned
 	m_processIds.push_back(pid);
 
-	// Explicitly set the priority as the new pid is unmapped atm
-	SetPriority(GetPriority(), IsFocused());
-	*/
+	if (!IsManaged()) {
+		return;
+	}
+
+	ActivityPriority_t priority = GetPriority();
+	bool focused = IsFocused();
+
+	if (m_placed && (m_currentPriority == priority) &&
+		(m_focused == focused)) {
+		PlaceProcess(pid);
+	} else {
+		SetPriority(priority, focused);
+	}
+}
+
+void ControlGroup::GetProcessIds(std::set<int>& pids) const
+{
+	pids.insert(m_processIds.begin(), m_processIds.end());
 }
 
 void ControlGroup::Enable()
@@ -95,6 +128,16 @@ void ControlGroup::Disable()
 	UpdatePriority();
 }
 
+void ControlGroup::ApplyPartition()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	/* The class cpusets were rewritten in place, but processes mapped
+	 * while the CPUs were not partitioned still need moving */
+	m_placed = false;
+	UpdatePriority();
+}
+
 MojErr ControlGroup::ToJson(MojObject& rep) const
 {
 	std::string path = GetRoot() + "/" + m_name;
@@ -119,21 +162,7 @@ void ControlGroup::SetPriority(ActivityPriority_t priority, bool focused)
 		m_name.c_str(), ActivityPriorityNames[priority],
 		focused ? "focused" : "unfocused");
 
-	 const char* shares[] = {
-		"none", 	/* ActivityPriorityNone */
-		"lowest",	/* ActivityPriorityLowest */
-		"low",  	/* ActivityPriorityLow */
-		"normal",	/* ActivityPriorityNormal */
-		"high", 	/* ActivityPriorityHigh */
-		"highest"	/* ActivityPriorityHighest */
-	};
-
-        std::string controlFile;
-        if (focused) {
-                controlFile = GetRoot() + "/focused/tasks";
-        } else {
-                controlFile = GetRoot() + "/unfocused/" + shares[priority] + "/tasks";
-        }
+	std::string controlFile = GetClassControlFile(priority, focused);
 
 	pid = m_processIds.begin();
 
@@ -141,21 +170,26 @@ void ControlGroup::SetPriority(ActivityPriority_t priority, bool focused)
 		nextPid = pid;
 		nextPid++;
 
-                length = snprintf(buf, 8, "%d", (int)*pid);
-                success = success && WriteControlFile(controlFile, buf, length, pid);
+		length = snprintf(buf, 8, "%d", (int)*pid);
+
+		/* Every pid is written, whether or not an earlier one failed */
+		bool written = WriteControlFile(controlFile, buf, length, pid);
 
 		// Fix for roadrunner
-		if(pid == m_processIds.begin() && !success && !focused){
-			controlFile = GetRoot() + "/unfocused/tasks";
-			success = success || WriteControlFile(controlFile, buf, length, pid);
+		if(pid == m_processIds.begin() && !written && !focused){
+			controlFile = GetRoot() + "/unfocused/cgroup.procs";
+			written = WriteControlFile(controlFile, buf, length, pid);
 		}
 
+		success = success && written;
+
 		pid = nextPid;
-    }
+	}
 
 	if (success) {
 		m_currentPriority = priority;
 		m_focused = focused;
+		m_placed = true;
 	} else {
 		LOG_AM_WARNING(MSGID_CONTAINER_PRIORITY_CHANGE_FAIL, 3, PMLOGKS("container",m_name.c_str()),
 			  PMLOGKS("Priority",ActivityPriorityNames[priority]),
@@ -163,10 +197,54 @@ void ControlGroup::SetPriority(ActivityPriority_t priority, bool focused)
 	}
 }
 
-const std::string& ControlGroup::GetRoot() const
+void ControlGroup::PlaceProcess(pid_t pid)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	char buf[16];
+	size_t length = (size_t)snprintf(buf, sizeof(buf), "%d", (int)pid);
+
+	/* MapProcess() just appended it */
+	std::list<int>::iterator current = m_processIds.end();
+	--current;
+
+	WriteControlFile(GetClassControlFile(m_currentPriority, m_focused), buf,
+		length, current);
+}
+
+std::string ControlGroup::GetClassControlFile(ActivityPriority_t priority,
+	bool focused) const
+{
+	if (focused) {
+		return GetRoot() + "/focused/cgroup.procs";
+	} else {
+		return GetRoot() + "/unfocused/" + ActivityPriorityNames[priority] +
+			"/cgroup.procs";
+	}
+}
+
+boost::shared_ptr<ControlGroupManager>
+ControlGroup::GetControlGroupManager() const
 {
 	return boost::dynamic_pointer_cast<ControlGroupManager, ContainerManager>
-		(m_manager.lock())->GetRoot();
+		(m_manager.lock());
+}
+
+bool ControlGroup::IsPartitioned() const
+{
+	boost::shared_ptr<ControlGroupManager> manager = GetControlGroupManager();
+
+	return manager && manager->GetCpuPartition().IsEnabled();
+}
+
+bool ControlGroup::IsManaged() const
+{
+	return IsPartitioned();
+}
+
+const std::string& ControlGroup::GetRoot() const
+{
+	return GetControlGroupManager()->GetRoot();
 }
 
 bool ControlGroup::WriteControlFile(const std::string& controlFile,
@@ -204,14 +282,438 @@ bool ControlGroup::WriteControlFile(const std::string& controlFile,
 	return true;
 }
 
+/* Indexed by ActivityPriority_t.  Raising the priority of a thread needs
+ * CAP_SYS_NICE, which the daemon has. */
+static const struct {
+	int	m_policy;
+	int	m_nice;
+} SchedSettings[] = {
+	{ SCHED_IDLE,	19 },	/* ActivityPriorityNone */
+	{ SCHED_IDLE,	19 },	/* ActivityPriorityLowest */
+	{ SCHED_BATCH,	5 },	/* ActivityPriorityLow */
+	{ SCHED_OTHER,	0 },	/* ActivityPriorityNormal */
+	{ SCHED_OTHER,	0 },	/* ActivityPriorityHigh */
+	{ SCHED_OTHER,	-2 }	/* ActivityPriorityHighest */
+};
+
+static const int FocusedNice = -4;
+
 NullControlGroup::NullControlGroup(const std::string& name,
 	boost::shared_ptr<ContainerManager> manager)
 	: ControlGroup(name, manager)
+	, m_policy(SCHED_OTHER)
+	, m_nice(0)
+	, m_setAffinity(false)
+	, m_pinned(false)
 {
+	CPU_ZERO(&m_mask);
 }
 
 NullControlGroup::~NullControlGroup()
 {
+	RestoreAll();
+}
+
+NullControlGroup::ThreadOriginal::ThreadOriginal()
+	: m_policy(SCHED_OTHER)
+	, m_nice(0)
+	, m_hasMask(false)
+{
+	CPU_ZERO(&m_mask);
+}
+
+NullControlGroup::ProcessOriginal::ProcessOriginal()
+	: m_startTime(0)
+{
+}
+
+void NullControlGroup::MapProcess(pid_t pid)
+{
+	/* The process mapped before under this pid has exited */
+	if (!IsSameProcess((int)pid)) {
+		m_threads.erase((int)pid);
+		m_originals.erase((int)pid);
+		m_processIds.remove((int)pid);
+	}
+
+	ControlGroup::MapProcess(pid);
+}
+
+void NullControlGroup::Disable()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	RestoreAll();
+}
+
+void NullControlGroup::ApplyPartition()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	/* Nothing was rewritten under the threads, so place them all again; if
+	 * the partition was turned off, this releases them to every CPU. */
+	if (m_placed) {
+		SetPriority(GetPriority(), IsFocused());
+	}
+}
+
+void NullControlGroup::Rescan()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!m_placed) {
+		return;
+	}
+
+	std::list<int>::iterator pid = m_processIds.begin();
+	while (pid != m_processIds.end()) {
+		if (PlaceThreads(*pid, m_threads[*pid])) {
+			++pid;
+		} else {
+			m_threads.erase(*pid);
+			pid = m_processIds.erase(pid);
+		}
+	}
+}
+
+MojErr NullControlGroup::ToJson(MojObject& rep) const
+{
+	MojErr err = rep.putString(_T("policy"),
+		(m_policy == SCHED_IDLE) ? "idle" :
+		(m_policy == SCHED_BATCH) ? "batch" : "other");
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("nice"), (MojInt64)m_nice);
+	MojErrCheck(err);
+
+	MojObject processes(MojObject::TypeArray);
+	for (ThreadMap::const_iterator iter = m_threads.begin();
+		iter != m_threads.end(); ++iter) {
+		MojObject process(MojObject::TypeObject);
+
+		err = process.putInt(_T("pid"), (MojInt64)iter->first);
+		MojErrCheck(err);
+
+		err = process.putInt(_T("threads"), (MojInt64)iter->second.size());
+		MojErrCheck(err);
+
+		err = processes.push(process);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("processes"), processes);
+	MojErrCheck(err);
+
+	return ResourceContainer::ToJson(rep);
+}
+
+/* A disabled manager leaves the threads as they were */
+bool NullControlGroup::IsManaged() const
+{
+	boost::shared_ptr<ControlGroupManager> manager = GetControlGroupManager();
+
+	return manager && manager->IsEnabled();
+}
+
+void NullControlGroup::SetPriority(ActivityPriority_t priority, bool focused)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	boost::shared_ptr<ControlGroupManager> manager = GetControlGroupManager();
+	if (!manager) {
+		return;
+	}
+
+	const CpuPartition& partition = manager->GetCpuPartition();
+	partition.GetMask(priority, focused, m_mask);
+
+	m_policy = focused ? SCHED_OTHER : SchedSettings[priority].m_policy;
+	m_nice = focused ? FocusedNice : SchedSettings[priority].m_nice;
+
+	LOG_AM_DEBUG("Placing [Container %s] for [%s,%s] at nice %d on [%s]",
+		m_name.c_str(), ActivityPriorityNames[priority],
+		focused ? "focused" : "unfocused", m_nice,
+		partition.GetCpus(priority, focused).c_str());
+
+	/* Every thread needs the new settings.  Only touch the affinity if
+	 * there is a partition to pin to, or one to release the threads
+	 * from. */
+	m_threads.clear();
+	m_setAffinity = IsPartitioned() || m_pinned;
+
+	std::list<int>::iterator pid = m_processIds.begin();
+	while (pid != m_processIds.end()) {
+		if (PlaceThreads(*pid, m_threads[*pid])) {
+			++pid;
+		} else {
+			m_threads.erase(*pid);
+			pid = m_processIds.erase(pid);
+		}
+	}
+
+	m_pinned = IsPartitioned();
+	m_setAffinity = m_pinned;
+
+	m_currentPriority = priority;
+	m_focused = focused;
+	m_placed = true;
+}
+
+void NullControlGroup::PlaceProcess(pid_t pid)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!PlaceThreads((int)pid, m_threads[(int)pid])) {
+		m_threads.erase((int)pid);
+		m_processIds.remove((int)pid);
+	}
+}
+
+bool NullControlGroup::PlaceThreads(int pid, std::set<int>& placed)
+{
+	char path[32];
+	snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+	DIR *tasks = IsSameProcess(pid) ? opendir(path) : NULL;
+	if (!tasks) {
+		m_originals.erase(pid);
+		return false;
+	}
+
+	ThreadOriginalMap& originals = m_originals[pid].m_threads;
+
+	/* A thread started since the process was first placed inherited the
+	 * settings given to the thread that created it; what it would have
+	 * had is what the main thread had. */
+	const ThreadOriginal *inherited = NULL;
+	if (!originals.empty()) {
+		ThreadOriginalMap::const_iterator main = originals.find(pid);
+		if (main != originals.end()) {
+			inherited = &main->second;
+		}
+	}
+
+	std::set<int> current;
+
+	struct dirent *entry;
+	while ((entry = readdir(tasks)) != NULL) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+
+		int tid = (int)strtol(entry->d_name, NULL, 10);
+		current.insert(tid);
+
+		if (placed.find(tid) == placed.end()) {
+			PlaceThread(tid, originals, inherited);
+		}
+	}
+
+	closedir(tasks);
+
+	/* Threads that exited are forgotten */
+	placed.swap(current);
+
+	ThreadOriginalMap::iterator original = originals.begin();
+	while (original != originals.end()) {
+		if (placed.find(original->first) == placed.end()) {
+			originals.erase(original++);
+		} else {
+			++original;
+		}
+	}
+
+	return true;
+}
+
+/* A thread exiting meanwhile is not an error */
+void NullControlGroup::PlaceThread(int tid, ThreadOriginalMap& originals,
+	const ThreadOriginal *inherited)
+{
+	/* Real-time threads (audio, input) chose their policy for a reason,
+	 * and demoting them would cost more than they take */
+	int current = sched_getscheduler((pid_t)tid);
+	if (current < 0) {
+		return;
+	}
+#ifdef SCHED_RESET_ON_FORK
+	current &= ~SCHED_RESET_ON_FORK;
+#endif
+	if ((current == SCHED_FIFO) || (current == SCHED_RR)) {
+		static MetricsCounter& s_skipped =
+			Metrics::GetCounter("sched.realtimeSkipped");
+		s_skipped.Increment();
+		return;
+	}
+
+	ThreadOriginalMap::iterator original = originals.find(tid);
+	if (original == originals.end()) {
+		ThreadOriginal settings;
+
+		if (inherited) {
+			settings.m_policy = inherited->m_policy;
+			settings.m_nice = inherited->m_nice;
+		} else {
+			settings.m_policy = current;
+
+			/* -1 is a valid nice level */
+			errno = 0;
+			settings.m_nice = getpriority(PRIO_PROCESS, (id_t)tid);
+			if (errno != 0) {
+				return;
+			}
+		}
+
+		original = originals.insert(std::make_pair(tid, settings)).first;
+	}
+
+	if (m_setAffinity && !original->second.m_hasMask) {
+		if (sched_getaffinity((pid_t)tid, sizeof(original->second.m_mask),
+			&original->second.m_mask) < 0) {
+			return;
+		}
+		original->second.m_hasMask = true;
+	}
+
+	static MetricsCounter& s_placed =
+		Metrics::GetCounter("sched.threadsPlaced");
+	s_placed.Increment();
+
+	struct sched_param param;
+	param.sched_priority = 0;
+
+	if (m_setAffinity &&
+		(sched_setaffinity((pid_t)tid, sizeof(m_mask), &m_mask) < 0) &&
+		(errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_AFFINITY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to set CPU affinity");
+	}
+
+	if ((sched_setscheduler((pid_t)tid, m_policy, &param) < 0) &&
+		(errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_SCHED_POLICY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to set scheduling policy");
+	}
+
+	/* Nice levels are per thread on Linux */
+	if ((setpriority(PRIO_PROCESS, (id_t)tid, m_nice) < 0) &&
+		(errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_SCHED_POLICY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to set nice level");
+	}
+}
+
+void NullControlGroup::RestoreAll()
+{
+	std::list<int>::iterator pid = m_processIds.begin();
+	while (pid != m_processIds.end()) {
+		if (IsSameProcess(*pid)) {
+			RestoreThreads(*pid);
+			++pid;
+		} else {
+			m_originals.erase(*pid);
+			pid = m_processIds.erase(pid);
+		}
+	}
+
+	m_threads.clear();
+	m_placed = false;
+	m_setAffinity = false;
+	m_pinned = false;
+}
+
+/* Only threads the process still has are restored; a tid of one that
+ * exited may since belong to some other process */
+void NullControlGroup::RestoreThreads(int pid)
+{
+	ProcessOriginalMap::iterator found = m_originals.find(pid);
+	if (found == m_originals.end()) {
+		return;
+	}
+
+	ThreadOriginalMap& originals = found->second.m_threads;
+
+	char path[32];
+	snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+	DIR *tasks = opendir(path);
+	if (tasks) {
+		struct dirent *entry;
+		while ((entry = readdir(tasks)) != NULL) {
+			if (entry->d_name[0] == '.') {
+				continue;
+			}
+
+			int tid = (int)strtol(entry->d_name, NULL, 10);
+
+			ThreadOriginalMap::const_iterator original = originals.find(tid);
+			if (original != originals.end()) {
+				RestoreThread(tid, original->second);
+			}
+		}
+
+		closedir(tasks);
+	}
+
+	originals.clear();
+}
+
+/* The start time is kept from when the process is first seen until it is
+ * dropped, so it still tells a reused pid apart after being restored */
+bool NullControlGroup::IsSameProcess(int pid)
+{
+	unsigned long long start;
+	if (!ProcessPolicyManager::GetStartTime((pid_t)pid, start)) {
+		return false;
+	}
+
+	ProcessOriginalMap::iterator found = m_originals.find(pid);
+	if (found == m_originals.end()) {
+		m_originals[pid].m_startTime = start;
+		return true;
+	}
+
+	return found->second.m_startTime == start;
+}
+
+void NullControlGroup::RestoreThread(int tid, const ThreadOriginal& original)
+{
+	static MetricsCounter& s_restored =
+		Metrics::GetCounter("sched.threadsRestored");
+	s_restored.Increment();
+
+	struct sched_param param;
+	param.sched_priority = 0;
+
+	if (original.m_hasMask &&
+		(sched_setaffinity((pid_t)tid, sizeof(original.m_mask),
+			&original.m_mask) < 0) && (errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_AFFINITY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to restore CPU affinity");
+	}
+
+	if ((sched_setscheduler((pid_t)tid, original.m_policy, &param) < 0) &&
+		(errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_SCHED_POLICY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to restore scheduling policy");
+	}
+
+	if ((setpriority(PRIO_PROCESS, (id_t)tid, original.m_nice) < 0) &&
+		(errno != ESRCH)) {
+		LOG_AM_WARNING(MSGID_SET_SCHED_POLICY_FAIL, 2,
+			PMLOGKFV("tid", "%d", tid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to restore nice level");
+	}
 }
 
 bool NullControlGroup::WriteControlFile(const std::string& controlFile,
@@ -219,4 +721,3 @@ bool NullControlGroup::WriteControlFile(const std::string& controlFile,
 {
 	return true;
 }
-
@@ -18,6 +18,7 @@
 
 #include "ControlGroupManager.h"
 #include "ControlGroup.h"
+#include "Metrics.h"
 #include "Logging.h"
 
 #ifdef MOJ_LINUX
@@ -25,14 +26,22 @@
 #include <linux/magic.h>
 #endif
 
+#include <cerrno>
 #include <cstring>
 #include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+const unsigned ControlGroupManager::RescanInterval;
 
 ControlGroupManager::ControlGroupManager(const std::string& root,
 	boost::shared_ptr<MasterResourceManager> master)
 	: ContainerManager(master)
 	, m_root(root)
 	, m_supported(false)
+	, m_classesReady(false)
 {
 #ifdef MOJ_LINUX
 	struct statfs cgroupstat;
@@ -52,6 +61,9 @@ ControlGroupManager::ControlGroupManager(const std::string& root,
 	}
 
 	m_supported = true;
+
+	ReadControl(m_root + "/cpuset.cpus", m_allCpus);
+	ReadControl(m_root + "/cpuset.mems", m_mems);
 #endif
 }
 
@@ -75,6 +87,14 @@ boost::shared_ptr<ResourceContainer> ControlGroupManager::CreateContainer(
 		controlGroup = boost::make_shared<NullControlGroup>(name,
 			boost::dynamic_pointer_cast<ControlGroupManager, ResourceManager>
 				(shared_from_this()));
+
+		if (!m_rescanTimeout) {
+			m_rescanTimeout = boost::make_shared<Timeout<ControlGroupManager> >(
+				boost::dynamic_pointer_cast<ControlGroupManager,
+					ResourceManager>(shared_from_this()), RescanInterval,
+				&ControlGroupManager::RescanThreads);
+			m_rescanTimeout->Arm(RescanInterval);
+		}
 	}
 
 	controlGroup->Init();
@@ -96,3 +116,155 @@ const std::string& ControlGroupManager::GetRoot() const
 {
 	return m_root;
 }
+
+/* Without a cgroup filesystem the Containers pin their own threads */
+const char *ControlGroupManager::GetCpuPartitionMode() const
+{
+	return m_supported ? "cpuset" : "affinity";
+}
+
+MojErr ControlGroupManager::InfoToJson(MojObject& rep) const
+{
+	MojObject partition(MojObject::TypeObject);
+
+	MojErr err = CpuPartitionToJson(partition);
+	MojErrCheck(err);
+
+	err = rep.put(_T("cpuPartition"), partition);
+	MojErrCheck(err);
+
+	return ContainerManager::InfoToJson(rep);
+}
+
+void ControlGroupManager::ApplyCpuPartition()
+{
+	if (m_supported) {
+		WriteClassCpus();
+	}
+
+	for (ContainerMap::iterator iter = m_containers.begin();
+		iter != m_containers.end(); ++iter) {
+		boost::shared_ptr<ControlGroup> group =
+			boost::dynamic_pointer_cast<ControlGroup, ResourceContainer>(
+				iter->second);
+		if (group) {
+			group->ApplyPartition();
+		}
+	}
+}
+
+void ControlGroupManager::RescanThreads()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	static MetricsCounter& s_rescans = Metrics::GetCounter("sched.rescans");
+	s_rescans.Increment();
+
+	for (ContainerMap::iterator iter = m_containers.begin();
+		iter != m_containers.end(); ++iter) {
+		boost::shared_ptr<NullControlGroup> group =
+			boost::dynamic_pointer_cast<NullControlGroup, ResourceContainer>(
+				iter->second);
+		if (group) {
+			group->Rescan();
+		}
+	}
+
+	m_rescanTimeout->Arm(RescanInterval);
+}
+
+/* Write every class's cpuset.cpus from the partition, creating the class
+ * directories the first time the partition is enabled */
+bool ControlGroupManager::WriteClassCpus()
+{
+	if (!m_partition.IsEnabled() && !m_classesReady) {
+		return true;
+	}
+
+	bool success = PrepareClass(m_root + "/focused",
+		m_partition.GetCpus(ActivityPriorityHighest, true));
+
+	success = PrepareClass(m_root + "/unfocused", std::string()) && success;
+
+	for (int priority = ActivityPriorityNone;
+		priority < MaxActivityPriority; priority++) {
+		success = PrepareClass(m_root + "/unfocused/" +
+			ActivityPriorityNames[priority],
+			m_partition.GetCpus((ActivityPriority_t)priority, false)) &&
+			success;
+	}
+
+	m_classesReady = true;
+
+	return success;
+}
+
+bool ControlGroupManager::PrepareClass(const std::string& path,
+	const std::string& cpus)
+{
+	if (mkdir(path.c_str(), 0755) == 0) {
+		/* A new cpuset takes no tasks until it has memory nodes */
+		WriteControl(path + "/cpuset.mems", m_mems);
+	} else if (errno != EEXIST) {
+		LOG_AM_ERROR(MSGID_CGROUP_CREATE_FAIL, 2,
+			PMLOGKS("path", path.c_str()), PMLOGKS("error", strerror(errno)),
+			"Failed to create cpuset class");
+		return false;
+	}
+
+	return WriteControl(path + "/cpuset.cpus", cpus.empty() ? m_allCpus : cpus);
+}
+
+bool ControlGroupManager::ReadControl(const std::string& path,
+	std::string& value)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		LOG_AM_ERROR(MSGID_CONTROL_FILE_OPEN_FAIL, 2,
+			PMLOGKS("control_file", path.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return false;
+	}
+
+	char buf[256];
+	ssize_t ret = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (ret < 0) {
+		return false;
+	}
+
+	value.assign(buf, (size_t)ret);
+	value.erase(value.find_last_not_of(" \n") + 1);
+
+	return true;
+}
+
+bool ControlGroupManager::WriteControl(const std::string& path,
+	const std::string& value)
+{
+	if (value.empty()) {
+		return false;
+	}
+
+	int fd = open(path.c_str(), O_WRONLY);
+	if (fd < 0) {
+		LOG_AM_ERROR(MSGID_CONTROL_FILE_OPEN_FAIL, 2,
+			PMLOGKS("control_file", path.c_str()),
+			PMLOGKS("Reason", strerror(errno)), "");
+		return false;
+	}
+
+	ssize_t ret = write(fd, value.c_str(), value.length());
+	if (ret != (ssize_t)value.length()) {
+		LOG_AM_ERROR(MSGID_WRITE_TO_CONTROL_FILE_FAIL, 2,
+			PMLOGKS("control_file", path.c_str()),
+			PMLOGKS("Reason", (ret < 0) ? strerror(errno) : "short write"),
+			"");
+		close(fd);
+		return false;
+	}
+
+	close(fd);
+	return true;
+}
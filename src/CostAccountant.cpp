@@ -0,0 +1,429 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "CostAccountant.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vector>
+
+CostAccountant::Cost::Cost()
+	: m_cpuUsec(0)
+	, m_readBytes(0)
+	, m_writeBytes(0)
+{
+}
+
+void CostAccountant::Cost::Add(const Cost& cost)
+{
+	m_cpuUsec += cost.m_cpuUsec;
+	m_readBytes += cost.m_readBytes;
+	m_writeBytes += cost.m_writeBytes;
+}
+
+MojErr CostAccountant::Cost::ToJson(MojObject& rep) const
+{
+	MojErr err = rep.putInt(_T("cpuMs"), (MojInt64)(m_cpuUsec / 1000));
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("readBytes"), (MojInt64)m_readBytes);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("writeBytes"), (MojInt64)m_writeBytes);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+CostAccountant::History::History()
+	: m_runs(0)
+	, m_sequence(0)
+{
+}
+
+CostAccountant::CostAccountant()
+	: m_sequence(0)
+	, m_ticksPerSecond(sysconf(_SC_CLK_TCK))
+{
+	if (m_ticksPerSecond <= 0) {
+		m_ticksPerSecond = 100;
+	}
+}
+
+CostAccountant::~CostAccountant()
+{
+}
+
+void CostAccountant::Begin(activityId_t id, const std::string& name)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	Running& running = m_running[id];
+	running.m_name = name;
+	running.m_cost = Cost();
+}
+
+void CostAccountant::End(activityId_t id)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	RunningMap::iterator found = m_running.find(id);
+	if (found == m_running.end()) {
+		return;
+	}
+
+	const Cost& cost = found->second.m_cost;
+
+	History& history = m_histories[found->second.m_name];
+	if (!history.m_runs) {
+		history.m_average = cost;
+	} else {
+		/* average += (cost - average) / AverageWeight, without going
+		 * negative in unsigned arithmetic */
+		MojUInt64 *averages[] = { &history.m_average.m_cpuUsec,
+			&history.m_average.m_readBytes, &history.m_average.m_writeBytes };
+		const MojUInt64 costs[] = { cost.m_cpuUsec, cost.m_readBytes,
+			cost.m_writeBytes };
+
+		for (int i = 0; i < 3; i++) {
+			*averages[i] = ((*averages[i] * (AverageWeight - 1)) + costs[i]) /
+				AverageWeight;
+		}
+	}
+
+	history.m_runs++;
+	history.m_total.Add(cost);
+	history.m_last = cost;
+	history.m_sequence = ++m_sequence;
+
+	LOG_AM_DEBUG("[Activity %llu] \"%s\" cost %llu us CPU, %llu bytes read, "
+		"%llu bytes written", id, found->second.m_name.c_str(),
+		(unsigned long long)cost.m_cpuUsec,
+		(unsigned long long)cost.m_readBytes,
+		(unsigned long long)cost.m_writeBytes);
+
+	m_running.erase(found);
+
+	if (m_histories.size() > MaxHistories) {
+		HistoryMap::iterator oldest = m_histories.begin();
+		for (HistoryMap::iterator iter = m_histories.begin();
+			iter != m_histories.end(); ++iter) {
+			if (iter->second.m_sequence < oldest->second.m_sequence) {
+				oldest = iter;
+			}
+		}
+		m_histories.erase(oldest);
+	}
+
+	if (m_running.empty()) {
+		m_readings.clear();
+	}
+}
+
+bool CostAccountant::IsAccounting() const
+{
+	return !m_running.empty();
+}
+
+void CostAccountant::Sample(const ProcessMap& processes)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	static MetricsCounter& s_samples = Metrics::GetCounter("costs.samples");
+	s_samples.Increment();
+
+	SharerMap sharers;
+	GetSharers(processes, sharers);
+
+	ReadingMap readings;
+
+	for (SharerMap::const_iterator iter = sharers.begin();
+		iter != sharers.end(); ++iter) {
+		Reading reading;
+		if (!ReadProcess(iter->first, reading)) {
+			continue;
+		}
+
+		readings[iter->first] = reading;
+
+		ReadingMap::const_iterator last = m_readings.find(iter->first);
+		if (last != m_readings.end()) {
+			Charge(iter->second, last->second, reading);
+		}
+	}
+
+	/* Processes no running Activity uses are forgotten */
+	m_readings.swap(readings);
+}
+
+void CostAccountant::SampleProcesses(const ProcessMap& processes,
+	const std::set<int>& pids)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	static MetricsCounter& s_samples =
+		Metrics::GetCounter("costs.partialSamples");
+	s_samples.Increment();
+
+	SharerMap sharers;
+	GetSharers(processes, sharers);
+
+	for (std::set<int>::const_iterator pid = pids.begin();
+		pid != pids.end(); ++pid) {
+		Reading reading;
+		if (!ReadProcess(*pid, reading)) {
+			m_readings.erase(*pid);
+			continue;
+		}
+
+		/* A process nobody was running in only gets a fresh baseline;
+		 * what it did meanwhile is not charged to anyone */
+		ReadingMap::iterator last = m_readings.find(*pid);
+		SharerMap::const_iterator found = sharers.find(*pid);
+		if ((last != m_readings.end()) && (found != sharers.end())) {
+			Charge(found->second, last->second, reading);
+		}
+
+		m_readings[*pid] = reading;
+	}
+}
+
+/* Which running Activities share each process */
+void CostAccountant::GetSharers(const ProcessMap& processes,
+	SharerMap& sharers)
+{
+	for (ProcessMap::const_iterator iter = processes.begin();
+		iter != processes.end(); ++iter) {
+		RunningMap::iterator running = m_running.find(iter->first);
+		if (running == m_running.end()) {
+			continue;
+		}
+
+		for (std::set<int>::const_iterator pid = iter->second.begin();
+			pid != iter->second.end(); ++pid) {
+			sharers[*pid].push_back(&running->second);
+		}
+	}
+}
+
+/* Split the growth of a process since "previous" evenly between the
+ * Activities sharing it */
+void CostAccountant::Charge(const RunningVec& sharers,
+	const Reading& previous, const Reading& reading)
+{
+	/* A counter going backwards means the pid was reused */
+	if ((reading.m_cpuUsec < previous.m_cpuUsec) ||
+		(reading.m_readBytes < previous.m_readBytes) ||
+		(reading.m_writeBytes < previous.m_writeBytes)) {
+		return;
+	}
+
+	MojUInt64 count = (MojUInt64)sharers.size();
+
+	Cost share;
+	share.m_cpuUsec = (reading.m_cpuUsec - previous.m_cpuUsec) / count;
+	share.m_readBytes = (reading.m_readBytes - previous.m_readBytes) / count;
+	share.m_writeBytes = (reading.m_writeBytes - previous.m_writeBytes) /
+		count;
+
+	for (RunningVec::const_iterator running = sharers.begin();
+		running != sharers.end(); ++running) {
+		(*running)->m_cost.Add(share);
+	}
+}
+
+const CostAccountant::Cost *CostAccountant::GetCost(activityId_t id) const
+{
+	RunningMap::const_iterator found = m_running.find(id);
+	if (found == m_running.end()) {
+		return NULL;
+	}
+
+	return &found->second.m_cost;
+}
+
+const CostAccountant::History *CostAccountant::GetHistory(
+	const std::string& name) const
+{
+	HistoryMap::const_iterator found = m_histories.find(name);
+	if (found == m_histories.end()) {
+		return NULL;
+	}
+
+	return &found->second;
+}
+
+MojErr CostAccountant::ActivityToJson(activityId_t id,
+	const std::string& name, MojObject& rep) const
+{
+	MojErr err;
+
+	const Cost *cost = GetCost(id);
+	if (cost) {
+		MojObject current(MojObject::TypeObject);
+		err = cost->ToJson(current);
+		MojErrCheck(err);
+
+		err = rep.put(_T("current"), current);
+		MojErrCheck(err);
+	}
+
+	const History *history = GetHistory(name);
+	if (history) {
+		err = HistoryToJson(*history, rep);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+MojErr CostAccountant::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	MojObject running(MojObject::TypeArray);
+	for (RunningMap::const_iterator iter = m_running.begin();
+		iter != m_running.end(); ++iter) {
+		MojObject entry(MojObject::TypeObject);
+
+		err = entry.putInt(_T("activityId"), (MojInt64)iter->first);
+		MojErrCheck(err);
+
+		err = entry.putString(_T("name"), iter->second.m_name.c_str());
+		MojErrCheck(err);
+
+		err = iter->second.m_cost.ToJson(entry);
+		MojErrCheck(err);
+
+		err = running.push(entry);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("running"), running);
+	MojErrCheck(err);
+
+	MojObject histories(MojObject::TypeObject);
+	for (HistoryMap::const_iterator iter = m_histories.begin();
+		iter != m_histories.end(); ++iter) {
+		MojObject entry(MojObject::TypeObject);
+
+		err = HistoryToJson(iter->second, entry);
+		MojErrCheck(err);
+
+		err = histories.put(iter->first.c_str(), entry);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("byName"), histories);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr CostAccountant::HistoryToJson(const History& history, MojObject& rep)
+{
+	MojErr err = rep.putInt(_T("runs"), (MojInt64)history.m_runs);
+	MojErrCheck(err);
+
+	MojObject total(MojObject::TypeObject);
+	err = history.m_total.ToJson(total);
+	MojErrCheck(err);
+
+	err = rep.put(_T("total"), total);
+	MojErrCheck(err);
+
+	MojObject average(MojObject::TypeObject);
+	err = history.m_average.ToJson(average);
+	MojErrCheck(err);
+
+	err = rep.put(_T("average"), average);
+	MojErrCheck(err);
+
+	MojObject last(MojObject::TypeObject);
+	err = history.m_last.ToJson(last);
+	MojErrCheck(err);
+
+	err = rep.put(_T("last"), last);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+/* utime and stime are fields 14 and 15 of /proc/<pid>/stat, counted from
+ * the end of the command name, which may itself hold spaces or ')'.
+ * read_bytes and write_bytes of /proc/<pid>/io count what reached the
+ * storage layer; a process whose io is unreadable is charged CPU only. */
+bool CostAccountant::ReadProcess(int pid, Reading& reading) const
+{
+	char path[32];
+	char buf[1024];
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	ssize_t length = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (length <= 0) {
+		return false;
+	}
+	buf[length] = '\0';
+
+	const char *fields = strrchr(buf, ')');
+	unsigned long long utime, stime;
+	if (!fields || (sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u "
+		"%*u %*u %*u %llu %llu", &utime, &stime) != 2)) {
+		return false;
+	}
+
+	reading.m_cpuUsec = ((utime + stime) * 1000000ULL) /
+		(unsigned long long)m_ticksPerSecond;
+	reading.m_readBytes = 0;
+	reading.m_writeBytes = 0;
+
+	snprintf(path, sizeof(path), "/proc/%d/io", pid);
+
+	FILE *io = fopen(path, "r");
+	if (!io) {
+		return true;
+	}
+
+	char line[128];
+	unsigned long long value;
+	while (fgets(line, sizeof(line), io)) {
+		if (sscanf(line, "read_bytes: %llu", &value) == 1) {
+			reading.m_readBytes = value;
+		} else if (sscanf(line, "write_bytes: %llu", &value) == 1) {
+			reading.m_writeBytes = value;
+		}
+	}
+
+	fclose(io);
+
+	return true;
+}
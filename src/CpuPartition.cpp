@@ -0,0 +1,145 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "CpuPartition.h"
+
+#include <cstdlib>
+
+CpuPartition::CpuPartition()
+{
+}
+
+bool CpuPartition::IsEnabled() const
+{
+	return !m_performance.empty() || !m_efficiency.empty();
+}
+
+std::string CpuPartition::GetCpus(ActivityPriority_t priority,
+	bool focused) const
+{
+	if (focused || (priority >= ActivityPriorityHigh)) {
+		return m_performance;
+	} else if (priority <= ActivityPriorityLow) {
+		return m_efficiency;
+	} else if (m_performance.empty() || m_efficiency.empty()) {
+		return std::string();
+	} else {
+		return m_performance + "," + m_efficiency;
+	}
+}
+
+void CpuPartition::GetMask(ActivityPriority_t priority, bool focused,
+	cpu_set_t& mask) const
+{
+	std::string cpus = GetCpus(priority, focused);
+
+	if (cpus.empty() || !ParseCpuList(cpus, mask)) {
+		CPU_ZERO(&mask);
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, &mask);
+		}
+	}
+}
+
+MojErr CpuPartition::FromJson(const MojObject& rep)
+{
+	MojErr err;
+	CpuPartition partition = *this;
+
+	const MojChar *keys[] = { _T("performance"), _T("efficiency") };
+	std::string *lists[] = { &partition.m_performance,
+		&partition.m_efficiency };
+
+	for (int i = 0; i < 2; i++) {
+		MojString value;
+		bool found = false;
+
+		err = rep.get(keys[i], value, found);
+		MojErrCheck(err);
+
+		if (!found) {
+			continue;
+		}
+
+		cpu_set_t mask;
+		if (!value.empty() && !ParseCpuList(value.data(), mask)) {
+			return MojErrInvalidArg;
+		}
+
+		lists[i]->assign(value.data());
+	}
+
+	*this = partition;
+
+	return MojErrNone;
+}
+
+MojErr CpuPartition::ToJson(MojObject& rep) const
+{
+	MojErr err = rep.putString(_T("performance"), m_performance.c_str());
+	MojErrCheck(err);
+
+	err = rep.putString(_T("efficiency"), m_efficiency.c_str());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+/* Parses "0-3,6".  An empty list, or one naming no CPU, does not parse. */
+bool CpuPartition::ParseCpuList(const std::string& list, cpu_set_t& mask)
+{
+	CPU_ZERO(&mask);
+
+	const char *pos = list.c_str();
+	bool any = false;
+
+	while (*pos) {
+		char *end;
+
+		long first = strtol(pos, &end, 10);
+		if ((end == pos) || (first < 0) || (first >= CPU_SETSIZE)) {
+			return false;
+		}
+
+		long last = first;
+		pos = end;
+
+		if (*pos == '-') {
+			pos++;
+			last = strtol(pos, &end, 10);
+			if ((end == pos) || (last < first) || (last >= CPU_SETSIZE)) {
+				return false;
+			}
+			pos = end;
+		}
+
+		for (long cpu = first; cpu <= last; cpu++) {
+			CPU_SET((int)cpu, &mask);
+		}
+		any = true;
+
+		if (*pos == ',') {
+			pos++;
+		} else if (*pos) {
+			return false;
+		}
+	}
+
+	return any;
+}
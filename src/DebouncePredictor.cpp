@@ -0,0 +1,432 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "DebouncePredictor.h"
+#include "PowerdPowerLock.h"
+#include "Logging.h"
+
+#include <cmath>
+
+const unsigned DebouncePredictor::GapBounds[BucketCount - 1] =
+	{ 1, 2, 4, 8, 12, 16, 24, 32, 48, 64 };
+
+DebouncePredictor::Config	DebouncePredictor::s_config;
+DebouncePredictor::Histogram	DebouncePredictor::s_global;
+DebouncePredictor::CreatorMap	DebouncePredictor::s_creators;
+
+bool		DebouncePredictor::s_lockFreeAwaiting = false;
+time_t		DebouncePredictor::s_lockFree = 0;
+bool		DebouncePredictor::s_lockFreeDebounced = false;
+unsigned	DebouncePredictor::s_lockFreeDelay = 0;
+
+unsigned long long	DebouncePredictor::s_decisions = 0;
+unsigned long long	DebouncePredictor::s_hits = 0;
+unsigned long long	DebouncePredictor::s_fixedHits = 0;
+unsigned long long	DebouncePredictor::s_awakeSeconds = 0;
+unsigned long long	DebouncePredictor::s_wastedSeconds = 0;
+unsigned long long	DebouncePredictor::s_fixedAwakeSeconds = 0;
+unsigned long long	DebouncePredictor::s_fixedWastedSeconds = 0;
+
+DebouncePredictor::Config::Config()
+	: m_enabled(true)
+	, m_wakeCost(8)
+	, m_maxDelay(32)
+	, m_minSamples(4)
+	, m_sampleHalfLife(16)
+{
+}
+
+unsigned DebouncePredictor::Predict(const std::string& creator)
+{
+	unsigned fixed = (unsigned)PowerdPowerLock::PowerActivityDebounceDuration;
+
+	if (!s_config.m_enabled) {
+		return fixed;
+	}
+
+	const Histogram *gaps = &s_global;
+	const char *source = "global";
+
+	CreatorMap::const_iterator found = s_creators.find(creator);
+	if ((found != s_creators.end()) &&
+		(found->second.m_gaps.GetWeight() >= (double)s_config.m_minSamples)) {
+		gaps = &found->second.m_gaps;
+		source = "creator";
+	}
+
+	if (gaps->GetWeight() < (double)s_config.m_minSamples) {
+		return fixed;
+	}
+
+	double cost;
+	unsigned delay = gaps->Best(s_config, cost);
+
+	LOG_AM_DEBUG("Debouncing power for %s for %us (%s, expected cost %.1fs)",
+		creator.c_str(), delay, source, cost);
+
+	return delay;
+}
+
+void DebouncePredictor::NoteAcquire(const std::string& creator, time_t now)
+{
+	if (s_lockFreeAwaiting) {
+		unsigned gap = (now > s_lockFree) ? (unsigned)(now - s_lockFree) : 0;
+
+		s_global.Add((double)gap, GetDecay());
+		s_global.m_updated = now;
+
+		if (s_lockFreeDebounced) {
+			unsigned fixed =
+				(unsigned)PowerdPowerLock::PowerActivityDebounceDuration;
+
+			s_decisions++;
+
+			if (gap <= s_lockFreeDelay) {
+				s_hits++;
+				s_awakeSeconds += gap;
+			} else {
+				s_awakeSeconds += s_lockFreeDelay;
+				s_wastedSeconds += s_lockFreeDelay;
+			}
+
+			if (gap <= fixed) {
+				s_fixedHits++;
+				s_fixedAwakeSeconds += gap;
+			} else {
+				s_fixedAwakeSeconds += fixed;
+				s_fixedWastedSeconds += fixed;
+			}
+		}
+
+		s_lockFreeAwaiting = false;
+	}
+
+	CreatorMap::iterator found = s_creators.find(creator);
+	if ((found != s_creators.end()) && found->second.m_awaiting) {
+		time_t released = found->second.m_released;
+		unsigned gap = (now > released) ? (unsigned)(now - released) : 0;
+
+		found->second.m_gaps.Add((double)gap, GetDecay());
+		found->second.m_gaps.m_updated = now;
+		found->second.m_awaiting = false;
+	}
+}
+
+void DebouncePredictor::NoteRelease(const std::string& creator, time_t now)
+{
+	std::pair<CreatorMap::iterator, bool> inserted =
+		s_creators.insert(CreatorMap::value_type(creator, CreatorState()));
+
+	CreatorState& state = inserted.first->second;
+	state.m_awaiting = true;
+	state.m_released = now;
+
+	if (inserted.second) {
+		state.m_gaps.m_updated = now;
+	}
+
+	if (s_creators.size() > MaxCreators) {
+		TrimCreators();
+	}
+}
+
+void DebouncePredictor::NoteLockFree(time_t now, bool debounced,
+	unsigned delay)
+{
+	s_lockFreeAwaiting = true;
+	s_lockFree = now;
+	s_lockFreeDebounced = debounced;
+	s_lockFreeDelay = delay;
+}
+
+const DebouncePredictor::Config& DebouncePredictor::GetConfig()
+{
+	return s_config;
+}
+
+static MojErr GetConfigValue(const MojObject& rep, const MojChar *key,
+	unsigned& value)
+{
+	MojUInt32 newValue;
+	bool found = false;
+
+	MojErr err = rep.get(key, newValue, found);
+	MojErrCheck(err);
+
+	if (found) {
+		value = (unsigned)newValue;
+	}
+
+	return MojErrNone;
+}
+
+MojErr DebouncePredictor::ConfigFromJson(const MojObject& rep)
+{
+	MojErr err;
+	Config config = s_config;
+
+	rep.get(_T("enabled"), config.m_enabled);
+
+	err = GetConfigValue(rep, _T("wakeCost"), config.m_wakeCost);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("maxDelay"), config.m_maxDelay);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("minSamples"), config.m_minSamples);
+	MojErrCheck(err);
+	err = GetConfigValue(rep, _T("sampleHalfLife"), config.m_sampleHalfLife);
+	MojErrCheck(err);
+
+	if (!config.m_sampleHalfLife) {
+		return MojErrInvalidArg;
+	}
+
+	s_config = config;
+
+	return MojErrNone;
+}
+
+MojErr DebouncePredictor::ConfigToJson(MojObject& rep)
+{
+	MojErr err;
+
+	err = rep.putBool(_T("enabled"), s_config.m_enabled);
+	MojErrCheck(err);
+	err = rep.putInt(_T("wakeCost"), (MojInt64)s_config.m_wakeCost);
+	MojErrCheck(err);
+	err = rep.putInt(_T("maxDelay"), (MojInt64)s_config.m_maxDelay);
+	MojErrCheck(err);
+	err = rep.putInt(_T("minSamples"), (MojInt64)s_config.m_minSamples);
+	MojErrCheck(err);
+	err = rep.putInt(_T("sampleHalfLife"),
+		(MojInt64)s_config.m_sampleHalfLife);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr DebouncePredictor::ToJson(MojObject& rep)
+{
+	MojErr err;
+
+	MojObject performance(MojObject::TypeObject);
+
+	err = performance.putInt(_T("decisions"), (MojInt64)s_decisions);
+	MojErrCheck(err);
+	err = performance.putInt(_T("hits"), (MojInt64)s_hits);
+	MojErrCheck(err);
+	err = performance.putInt(_T("awakeSeconds"), (MojInt64)s_awakeSeconds);
+	MojErrCheck(err);
+	err = performance.putInt(_T("wastedSeconds"), (MojInt64)s_wastedSeconds);
+	MojErrCheck(err);
+
+	MojObject fixed(MojObject::TypeObject);
+
+	err = fixed.putInt(_T("delay"),
+		(MojInt64)PowerdPowerLock::PowerActivityDebounceDuration);
+	MojErrCheck(err);
+	err = fixed.putInt(_T("hits"), (MojInt64)s_fixedHits);
+	MojErrCheck(err);
+	err = fixed.putInt(_T("awakeSeconds"), (MojInt64)s_fixedAwakeSeconds);
+	MojErrCheck(err);
+	err = fixed.putInt(_T("wastedSeconds"), (MojInt64)s_fixedWastedSeconds);
+	MojErrCheck(err);
+
+	err = performance.put(_T("fixed"), fixed);
+	MojErrCheck(err);
+
+	err = rep.put(_T("performance"), performance);
+	MojErrCheck(err);
+
+	MojObject global(MojObject::TypeObject);
+	err = s_global.ToJson(global);
+	MojErrCheck(err);
+	err = rep.put(_T("global"), global);
+	MojErrCheck(err);
+
+	MojObject creators(MojObject::TypeObject);
+	for (CreatorMap::const_iterator iter = s_creators.begin();
+		iter != s_creators.end(); ++iter) {
+		MojObject creator(MojObject::TypeObject);
+		err = iter->second.m_gaps.ToJson(creator);
+		MojErrCheck(err);
+		err = creators.put(iter->first.c_str(), creator);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("creators"), creators);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void DebouncePredictor::Reset()
+{
+	s_global = Histogram();
+	s_creators.clear();
+
+	s_lockFreeAwaiting = false;
+	s_lockFree = 0;
+	s_lockFreeDebounced = false;
+	s_lockFreeDelay = 0;
+
+	s_decisions = 0;
+	s_hits = 0;
+	s_fixedHits = 0;
+	s_awakeSeconds = 0;
+	s_wastedSeconds = 0;
+	s_fixedAwakeSeconds = 0;
+	s_fixedWastedSeconds = 0;
+}
+
+double DebouncePredictor::GetDecay()
+{
+	return pow(0.5, 1.0 / (double)s_config.m_sampleHalfLife);
+}
+
+/* Forget the creator heard from least recently */
+void DebouncePredictor::TrimCreators()
+{
+	CreatorMap::iterator oldest = s_creators.begin();
+
+	for (CreatorMap::iterator iter = s_creators.begin();
+		iter != s_creators.end(); ++iter) {
+		if (iter->second.m_gaps.m_updated < oldest->second.m_gaps.m_updated) {
+			oldest = iter;
+		}
+	}
+
+	if (oldest != s_creators.end()) {
+		s_creators.erase(oldest);
+	}
+}
+
+DebouncePredictor::Histogram::Histogram()
+	: m_updated(0)
+	, m_total(0.0)
+{
+	for (unsigned i = 0; i < BucketCount; ++i) {
+		m_weights[i] = 0.0;
+	}
+}
+
+void DebouncePredictor::Histogram::Add(double gap, double decay)
+{
+	unsigned bucket = 0;
+	while ((bucket < (BucketCount - 1)) && (gap > (double)GapBounds[bucket])) {
+		bucket++;
+	}
+
+	m_total = 0.0;
+	for (unsigned i = 0; i < BucketCount; ++i) {
+		m_weights[i] *= decay;
+		if (i == bucket) {
+			m_weights[i] += 1.0;
+		}
+		m_total += m_weights[i];
+	}
+}
+
+unsigned DebouncePredictor::Histogram::Best(const Config& config,
+	double& cost) const
+{
+	unsigned best = 0;
+	cost = ExpectedCost(0, config.m_wakeCost);
+
+	for (unsigned i = 0; i < (BucketCount - 1); ++i) {
+		if (GapBounds[i] > config.m_maxDelay) {
+			break;
+		}
+
+		double candidate = ExpectedCost(GapBounds[i], config.m_wakeCost);
+		if (candidate < cost) {
+			cost = candidate;
+			best = GapBounds[i];
+		}
+	}
+
+	return best;
+}
+
+/* Gaps are taken to fall in the middle of their bucket; those past the
+ * last bound are always misses */
+double DebouncePredictor::Histogram::ExpectedCost(unsigned delay,
+	unsigned wakeCost) const
+{
+	if (m_total <= 0.0) {
+		return 0.0;
+	}
+
+	double cost = 0.0;
+	double lower = 0.0;
+
+	for (unsigned i = 0; i < BucketCount; ++i) {
+		if ((i < (BucketCount - 1)) && (GapBounds[i] <= delay)) {
+			cost += m_weights[i] * ((lower + (double)GapBounds[i]) / 2.0);
+		} else {
+			cost += m_weights[i] * (double)(delay + wakeCost);
+		}
+
+		if (i < (BucketCount - 1)) {
+			lower = (double)GapBounds[i];
+		}
+	}
+
+	return cost / m_total;
+}
+
+MojErr DebouncePredictor::Histogram::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	err = rep.putDecimal(_T("samples"), MojDecimal(m_total));
+	MojErrCheck(err);
+
+	MojObject buckets(MojObject::TypeObject);
+	for (unsigned i = 0; i < BucketCount; ++i) {
+		if (m_weights[i] < 0.01) {
+			continue;
+		}
+
+		MojString label;
+		if (i < (BucketCount - 1)) {
+			err = label.format(_T("%u"), GapBounds[i]);
+		} else {
+			err = label.format(_T(">%u"), GapBounds[BucketCount - 2]);
+		}
+		MojErrCheck(err);
+
+		err = buckets.putDecimal(label.data(), MojDecimal(m_weights[i]));
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("gaps"), buckets);
+	MojErrCheck(err);
+
+	if (m_total >= (double)s_config.m_minSamples) {
+		double cost;
+		unsigned delay = Best(s_config, cost);
+
+		err = rep.putInt(_T("delay"), (MojInt64)delay);
+		MojErrCheck(err);
+
+		err = rep.putDecimal(_T("expectedCost"), MojDecimal(cost));
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
@@ -24,6 +24,13 @@
 #include "Activity.h"
 #include "ResourceManager.h"
 #include "ContainerManager.h"
+#include "WorkloadRecorder.h"
+#include "MethodLatency.h"
+#include "FlightRecorder.h"
+#include "DiagnosticFile.h"
+#include "ConnectionDamping.h"
+#include "PowerdProxy.h"
+#include "DebouncePredictor.h"
 #include "Logging.h"
 
 /*!
@@ -33,6 +40,16 @@
  * - \ref com_palm_activitymanager_devel_run
  * - \ref com_palm_activitymanager_devel_concurrency
  * - \ref com_palm_activitymanager_devel_priority_control
+ * - \ref com_palm_activitymanager_devel_memory_usage
+ * - \ref com_palm_activitymanager_devel_start_recording
+ * - \ref com_palm_activitymanager_devel_stop_recording
+ * - \ref com_palm_activitymanager_devel_reset_metrics
+ * - \ref com_palm_activitymanager_devel_dump_flight_recorder
+ * - \ref com_palm_activitymanager_devel_connection_damping
+ * - \ref com_palm_activitymanager_devel_battery_updates
+ * - \ref com_palm_activitymanager_devel_power_debounce
+ * - \ref com_palm_activitymanager_devel_container_freezer
+ * - \ref com_palm_activitymanager_devel_cpu_partition
  */
 
 const DevelCategoryHandler::Method DevelCategoryHandler::s_methods[] = {
@@ -40,6 +57,16 @@ const DevelCategoryHandler::Method DevelCategoryHandler::s_methods[] = {
 	{ _T("run"), (Callback) &DevelCategoryHandler::Run },
 	{ _T("concurrency"), (Callback) &DevelCategoryHandler::SetConcurrency },
 	{ _T("priorityControl"), (Callback) &DevelCategoryHandler::PriorityControl },
+	{ _T("memoryUsage"), (Callback) &DevelCategoryHandler::MemoryUsage },
+	{ _T("startRecording"), (Callback) &DevelCategoryHandler::StartRecording },
+	{ _T("stopRecording"), (Callback) &DevelCategoryHandler::StopRecording },
+	{ _T("resetMetrics"), (Callback) &DevelCategoryHandler::ResetMetrics },
+	{ _T("dumpFlightRecorder"), (Callback) &DevelCategoryHandler::DumpFlightRecorder },
+	{ _T("connectionDamping"), (Callback) &DevelCategoryHandler::ConnectionDampingConfig },
+	{ _T("batteryUpdates"), (Callback) &DevelCategoryHandler::BatteryUpdates },
+	{ _T("powerDebounce"), (Callback) &DevelCategoryHandler::PowerDebounce },
+	{ _T("containerFreezer"), (Callback) &DevelCategoryHandler::ContainerFreezer },
+	{ _T("cpuPartition"), (Callback) &DevelCategoryHandler::CpuPartitionConfig },
 	{ NULL, NULL }
 };
 
@@ -133,7 +160,7 @@ Example response for a failed call:
 MojErr
 DevelCategoryHandler::Evict(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Evict: %s", MojoObjectJson(payload).c_str());
@@ -228,7 +255,7 @@ Example response for a failed call:
 MojErr
 DevelCategoryHandler::Run(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Run: %s", MojoObjectJson(payload).c_str());
@@ -325,7 +352,7 @@ Example response for a failed call:
 MojErr
 DevelCategoryHandler::SetConcurrency(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("SetConcurrency: %s",
@@ -417,7 +444,7 @@ Example response for a failed call:
 MojErr
 DevelCategoryHandler::PriorityControl(MojServiceMessage *msg, MojObject& payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("PriorityControl: %s",
@@ -448,6 +475,1120 @@ DevelCategoryHandler::PriorityControl(MojServiceMessage *msg, MojObject& payload
 	return MojErrNone;
 }
 
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_memory_usage memoryUsage
+
+\e Private.
+
+com.palm.activitymanager/devel/memoryUsage
+
+Report the approximate memory used by all instantiated Activities, broken
+down by component.
+
+\subsection com_palm_activitymanager_devel_memory_usage_syntax Syntax:
+\code
+{
+}
+\endcode
+
+\subsection com_palm_activitymanager_devel_memory_usage_returns Returns:
+\code
+{
+    "activities": int,
+    "coldStateAllocated": int,
+    "totalBytes": int,
+    "bytesPerActivity": int,
+    "busIds": int,
+    "components": {
+        "object": int,
+        "strings": int,
+        "requirements": int,
+        "persistCommands": int,
+        "coldState": int
+    },
+    "returnValue": boolean
+}
+\endcode
+
+\param activities Number of Activities currently instantiated.
+\param coldStateAllocated Number of Activities which have allocated their
+                          rarely used state (adopters, associations, power).
+\param totalBytes Approximate bytes used by all Activities.
+\param bytesPerActivity Average bytes per Activity.
+\param busIds Number of distinct bus ids (apps, services, anonymous clients)
+              currently interned.
+\param components Bytes used, by component, across all Activities.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_memory_usage_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/memoryUsage '{ }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "activities": 31,
+    "coldStateAllocated": 4,
+    "totalBytes": 13908,
+    "bytesPerActivity": 448,
+    "busIds": 23,
+    "components": {
+        "object": 11160,
+        "strings": 1836,
+        "requirements": 448,
+        "persistCommands": 0,
+        "coldState": 464
+    },
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::MemoryUsage(MojServiceMessage *msg, MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("MemoryUsage: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+	MojObject reply(MojObject::TypeObject);
+
+	err = m_am->MemoryUsageToJson(reply);
+	MojErrCheck(err);
+
+	err = reply.putInt(_T("busIds"), (MojInt64)BusId::GetSymbolCount());
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_start_recording startRecording
+
+\e Private.
+
+com.palm.activitymanager/devel/startRecording
+
+Start recording the workload to a trace file: every incoming request, and
+every update received on the subscriptions the Activity Manager holds.  The
+trace can be fed back through the in-process bus with
+activitymanager-replay.  If a recording is already in progress, it is
+stopped first.
+
+Traces are only written to /var/log/activitymanager.
+
+\subsection com_palm_activitymanager_devel_start_recording_syntax Syntax:
+\code
+{
+    "name": string
+}
+\endcode
+
+\param name Name of the trace file.  It may not contain '/' or start with
+            '.', and must not already exist.
+
+\subsection com_palm_activitymanager_devel_start_recording_returns Returns:
+\code
+{
+    "path": string,
+    "errorCode": int,
+    "errorText": string,
+    "returnValue": boolean
+}
+\endcode
+
+\param path Full path of the trace file.
+\param errorCode Code for the error in case the call was not succesful.
+\param errorText Describes the error if the call was not succesful.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_start_recording_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/startRecording '{ "name": "am.trace" }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "path": "/var/log/activitymanager/am.trace",
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::StartRecording(MojServiceMessage *msg, MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("StartRecording: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	MojString name;
+	bool found = false;
+	err = payload.get(_T("name"), name, found);
+	MojErrCheck(err);
+	if (!found || name.empty()) {
+		err = msg->replyError(MojErrInvalidArg, _T("Must specify \"name\""));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	err = WorkloadRecorder::Start(name.data(), m_am);
+	if (err == MojErrInvalidArg) {
+		err = msg->replyError(err, _T("\"name\" must be a plain file name"));
+		MojErrCheck(err);
+		return MojErrNone;
+	} else if (err == MojErrExists) {
+		err = msg->replyError(err, _T("Trace file already exists"));
+		MojErrCheck(err);
+		return MojErrNone;
+	} else if (err) {
+		err = msg->replyError(err, _T("Failed to start recording"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	MojObject reply(MojObject::TypeObject);
+	err = reply.putString(_T("path"),
+		WorkloadRecorder::GetPath().c_str());
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_stop_recording stopRecording
+
+\e Private.
+
+com.palm.activitymanager/devel/stopRecording
+
+Stop recording the workload.  The final state of every Activity is written
+to the end of the trace, for comparison against a replay.
+
+\subsection com_palm_activitymanager_devel_stop_recording_syntax Syntax:
+\code
+{
+}
+\endcode
+
+\subsection com_palm_activitymanager_devel_stop_recording_returns Returns:
+\code
+{
+    "path": string,
+    "records": int,
+    "returnValue": boolean
+}
+\endcode
+
+\param path File the trace was written to.
+\param records Number of records written, including the start and end
+               records.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_stop_recording_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/stopRecording '{ }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "path": "/var/log/activitymanager/am.trace",
+    "records": 5214,
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::StopRecording(MojServiceMessage *msg, MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("StopRecording: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	if (!WorkloadRecorder::IsRecording()) {
+		err = msg->replyError(MojErrInvalidArg, _T("Not recording"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	err = WorkloadRecorder::Stop(m_am);
+	MojErrCheck(err);
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = reply.putString(_T("path"), WorkloadRecorder::GetPath().c_str());
+	MojErrCheck(err);
+
+	err = reply.putInt(_T("records"),
+		(MojInt64)WorkloadRecorder::GetRecordCount());
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_reset_metrics resetMetrics
+
+\e Private.
+
+com.palm.activitymanager/devel/resetMetrics
+
+Zero the metrics returned by "info" with "metrics": true, and restart the
+period counter rates are computed over.  Gauges keep their current value;
+only their high watermark is reset.  Per-method latencies and their slowest
+request exemplars are cleared as well.
+
+\subsection com_palm_activitymanager_devel_reset_metrics_syntax Syntax:
+\code
+{
+}
+\endcode
+
+\subsection com_palm_activitymanager_devel_reset_metrics_returns Returns:
+\code
+{
+    "errorCode": int,
+    "errorText": string,
+    "returnValue": boolean
+}
+\endcode
+
+\param errorCode Code for the error in case the call was not succesful.
+\param errorText Describes the error if the call was not succesful.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_reset_metrics_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/resetMetrics '{ }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::ResetMetrics(MojServiceMessage *msg, MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("ResetMetrics: %s", MojoObjectJson(payload).c_str());
+
+	Metrics::Reset();
+	MethodLatency::ResetAll();
+
+	MojErr err = msg->replySuccess();
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_dump_flight_recorder dumpFlightRecorder
+
+\e Private.
+
+com.palm.activitymanager/devel/dumpFlightRecorder
+
+Write the flight recorder's most recent state transitions, queue moves,
+requirement changes and persist completions to a binary file in
+/var/log/activitymanager.  The same dump is written to
+activitymanager.flight there when the Activity Manager receives SIGUSR2.
+activitymanager-flightdecode converts a dump to a Chrome trace.
+
+\subsection com_palm_activitymanager_devel_dump_flight_recorder_syntax Syntax:
+\code
+{
+    "name": string
+}
+\endcode
+
+\param name Name of the dump file.  Optional; by default the dump replaces
+            activitymanager.flight.  A name given here may not contain '/'
+            or start with '.', and must not already exist.
+
+\subsection com_palm_activitymanager_devel_dump_flight_recorder_returns Returns:
+\code
+{
+    "path": string,
+    "events": int,
+    "returnValue": boolean
+}
+\endcode
+
+\param path File the dump was written to.
+\param events Number of events written.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_dump_flight_recorder_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/dumpFlightRecorder '{ }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "path": "/var/log/activitymanager/activitymanager.flight",
+    "events": 4096,
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::DumpFlightRecorder(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("DumpFlightRecorder: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	MojString name;
+	bool found = false;
+	err = payload.get(_T("name"), name, found);
+	MojErrCheck(err);
+
+	bool replace = false;
+	if (!found || name.empty()) {
+		err = name.assign(FlightRecorder::DefaultDumpName);
+		MojErrCheck(err);
+		replace = true;
+	} else if (!DiagnosticFile::IsValidName(name.data())) {
+		err = msg->replyError(MojErrInvalidArg,
+			_T("\"name\" must be a plain file name"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	std::string path;
+	long events = FlightRecorder::Dump(name.data(), replace, path);
+	if (events < 0) {
+		err = msg->replyError(MojErrAccessDenied,
+			_T("Failed to write flight recorder dump"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = reply.putString(_T("path"), path.c_str());
+	MojErrCheck(err);
+
+	err = reply.putInt(_T("events"), (MojInt64)events);
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_connection_damping connectionDamping
+
+\e Private.
+
+com.palm.activitymanager/devel/connectionDamping
+
+Tune how the "internet", "wifi" and "wan" requirements and their confidence
+requirements ride out flapping connections.  A lost connection is reported
+only after it has stayed down for the hold-down time.  Each loss adds to the
+connection's flap penalty, which halves every half life; at the suppress
+limit the connection is reported down until the penalty decays below the
+reuse limit.  Confidence increases are reported at once, and decreases once
+they have lasted the confidence hold.  The current state of each connection
+is returned by "info".
+
+\subsection com_palm_activitymanager_devel_connection_damping_syntax Syntax:
+\code
+{
+    "holdDown": int,
+    "penalty": int,
+    "suppressLimit": int,
+    "reuseLimit": int,
+    "halfLife": int,
+    "maxSuppress": int,
+    "confidenceHold": int
+}
+\endcode
+
+\param holdDown Seconds a connection must stay down before its requirements
+                are unmet.  0 reports losses immediately.
+\param penalty Penalty added each time a connection is lost.  0 disables
+               suppression.
+\param suppressLimit Penalty at which a connection is suppressed.
+\param reuseLimit Penalty below which a suppressed connection is reported
+                  again.  Must be less than \e suppressLimit.
+\param halfLife Seconds for the penalty to halve.
+\param maxSuppress Longest a connection stays suppressed after its last
+                   loss, in seconds.
+\param confidenceHold Seconds a lower confidence level must last before it
+                      is reported.
+
+All parameters are optional; those not given are left unchanged.
+
+\subsection com_palm_activitymanager_devel_connection_damping_returns Returns:
+\code
+{
+    "holdDown": int,
+    "penalty": int,
+    "suppressLimit": int,
+    "reuseLimit": int,
+    "halfLife": int,
+    "maxSuppress": int,
+    "confidenceHold": int,
+    "returnValue": boolean
+}
+\endcode
+
+The returned values are the settings now in effect.
+
+\subsection com_palm_activitymanager_devel_connection_damping_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/connectionDamping '{ "holdDown": 0, "penalty": 0 }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "confidenceHold": 5,
+    "halfLife": 30,
+    "holdDown": 0,
+    "maxSuppress": 120,
+    "penalty": 0,
+    "returnValue": true,
+    "reuseLimit": 750,
+    "suppressLimit": 2500
+}
+\endcode
+
+Example response for a failed call:
+\code
+{
+    "errorCode": 22,
+    "errorText": "\"reuseLimit\" must be less than \"suppressLimit\"",
+    "returnValue": false
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::ConnectionDampingConfig(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("ConnectionDamping: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err = ConnectionDamping::ConfigFromJson(payload);
+	if (err == MojErrInvalidArg) {
+		err = msg->replyError(MojErrInvalidArg, _T("\"reuseLimit\" must be "
+			"less than \"suppressLimit\""));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojErrCheck(err);
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = ConnectionDamping::ConfigToJson(reply);
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_battery_updates batteryUpdates
+
+\e Private.
+
+com.palm.activitymanager/devel/batteryUpdates
+
+Set how often Activities whose "battery" requirement stays met are sent an
+update event for a change in the battery level.  Requirements are still met
+or unmet as soon as the level crosses their threshold.  The number of
+updates sent and skipped is in the "battery.updates" and
+"battery.updatesSkipped" metrics returned by "info".
+
+\subsection com_palm_activitymanager_devel_battery_updates_syntax Syntax:
+\code
+{
+    "step": int,
+    "interval": int
+}
+\endcode
+
+\param step Percent the battery level must move from the level last sent
+            before another update is sent.  Optional.
+\param interval Minimum seconds between updates.  Optional.
+
+A \e step and \e interval of 0 send an update for every change.
+
+\subsection com_palm_activitymanager_devel_battery_updates_returns Returns:
+\code
+{
+    "step": int,
+    "interval": int,
+    "returnValue": boolean
+}
+\endcode
+
+\param step Step now in effect.
+\param interval Interval now in effect.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_battery_updates_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/batteryUpdates '{ "step": 10 }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "interval": 60,
+    "returnValue": true,
+    "step": 10
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::BatteryUpdates(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("BatteryUpdates: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	MojUInt32 step = PowerdProxy::GetBatteryUpdateStep();
+	MojUInt32 interval = PowerdProxy::GetBatteryUpdateInterval();
+	bool found = false;
+
+	err = payload.get(_T("step"), step, found);
+	MojErrCheck(err);
+
+	err = payload.get(_T("interval"), interval, found);
+	MojErrCheck(err);
+
+	PowerdProxy::SetBatteryUpdatePolicy((unsigned)step, (unsigned)interval);
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = reply.putInt(_T("step"),
+		(MojInt64)PowerdProxy::GetBatteryUpdateStep());
+	MojErrCheck(err);
+
+	err = reply.putInt(_T("interval"),
+		(MojInt64)PowerdProxy::GetBatteryUpdateInterval());
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_power_debounce powerDebounce
+
+\e Private.
+
+com.palm.activitymanager/devel/powerDebounce
+
+Tune and inspect the predictor that picks how long power stays locked after
+an Activity with "powerDebounce" ends.  The predictor learns the gaps
+between powered Activities, overall and for each creator, and picks the
+delay with the lowest expected cost, counting a resume from suspend as
+\e wakeCost seconds awake.
+
+\subsection com_palm_activitymanager_devel_power_debounce_syntax Syntax:
+\code
+{
+    "enabled": boolean,
+    "wakeCost": int,
+    "maxDelay": int,
+    "minSamples": int,
+    "sampleHalfLife": int,
+    "reset": boolean
+}
+\endcode
+
+\param enabled False to always debounce for the fixed 12 seconds.
+\param wakeCost Cost of one resume, in seconds of staying awake.
+\param maxDelay Longest delay the predictor may pick, in seconds.
+\param minSamples Weight of observed gaps needed before a creator's own
+                  gaps, or the global gaps, are used.  Until then the fixed
+                  delay is used.
+\param sampleHalfLife Number of new gaps after which an old one counts for
+                      half as much.
+\param reset True to forget all learned gaps and performance.
+
+All parameters are optional.
+
+\subsection com_palm_activitymanager_devel_power_debounce_returns Returns:
+\code
+{
+    "config": object,
+    "performance": {
+        "decisions": int,
+        "hits": int,
+        "awakeSeconds": int,
+        "wastedSeconds": int,
+        "fixed": {
+            "delay": int,
+            "hits": int,
+            "awakeSeconds": int,
+            "wastedSeconds": int
+        }
+    },
+    "global": object,
+    "creators": object,
+    "returnValue": boolean
+}
+\endcode
+
+\param config Settings now in effect.
+\param performance How the delays picked when the power lock was released
+                   turned out against the next powered Activity: how many
+                   it arrived within (each a resume avoided), the seconds
+                   spent awake waiting, and the seconds spent awake for
+                   nothing.  "fixed" scores the fixed delay against the
+                   same arrivals.
+\param global Weight of gaps observed after the power lock was released,
+              by upper bound in seconds, with the delay the predictor
+              would pick and its expected cost.
+\param creators The same, for the gaps between each creator's Activities.
+\param returnValue Indicates if the call was succesful.
+
+\subsection com_palm_activitymanager_devel_power_debounce_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/powerDebounce '{ "wakeCost": 10 }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "config": {
+        "enabled": true,
+        "maxDelay": 32,
+        "minSamples": 4,
+        "sampleHalfLife": 16,
+        "wakeCost": 10
+    },
+    "creators": {
+        "serviceId:com.palm.smtp": {
+            "delay": 4,
+            "expectedCost": 5.2,
+            "gaps": {
+                "4": 6.1,
+                ">64": 1.8
+            },
+            "samples": 7.9
+        }
+    },
+    "global": {
+        "delay": 8,
+        "expectedCost": 6.9,
+        "gaps": {
+            "2": 3.4,
+            "8": 5.7,
+            "48": 2.1,
+            ">64": 4.3
+        },
+        "samples": 15.5
+    },
+    "performance": {
+        "awakeSeconds": 214,
+        "decisions": 41,
+        "fixed": {
+            "awakeSeconds": 331,
+            "delay": 12,
+            "hits": 24,
+            "wastedSeconds": 204
+        },
+        "hits": 22,
+        "wastedSeconds": 96
+    },
+    "returnValue": true
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::PowerDebounce(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("PowerDebounce: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err = DebouncePredictor::ConfigFromJson(payload);
+	if (err == MojErrInvalidArg) {
+		err = msg->replyError(MojErrInvalidArg,
+			_T("\"sampleHalfLife\" must be at least 1"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojErrCheck(err);
+
+	bool reset = false;
+	payload.get(_T("reset"), reset);
+	if (reset) {
+		DebouncePredictor::Reset();
+	}
+
+	MojObject reply(MojObject::TypeObject);
+
+	MojObject config(MojObject::TypeObject);
+	err = DebouncePredictor::ConfigToJson(config);
+	MojErrCheck(err);
+
+	err = reply.put(_T("config"), config);
+	MojErrCheck(err);
+
+	err = DebouncePredictor::ToJson(reply);
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_container_freezer containerFreezer
+
+\e Private.
+
+com.palm.activitymanager/devel/containerFreezer
+
+Configure and inspect the container freezer.  While enabled, every
+container at the "lowest" priority is frozen whenever a focused or
+immediate Activity is running, and thawed when none is.  A freeze never
+lasts longer than \e maxFreeze seconds; after any thaw the containers run
+for at least \e minThaw seconds before they can be frozen again.
+
+The freezer needs a Container Manager that supports freezing (cgroup v2).
+
+\subsection com_palm_activitymanager_devel_container_freezer_syntax Syntax:
+\code
+{
+    "enabled": boolean,
+    "maxFreeze": int,
+    "minThaw": int
+}
+\endcode
+
+\param enabled True to freeze the lowest priority containers.  Off by
+               default.
+\param maxFreeze Longest a freeze may last, in seconds.  At least 1.
+\param minThaw Shortest time the containers run between two freezes, in
+               seconds.
+
+All parameters are optional.
+
+\subsection com_palm_activitymanager_devel_container_freezer_returns Returns:
+\code
+{
+    "enabled": boolean,
+    "maxFreeze": int,
+    "minThaw": int,
+    "supported": boolean,
+    "foreground": boolean,
+    "frozen": boolean,
+    "frozenFor": int,
+    "returnValue": boolean,
+    "errorCode": int,
+    "errorText": string
+}
+\endcode
+
+\param enabled, maxFreeze, minThaw Settings now in effect.
+\param supported True if the Container Manager can freeze containers.
+\param foreground True if a focused or immediate Activity is running.
+\param frozen True if the lowest priority containers are frozen now.
+\param frozenFor Seconds since they were frozen.  Only present if frozen.
+\param returnValue Indicates if the call was succesful.
+\param errorCode Code for the error in case the call was not succesful.
+\param errorText Describes the error if the call was not succesful.
+
+\subsection com_palm_activitymanager_devel_container_freezer_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/containerFreezer '{ "enabled": true, "maxFreeze": 20 }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "enabled": true,
+    "foreground": true,
+    "frozen": true,
+    "frozenFor": 3,
+    "maxFreeze": 20,
+    "minThaw": 10,
+    "supported": true,
+    "returnValue": true
+}
+\endcode
+
+Example response for a failed call:
+\code
+{
+    "errorCode": 22,
+    "errorText": "\"maxFreeze\" must be at least 1",
+    "returnValue": false
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::ContainerFreezer(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("ContainerFreezer: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	if (!m_containerManager) {
+		err = msg->replyError(MojErrNotImplemented,
+			_T("Containers not implemented for this target"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	ContainerManager::FreezePolicy policy =
+		m_containerManager->GetFreezePolicy();
+
+	MojUInt32 maxFreeze = policy.m_maxFreeze;
+	MojUInt32 minThaw = policy.m_minThaw;
+	bool found = false;
+
+	payload.get(_T("enabled"), policy.m_enabled);
+
+	err = payload.get(_T("maxFreeze"), maxFreeze, found);
+	MojErrCheck(err);
+
+	err = payload.get(_T("minThaw"), minThaw, found);
+	MojErrCheck(err);
+
+	if (!maxFreeze) {
+		err = msg->replyError(MojErrInvalidArg,
+			_T("\"maxFreeze\" must be at least 1"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	policy.m_maxFreeze = (unsigned)maxFreeze;
+	policy.m_minThaw = (unsigned)minThaw;
+
+	m_containerManager->SetFreezePolicy(policy);
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = m_containerManager->FreezerToJson(reply);
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
+/*!
+\page com_palm_activitymanager_devel
+\n
+\section com_palm_activitymanager_devel_cpu_partition cpuPartition
+
+\e Private.
+
+com.palm.activitymanager/devel/cpuPartition
+
+Split the CPUs between the container priority classes.  Focused, highest
+and high priority containers are pinned to the \e performance cores; low,
+lowest and none to the \e efficiency cores; normal may use both.  The
+pinning follows each container's priority as it changes.
+
+On a cgroup v1 cpuset hierarchy, or a cgroup v2 one that delegates the
+cpuset controller, the classes' cpuset.cpus are rewritten.  Without a cgroup
+hierarchy, every thread of each mapped process is pinned with
+sched_setaffinity().
+
+\subsection com_palm_activitymanager_devel_cpu_partition_syntax Syntax:
+\code
+{
+    "performance": string,
+    "efficiency": string
+}
+\endcode
+
+\param performance CPU list in the kernel's format, e.g. "4-7".  An empty
+                   string leaves the classes that use it unpinned.
+\param efficiency CPU list, e.g. "0-3".
+
+All parameters are optional.  With both lists empty, partitioning is off.
+
+\subsection com_palm_activitymanager_devel_cpu_partition_returns Returns:
+\code
+{
+    "performance": string,
+    "efficiency": string,
+    "mode": string,
+    "returnValue": boolean,
+    "errorCode": int,
+    "errorText": string
+}
+\endcode
+
+\param performance, efficiency Settings now in effect.
+\param mode "cpuset" if the cpuset classes are used, "affinity" otherwise.
+\param returnValue Indicates if the call was succesful.
+\param errorCode Code for the error in case the call was not succesful.
+\param errorText Describes the error if the call was not succesful.
+
+\subsection com_palm_activitymanager_devel_cpu_partition_examples Examples:
+\code
+luna-send -n 1 -f luna://com.palm.activitymanager/devel/cpuPartition '{ "performance": "4-7", "efficiency": "0-3" }'
+\endcode
+
+Example response for a succesful call:
+\code
+{
+    "efficiency": "0-3",
+    "mode": "cpuset",
+    "performance": "4-7",
+    "returnValue": true
+}
+\endcode
+
+Example response for a failed call:
+\code
+{
+    "errorCode": 22,
+    "errorText": "CPU lists must be of the form \"0-3,6\"",
+    "returnValue": false
+}
+\endcode
+*/
+
+MojErr
+DevelCategoryHandler::CpuPartitionConfig(MojServiceMessage *msg,
+	MojObject& payload)
+{
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
+
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("CpuPartition: %s", MojoObjectJson(payload).c_str());
+
+	MojErr err;
+
+	if (!m_containerManager || !m_containerManager->GetCpuPartitionMode()) {
+		err = msg->replyError(MojErrNotImplemented,
+			_T("CPU partitioning not implemented for this target"));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	CpuPartition partition = m_containerManager->GetCpuPartition();
+
+	err = partition.FromJson(payload);
+	if (err == MojErrInvalidArg) {
+		err = msg->replyError(MojErrInvalidArg,
+			_T("CPU lists must be of the form \"0-3,6\""));
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojErrCheck(err);
+
+	m_containerManager->SetCpuPartition(partition);
+
+	MojObject reply(MojObject::TypeObject);
+
+	err = m_containerManager->CpuPartitionToJson(reply);
+	MojErrCheck(err);
+
+	err = msg->reply(reply);
+	MojErrCheck(err);
+
+	ACTIVITY_SERVICEMETHOD_END(msg);
+
+	return MojErrNone;
+}
+
 MojErr
 DevelCategoryHandler::LookupActivity(MojServiceMessage *msg, MojObject& payload, boost::shared_ptr<Activity>& act)
 {
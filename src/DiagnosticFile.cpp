@@ -0,0 +1,88 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+#include "DiagnosticFile.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+const char *DiagnosticFile::Directory = "/var/log/activitymanager";
+
+bool DiagnosticFile::IsValidName(const std::string& name)
+{
+	return !name.empty() && (name[0] != '.') &&
+		(name.find('/') == std::string::npos);
+}
+
+FILE *DiagnosticFile::Create(const std::string& name, bool replace,
+	std::string& path)
+{
+	path = std::string(Directory) + "/" + name;
+
+	if (!IsValidName(name)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if ((mkdir(Directory, 0700) < 0) && (errno != EEXIST)) {
+		return NULL;
+	}
+
+	/* Refuse a directory someone else could have put files or links in */
+	int dir = open(Directory, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (dir < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	if ((fstat(dir, &st) < 0) || (st.st_uid != geteuid()) ||
+		(st.st_mode & (S_IWGRP | S_IWOTH))) {
+		close(dir);
+		errno = EACCES;
+		return NULL;
+	}
+
+	if (replace && (unlinkat(dir, name.c_str(), 0) < 0) &&
+		(errno != ENOENT)) {
+		int saved = errno;
+		close(dir);
+		errno = saved;
+		return NULL;
+	}
+
+	int fd = openat(dir, name.c_str(),
+		O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	int saved = errno;
+	close(dir);
+
+	if (fd < 0) {
+		errno = saved;
+		return NULL;
+	}
+
+	FILE *file = fdopen(fd, "w");
+	if (!file) {
+		saved = errno;
+		close(fd);
+		errno = saved;
+	}
+
+	return file;
+}
@@ -0,0 +1,207 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "FlightRecorder.h"
+#include "ActivityTypes.h"
+#include "ActivityManager.h"
+#include "DiagnosticFile.h"
+#include "Logging.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+const char *FlightRecorder::DefaultDumpName = "activitymanager.flight";
+
+const char *FlightRecorder::ReasonNames[] = {
+	"none",
+	"command",
+	"schedule",
+	"scheduleDue",
+	"triggered",
+	"requirement",
+	"ready",
+	"run",
+	"start",
+	"powerLocked",
+	"powerUnlocked",
+	"callback",
+	"requeue",
+	"yield",
+	"restart",
+	"end",
+	"orphaned",
+	"adopted",
+	"unsubscribed",
+	"initialized",
+	"notReady",
+	"evicted",
+	"released"
+};
+
+FlightRecord				FlightRecorder::s_ring[Capacity];
+unsigned long long			FlightRecorder::s_next = 0;
+std::vector<std::string>	FlightRecorder::s_requirements;
+
+/* Requirement names beyond this many are recorded as the last entry */
+static const unsigned MaxRequirementNames = 64;
+
+static MojInt64 MonotonicUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((MojInt64)ts.tv_sec * 1000000LL) +
+		((MojInt64)ts.tv_nsec / 1000LL);
+}
+
+void FlightRecorder::Record(FlightEventType type, activityId_t id,
+	MojUInt8 from, MojUInt8 to, MojUInt16 reason, MojUInt32 arg)
+{
+	FlightRecord& record = s_ring[s_next & (Capacity - 1)];
+	s_next++;
+
+	record.m_time = MonotonicUs();
+	record.m_activity = id;
+	record.m_arg = arg;
+	record.m_reason = reason;
+	record.m_type = (MojUInt8)type;
+	record.m_from = from;
+	record.m_to = to;
+}
+
+MojUInt16 FlightRecorder::GetRequirementCode(const std::string& name)
+{
+	for (unsigned i = 0; i < s_requirements.size(); i++) {
+		if (s_requirements[i] == name) {
+			return (MojUInt16)i;
+		}
+	}
+
+	if (s_requirements.size() >= MaxRequirementNames) {
+		return (MojUInt16)(MaxRequirementNames - 1);
+	}
+
+	s_requirements.push_back(name);
+	return (MojUInt16)(s_requirements.size() - 1);
+}
+
+static bool WriteNames(FILE *file, const char * const *names, unsigned count)
+{
+	MojUInt32 n = count;
+	if (fwrite(&n, sizeof(n), 1, file) != 1) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		if (fwrite(names[i], strlen(names[i]) + 1, 1, file) != 1) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+long FlightRecorder::Dump(const std::string& name, bool replace,
+	std::string& path)
+{
+	FILE *file = DiagnosticFile::Create(name, replace, path);
+	if (!file) {
+		LOG_AM_ERROR(MSGID_FLIGHT_DUMP_FAIL, 2, PMLOGKS("path", path.c_str()),
+			PMLOGKS("error", strerror(errno)),
+			"Failed to open flight recorder dump file");
+		return -1;
+	}
+
+	unsigned long long count = (s_next < Capacity) ? s_next : Capacity;
+	unsigned long long first = s_next - count;
+
+	FlightDumpHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, "AMFLIGHT", sizeof(header.m_magic));
+	header.m_version = DumpVersion;
+	header.m_recordSize = sizeof(FlightRecord);
+	header.m_count = count;
+	header.m_dropped = first;
+	header.m_monotonic = MonotonicUs();
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	header.m_wall = ((MojInt64)ts.tv_sec * 1000000LL) +
+		((MojInt64)ts.tv_nsec / 1000LL);
+
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+	/* Oldest first; the ring wraps at most once */
+	unsigned start = (unsigned)(first & (Capacity - 1));
+	unsigned tail = (unsigned)((count < (Capacity - start)) ?
+		count : (Capacity - start));
+
+	if (ok && tail) {
+		ok = (fwrite(&s_ring[start], sizeof(FlightRecord), tail, file) ==
+			tail);
+	}
+
+	if (ok && (count > tail)) {
+		ok = (fwrite(&s_ring[0], sizeof(FlightRecord),
+			(size_t)(count - tail), file) == (count - tail));
+	}
+
+	std::vector<const char *> requirements;
+	for (unsigned i = 0; i < s_requirements.size(); i++) {
+		requirements.push_back(s_requirements[i].c_str());
+	}
+
+	ok = ok && WriteNames(file, ActivityStateNames, MaxActivityState) &&
+		WriteNames(file, ActivityManager::RunQueueNames,
+			ActivityManager::RunQueueMax) &&
+		WriteNames(file, ReasonNames, MaxFlightReason) &&
+		WriteNames(file, requirements.empty() ? NULL : &requirements[0],
+			(unsigned)requirements.size());
+
+	if ((fclose(file) != 0) || !ok) {
+		LOG_AM_ERROR(MSGID_FLIGHT_DUMP_FAIL, 2, PMLOGKS("path", path.c_str()),
+			PMLOGKS("error", strerror(errno)),
+			"Failed to write flight recorder dump");
+		return -1;
+	}
+
+	LOG_AM_DEBUG("Flight recorder: %llu events dumped to %s", count,
+		path.c_str());
+
+	return (long)count;
+}
+
+int FlightRecorder::SignalDump(void *data)
+{
+	std::string path;
+	Dump(DefaultDumpName, true, path);
+
+	/* Stay installed */
+	return TRUE;
+}
+
+void FlightRecorder::EnableSignalDump()
+{
+	g_unix_signal_add(SIGUSR2, (GSourceFunc)&FlightRecorder::SignalDump,
+		NULL);
+}
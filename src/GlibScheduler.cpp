@@ -38,11 +38,14 @@ void GlibScheduler::UpdateTimeout(time_t nextWakeup, time_t curTime)
 		(unsigned long long)nextWakeup,
 		(unsigned long long)curTime);
 
-	m_timeout = boost::make_shared<Timeout<GlibScheduler> >(
-		boost::dynamic_pointer_cast<GlibScheduler, Scheduler>(
-			shared_from_this()), (int)(nextWakeup - curTime),
-		&GlibScheduler::TimeoutCallback);
-	m_timeout->Arm();
+	if (!m_timeout) {
+		m_timeout = boost::make_shared<Timeout<GlibScheduler> >(
+			boost::dynamic_pointer_cast<GlibScheduler, Scheduler>(
+				shared_from_this()), (int)(nextWakeup - curTime),
+			&GlibScheduler::TimeoutCallback);
+	}
+
+	m_timeout->Arm((unsigned)(nextWakeup - curTime));
 }
 
 void GlibScheduler::CancelTimeout()
@@ -50,7 +53,7 @@ void GlibScheduler::CancelTimeout()
 	LOG_AM_TRACE("Scheduler timeout cancelled");
 
 	if (m_timeout) {
-		m_timeout.reset();
+		m_timeout->Cancel();
 	}
 }
 
@@ -58,8 +61,6 @@ void GlibScheduler::TimeoutCallback()
 {
 	LOG_AM_TRACE("Scheduler timeout callback");
 
-	m_timeout.reset();
-
 	Wake();
 }
 
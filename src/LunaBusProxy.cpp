@@ -106,6 +106,10 @@ void LunaBusProxy::ProcessBusUpdate(MojServiceMessage *msg,
 			return;
 		}
 
+		/* At boot this is every service on the bus; map them all at once */
+		ContainerManager::ContainerMappingVec mappings;
+		mappings.reserve(services.size());
+
 		for (MojObject::ConstArrayIterator iter = services.arrayBegin();
 			iter != services.arrayEnd(); ++iter) {
 			const MojObject& service = *iter;
@@ -146,14 +150,20 @@ void LunaBusProxy::ProcessBusUpdate(MojServiceMessage *msg,
 					LOG_AM_DEBUG("Restricted names found in list of equivalent names for service \"%s\"",
 						serviceName.data());
 				} else {
-					m_containerManager->MapContainer(busIdVec[0].GetId(),
-						busIdVec, (pid_t)pid);
+					mappings.push_back(ContainerManager::ContainerMapping());
+					ContainerManager::ContainerMapping& mapping =
+						mappings.back();
+					mapping.m_name = busIdVec[0].GetId();
+					mapping.m_ids.swap(busIdVec);
+					mapping.m_pid = (pid_t)pid;
 				}
 			} else {
 				LOG_AM_DEBUG("No valid names found for service \"%s\" while processing batch service status update",
 					serviceName.data());
 			}
 		}
+
+		m_containerManager->MapContainers(mappings);
 	}
 
 	if (response.contains(_T("connected"))) {
@@ -0,0 +1,402 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "MethodLatency.h"
+#include "MojoObjectWrapper.h"
+#include "MojoSubscription.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <exception>
+
+MethodLatency::MethodMap	MethodLatency::s_methods;
+
+MethodTimer		*MethodTimer::s_current = NULL;
+MethodPending	*MethodFinishTimer::s_finishing = NULL;
+
+LatencyHistogram::LatencyHistogram()
+	: m_count(0)
+	, m_max(0)
+{
+}
+
+unsigned LatencyHistogram::GetSlot(MojInt64 us)
+{
+	if (us < (MojInt64)(2 * SubBucketCount)) {
+		return (us < 0) ? 0 : (unsigned)us;
+	}
+
+	unsigned msb = 63 - __builtin_clzll((unsigned long long)us);
+	if (msb >= MaxValueBits) {
+		return SlotCount - 1;
+	}
+
+	unsigned shift = msb - SubBucketBits;
+	return (shift * SubBucketCount) + (unsigned)(us >> shift);
+}
+
+/* Midpoint of the range of values counted in a slot */
+MojInt64 LatencyHistogram::GetSlotValue(unsigned slot)
+{
+	if (slot < (2 * SubBucketCount)) {
+		return slot;
+	}
+
+	unsigned shift = (slot / SubBucketCount) - 1;
+	MojInt64 lower = (MojInt64)(slot - (shift * SubBucketCount)) << shift;
+
+	return lower + (((1LL << shift) - 1) / 2);
+}
+
+void LatencyHistogram::Record(MojInt64 us)
+{
+	if (m_slots.empty()) {
+		m_slots.resize(SlotCount, 0);
+	}
+
+	m_slots[GetSlot(us)]++;
+	m_count++;
+
+	if (us > m_max) {
+		m_max = us;
+	}
+}
+
+MojInt64 LatencyHistogram::GetPercentile(double percentile) const
+{
+	if (!m_count) {
+		return 0;
+	}
+
+	unsigned long long target = (unsigned long long)
+		ceil((percentile / 100.0) * (double)m_count);
+	if (target < 1) {
+		target = 1;
+	}
+
+	unsigned long long seen = 0;
+	for (unsigned slot = 0; slot < m_slots.size(); slot++) {
+		seen += m_slots[slot];
+		if (seen >= target) {
+			MojInt64 value = GetSlotValue(slot);
+			return (value > m_max) ? m_max : value;
+		}
+	}
+
+	return m_max;
+}
+
+void LatencyHistogram::Reset()
+{
+	std::fill(m_slots.begin(), m_slots.end(), 0);
+	m_count = 0;
+	m_max = 0;
+}
+
+MojErr LatencyHistogram::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	err = rep.putInt(_T("count"), (MojInt64)m_count);
+	MojErrCheck(err);
+
+	if (!m_count) {
+		return MojErrNone;
+	}
+
+	err = rep.putDecimal(_T("p50"),
+		MojDecimal((double)GetPercentile(50.0) / 1000.0));
+	MojErrCheck(err);
+
+	err = rep.putDecimal(_T("p99"),
+		MojDecimal((double)GetPercentile(99.0) / 1000.0));
+	MojErrCheck(err);
+
+	err = rep.putDecimal(_T("p999"),
+		MojDecimal((double)GetPercentile(99.9) / 1000.0));
+	MojErrCheck(err);
+
+	err = rep.putDecimal(_T("max"), MojDecimal((double)m_max / 1000.0));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MethodLatency::MethodLatency(const std::string& name)
+	: m_calls(Metrics::GetCounter("calls" + name))
+{
+}
+
+MethodLatency& MethodLatency::Get(MojServiceMessage *msg)
+{
+	std::string name = Metrics::GetMethodName(msg);
+
+	MethodMap::iterator found = s_methods.find(name);
+	if (found != s_methods.end()) {
+		return *found->second;
+	}
+
+	MethodLatency *method = new MethodLatency(name);
+	s_methods[name] = method;
+
+	return *method;
+}
+
+MojErr MethodLatency::AllToJson(MojObject& rep)
+{
+	MojErr err;
+
+	for (MethodMap::const_iterator iter = s_methods.begin();
+		iter != s_methods.end(); ++iter) {
+		MojObject method(MojObject::TypeObject);
+
+		err = iter->second->ToJson(method);
+		MojErrCheck(err);
+
+		err = rep.put(iter->first.c_str(), method);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+void MethodLatency::ResetAll()
+{
+	for (MethodMap::iterator iter = s_methods.begin();
+		iter != s_methods.end(); ++iter) {
+		iter->second->Reset();
+	}
+}
+
+MojErr MethodLatency::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	MojObject total(MojObject::TypeObject);
+	err = m_total.ToJson(total);
+	MojErrCheck(err);
+
+	err = rep.put(_T("total"), total);
+	MojErrCheck(err);
+
+	MojObject handler(MojObject::TypeObject);
+	err = m_handler.ToJson(handler);
+	MojErrCheck(err);
+
+	err = rep.put(_T("handler"), handler);
+	MojErrCheck(err);
+
+	/* Only methods that defer their reply have the other two phases */
+	if (m_persist.GetCount()) {
+		MojObject persist(MojObject::TypeObject);
+		err = m_persist.ToJson(persist);
+		MojErrCheck(err);
+
+		err = rep.put(_T("persist"), persist);
+		MojErrCheck(err);
+
+		MojObject finish(MojObject::TypeObject);
+		err = m_finish.ToJson(finish);
+		MojErrCheck(err);
+
+		err = rep.put(_T("finish"), finish);
+		MojErrCheck(err);
+	}
+
+	MojObject slowest(MojObject::TypeArray);
+	for (std::vector<Exemplar>::const_iterator iter = m_exemplars.begin();
+		iter != m_exemplars.end(); ++iter) {
+		MojObject exemplar(MojObject::TypeObject);
+
+		err = exemplar.putDecimal(_T("total"),
+			MojDecimal((double)iter->m_total / 1000.0));
+		MojErrCheck(err);
+
+		err = exemplar.putDecimal(_T("handler"),
+			MojDecimal((double)iter->m_handler / 1000.0));
+		MojErrCheck(err);
+
+		if (iter->m_persist) {
+			err = exemplar.putDecimal(_T("persist"),
+				MojDecimal((double)iter->m_persist / 1000.0));
+			MojErrCheck(err);
+		}
+
+		err = exemplar.putInt(_T("when"), (MojInt64)iter->m_when);
+		MojErrCheck(err);
+
+		err = exemplar.putString(_T("caller"), iter->m_caller.c_str());
+		MojErrCheck(err);
+
+		err = exemplar.putInt(_T("payloadSize"),
+			(MojInt64)iter->m_payloadSize);
+		MojErrCheck(err);
+
+		err = slowest.push(exemplar);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("slowest"), slowest);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MethodLatency::Reset()
+{
+	m_handler.Reset();
+	m_persist.Reset();
+	m_finish.Reset();
+	m_total.Reset();
+	m_exemplars.clear();
+}
+
+void MethodLatency::Completed(MojServiceMessage *msg, const MojObject& payload,
+	MojInt64 total, MojInt64 handler, MojInt64 persist)
+{
+	m_total.Record(total);
+
+	/* Only requests slower than every current exemplar cost anything more */
+	if ((m_exemplars.size() == ExemplarCount) &&
+		(total <= m_exemplars.back().m_total)) {
+		return;
+	}
+
+	Exemplar exemplar;
+	exemplar.m_total = total;
+	exemplar.m_handler = handler;
+	exemplar.m_persist = persist;
+	exemplar.m_when = time(NULL);
+	exemplar.m_payloadSize = strlen(MojoObjectJson(payload).c_str());
+
+	try {
+		exemplar.m_caller = MojoSubscription::GetBusId(msg).GetString();
+	} catch (...) {
+		exemplar.m_caller = "unknown";
+	}
+
+	std::vector<Exemplar>::iterator iter = m_exemplars.begin();
+	while ((iter != m_exemplars.end()) && (iter->m_total >= total)) {
+		++iter;
+	}
+
+	m_exemplars.insert(iter, exemplar);
+
+	if (m_exemplars.size() > ExemplarCount) {
+		m_exemplars.pop_back();
+	}
+}
+
+MethodTimer::MethodTimer(MethodLatency& method, MojServiceMessage *msg,
+	const MojObject& payload)
+	: m_method(method)
+	, m_msg(msg)
+	, m_payload(payload)
+	, m_start(Metrics::Now())
+	, m_outer(s_current)
+{
+	m_method.m_calls.Increment();
+	s_current = this;
+}
+
+MethodTimer::~MethodTimer()
+{
+	s_current = m_outer;
+
+	MojInt64 now = Metrics::Now();
+	MojInt64 elapsed = now - m_start;
+
+	m_method.m_handler.Record(elapsed);
+
+	/* If the handler returned without replying, the reply is waiting on
+	 * the persist chain and will be sent from the completion that captured
+	 * this request.  A handler leaving on an exception is replied to by the
+	 * envelope. */
+	if ((m_msg->numReplies() == 0) && !std::uncaught_exception()) {
+		if (m_pending) {
+			m_pending->m_handled = now;
+		}
+	} else {
+		m_method.Completed(m_msg, m_payload, elapsed, elapsed, 0);
+	}
+}
+
+boost::shared_ptr<MethodPending> MethodTimer::Capture(MojServiceMessage *msg)
+{
+	if (!s_current || (s_current->m_msg != msg)) {
+		return boost::shared_ptr<MethodPending>();
+	}
+
+	if (!s_current->m_pending) {
+		s_current->m_pending = boost::make_shared<MethodPending>();
+		s_current->m_pending->m_method = &s_current->m_method;
+		s_current->m_pending->m_msg = msg;
+		s_current->m_pending->m_received = s_current->m_start;
+		s_current->m_pending->m_handled = 0;
+	}
+
+	return s_current->m_pending;
+}
+
+MethodFinishTimer::Scope::Scope(
+	const boost::shared_ptr<MethodPending>& pending)
+	: m_outer(s_finishing)
+{
+	s_finishing = pending.get();
+}
+
+MethodFinishTimer::Scope::~Scope()
+{
+	s_finishing = m_outer;
+}
+
+MethodFinishTimer::MethodFinishTimer(MojServiceMessage *msg,
+	const MojObject& payload)
+	: m_msg(msg)
+	, m_payload(payload)
+	, m_start(Metrics::Now())
+	, m_pending(NULL)
+{
+	if (s_finishing && (s_finishing->m_msg == msg) &&
+		s_finishing->m_handled) {
+		m_pending = s_finishing;
+	}
+}
+
+MethodFinishTimer::~MethodFinishTimer()
+{
+	if (!m_pending) {
+		return;
+	}
+
+	MojInt64 now = Metrics::Now();
+	MethodLatency& method = *m_pending->m_method;
+
+	MojInt64 persist = m_start - m_pending->m_handled;
+
+	method.m_persist.Record(persist);
+	method.m_finish.Record(now - m_start);
+	method.Completed(m_msg, m_payload, now - m_pending->m_received,
+		m_pending->m_handled - m_pending->m_received, persist);
+
+	/* Only the first reply counts */
+	m_pending->m_handled = 0;
+}
@@ -0,0 +1,243 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "Metrics.h"
+#include "MojoBusMessage.h"
+
+#include <ctime>
+
+const MojInt64 MetricsHistogram::BucketLimits[] = {
+	1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 60000
+};
+
+Metrics::CounterMap		Metrics::s_counters;
+Metrics::GaugeMap		Metrics::s_gauges;
+Metrics::HistogramMap	Metrics::s_histograms;
+MojInt64				Metrics::s_resetTime = Metrics::Now();
+
+MetricsHistogram::MetricsHistogram()
+{
+	Reset();
+}
+
+void MetricsHistogram::Observe(MojInt64 us)
+{
+	if (us < 0) {
+		us = 0;
+	}
+
+	unsigned bucket = 0;
+	while ((bucket < (BucketCount - 1)) &&
+		(us > (BucketLimits[bucket] * 1000LL))) {
+		bucket++;
+	}
+
+	m_buckets[bucket]++;
+	m_count++;
+	m_sum += us;
+
+	if (us > m_max) {
+		m_max = us;
+	}
+}
+
+void MetricsHistogram::Reset()
+{
+	for (unsigned i = 0; i < BucketCount; i++) {
+		m_buckets[i] = 0;
+	}
+
+	m_count = 0;
+	m_sum = 0;
+	m_max = 0;
+}
+
+MojErr MetricsHistogram::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	err = rep.putInt(_T("count"), (MojInt64)m_count);
+	MojErrCheck(err);
+
+	if (!m_count) {
+		return MojErrNone;
+	}
+
+	err = rep.putDecimal(_T("meanMs"),
+		MojDecimal((double)m_sum / (double)m_count / 1000.0));
+	MojErrCheck(err);
+
+	err = rep.putDecimal(_T("maxMs"), MojDecimal((double)m_max / 1000.0));
+	MojErrCheck(err);
+
+	/* Only the buckets that have samples, keyed by their upper limit */
+	MojObject buckets(MojObject::TypeObject);
+	for (unsigned i = 0; i < BucketCount; i++) {
+		if (!m_buckets[i]) {
+			continue;
+		}
+
+		MojString key;
+		if (i < (BucketCount - 1)) {
+			err = key.format(_T("%lld"), (long long)BucketLimits[i]);
+		} else {
+			err = key.assign(_T("inf"));
+		}
+		MojErrCheck(err);
+
+		err = buckets.putInt(key.data(), (MojInt64)m_buckets[i]);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("buckets"), buckets);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MetricsCounter& Metrics::GetCounter(const std::string& name)
+{
+	return s_counters[name];
+}
+
+MetricsGauge& Metrics::GetGauge(const std::string& name)
+{
+	return s_gauges[name];
+}
+
+MetricsHistogram& Metrics::GetHistogram(const std::string& name)
+{
+	return s_histograms[name];
+}
+
+std::string Metrics::GetMethodName(MojServiceMessage *msg)
+{
+	std::string name;
+
+	try {
+		const MojChar *category = MojoBusMessage::GetCategory(msg);
+		if (category && (category[0] != '\0') &&
+			!((category[0] == '/') && (category[1] == '\0'))) {
+			name += category;
+		}
+	} catch (...) {
+		/* Counted against the root category */
+	}
+
+	const MojChar *method = msg->method();
+
+	name += "/";
+	name += method ? method : "";
+
+	return name;
+}
+
+MojInt64 Metrics::Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((MojInt64)ts.tv_sec * 1000000LL) +
+		((MojInt64)ts.tv_nsec / 1000LL);
+}
+
+MojErr Metrics::ToJson(MojObject& rep)
+{
+	MojErr err;
+
+	double elapsed = (double)(Now() - s_resetTime) / 1000000.0;
+
+	err = rep.putDecimal(_T("elapsed"), MojDecimal(elapsed));
+	MojErrCheck(err);
+
+	MojObject counters(MojObject::TypeObject);
+	for (CounterMap::const_iterator iter = s_counters.begin();
+		iter != s_counters.end(); ++iter) {
+		MojObject counter(MojObject::TypeObject);
+
+		err = counter.putInt(_T("count"), (MojInt64)iter->second.GetValue());
+		MojErrCheck(err);
+
+		if (elapsed > 0.0) {
+			err = counter.putDecimal(_T("rate"), MojDecimal(
+				(double)iter->second.GetValue() / elapsed));
+			MojErrCheck(err);
+		}
+
+		err = counters.put(iter->first.c_str(), counter);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("counters"), counters);
+	MojErrCheck(err);
+
+	MojObject gauges(MojObject::TypeObject);
+	for (GaugeMap::const_iterator iter = s_gauges.begin();
+		iter != s_gauges.end(); ++iter) {
+		MojObject gauge(MojObject::TypeObject);
+
+		err = gauge.putInt(_T("value"), iter->second.GetValue());
+		MojErrCheck(err);
+
+		err = gauge.putInt(_T("high"), iter->second.GetHigh());
+		MojErrCheck(err);
+
+		err = gauges.put(iter->first.c_str(), gauge);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("gauges"), gauges);
+	MojErrCheck(err);
+
+	MojObject histograms(MojObject::TypeObject);
+	for (HistogramMap::const_iterator iter = s_histograms.begin();
+		iter != s_histograms.end(); ++iter) {
+		MojObject histogram(MojObject::TypeObject);
+
+		err = iter->second.ToJson(histogram);
+		MojErrCheck(err);
+
+		err = histograms.put(iter->first.c_str(), histogram);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("histograms"), histograms);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void Metrics::Reset()
+{
+	for (CounterMap::iterator iter = s_counters.begin();
+		iter != s_counters.end(); ++iter) {
+		iter->second.Reset();
+	}
+
+	for (GaugeMap::iterator iter = s_gauges.begin();
+		iter != s_gauges.end(); ++iter) {
+		iter->second.Reset();
+	}
+
+	for (HistogramMap::iterator iter = s_histograms.begin();
+		iter != s_histograms.end(); ++iter) {
+		iter->second.Reset();
+	}
+
+	s_resetTime = Now();
+}
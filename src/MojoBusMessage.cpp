@@ -0,0 +1,99 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "MojoBusMessage.h"
+
+#include <stdexcept>
+#include <luna/MojLunaMessage.h>
+
+static LocalBusMessage *GetLocalBusMessage(MojServiceMessage *msg)
+{
+	LocalBusMessage *localMsg = dynamic_cast<LocalBusMessage *>(msg);
+	if (!localMsg) {
+		throw std::runtime_error("Message did not originate from the "
+			"Luna Bus");
+	}
+
+	return localMsg;
+}
+
+bool MojoBusMessage::IsBusMessage(MojServiceMessage *msg)
+{
+	return (dynamic_cast<MojLunaMessage *>(msg) != NULL) ||
+		(dynamic_cast<LocalBusMessage *>(msg) != NULL);
+}
+
+bool MojoBusMessage::IsPublic(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->isPublic();
+	}
+
+	return GetLocalBusMessage(msg)->IsPublic();
+}
+
+const MojChar *MojoBusMessage::GetAppId(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->appId();
+	}
+
+	return GetLocalBusMessage(msg)->GetAppId();
+}
+
+const MojChar *MojoBusMessage::GetSenderId(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->senderId();
+	}
+
+	return GetLocalBusMessage(msg)->GetSenderId();
+}
+
+const MojChar *MojoBusMessage::GetSenderAddress(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->senderAddress();
+	}
+
+	return GetLocalBusMessage(msg)->GetSenderAddress();
+}
+
+const MojChar *MojoBusMessage::GetCategory(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->category();
+	}
+
+	return GetLocalBusMessage(msg)->GetCategory();
+}
+
+const MojChar *MojoBusMessage::GetMethod(MojServiceMessage *msg)
+{
+	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
+	if (lunaMsg) {
+		return lunaMsg->method();
+	}
+
+	return GetLocalBusMessage(msg)->GetMethod();
+}
@@ -18,8 +18,11 @@
 
 #include <stdexcept>
 #include <luna/MojLunaMessage.h>
+#include <luna/MojLunaService.h>
 
 #include "MojoCall.h"
+#include "MojoBusMessage.h"
+#include "WorkloadRecorder.h"
 #include "Activity.h"
 #include "Logging.h"
 
@@ -92,15 +95,29 @@ MojErr MojoCall::Call(bool usePublicBus, const char *proxyRequester)
 	MojRefCountedPtr<MojServiceRequest> req;
 
 	MojLunaService *service = dynamic_cast<MojLunaService *>(m_service);
-	if (!service) {
-		throw std::runtime_error("Service for call is not a Luna Service");
-	}
-
-	if (proxyRequester) {
-		err = service->createRequest(req, usePublicBus, proxyRequester);
+	LocalBusService *localService;
+	if (service) {
+		if (proxyRequester) {
+			err = service->createRequest(req, usePublicBus, proxyRequester);
+			MojErrCheck(err);
+		} else {
+			err = service->createRequest(req, usePublicBus);
+			MojErrCheck(err);
+		}
+	} else if ((localService = dynamic_cast<LocalBusService *>(m_service))) {
+		err = localService->createRequest(req, usePublicBus, proxyRequester);
 		MojErrCheck(err);
+	} else if (usePublicBus || proxyRequester) {
+		/* Making the call anyway would put it on the wrong bus, or make it
+		 * as the Activity Manager rather than on the Activity's behalf */
+		LOG_AM_ERROR(MSGID_CALL_IDENTITY_UNSUPPORTED, 3,
+			PMLOGKFV("serial", "%u", m_serial),
+			PMLOGKS("Url", m_url.GetString().c_str()),
+			PMLOGKS("requester", proxyRequester ? proxyRequester : ""),
+			"Service can't make public bus or proxied requests");
+		return MojErrNotImplemented;
 	} else {
-		err = service->createRequest(req, usePublicBus);
+		err = m_service->createRequest(req);
 		MojErrCheck(err);
 	}
 
@@ -142,6 +159,12 @@ void MojoCall::HandleResponseWrapper(MojServiceMessage *msg, MojObject& response
 	LOG_AM_DEBUG("[Call %u] %s: Received response %s", m_serial,
 		m_url.GetString().c_str(), MojoObjectJson(response).c_str());
 
+	/* Subscription updates are part of the workload; one-shot replies are
+	 * not, as a replay's services answer those themselves. */
+	if ((m_replies != 1) && WorkloadRecorder::IsRecording()) {
+		WorkloadRecorder::RecordSignal(m_url, m_params, response, err);
+	}
+
 	/* XXX If response count reached, cancel call. */
 	try {
 		HandleResponse(msg, response, err);
@@ -166,15 +189,14 @@ bool MojoCall::IsPermanentFailure(MojServiceMessage *msg, const MojObject& respo
 		return err;
 	}
 
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
+	if (!MojoBusMessage::IsBusMessage(msg)) {
 		LOG_AM_ERROR(MSGID_NON_LUNA_BUS_MSG, 0, "IsPermanentFailure() : Message %s did not originate from the Luna Bus",
 			  MojoObjectJson(response).c_str());
 		throw std::runtime_error("Message did not originate from the "
 			"Luna Bus");
 	}
 
-	const MojChar *method = lunaMsg->method();
+	const MojChar *method = MojoBusMessage::GetMethod(msg);
 	if (!method)
 		return false;
 	else if (!strcmp(method, LUNABUS_ERROR_PERMISSION_DENIED))
@@ -192,18 +214,17 @@ bool MojoCall::IsProtocolError(MojServiceMessage *msg, const MojObject& response
 	if (err == MojErrNone)
 		return false;
 
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
+	if (!MojoBusMessage::IsBusMessage(msg)) {
 		LOG_AM_ERROR(MSGID_NON_LUNA_BUS_MSG, 0, "IsProtocolError() : Message %s did not originate from the Luna Bus",
 			  MojoObjectJson(response).c_str());
 		throw std::runtime_error("Message did not originate from the Luna Bus");
 	}
 
-	const MojChar *category = lunaMsg->category();
+	const MojChar *category = MojoBusMessage::GetCategory(msg);
 	if (!category) {
 		return false;
 	} else {
-		return (!strcmp(LUNABUS_ERROR_CATEGORY, lunaMsg->category()));
+		return (!strcmp(LUNABUS_ERROR_CATEGORY, category));
 	}
 }
 
@@ -20,6 +20,8 @@
 #include "MojoTrigger.h"
 #include "Activity.h"
 #include "ActivityJson.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include "Logging.h"
 
 MojoCallback::MojoCallback(boost::shared_ptr<Activity> activity,
@@ -28,6 +30,7 @@ MojoCallback::MojoCallback(boost::shared_ptr<Activity> activity,
 	, m_service(service)
 	, m_url(url)
 	, m_params(params)
+	, m_called(0)
 {
 }
 
@@ -66,6 +69,12 @@ MojErr MojoCallback::Call()
 			m_service, m_url, params);
 	m_call->Call();
 
+	static MetricsCounter& s_calls = Metrics::GetCounter("callbacks.calls");
+	s_calls.Increment();
+	m_called = Metrics::Now();
+
+	AM_PROBE2(callback_call, activity->GetId(), GetSerial());
+
 	return MojErrNone;
 }
 
@@ -109,12 +118,31 @@ void MojoCallback::HandleResponse(MojServiceMessage *msg,
 		m_activity.lock()->GetId(), m_url.GetString().c_str(),
 		MojoObjectJson(rep).c_str());
 
+	static MetricsHistogram& s_latency =
+		Metrics::GetHistogram("callbacks.latency");
+	static MetricsCounter& s_transient =
+		Metrics::GetCounter("callbacks.failedTransient");
+	static MetricsCounter& s_permanent =
+		Metrics::GetCounter("callbacks.failedPermanent");
+
+	MojInt64 latency = 0;
+	if (m_called) {
+		latency = Metrics::Now() - m_called;
+		s_latency.Observe(latency);
+		m_called = 0;
+	}
+
+	AM_PROBE4(callback_response, m_activity.lock()->GetId(), GetSerial(),
+		(int)err, latency);
+
 	/* All non-bus failures in a callback should be considered permanent
 	 * failures. */
 	if (err) {
 		if (MojoCall::IsPermanentFailure(msg, rep, err)) {
+			s_permanent.Increment();
 			Failed(PermanentFailure);
 		} else {
+			s_transient.Increment();
 			Failed(TransientFailure);
 		}
 	} else {
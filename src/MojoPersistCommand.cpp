@@ -21,6 +21,8 @@
 #include "Completion.h"
 #include "Activity.h"
 #include "MojoObjectWrapper.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include "Logging.h"
 
 #include <stdexcept>
@@ -55,6 +57,10 @@ void MojoPersistCommand::Persist()
 	LOG_AM_DEBUG("[Activity %llu] [PersistCommand %s]: Issuing",
 		m_activity->GetId(), GetString().c_str());
 
+	Issued();
+
+	AM_PROBE1(persist_issue, m_activity->GetId());
+
 	/* Perform update of Parameters, if desired - modify copy, not original,
 	 * to ensure old data isn't retained between calls */
 	try {
@@ -94,6 +100,11 @@ void MojoPersistCommand::PersistResponse(MojServiceMessage *msg,
 			LOG_AM_WARNING(MSGID_PERSIST_CMD_TRANSIENT_ERR, 2, PMLOGKFV("activity","%llu",m_activity->GetId()),
 				    PMLOGKS("persist_command",GetString().c_str()), "Failed with transient error, retrying: %s",
 				    MojoObjectJson(response).c_str());
+
+			static MetricsCounter& s_retries =
+				Metrics::GetCounter("persist.retries");
+			s_retries.Increment();
+
 			m_call->Call();
 		}
 	} else {
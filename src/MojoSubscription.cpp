@@ -17,11 +17,13 @@
 // LICENSE@@@
 
 #include "MojoSubscription.h"
+#include "MojoBusMessage.h"
 #include "Activity.h"
 #include "Logging.h"
 
 #include <luna/MojLunaMessage.h>
 #include <stdexcept>
+#include <cstring>
 
 MojoSubscription::MojoSubscription(boost::shared_ptr<Activity> activity,
 	bool detailedEvents, MojServiceMessage *msg)
@@ -95,26 +97,7 @@ MojErr MojoSubscription::SendEvent(ActivityEvent_t event)
 
 std::string MojoSubscription::GetSubscriberString(MojServiceMessage *msg)
 {
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
-		throw std::runtime_error("Can't generate subscriber string from "
-			"non-Luna message");
-	}
-
-	const char *appId = lunaMsg->appId();
-	if (appId) {
-		std::string appIdFixed(appId);
-		FixAppId(appIdFixed);
-		return BusId::GetString(appIdFixed, BusApp);
-	} else {
-		const char *serviceId = lunaMsg->senderId();
-		if (serviceId) {
-			return BusId::GetString(serviceId, BusService);
-		} else {
-			return BusId::GetString(lunaMsg->senderAddress(),
-				BusAnon);
-		}
-	}
+	return GetBusId(msg).GetString();
 }
 
 std::string MojoSubscription::GetSubscriberString(
@@ -123,28 +106,37 @@ std::string MojoSubscription::GetSubscriberString(
 	return GetSubscriberString(msg.get());
 }
 
+static BusId SenderBusId(const char *appId, const char *serviceId,
+	const char *address)
+{
+	if (appId) {
+		/* Only the portion up to the first space is the app id */
+		return BusId(appId, strcspn(appId, " "), BusApp);
+	} else if (serviceId) {
+		return BusId(serviceId, BusService);
+	} else {
+		return BusId(address, BusAnon);
+	}
+}
+
+/* Called on every request, so a Luna message costs a single cast.  (Each
+ * MojoSubscription looks its subscriber up only once, in MojoSubscriber.) */
 BusId MojoSubscription::GetBusId(MojServiceMessage *msg)
 {
 	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
+	if (lunaMsg) {
+		return SenderBusId(lunaMsg->appId(), lunaMsg->senderId(),
+			lunaMsg->senderAddress());
+	}
+
+	LocalBusMessage *localMsg = dynamic_cast<LocalBusMessage *>(msg);
+	if (!localMsg) {
 		throw std::runtime_error("Can't generate subscriber string from "
 			"non-Luna message");
 	}
 
-	const char *appId = lunaMsg->appId();
-	if (appId) {
-		std::string appIdFixed(appId);
-		FixAppId(appIdFixed);
-		return BusId(appIdFixed, BusApp);
-	} else {
-		const char *serviceId = lunaMsg->senderId();
-		if (serviceId) {
-			return BusId(serviceId, BusService);
-		} else {
-			return BusId(lunaMsg->senderAddress(),
-				BusAnon);
-		}
-	}
+	return SenderBusId(localMsg->GetAppId(), localMsg->GetSenderId(),
+		localMsg->GetSenderAddress());
 }
 
 BusId MojoSubscription::GetBusId(MojRefCountedPtr<MojServiceMessage> msg)
@@ -152,14 +144,6 @@ BusId MojoSubscription::GetBusId(MojRefCountedPtr<MojServiceMessage> msg)
 	return GetBusId(msg.get());
 }
 
-void MojoSubscription::FixAppId(std::string& appId)
-{
-	size_t firstSpace = appId.find_first_of(' ');
-	if (firstSpace != std::string::npos) {
-		appId.resize(firstSpace);
-	}
-}
-
 void MojoSubscription::HandleCancel()
 {
 	m_msg.reset();
@@ -191,26 +175,7 @@ MojErr MojoSubscription::MojoCancelHandler::HandleCancel(
 
 MojoSubscription::MojoSubscriber::MojoSubscriber(MojServiceMessage *msg)
 {
-	MojLunaMessage *lunaMsg = dynamic_cast<MojLunaMessage *>(msg);
-	if (!lunaMsg) {
-		throw std::runtime_error("Can't generate subscriber from non-Luna "
-			"message");
-	}
-
-	const char *appId = lunaMsg->appId();
-	if (appId) {
-		std::string appIdFixed(appId);
-		MojoSubscription::FixAppId(appIdFixed);
-		m_id = BusId(appIdFixed, BusApp);
-	} else {
-		const char *serviceId = lunaMsg->senderId();
-
-		if (serviceId) {
-			m_id = BusId(serviceId, BusService);
-		} else {
-			m_id = BusId(lunaMsg->senderAddress(), BusAnon);
-		}
-	}
+	m_id = MojoSubscription::GetBusId(msg);
 }
 
 MojoSubscription::MojoSubscriber::~MojoSubscriber()
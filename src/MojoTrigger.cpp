@@ -21,6 +21,8 @@
 #include "MojoMatcher.h"
 #include "Activity.h"
 #include "ActivityJson.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include "Logging.h"
 
 #include <stdexcept>
@@ -132,6 +134,11 @@ void MojoExclusiveTrigger::Fire()
 	LOG_AM_DEBUG("[Activity %llu] Trigger firing",
 		m_activity.lock()->GetId());
 
+	static MetricsCounter& s_fired = Metrics::GetCounter("triggers.fired");
+	s_fired.Increment();
+
+	AM_PROBE1(trigger_fire, m_activity.lock()->GetId());
+
 	m_triggered = true;
 	m_subscription->Unsubscribe();
 	m_activity.lock()->Triggered(shared_from_this());
@@ -19,6 +19,7 @@
 #include "MojoTriggerSubscription.h"
 #include "MojoTrigger.h"
 #include "MojoCall.h"
+#include "Metrics.h"
 
 MojLogger MojoTriggerSubscription::s_log(_T("activitymanager.triggersubscription"));
 
@@ -66,8 +67,16 @@ bool MojoTriggerSubscription::IsSubscribed() const
 void MojoTriggerSubscription::ProcessResponse(MojServiceMessage *msg,
 	const MojObject& response, MojErr err)
 {
+	static MetricsCounter& s_responses =
+		Metrics::GetCounter("triggers.responses");
+	s_responses.Increment();
+
 	if (err != MojErrNone) {
 		if (!MojoCall::IsPermanentFailure(msg, response, err)) {
+			static MetricsCounter& s_resubscribes =
+				Metrics::GetCounter("triggers.resubscribes");
+			s_resubscribes.Increment();
+
 			m_call->Call();
 			return;
 		}
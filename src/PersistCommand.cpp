@@ -20,6 +20,9 @@
 #include "PersistToken.h"
 #include "Completion.h"
 #include "Activity.h"
+#include "Metrics.h"
+#include "FlightRecorder.h"
+#include "Probes.h"
 #include "Logging.h"
 
 #include <stdexcept>
@@ -30,11 +33,19 @@ PersistCommand::PersistCommand(boost::shared_ptr<Activity> activity,
 	boost::shared_ptr<Completion> completion)
 	: m_activity(activity)
 	, m_completion(completion)
+	, m_issued(0)
+	, m_counted(false)
 {
 }
 
+/* A command cancelled, or dropped with its Activity, never completes */
 PersistCommand::~PersistCommand()
 {
+	if (m_counted) {
+		static MetricsGauge& s_outstanding =
+			Metrics::GetGauge("persist.outstanding");
+		s_outstanding.Add(-1);
+	}
 }
 
 boost::shared_ptr<Activity> PersistCommand::GetActivity()
@@ -78,10 +89,50 @@ void PersistCommand::Append(boost::shared_ptr<PersistCommand> command)
 	target->m_next = command;
 }
 
+void PersistCommand::Issued()
+{
+	static MetricsCounter& s_issued = Metrics::GetCounter("persist.issued");
+	static MetricsGauge& s_outstanding =
+		Metrics::GetGauge("persist.outstanding");
+
+	s_issued.Increment();
+	if (!m_counted) {
+		s_outstanding.Add(1);
+		m_counted = true;
+	}
+	m_issued = Metrics::Now();
+}
+
 void PersistCommand::Complete(bool success)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
+	if (m_issued) {
+		static MetricsHistogram& s_latency =
+			Metrics::GetHistogram("persist.latency");
+		static MetricsCounter& s_failed =
+			Metrics::GetCounter("persist.failed");
+
+		MojInt64 latency = Metrics::Now() - m_issued;
+
+		s_latency.Observe(latency);
+		AM_PROBE3(persist_complete, m_activity->GetId(), success, latency);
+		FlightRecorder::Record(FlightPersistEvent, m_activity->GetId(), 0,
+			success ? 1 : 0, FlightReasonNone, (MojUInt32)(latency / 1000));
+		if (!success) {
+			s_failed.Increment();
+		}
+
+		m_issued = 0;
+	}
+
+	if (m_counted) {
+		static MetricsGauge& s_outstanding =
+			Metrics::GetGauge("persist.outstanding");
+		s_outstanding.Add(-1);
+		m_counted = false;
+	}
+
 	/* All steps of Complete must execute, including launching the next
 	 * command in the chain.  All exceptions must be handled locally. */
 	try {
@@ -0,0 +1,500 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "PowerdPowerLock.h"
+#include "PowerdPowerActivity.h"
+#include "DebouncePredictor.h"
+#include "Activity.h"
+#include "Clock.h"
+#include "MojoCall.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#ifdef ACTIVITYMANAGER_RENEW_POWER_ACTIVITIES
+const int PowerdPowerLock::PowerActivityLockDuration = 300;
+const int PowerdPowerLock::PowerActivityLockUpdateInterval = 240;
+#else
+/* Renewed ahead of expiry, so a holder that arrived just before a renewal
+ * is still covered from the moment it arrived */
+const int PowerdPowerLock::PowerActivityLockDuration = 900;
+const int PowerdPowerLock::PowerActivityLockUpdateInterval = 840;
+#endif
+
+const int PowerdPowerLock::PowerActivityDebounceDuration = 12;
+
+const char *PowerdPowerLock::RemotePowerActivityName = "am:activitymanager";
+
+static void CountCall()
+{
+	static MetricsCounter& s_calls = Metrics::GetCounter("power.calls");
+	s_calls.Increment();
+}
+
+static void CountCallsSaved(unsigned long long n)
+{
+	static MetricsCounter& s_saved = Metrics::GetCounter("power.callsSaved");
+	s_saved.Increment(n);
+}
+
+PowerdPowerLock::PowerdPowerLock(MojService *service)
+	: m_service(service)
+	, m_remoteState(RemoteUnlocked)
+	, m_holders(0)
+	, m_acquiredSinceLock(false)
+	, m_debouncing(false)
+	, m_debounceUntil(0)
+	, m_calls(0)
+	, m_callsSaved(0)
+{
+}
+
+PowerdPowerLock::~PowerdPowerLock()
+{
+	if (m_remoteState != RemoteUnlocked) {
+		LOG_AM_DEBUG("Power lock destroyed while %s with %u holders",
+			RemoteStateToString(m_remoteState), m_holders);
+	}
+}
+
+void PowerdPowerLock::Acquire(boost::shared_ptr<PowerdPowerActivity> holder)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	m_holders++;
+	m_acquiredSinceLock = true;
+
+	DebouncePredictor::NoteAcquire(
+		holder->GetActivity()->GetCreator().GetString(),
+		Clock::GetInstance().GetMonotonicTime());
+
+	/* Back before its release was confirmed; the release is moot */
+	Remove(m_unlocking, holder);
+
+	LOG_AM_DEBUG("Power lock acquired by serial %lu, %u holders, %s",
+		holder->GetSerial(), m_holders, RemoteStateToString(m_remoteState));
+
+	if (m_remoteState == RemoteLocked) {
+		m_callsSaved++;
+		CountCallsSaved(1);
+
+		holder->LockAcquired();
+		return;
+	}
+
+	if (m_remoteState == RemoteLocking) {
+		m_callsSaved++;
+		CountCallsSaved(1);
+	}
+
+	m_locking.push_back(holder);
+	Sync();
+}
+
+void PowerdPowerLock::Release(boost::shared_ptr<PowerdPowerActivity> holder,
+	bool debounce)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!m_holders) {
+		LOG_AM_DEBUG("Power lock released by serial %lu with no holders",
+			holder->GetSerial());
+		holder->LockReleased();
+		return;
+	}
+
+	m_holders--;
+
+	/* Left before the lock was confirmed; it won't be told it was */
+	Remove(m_locking, holder);
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+
+	if (debounce) {
+		std::string creator =
+			holder->GetActivity()->GetCreator().GetString();
+
+		time_t until = now + DebouncePredictor::Predict(creator);
+		if (!m_debouncing || (until > m_debounceUntil)) {
+			m_debouncing = true;
+			m_debounceUntil = until;
+		}
+
+		DebouncePredictor::NoteRelease(creator, now);
+	}
+
+	LOG_AM_DEBUG("Power lock released by serial %lu%s, %u holders, %s",
+		holder->GetSerial(), debounce ? " with debounce" : "", m_holders,
+		RemoteStateToString(m_remoteState));
+
+	if (m_holders) {
+		m_callsSaved++;
+		CountCallsSaved(1);
+
+		holder->LockReleased();
+		return;
+	}
+
+	bool debounced = m_debouncing && (m_debounceUntil >= now);
+	DebouncePredictor::NoteLockFree(now, debounced,
+		debounced ? (unsigned)(m_debounceUntil - now) : 0);
+
+	m_unlocking.push_back(holder);
+	Sync();
+}
+
+MojErr PowerdPowerLock::ToJson(MojObject& rep) const
+{
+	MojErr err;
+
+	err = rep.putString(_T("state"), RemoteStateToString(m_remoteState));
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("holders"), (MojInt64)m_holders);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("calls"), (MojInt64)m_calls);
+	MojErrCheck(err);
+
+	err = rep.putInt(_T("callsSaved"), (MojInt64)m_callsSaved);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void PowerdPowerLock::Sync()
+{
+	if (m_call) {
+		return;
+	}
+
+	MojErr err;
+
+	if (m_holders) {
+		if (m_remoteState == RemoteLocked) {
+			return;
+		}
+
+		m_remoteState = RemoteLocking;
+
+		err = IssueLock();
+		if (err) {
+			LOG_AM_ERROR(MSGID_PWR_LOCK_CREATE_FAIL, 1,
+				PMLOGKFV("holders", "%u", m_holders),
+				"Failed to issue command to create power lock");
+
+			/* Fake it so the Activities don't stall */
+			LOG_AM_WARNING(MSGID_PWR_LOCK_FAKE_NOTI, 1,
+				PMLOGKFV("holders", "%u", m_holders),
+				"Faking power locked notification");
+
+			m_remoteState = RemoteLocked;
+			NotifyLocked();
+		}
+	} else {
+		if (m_remoteState == RemoteUnlocked) {
+			NotifyUnlocked();
+			return;
+		}
+
+		m_remoteState = RemoteUnlocking;
+
+		err = IssueUnlock();
+		if (err) {
+			LOG_AM_ERROR(MSGID_PWR_UNLOCK_CREATE_FAIL, 0,
+				"Failed to issue command to remove power lock");
+
+			/* Fake it so the Activity doesn't stall - the lock will fall
+			 * off on its own... not that that's a good thing, but better
+			 * than nothing. */
+			LOG_AM_WARNING(MSGID_PWR_UNLOCK_FAKE_NOTI, 0,
+				"Faking power unlocked notification");
+
+			m_remoteState = RemoteUnlocked;
+			m_debouncing = false;
+			m_timeout.reset();
+			NotifyUnlocked();
+		}
+	}
+}
+
+MojErr PowerdPowerLock::IssueLock()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err;
+	MojObject params;
+
+	err = params.putString(_T("id"), RemotePowerActivityName);
+	MojErrCheck(err);
+
+	err = params.putInt(_T("duration_ms"), PowerActivityLockDuration * 1000);
+	MojErrCheck(err);
+
+	m_call = boost::make_shared<MojoWeakPtrCall<PowerdPowerLock> >(
+		shared_from_this(), &PowerdPowerLock::LockResponse, m_service,
+		"palm://com.palm.power/com/palm/power/activityStart", params);
+	m_call->Call();
+
+	m_acquiredSinceLock = false;
+
+	m_calls++;
+	CountCall();
+
+	return MojErrNone;
+}
+
+MojErr PowerdPowerLock::IssueUnlock()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err;
+	MojObject params;
+
+	err = params.putString(_T("id"), RemotePowerActivityName);
+	MojErrCheck(err);
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+
+	if (m_debouncing && (now < m_debounceUntil)) {
+		/* Shorten the lock to what is left of the debounce */
+		err = params.putInt(_T("duration_ms"),
+			(MojInt64)(m_debounceUntil - now) * 1000);
+		MojErrCheck(err);
+
+		m_call = boost::make_shared<MojoWeakPtrCall<PowerdPowerLock> >(
+			shared_from_this(), &PowerdPowerLock::UnlockResponse, m_service,
+			"palm://com.palm.power/com/palm/power/activityStart", params);
+	} else {
+		m_call = boost::make_shared<MojoWeakPtrCall<PowerdPowerLock> >(
+			shared_from_this(), &PowerdPowerLock::UnlockResponse, m_service,
+			"palm://com.palm.power/com/palm/power/activityEnd", params);
+	}
+
+	m_call->Call();
+
+	m_calls++;
+	CountCall();
+
+	return MojErrNone;
+}
+
+void PowerdPowerLock::LockResponse(MojServiceMessage *msg,
+	const MojObject& response, MojErr err)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	m_call.reset();
+
+	if (err == MojErrNone) {
+		LOG_AM_DEBUG("Power lock successfully %s for %u holders",
+			(m_remoteState == RemoteLocked) ? "updated" : "created",
+			m_holders);
+
+		m_remoteState = RemoteLocked;
+
+		if (!m_timeout) {
+			m_timeout = boost::make_shared<Timeout<PowerdPowerLock> >(
+				shared_from_this(), PowerActivityLockUpdateInterval,
+				&PowerdPowerLock::RenewTimeout);
+		}
+
+		m_timeout->Arm();
+
+		NotifyLocked();
+		Sync();
+		return;
+	}
+
+	if (m_remoteState != RemoteLocked) {
+		LOG_AM_WARNING(MSGID_PWRLK_NOTI_CREATE_FAIL, 1,
+			PMLOGKFV("holders", "%u", m_holders),
+			"Attempt to create power lock failed, retrying. Error %s",
+			MojoObjectJson(response).c_str());
+	} else {
+		LOG_AM_WARNING(MSGID_PWRLK_NOTI_UPDATE_FAIL, 1,
+			PMLOGKFV("holders", "%u", m_holders),
+			"Attempt to update power lock failed, retrying. Error %s",
+			MojoObjectJson(response).c_str());
+	}
+
+	if (!m_holders) {
+		/* Nobody wants it any more; there's nothing to retry for */
+		if (m_remoteState != RemoteLocked) {
+			m_remoteState = RemoteUnlocked;
+		}
+		Sync();
+		return;
+	}
+
+	/* Retry - powerd may have restarted. */
+	MojErr err2 = IssueLock();
+	if (err2) {
+		LOG_AM_WARNING(MSGID_PWR_LOCK_CREATE_FAIL, 1,
+			PMLOGKFV("holders", "%u", m_holders),
+			"Failed to issue command to create power lock in Noti");
+
+		/* If power was not currently locked, fake the create so the
+		 * Activities don't hang */
+		if (m_remoteState != RemoteLocked) {
+			LOG_AM_WARNING(MSGID_PWR_LOCK_FAKE_NOTI, 1,
+				PMLOGKFV("holders", "%u", m_holders),
+				"Faking power locked notification in noti");
+
+			m_remoteState = RemoteLocked;
+			NotifyLocked();
+		}
+	}
+}
+
+void PowerdPowerLock::UnlockResponse(MojServiceMessage *msg,
+	const MojObject& response, MojErr err)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	m_call.reset();
+
+	if (err == MojErrNone) {
+		LOG_AM_DEBUG("Power lock successfully %s",
+			m_debouncing ? "debounced" : "removed");
+	} else {
+		LOG_AM_WARNING(MSGID_PWRULK_NOTI_ERR, 1,
+			PMLOGKFV("holders", "%u", m_holders),
+			"Attempt to remove power lock failed, retrying. Error: %s",
+			MojoObjectJson(response).c_str());
+
+		/* If it's wanted again, the lock that replaces it will do.
+		 * Otherwise retry.  XXX but if error is "Activity doesn't exist",
+		 * it's done. */
+		if (!m_holders) {
+			MojErr err2 = IssueUnlock();
+			if (!err2) {
+				return;
+			}
+
+			LOG_AM_WARNING(MSGID_PWR_UNLOCK_CREATE_ERR, 0,
+				"Failed to issue command to remove power lock");
+
+			/* Not much to do at this point, let the Activity move on
+			 * so it doesn't hang. */
+			LOG_AM_WARNING(MSGID_PWR_UNLOCK_FAKE_NOTI, 0,
+				"Faking power unlocked notification in Noti");
+		}
+	}
+
+	m_remoteState = RemoteUnlocked;
+	m_debouncing = false;
+	m_timeout.reset();
+
+	NotifyUnlocked();
+	Sync();
+}
+
+void PowerdPowerLock::RenewTimeout()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if ((m_remoteState != RemoteLocked) || !m_holders || m_call) {
+		return;
+	}
+
+#ifndef ACTIVITYMANAGER_RENEW_POWER_ACTIVITIES
+	/* Only renew for holders that arrived after the lock was last
+	 * requested; the rest have had their maximum.  If nobody new arrived,
+	 * the lock is left to lapse.  There is only one lock, so a renewal
+	 * made for a newcomer extends it for the earlier holders too; the
+	 * device is kept awake for the newcomer either way. */
+	if (!m_acquiredSinceLock) {
+		LOG_AM_WARNING(MSGID_PWR_TIMEOUT_NOTI, 2,
+			PMLOGKFV("holders", "%u", m_holders),
+			PMLOGKFV("LOCKDURATION", "%d", PowerActivityLockDuration),
+			"Power lock exceeded maximum length of seconds, not being renewed");
+		m_remoteState = RemoteUnlocked;
+		return;
+	}
+#endif
+
+	LOG_AM_DEBUG("Attempting to update power lock for %u holders",
+		m_holders);
+
+	/* One renewal instead of one per holder */
+	m_callsSaved += m_holders - 1;
+	CountCallsSaved(m_holders - 1);
+
+	MojErr err = IssueLock();
+	if (err) {
+		LOG_AM_ERROR(MSGID_PWR_ACTIVITY_CREATE_ERR, 1,
+			PMLOGKFV("holders", "%u", m_holders),
+			"Failed to issue command to update power lock");
+		m_timeout->Arm();
+	}
+}
+
+void PowerdPowerLock::NotifyLocked()
+{
+	/* Holders may acquire or release again from their notification */
+	HolderVec locked;
+	locked.swap(m_locking);
+
+	for (HolderVec::iterator iter = locked.begin(); iter != locked.end();
+		++iter) {
+		boost::shared_ptr<PowerdPowerActivity> holder = iter->lock();
+		if (holder) {
+			holder->LockAcquired();
+		}
+	}
+}
+
+void PowerdPowerLock::NotifyUnlocked()
+{
+	HolderVec unlocked;
+	unlocked.swap(m_unlocking);
+
+	for (HolderVec::iterator iter = unlocked.begin(); iter != unlocked.end();
+		++iter) {
+		boost::shared_ptr<PowerdPowerActivity> holder = iter->lock();
+		if (holder) {
+			holder->LockReleased();
+		}
+	}
+}
+
+bool PowerdPowerLock::Remove(HolderVec& holders,
+	boost::shared_ptr<PowerdPowerActivity> holder)
+{
+	for (HolderVec::iterator iter = holders.begin(); iter != holders.end();
+		++iter) {
+		if (iter->lock() == holder) {
+			holders.erase(iter);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const char *PowerdPowerLock::RemoteStateToString(RemoteState state)
+{
+	switch (state) {
+	case RemoteUnlocked: return "unlocked";
+	case RemoteLocking: return "locking";
+	case RemoteLocked: return "locked";
+	case RemoteUnlocking: return "unlocking";
+	}
+
+	return "unknown";
+}
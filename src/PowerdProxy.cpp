@@ -18,12 +18,18 @@
 
 #include "PowerdProxy.h"
 #include "PowerdPowerActivity.h"
+#include "PowerdPowerLock.h"
 #include "MojoCall.h"
 #include "Activity.h"
 #include "ActivityJson.h"
+#include "Clock.h"
+#include "Metrics.h"
 #include "Logging.h"
 #include <stdexcept>
 
+unsigned PowerdProxy::s_batteryUpdateStep = DefaultBatteryUpdateStep;
+unsigned PowerdProxy::s_batteryUpdateInterval = DefaultBatteryUpdateInterval;
+
 PowerdProxy::PowerdProxy(MojService *service)
 	: m_chargerStatusSubscribed(false)
 	, m_batteryStatusSubscribed(false)
@@ -31,12 +37,17 @@ PowerdProxy::PowerdProxy(MojService *service)
 	, m_usbChargerConnected(false)
 	, m_onPuck(false)
 	, m_batteryPercent(0)
+	, m_batteryReported(false)
+	, m_batteryReportedPercent(0)
+	, m_batteryReportedTime(0)
 	, m_service(service)
 {
 	m_chargingRequirementCore = boost::make_shared<RequirementCore>
 		("charging", true);
 	m_dockedRequirementCore = boost::make_shared<RequirementCore>
 		("docked", true);
+
+	m_powerLock = boost::make_shared<PowerdPowerLock>(service);
 }
 
 PowerdProxy::~PowerdProxy()
@@ -149,6 +160,7 @@ void PowerdProxy::Disable()
 	m_batteryStatus.reset();
 
 	m_triggerChargerStatus.reset();
+	m_batteryUpdateTimeout.reset();
 
 	m_chargerStatusSubscribed = false;
 	m_batteryStatusSubscribed = false;
@@ -159,7 +171,20 @@ boost::shared_ptr<PowerActivity> PowerdProxy::CreatePowerActivity(
 {
 	return boost::make_shared<PowerdPowerActivity>(
 		boost::dynamic_pointer_cast<PowerManager, RequirementManager>
-			(shared_from_this()), activity, m_service, m_serial++);
+			(shared_from_this()), activity, m_powerLock, m_serial++);
+}
+
+MojErr PowerdProxy::StatusToJson(MojObject& rep) const
+{
+	MojObject powerLock(MojObject::TypeObject);
+
+	MojErr err = m_powerLock->ToJson(powerLock);
+	MojErrCheck(err);
+
+	err = rep.put(_T("powerLock"), powerLock);
+	MojErrCheck(err);
+
+	return MojErrNone;
 }
 
 MojInt64 PowerdProxy::GetBatteryPercent() const
@@ -361,6 +386,9 @@ void PowerdProxy::ChargerStatusSignal(MojServiceMessage *msg,
 			}
 		}
 
+		/* Docking and charging usually change together */
+		RequirementBatch batch;
+
 		if (m_onPuck) {
 			if (!m_dockedRequirementCore->IsMet()) {
 				LOG_AM_DEBUG("Device is now docked");
@@ -438,16 +466,23 @@ void PowerdProxy::BatteryStatusSignal(MojServiceMessage *msg,
 		 * the state of the associated battery requirement. */
 		m_batteryPercent = batteryPercent;
 
+		/* Each Activity gets one update however many of its requirements
+		 * the change crosses */
+		RequirementBatch batch;
+
+		/* Only the requirements whose watermark the change crossed are
+		 * met or unmet.  Those that stay met are merely told the new level,
+		 * and only as often as the update policy allows. */
 		if (batteryPercent < oldBatteryPercent) {
 			BatteryRequirement::MultiTable::iterator newWatermark =
 				m_batteryRequirements.upper_bound(batteryPercent,
 					BatteryRequirement::KeyComp());
 
-			/* Currently met requirements may wish to generate updates.
-			 * Some of those requirements are about to be unmet due to
-			 * battery drain.  Do not generate separate udpates. */
-			std::for_each(m_batteryRequirements.begin(), newWatermark,
-				boost::mem_fn(&Requirement::Updated));
+			if ((newWatermark != m_batteryRequirements.begin()) &&
+				IsBatteryUpdateDue(batteryPercent)) {
+				std::for_each(m_batteryRequirements.begin(), newWatermark,
+					boost::mem_fn(&Requirement::Updated));
+			}
 
 			std::for_each(newWatermark,
 				m_batteryRequirements.upper_bound(oldBatteryPercent,
@@ -458,10 +493,12 @@ void PowerdProxy::BatteryStatusSignal(MojServiceMessage *msg,
 				m_batteryRequirements.upper_bound(oldBatteryPercent,
 					BatteryRequirement::KeyComp());
 
-			/* Some unmet requirements are about to be met.  For the
-			 * currently met ones, just generate an update */
-			std::for_each(m_batteryRequirements.begin(), oldWatermark,
-				boost::mem_fn(&Requirement::Updated));
+			if ((oldWatermark != m_batteryRequirements.begin()) &&
+				IsBatteryUpdateDue(batteryPercent)) {
+				std::for_each(m_batteryRequirements.begin(), oldWatermark,
+					boost::mem_fn(&Requirement::Updated));
+			}
+
 			std::for_each(oldWatermark,
 				m_batteryRequirements.upper_bound(batteryPercent,
 					BatteryRequirement::KeyComp()),
@@ -470,6 +507,96 @@ void PowerdProxy::BatteryStatusSignal(MojServiceMessage *msg,
 	}
 }
 
+bool PowerdProxy::IsBatteryUpdateDue(MojInt64 batteryPercent)
+{
+	static MetricsCounter& s_sent = Metrics::GetCounter("battery.updates");
+	static MetricsCounter& s_skipped =
+		Metrics::GetCounter("battery.updatesSkipped");
+
+	time_t now = Clock::GetInstance().GetMonotonicTime();
+
+	MojInt64 change = batteryPercent - m_batteryReportedPercent;
+	if (change < 0) {
+		change = -change;
+	}
+
+	if (change < (MojInt64)s_batteryUpdateStep) {
+		s_skipped.Increment();
+		return false;
+	}
+
+	/* The first update is always due */
+	unsigned elapsed = (unsigned)(now - m_batteryReportedTime);
+	if (m_batteryReported && (elapsed < s_batteryUpdateInterval)) {
+		s_skipped.Increment();
+
+		/* Send the latest level once the interval is up, in case it
+		 * doesn't change again before then */
+		if (!m_batteryUpdateTimeout) {
+			m_batteryUpdateTimeout =
+				boost::make_shared<Timeout<PowerdProxy> >(
+					boost::dynamic_pointer_cast<PowerdProxy,
+						RequirementManager>(shared_from_this()),
+					s_batteryUpdateInterval - elapsed,
+					&PowerdProxy::FlushBatteryUpdate);
+		}
+
+		if (!m_batteryUpdateTimeout->IsArmed()) {
+			m_batteryUpdateTimeout->Arm(s_batteryUpdateInterval - elapsed);
+		}
+
+		return false;
+	}
+
+	if (m_batteryUpdateTimeout) {
+		m_batteryUpdateTimeout->Cancel();
+	}
+
+	m_batteryReported = true;
+	m_batteryReportedPercent = batteryPercent;
+	m_batteryReportedTime = now;
+
+	s_sent.Increment();
+	return true;
+}
+
+void PowerdProxy::FlushBatteryUpdate()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	RequirementBatch batch;
+
+	/* The requirements met at the current level */
+	BatteryRequirement::MultiTable::iterator watermark =
+		m_batteryRequirements.upper_bound(m_batteryPercent,
+			BatteryRequirement::KeyComp());
+
+	if ((watermark != m_batteryRequirements.begin()) &&
+		IsBatteryUpdateDue(m_batteryPercent)) {
+		std::for_each(m_batteryRequirements.begin(), watermark,
+			boost::mem_fn(&Requirement::Updated));
+	}
+}
+
+void PowerdProxy::SetBatteryUpdatePolicy(unsigned step, unsigned interval)
+{
+	LOG_AM_DEBUG("Battery updates every %u%% and at most every %u seconds",
+		step, interval);
+
+	s_batteryUpdateStep = step;
+	s_batteryUpdateInterval = interval;
+}
+
+unsigned PowerdProxy::GetBatteryUpdateStep()
+{
+	return s_batteryUpdateStep;
+}
+
+unsigned PowerdProxy::GetBatteryUpdateInterval()
+{
+	return s_batteryUpdateInterval;
+}
+
 PowerdProxy::BatteryRequirement::BatteryRequirement(
 	boost::shared_ptr<Activity> activity, MojInt64 percent,
 	boost::shared_ptr<PowerdProxy> powerd, bool met)
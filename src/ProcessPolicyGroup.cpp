@@ -0,0 +1,236 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "ProcessPolicyGroup.h"
+#include "ProcessPolicyManager.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <climits>
+
+const int ProcessPolicyGroup::Unapplied = INT_MIN;
+
+ProcessPolicyGroup::ProcessPolicyGroup(const std::string& name,
+	boost::shared_ptr<ProcessPolicyManager> manager)
+	: ResourceContainer(name, manager)
+	, m_value(Unapplied)
+{
+}
+
+ProcessPolicyGroup::~ProcessPolicyGroup()
+{
+}
+
+void ProcessPolicyGroup::UpdatePriority()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	boost::shared_ptr<ProcessPolicyManager> manager = GetPolicyManager();
+
+	/* A disabled manager leaves the processes as they were */
+	if (!manager->IsEnabled()) {
+		RestoreAll();
+		return;
+	}
+
+	ActivityPriority_t priority = GetPriority();
+	bool focused = IsFocused();
+
+	/* Several classes share a value; moving between them is free */
+	int value = manager->GetValue(priority, focused);
+	if (value == m_value) {
+		static MetricsCounter& s_skipped =
+			Metrics::GetCounter("process.updatesSkipped");
+		s_skipped.Increment();
+		return;
+	}
+
+	LOG_AM_DEBUG("Setting %s policy of [Container %s] for [%s,%s]",
+		manager->GetPolicyName(), m_name.c_str(),
+		ActivityPriorityNames[priority], focused ? "focused" : "unfocused");
+
+	m_value = value;
+	ApplyAll();
+}
+
+void ProcessPolicyGroup::MapProcess(pid_t pid)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("Mapping [pid %d] into [Container %s]", (int)pid,
+		m_name.c_str());
+
+	boost::shared_ptr<ProcessPolicyManager> manager = GetPolicyManager();
+
+	ProcessValueMap::iterator found = m_processes.find((int)pid);
+	if (found != m_processes.end()) {
+		if (manager->IsSameProcess(pid)) {
+			return;
+		}
+
+		/* The process mapped before has exited and its pid been reused;
+		 * the new one starts over */
+		manager->ForgetProcess(pid);
+		m_processes.erase(found);
+	}
+
+	manager->ClaimProcess(pid, m_name);
+
+	m_processes[(int)pid] = Unapplied;
+
+	if (!manager->IsEnabled()) {
+		return;
+	} else if (m_value == Unapplied) {
+		UpdatePriority();
+	} else {
+		ApplyAll();
+	}
+}
+
+void ProcessPolicyGroup::GetProcessIds(std::set<int>& pids) const
+{
+	for (ProcessValueMap::const_iterator iter = m_processes.begin();
+		iter != m_processes.end(); ++iter) {
+		pids.insert(iter->first);
+	}
+}
+
+void ProcessPolicyGroup::Enable()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	UpdatePriority();
+}
+
+void ProcessPolicyGroup::Disable()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	RestoreAll();
+}
+
+void ProcessPolicyGroup::ReleaseProcess(pid_t pid)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("[pid %d] leaving [Container %s]", (int)pid,
+		m_name.c_str());
+
+	ProcessValueMap::iterator found = m_processes.find((int)pid);
+	if (found == m_processes.end()) {
+		return;
+	}
+
+	if (found->second != Unapplied) {
+		GetPolicyManager()->Restore(pid);
+	}
+
+	m_processes.erase(found);
+}
+
+MojErr ProcessPolicyGroup::ToJson(MojObject& rep) const
+{
+	boost::shared_ptr<ProcessPolicyManager> manager = GetPolicyManager();
+
+	MojErr err;
+
+	if (m_value != Unapplied) {
+		err = manager->ValueToJson(rep, m_value);
+		MojErrCheck(err);
+	}
+
+	MojObject processes(MojObject::TypeArray);
+	for (ProcessValueMap::const_iterator iter = m_processes.begin();
+		iter != m_processes.end(); ++iter) {
+		MojObject process(MojObject::TypeObject);
+
+		err = process.putInt(_T("pid"), (MojInt64)iter->first);
+		MojErrCheck(err);
+
+		if (iter->second != Unapplied) {
+			err = manager->ValueToJson(process, iter->second);
+			MojErrCheck(err);
+		}
+
+		err = processes.push(process);
+		MojErrCheck(err);
+	}
+
+	err = rep.put(_T("processes"), processes);
+	MojErrCheck(err);
+
+	return ResourceContainer::ToJson(rep);
+}
+
+boost::shared_ptr<ProcessPolicyManager>
+ProcessPolicyGroup::GetPolicyManager() const
+{
+	return boost::dynamic_pointer_cast<ProcessPolicyManager, ContainerManager>
+		(m_manager.lock());
+}
+
+void ProcessPolicyGroup::ApplyAll()
+{
+	boost::shared_ptr<ProcessPolicyManager> manager = GetPolicyManager();
+
+	ProcessValueMap::iterator iter = m_processes.begin();
+	while (iter != m_processes.end()) {
+		pid_t pid = (pid_t)iter->first;
+		int original;
+		bool exists = true;
+
+		if (iter->second == m_value) {
+			/* Already there */
+		} else if (!manager->GetOriginal(pid, original)) {
+			exists = false;
+		} else if (manager->IsExempt(original)) {
+			/* Left as it was */
+		} else if (manager->Apply(pid, m_value)) {
+			iter->second = m_value;
+		} else {
+			manager->ForgetProcess(pid);
+			exists = false;
+		}
+
+		if (exists) {
+			++iter;
+		} else {
+			LOG_AM_DEBUG("[pid %d] of [Container %s] has exited",
+				iter->first, m_name.c_str());
+			m_processes.erase(iter++);
+		}
+	}
+}
+
+void ProcessPolicyGroup::RestoreAll()
+{
+	boost::shared_ptr<ProcessPolicyManager> manager = GetPolicyManager();
+
+	ProcessValueMap::iterator iter = m_processes.begin();
+	while (iter != m_processes.end()) {
+		if (iter->second == Unapplied) {
+			++iter;
+		} else if (manager->Restore((pid_t)iter->first)) {
+			iter->second = Unapplied;
+			++iter;
+		} else {
+			LOG_AM_DEBUG("[pid %d] of [Container %s] has exited",
+				iter->first, m_name.c_str());
+			m_processes.erase(iter++);
+		}
+	}
+
+	m_value = Unapplied;
+}
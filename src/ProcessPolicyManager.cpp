@@ -0,0 +1,426 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "ProcessPolicyManager.h"
+#include "ProcessPolicyGroup.h"
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* From linux/ioprio.h, which not every toolchain ships */
+#define AM_IOPRIO_CLASS_SHIFT	13
+#define AM_IOPRIO_CLASS_NONE	0
+#define AM_IOPRIO_CLASS_RT		1
+#define AM_IOPRIO_CLASS_BE		2
+#define AM_IOPRIO_WHO_PROCESS	1
+#define AM_IOPRIO_VALUE(cls, data) \
+	(((cls) << AM_IOPRIO_CLASS_SHIFT) | (data))
+
+/* Indexed from ActivityPriorityLowest.  A container with no Activities
+ * takes GetDefaultPriority(), so none never gets here. */
+static const int IoPriorities[] = {
+	AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 7),		/* ActivityPriorityLowest */
+	AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 6),		/* ActivityPriorityLow */
+	AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 4),		/* ActivityPriorityNormal */
+	AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 3),		/* ActivityPriorityHigh */
+	AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 2)		/* ActivityPriorityHighest */
+};
+
+static const int FocusedIoPriority = AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_BE, 0);
+
+static const int OomScoreAdjs[] = {
+	600,	/* ActivityPriorityLowest */
+	300,	/* ActivityPriorityLow */
+	0,		/* ActivityPriorityNormal */
+	0,		/* ActivityPriorityHigh */
+	0		/* ActivityPriorityHighest */
+};
+
+static const int FocusedOomScoreAdj = 0;
+
+ProcessPolicyManager::ProcessPolicyManager(Policy policy,
+	boost::shared_ptr<MasterResourceManager> master)
+	: ContainerManager(master)
+	, m_policy(policy)
+{
+}
+
+ProcessPolicyManager::~ProcessPolicyManager()
+{
+}
+
+ProcessPolicyManager::ProcessState::ProcessState()
+	: m_original(0)
+	, m_hasOriginal(false)
+	, m_startTime(0)
+{
+}
+
+boost::shared_ptr<ResourceContainer> ProcessPolicyManager::CreateContainer(
+	const std::string& name)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	LOG_AM_DEBUG("Creating [Container %s] for %s policy", name.c_str(),
+		GetPolicyName());
+
+	return boost::make_shared<ProcessPolicyGroup>(name,
+		boost::dynamic_pointer_cast<ProcessPolicyManager, ResourceManager>
+			(shared_from_this()));
+}
+
+ActivityPriority_t ProcessPolicyManager::GetDefaultPriority() const
+{
+	return ActivityPriorityLow;
+}
+
+ActivityPriority_t ProcessPolicyManager::GetDisabledPriority() const
+{
+	return ActivityPriorityNormal;
+}
+
+MojErr ProcessPolicyManager::InfoToJson(MojObject& rep) const
+{
+	MojErr err = rep.putString(_T("policy"), GetPolicyName());
+	MojErrCheck(err);
+
+	return ContainerManager::InfoToJson(rep);
+}
+
+ProcessPolicyManager::Policy ProcessPolicyManager::GetPolicy() const
+{
+	return m_policy;
+}
+
+const char *ProcessPolicyManager::GetPolicyName() const
+{
+	return (m_policy == PolicyIo) ? "io" : "memory";
+}
+
+const char *ProcessPolicyManager::GetValueName() const
+{
+	return (m_policy == PolicyIo) ? "ioPriority" : "oomScoreAdj";
+}
+
+int ProcessPolicyManager::GetValue(ActivityPriority_t priority,
+	bool focused) const
+{
+	if (m_policy == PolicyIo) {
+		return focused ? FocusedIoPriority :
+			IoPriorities[priority - ActivityPriorityLowest];
+	} else {
+		return focused ? FocusedOomScoreAdj :
+			OomScoreAdjs[priority - ActivityPriorityLowest];
+	}
+}
+
+MojErr ProcessPolicyManager::ValueToJson(MojObject& rep, int value) const
+{
+	MojErr err;
+
+	if (m_policy == PolicyIo) {
+		char buf[16];
+		snprintf(buf, sizeof(buf), "be/%d",
+			value & ((1 << AM_IOPRIO_CLASS_SHIFT) - 1));
+		err = rep.putString(GetValueName(), buf);
+	} else {
+		err = rep.putInt(GetValueName(), (MojInt64)value);
+	}
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+bool ProcessPolicyManager::Apply(pid_t pid, int value) const
+{
+	if (m_policy == PolicyIo) {
+		static MetricsCounter& s_sets =
+			Metrics::GetCounter("process.ioprioSets");
+		s_sets.Increment();
+
+		return SetIoPriority(pid, value);
+	} else {
+		static MetricsCounter& s_writes =
+			Metrics::GetCounter("process.oomScoreWrites");
+		s_writes.Increment();
+
+		return SetOomScoreAdj(pid, value);
+	}
+}
+
+bool ProcessPolicyManager::GetOriginal(pid_t pid, int& original)
+{
+	if (!IsSameProcess(pid)) {
+		LOG_AM_DEBUG("[pid %d] was reused", (int)pid);
+		ForgetProcess(pid);
+		return false;
+	}
+
+	ProcessState& state = m_processStates[(int)pid];
+
+	if (!state.m_hasOriginal) {
+		bool found = GetStartTime(pid, state.m_startTime) &&
+			((m_policy == PolicyIo) ?
+				GetIoPriority(pid, state.m_original) :
+				GetOomScoreAdj(pid, state.m_original));
+		if (!found) {
+			ForgetProcess(pid);
+			return false;
+		}
+
+		state.m_hasOriginal = true;
+	}
+
+	original = state.m_original;
+	return true;
+}
+
+bool ProcessPolicyManager::IsSameProcess(pid_t pid) const
+{
+	ProcessStateMap::const_iterator found = m_processStates.find((int)pid);
+	if ((found == m_processStates.end()) || !found->second.m_hasOriginal) {
+		return true;
+	}
+
+	unsigned long long start;
+	return GetStartTime(pid, start) && (start == found->second.m_startTime);
+}
+
+bool ProcessPolicyManager::IsExempt(int original) const
+{
+	if (m_policy == PolicyIo) {
+		return (original >> AM_IOPRIO_CLASS_SHIFT) == AM_IOPRIO_CLASS_RT;
+	} else {
+		return original < 0;
+	}
+}
+
+bool ProcessPolicyManager::Restore(pid_t pid)
+{
+	ProcessStateMap::iterator found = m_processStates.find((int)pid);
+	if ((found == m_processStates.end()) || !found->second.m_hasOriginal) {
+		return true;
+	}
+
+	/* Don't hand an exited process's value to whoever has its pid now */
+	if (!IsSameProcess(pid)) {
+		LOG_AM_DEBUG("[pid %d] was reused", (int)pid);
+		m_processStates.erase(found);
+		return false;
+	}
+
+	LOG_AM_DEBUG("Restoring %s policy of [pid %d]", GetPolicyName(),
+		(int)pid);
+
+	if (!Apply(pid, found->second.m_original)) {
+		m_processStates.erase(found);
+		return false;
+	}
+
+	return true;
+}
+
+void ProcessPolicyManager::ClaimProcess(pid_t pid,
+	const std::string& container)
+{
+	ProcessStateMap::iterator found = m_processStates.find((int)pid);
+	if (found == m_processStates.end()) {
+		ProcessState& state = m_processStates[(int)pid];
+		state.m_container = container;
+		return;
+	}
+
+	/* A new process with an old pid: with the old original forgotten, the
+	 * container that had the old one drops it without restoring anything */
+	if (!IsSameProcess(pid)) {
+		LOG_AM_DEBUG("[pid %d] was reused", (int)pid);
+		found->second.m_hasOriginal = false;
+	}
+
+	std::string previous = found->second.m_container;
+	found->second.m_container = container;
+
+	if (previous.empty() || (previous == container)) {
+		return;
+	}
+
+	ContainerMap::iterator owner = m_containers.find(previous);
+	if (owner != m_containers.end()) {
+		boost::shared_ptr<ProcessPolicyGroup> group =
+			boost::dynamic_pointer_cast<ProcessPolicyGroup, ResourceContainer>(
+				owner->second);
+		group->ReleaseProcess(pid);
+	}
+}
+
+void ProcessPolicyManager::ForgetProcess(pid_t pid)
+{
+	m_processStates.erase((int)pid);
+}
+
+/* The I/O priority is per thread, so every thread of the process is set.
+ * Threads exiting meanwhile are skipped. */
+bool ProcessPolicyManager::SetIoPriority(pid_t pid, int ioprio)
+{
+	char path[32];
+	snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+
+	DIR *tasks = opendir(path);
+	if (!tasks) {
+		if (syscall(SYS_ioprio_set, AM_IOPRIO_WHO_PROCESS, (int)pid,
+			ioprio) == 0) {
+			return true;
+		}
+		return (errno != ESRCH);
+	}
+
+	struct dirent *entry;
+	while ((entry = readdir(tasks)) != NULL) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+
+		int tid = (int)strtol(entry->d_name, NULL, 10);
+		if ((syscall(SYS_ioprio_set, AM_IOPRIO_WHO_PROCESS, tid,
+			ioprio) < 0) && (errno != ESRCH)) {
+			LOG_AM_WARNING(MSGID_SET_IOPRIO_FAIL, 2,
+				PMLOGKFV("tid", "%d", tid),
+				PMLOGKS("Reason", strerror(errno)),
+				"Failed to set I/O priority");
+		}
+	}
+
+	closedir(tasks);
+
+	return true;
+}
+
+bool ProcessPolicyManager::SetOomScoreAdj(pid_t pid, int adj)
+{
+	char path[40];
+	snprintf(path, sizeof(path), "/proc/%d/oom_score_adj", (int)pid);
+
+	int fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		if (errno == ENOENT) {
+			return false;
+		}
+
+		LOG_AM_WARNING(MSGID_SET_OOM_SCORE_FAIL, 2,
+			PMLOGKFV("pid", "%d", (int)pid),
+			PMLOGKS("Reason", strerror(errno)),
+			"Failed to open oom_score_adj");
+		return true;
+	}
+
+	char buf[16];
+	int length = snprintf(buf, sizeof(buf), "%d", adj);
+
+	ssize_t ret = write(fd, buf, (size_t)length);
+	int error = errno;
+	close(fd);
+
+	if (ret != (ssize_t)length) {
+		if ((ret < 0) && (error == ESRCH)) {
+			return false;
+		}
+
+		LOG_AM_WARNING(MSGID_SET_OOM_SCORE_FAIL, 2,
+			PMLOGKFV("pid", "%d", (int)pid),
+			PMLOGKS("Reason", (ret < 0) ? strerror(error) : "short write"),
+			"Failed to write oom_score_adj");
+	}
+
+	return true;
+}
+
+/* The main thread's I/O priority stands for the process's.  A process
+ * that never set one reads as class none, which writing back restores. */
+bool ProcessPolicyManager::GetIoPriority(pid_t pid, int& ioprio)
+{
+	long ret = syscall(SYS_ioprio_get, AM_IOPRIO_WHO_PROCESS, (int)pid);
+	if (ret < 0) {
+		if (errno == ESRCH) {
+			return false;
+		}
+
+		ioprio = AM_IOPRIO_VALUE(AM_IOPRIO_CLASS_NONE, 0);
+		return true;
+	}
+
+	ioprio = (int)ret;
+	return true;
+}
+
+bool ProcessPolicyManager::GetOomScoreAdj(pid_t pid, int& adj)
+{
+	char path[40];
+	snprintf(path, sizeof(path), "/proc/%d/oom_score_adj", (int)pid);
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	char buf[16];
+	ssize_t length = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (length <= 0) {
+		return false;
+	}
+	buf[length] = '\0';
+
+	adj = (int)strtol(buf, NULL, 10);
+	return true;
+}
+
+/* starttime is field 22 of /proc/<pid>/stat, counted from the end of the
+ * command name, which may itself hold spaces or ')' */
+bool ProcessPolicyManager::GetStartTime(pid_t pid, unsigned long long& start)
+{
+	char path[32];
+	char buf[1024];
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	ssize_t length = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (length <= 0) {
+		return false;
+	}
+	buf[length] = '\0';
+
+	const char *fields = strrchr(buf, ')');
+	return fields && (sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u "
+		"%*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu", &start) == 1);
+}
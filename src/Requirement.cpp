@@ -19,9 +19,11 @@
 #include "Requirement.h"
 #include "Activity.h"
 #include "ActivityJson.h"
+#include "FlightRecorder.h"
 
 Requirement::Requirement(boost::shared_ptr<Activity> activity, bool met)
 	: m_activity(activity)
+	, m_flightCode(FlightCodeUnresolved)
 	, m_met(met)
 {
 }
@@ -60,6 +62,16 @@ bool Requirement::IsMet() const
 	return m_met;
 }
 
+/* GetName() is virtual, so this can't be done by the constructor */
+MojUInt16 Requirement::GetFlightCode()
+{
+	if (m_flightCode == FlightCodeUnresolved) {
+		m_flightCode = FlightRecorder::GetRequirementCode(GetName());
+	}
+
+	return m_flightCode;
+}
+
 boost::shared_ptr<Activity> Requirement::GetActivity()
 {
 	return m_activity.lock();
@@ -18,12 +18,17 @@
 
 #include "RequirementManager.h"
 #include "DefaultRequirementManager.h"
+#include "Activity.h"
+#include "ActivityManager.h"
 #include "Logging.h"
 #include <algorithm>
 #include <stdexcept>
 
 MojLogger MasterRequirementManager::s_log(_T("activitymanager.masterrequirementmanager"));
 
+unsigned RequirementManager::s_batchDepth = 0;
+RequirementManager::ActivityVec RequirementManager::s_batchActivities;
+
 RequirementManager::RequirementManager()
 {
 }
@@ -50,6 +55,84 @@ void RequirementManager::Disable()
 {
 }
 
+MojErr RequirementManager::StatusToJson(MojObject& rep) const
+{
+	return MojErrNone;
+}
+
+void RequirementManager::BeginBatch()
+{
+	s_batchDepth++;
+}
+
+/* Runs from RequirementBatch's destructor, so it must not throw.  As in
+ * PersistCommand::Complete, an Activity that fails to settle is logged and
+ * the rest of the batch carries on. */
+void RequirementManager::CommitBatch()
+{
+	if (!s_batchDepth || --s_batchDepth) {
+		return;
+	}
+
+	if (s_batchActivities.empty()) {
+		return;
+	}
+
+	LOG_AM_DEBUG("Committing requirement batch of %u Activities",
+		(unsigned)s_batchActivities.size());
+
+	ActivityVec activities;
+	activities.swap(s_batchActivities);
+
+	/* Settling may make Activities ready, or re-enter with a new batch;
+	 * keep the ready queue until they all have */
+	std::set<boost::shared_ptr<ActivityManager> > managers;
+	for (ActivityVec::const_iterator iter = activities.begin();
+		iter != activities.end(); ++iter) {
+		boost::shared_ptr<ActivityManager> am = (*iter)->m_am.lock();
+		if (am && managers.insert(am).second) {
+			am->HoldReadyQueue();
+		}
+	}
+
+	for (ActivityVec::const_iterator iter = activities.begin();
+		iter != activities.end(); ++iter) {
+		try {
+			(*iter)->RequirementsSettled();
+		} catch (const std::exception& except) {
+			LOG_AM_WARNING(MSGID_REQ_BATCH_SETTLE_FAIL, 2,
+				PMLOGKFV("Activity", "%llu", (*iter)->GetId()),
+				PMLOGKS("Exception", except.what()),
+				"Unexpected exception settling requirement changes");
+		} catch (...) {
+			LOG_AM_WARNING(MSGID_REQ_BATCH_SETTLE_FAIL, 1,
+				PMLOGKFV("Activity", "%llu", (*iter)->GetId()),
+				"Unexpected exception settling requirement changes");
+		}
+	}
+
+	for (std::set<boost::shared_ptr<ActivityManager> >::const_iterator iter =
+		managers.begin(); iter != managers.end(); ++iter) {
+		try {
+			(*iter)->ReleaseReadyQueue();
+		} catch (const std::exception& except) {
+			LOG_AM_WARNING(MSGID_REQ_BATCH_SETTLE_FAIL, 1,
+				PMLOGKS("Exception", except.what()),
+				"Unexpected exception checking ready queue");
+		}
+	}
+}
+
+bool RequirementManager::IsBatching()
+{
+	return s_batchDepth != 0;
+}
+
+void RequirementManager::AddToBatch(boost::shared_ptr<Activity> activity)
+{
+	s_batchActivities.push_back(activity);
+}
+
 MasterRequirementManager::MasterRequirementManager()
 {
 }
@@ -124,6 +207,17 @@ void MasterRequirementManager::Disable()
 		boost::mem_fn(&RequirementManager::Disable));
 }
 
+MojErr MasterRequirementManager::StatusToJson(MojObject& rep) const
+{
+	for (ManagerSet::const_iterator iter = m_managers.begin();
+		iter != m_managers.end(); ++iter) {
+		MojErr err = (*iter)->StatusToJson(rep);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
 void MasterRequirementManager::AddManager(
 	boost::shared_ptr<RequirementManager> manager)
 {
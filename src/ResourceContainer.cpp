@@ -41,14 +41,19 @@ void ResourceContainer::AddEntity(boost::shared_ptr<BusEntity> entity)
 	LOG_AM_DEBUG("Adding [BusId %s] to [Container %s]",
 		entity->GetName().c_str(), m_name.c_str());
 
-	EntitySet::iterator found = m_entities.find(entity);
+	EntityMap::iterator found = m_entities.find(entity);
 	if (found != m_entities.end()) {
 		LOG_AM_DEBUG("[BusId %s] has already been added to [Container %s]",
 			entity->GetName().c_str(), m_name.c_str());
 		return;
 	}
 
-	m_entities.insert(entity);
+	EntityLevel level;
+	level.m_priority = entity->GetPriority();
+	level.m_focused = entity->IsFocused();
+
+	m_entities[entity] = level;
+	m_counts.Add(level.m_priority, level.m_focused);
 }
 
 void ResourceContainer::RemoveEntity(boost::shared_ptr<BusEntity> entity)
@@ -57,16 +62,49 @@ void ResourceContainer::RemoveEntity(boost::shared_ptr<BusEntity> entity)
 	LOG_AM_DEBUG("Removing [BusId %s] from [Container %s]",
 		entity->GetName().c_str(), m_name.c_str());
 
-	EntitySet::iterator found = m_entities.find(entity);
+	EntityMap::iterator found = m_entities.find(entity);
 	if (found == m_entities.end()) {
 		LOG_AM_DEBUG("[BusId %s] is not currently mapped to [Container %s]",
 			entity->GetName().c_str(), m_name.c_str());
 		return;
 	}
 
+	m_counts.Remove(found->second.m_priority, found->second.m_focused);
 	m_entities.erase(found);
 }
 
+bool ResourceContainer::UpdateEntity(boost::shared_ptr<BusEntity> entity)
+{
+	EntityMap::iterator found = m_entities.find(entity);
+	if (found == m_entities.end()) {
+		return false;
+	}
+
+	EntityLevel& level = found->second;
+
+	ActivityPriority_t priority = entity->GetPriority();
+	bool focused = entity->IsFocused();
+
+	if ((priority == level.m_priority) && (focused == level.m_focused)) {
+		return false;
+	}
+
+	ActivityPriority_t oldPriority = m_counts.GetPriority();
+	bool oldFocused = m_counts.IsFocused();
+
+	m_counts.Remove(level.m_priority, level.m_focused);
+	level.m_priority = priority;
+	level.m_focused = focused;
+	m_counts.Add(priority, focused);
+
+	return (m_counts.GetPriority() != oldPriority) ||
+		(m_counts.IsFocused() != oldFocused);
+}
+
+void ResourceContainer::GetProcessIds(std::set<int>& pids) const
+{
+}
+
 const std::string& ResourceContainer::GetName() const
 {
 	return m_name;
@@ -78,27 +116,17 @@ ActivityPriority_t ResourceContainer::GetPriority() const
 		return m_manager.lock()->GetDisabledPriority();
 	}
 
-	if (m_entities.empty()) {
+	ActivityPriority_t priority = m_counts.GetPriority();
+	if (priority == ActivityPriorityNone) {
 		return m_manager.lock()->GetDefaultPriority();
 	} else {
-		ActivityPriority_t priority = (*std::max_element(m_entities.begin(),
-			m_entities.end(), EntityPriorityCompare))->GetPriority();
-		if (priority == ActivityPriorityNone) {
-			return m_manager.lock()->GetDefaultPriority();
-		} else {
-			return priority;
-		}
+		return priority;
 	}
 }
 
 bool ResourceContainer::IsFocused() const
 {
-	if (m_entities.empty()) {
-		return false;
-	} else {
-		return (std::find_if(m_entities.begin(), m_entities.end(),
-			boost::mem_fn(&BusEntity::IsFocused)) != m_entities.end());
-	}
+	return m_counts.IsFocused();
 }
 
 MojErr ResourceContainer::ToJson(MojObject& rep) const
@@ -115,7 +143,9 @@ MojErr ResourceContainer::ToJson(MojObject& rep) const
 	MojObject entities(MojObject::TypeArray);
 
 	std::for_each(m_entities.begin(), m_entities.end(),
-		boost::bind(&BusEntity::PushJson, _1, boost::ref(entities), false));
+		boost::bind(&BusEntity::PushJson,
+			boost::bind(&EntityMap::value_type::first, _1),
+			boost::ref(entities), false));
 
 	err = rep.put(_T("entities"), entities);
 	MojErrCheck(err);
@@ -141,17 +171,3 @@ void ResourceContainer::PushJson(MojObject& array) const
 	}
 }
 
-bool ResourceContainer::EntityPriorityCompare(
-	const boost::shared_ptr<BusEntity>& x,
-	const boost::shared_ptr<BusEntity>& y)
-{
-	bool fx = x->IsFocused();
-	bool fy = y->IsFocused();
-
-	if (fx == fy) {
-		return (x->GetPriority() < y->GetPriority());
-	} else {
-		return fx < fy;
-	}
-}
-
@@ -19,11 +19,14 @@
 #include "ResourceManager.h"
 #include "Activity.h"
 #include "BusEntity.h"
+#include "Metrics.h"
 #include "Logging.h"
 #include <stdexcept>
 
 MojLogger MasterResourceManager::s_log(_T("activitymanager.resourcemanager"));
 
+const unsigned MasterResourceManager::CostSampleInterval;
+
 ResourceManager::ResourceManager()
 {
 }
@@ -32,8 +35,18 @@ ResourceManager::~ResourceManager()
 {
 }
 
+void ResourceManager::InformForegroundChanged(bool active)
+{
+}
+
+void ResourceManager::GetProcesses(boost::shared_ptr<BusEntity> entity,
+	std::set<int>& pids) const
+{
+}
+
 MasterResourceManager::MasterResourceManager()
 	: m_enabled(true)
+	, m_foreground(false)
 {
 }
 
@@ -55,6 +68,8 @@ void MasterResourceManager::Associate(boost::shared_ptr<Activity> activity)
 		iter != subscribers.end(); ++iter) {
 		Associate(activity, *iter);
 	}
+
+	BeginCost(activity);
 }
 
 void MasterResourceManager::Associate(boost::shared_ptr<Activity> activity,
@@ -76,6 +91,9 @@ void MasterResourceManager::Dissociate(boost::shared_ptr<Activity> activity)
 	LOG_AM_DEBUG("Dissociating all subscribers of [Activity %llu]",
 		activity->GetId());
 
+	/* Charge the last stretch while the subscribers are still known */
+	EndCost(activity);
+
 	/* Remove associations between the Activity and any remaining unique
 	 * subscribers. */
 	Activity::SubscriberIdVec subscribers = activity->GetUniqueSubscribers();
@@ -145,6 +163,10 @@ void MasterResourceManager::SetManager(const std::string& resource,
 			manager->Disable();
 		}
 	}
+
+	if (m_foreground) {
+		manager->InformForegroundChanged(true);
+	}
 }
 
 boost::shared_ptr<BusEntity> MasterResourceManager::GetEntity(const BusId& id)
@@ -171,6 +193,15 @@ void MasterResourceManager::InformEntityUpdated(
 	boost::shared_ptr<BusEntity> entity)
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+	/* Associations and focus changes often leave the Entity's priority
+	 * where it was; then no container can have changed either. */
+	if (!entity->ConsumeChange()) {
+		static MetricsCounter& s_skipped =
+			Metrics::GetCounter("resource.entityUpdatesSkipped");
+		s_skipped.Increment();
+		return;
+	}
+
 	LOG_AM_DEBUG("Informing all managers that [BusId %s] has been updated",
 		entity->GetName().c_str());
 
@@ -179,6 +210,27 @@ void MasterResourceManager::InformEntityUpdated(
 		iter->second->InformEntityUpdated(entity);
 	}
 }
+
+void MasterResourceManager::InformForegroundChanged(bool active)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	m_foreground = active;
+
+	for (ResourceManagerMap::iterator iter = m_managers.begin();
+		iter != m_managers.end(); ++iter) {
+		iter->second->InformForegroundChanged(active);
+	}
+}
+void MasterResourceManager::GetProcesses(boost::shared_ptr<BusEntity> entity,
+	std::set<int>& pids) const
+{
+	for (ResourceManagerMap::const_iterator iter = m_managers.begin();
+		iter != m_managers.end(); ++iter) {
+		iter->second->GetProcesses(entity, pids);
+	}
+}
+
 void MasterResourceManager::Enable()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
@@ -244,9 +296,137 @@ MojErr MasterResourceManager::InfoToJson(MojObject& rep) const
 	err = resourceManager.put(_T("resources"), resources);
 	MojErrCheck(err);
 
+	MojObject costs(MojObject::TypeObject);
+	err = m_costs.ToJson(costs);
+	MojErrCheck(err);
+
+	err = resourceManager.put(_T("costs"), costs);
+	MojErrCheck(err);
+
 	err = rep.put(_T("resourceManager"), resourceManager);
 	MojErrCheck(err);
 
 	return MojErrNone;
 }
 
+MojErr MasterResourceManager::CostToJson(boost::shared_ptr<Activity> activity,
+	MojObject& rep) const
+{
+	return m_costs.ActivityToJson(activity->GetId(), activity->GetName(), rep);
+}
+
+const CostAccountant& MasterResourceManager::GetCosts() const
+{
+	return m_costs;
+}
+
+void MasterResourceManager::BeginCost(boost::shared_ptr<Activity> activity)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	if (m_costActivities.find(activity->GetId()) != m_costActivities.end()) {
+		return;
+	}
+
+	/* Only the new Activity's processes are read: the Activities already
+	 * sharing one are charged for it up to now, and any other gets its
+	 * baseline.  The rest wait for the next full sample. */
+	CostAccountant::ProcessMap processes;
+	GetCostProcesses(processes);
+
+	std::set<int> pids;
+	GetActivityProcesses(activity, pids);
+
+	m_costs.SampleProcesses(processes, pids);
+
+	m_costActivities[activity->GetId()] = activity;
+	m_costs.Begin(activity->GetId(), activity->GetName());
+
+	if (!m_costTimeout) {
+		m_costTimeout = boost::make_shared<Timeout<MasterResourceManager> >(
+			boost::dynamic_pointer_cast<MasterResourceManager,
+				ResourceManager>(shared_from_this()), CostSampleInterval,
+			&MasterResourceManager::SampleCosts);
+	}
+
+	if (!m_costTimeout->IsArmed()) {
+		m_costTimeout->Arm(CostSampleInterval);
+	}
+}
+
+void MasterResourceManager::EndCost(boost::shared_ptr<Activity> activity)
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	ActivityMap::iterator found = m_costActivities.find(activity->GetId());
+	if (found == m_costActivities.end()) {
+		return;
+	}
+
+	/* Charge the ending Activity, and whoever shares its processes, up to
+	 * now */
+	CostAccountant::ProcessMap processes;
+	GetCostProcesses(processes);
+
+	CostAccountant::ProcessMap::const_iterator pids =
+		processes.find(activity->GetId());
+	if (pids != processes.end()) {
+		m_costs.SampleProcesses(processes, pids->second);
+	}
+
+	m_costs.End(activity->GetId());
+	m_costActivities.erase(activity->GetId());
+
+	if (m_costActivities.empty() && m_costTimeout) {
+		m_costTimeout->Cancel();
+	}
+}
+
+/* Every CostSampleInterval seconds while any Activity is accounted */
+void MasterResourceManager::SampleCosts()
+{
+	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
+
+	CostAccountant::ProcessMap processes;
+	GetCostProcesses(processes);
+
+	m_costs.Sample(processes);
+
+	if (!m_costActivities.empty() && m_costTimeout) {
+		m_costTimeout->Arm(CostSampleInterval);
+	}
+}
+
+/* Processes of each accounted Activity.  Activities gone without ending
+ * are dropped. */
+void MasterResourceManager::GetCostProcesses(
+	CostAccountant::ProcessMap& processes)
+{
+	ActivityMap::iterator iter = m_costActivities.begin();
+	while (iter != m_costActivities.end()) {
+		boost::shared_ptr<Activity> activity = iter->second.lock();
+		if (!activity) {
+			/* Whatever it was charged is kept */
+			m_costs.End(iter->first);
+			m_costActivities.erase(iter++);
+			continue;
+		}
+
+		GetActivityProcesses(activity, processes[iter->first]);
+		++iter;
+	}
+}
+
+void MasterResourceManager::GetActivityProcesses(
+	boost::shared_ptr<Activity> activity, std::set<int>& pids) const
+{
+	Activity::SubscriberIdVec subscribers =
+		activity->GetUniqueSubscribers();
+	for (Activity::SubscriberIdVec::const_iterator id =
+		subscribers.begin(); id != subscribers.end(); ++id) {
+		EntityMap::const_iterator entity = m_entities.find(*id);
+		if (entity != m_entities.end()) {
+			GetProcesses(entity->second, pids);
+		}
+	}
+}
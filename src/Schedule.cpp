@@ -18,6 +18,7 @@
 
 #include "Schedule.h"
 #include "Scheduler.h"
+#include "Clock.h"
 #include "Activity.h"
 #include "ActivityJson.h"
 #include "Logging.h"
@@ -57,7 +58,7 @@ void Schedule::CalcNextStartTime()
 
 time_t Schedule::GetTime() const
 {
-	time_t curTime = time(NULL);
+	time_t curTime = Clock::GetInstance().GetTime();
 
 	/* Adjust back to local time, if required.  This may not be the same
 	 * adjustment that was in place when the scheduled Activity was first
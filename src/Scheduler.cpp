@@ -18,6 +18,9 @@
 
 #include "Scheduler.h"
 #include "Activity.h"
+#include "Clock.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include "Logging.h"
 #include <stdexcept>
 #include <cstdlib>
@@ -195,6 +198,9 @@ void Scheduler::Wake()
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Wake callback");
 
+	static MetricsCounter& s_wakes = Metrics::GetCounter("scheduler.wakes");
+	s_wakes.Increment();
+
 	m_wakeScheduled = false;
 
 	DequeueAndUpdateTimeout();
@@ -216,7 +222,7 @@ void Scheduler::DequeueAndUpdateTimeout()
 		return;
 	}
 
-	time_t	curTime = time(NULL);
+	time_t	curTime = Clock::GetInstance().GetTime();
 
 	LOG_AM_DEBUG("Beginning to dequeue items at time %llu",
 		(unsigned long long)curTime);
@@ -262,6 +268,9 @@ void Scheduler::ProcessQueue(ScheduleQueue& queue, time_t curTime)
 		Schedule& item = *(queue.begin());
 
 		if (item.GetNextStartTime() <= curTime) {
+			AM_PROBE3(schedule_due, item.GetActivity()->GetId(),
+				(long long)item.GetNextStartTime(), (long long)curTime);
+
 			item.m_queueItem.unlink();
 			item.Scheduled();
 		} else {
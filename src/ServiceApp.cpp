@@ -33,8 +33,11 @@
 #include "SystemManagerProxy.h"
 #include "PowerdProxy.h"
 #include "ResourceManager.h"
+#include "CgroupV2Manager.h"
 #include "ControlGroupManager.h"
+#include "ProcessPolicyManager.h"
 #include "LunaBusProxy.h"
+#include "FlightRecorder.h"
 #include <nyx/nyx_client.h>
 #include <glib.h>
 
@@ -170,10 +173,36 @@ MojErr ActivityManagerApp::open()
 	try {
 		m_resourceManager = boost::make_shared<MasterResourceManager>();
 #ifndef WEBOS_TARGET_MACHINE_IMPL_SIMULATOR
-		m_controlGroupManager = boost::make_shared<ControlGroupManager>(
-			"/sys/fs/cgroup/cpuset", m_resourceManager);
-		m_resourceManager->SetManager("cpu", m_controlGroupManager);
-		m_busProxy = boost::make_shared<LunaBusProxy>(m_controlGroupManager,
+		if (CgroupV2Manager::IsCgroupV2("/sys/fs/cgroup")) {
+			boost::shared_ptr<CgroupV2Manager> cgroupManager =
+				boost::make_shared<CgroupV2Manager>(
+					"/sys/fs/cgroup/activitymanager", m_resourceManager);
+			if (cgroupManager->IsSupported()) {
+				m_containerManager = cgroupManager;
+			}
+		}
+
+		/* Without usable cgroup v2 classes, the v1 manager still sets the
+		 * threads' policies and CPU affinity directly */
+		if (!m_containerManager) {
+			m_containerManager = boost::make_shared<ControlGroupManager>(
+				"/sys/fs/cgroup/cpuset", m_resourceManager);
+		}
+		m_resourceManager->SetManager("cpu", m_containerManager);
+
+		boost::shared_ptr<ProcessPolicyManager> ioManager =
+			boost::make_shared<ProcessPolicyManager>(
+				ProcessPolicyManager::PolicyIo, m_resourceManager);
+		m_resourceManager->SetManager("io", ioManager);
+		m_containerManager->LinkManager(ioManager);
+
+		boost::shared_ptr<ProcessPolicyManager> memoryManager =
+			boost::make_shared<ProcessPolicyManager>(
+				ProcessPolicyManager::PolicyMemory, m_resourceManager);
+		m_resourceManager->SetManager("memory", memoryManager);
+		m_containerManager->LinkManager(memoryManager);
+
+		m_busProxy = boost::make_shared<LunaBusProxy>(m_containerManager,
 			&m_client);
 #endif
 
@@ -226,6 +255,8 @@ MojErr ActivityManagerApp::open()
 
 	LOG_AM_DEBUG("%s initialized", name().data());
 
+	FlightRecorder::EnableSignalDump();
+
 	/* System is initialized.  All object managers are prepared to instantiate
 	 * their objects as Activities are loaded from the database.  Begin
 	 * deserializing persistent Activities. */
@@ -327,7 +358,7 @@ MojErr ActivityManagerApp::online()
 	 *	palm://com.palm.activitymanager/... */
 	m_handler.reset(new ActivityCategoryHandler(m_db, m_json, m_am,
 		m_triggerManager, m_powerManager, m_resourceManager,
-		m_controlGroupManager));
+		m_containerManager, m_requirementManager));
 	MojAllocCheck(m_handler.get());
 
 	err = m_handler->Init();
@@ -354,7 +385,7 @@ MojErr ActivityManagerApp::online()
 	 *  palm://com.palm.activitymanager/devel/... */
 
 	m_develHandler.reset(new DevelCategoryHandler(m_am, m_json,
-		m_resourceManager, m_controlGroupManager));
+		m_resourceManager, m_containerManager));
 
 	MojAllocCheck(m_develHandler.get());
 
@@ -104,7 +104,7 @@ Example response for a failed call:
 MojErr
 TestCategoryHandler::Leak(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Leak: %s", MojoObjectJson(payload).c_str());
@@ -185,7 +185,7 @@ Example response for a failed call:
 MojErr
 TestCategoryHandler::WhereMatchTest(MojServiceMessage *msg, MojObject &payload)
 {
-	ACTIVITY_SERVICEMETHOD_BEGIN();
+	ACTIVITY_SERVICEMETHOD_BEGIN(msg, payload);
 
 	MojObject response;
 	bool found = payload.get(_T("response"), response);
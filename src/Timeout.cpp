@@ -17,12 +17,13 @@
 // LICENSE@@@
 
 #include "Timeout.h"
+#include "Metrics.h"
 #include "Logging.h"
 MojLogger TimeoutBase::s_log(_T("activitymanager.timeout"));
 
 TimeoutBase::TimeoutBase(unsigned seconds)
 	: m_seconds(seconds)
-	, m_timeout(NULL)
+	, m_timer(0)
 {
 }
 
@@ -31,53 +32,63 @@ TimeoutBase::~TimeoutBase()
 	Cancel();
 }
 
+static MetricsGauge& PendingTimers()
+{
+	static MetricsGauge& s_pending = Metrics::GetGauge("timers.pending");
+	return s_pending;
+}
+
 void TimeoutBase::Arm()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
-	if (m_timeout) {
-		Cancel();
+	if (m_timer) {
+		m_timer = Clock::GetInstance().RearmTimer(m_timer, m_seconds, this);
+	} else {
+		m_timer = Clock::GetInstance().AddTimer(m_seconds, this);
+		PendingTimers().Add(1);
 	}
+}
 
-	GSource *timeout = g_timeout_source_new_seconds((guint)m_seconds);
-	g_source_set_callback(timeout, TimeoutBase::StaticWakeupTimeout, this,
-		NULL);
-	g_source_attach(timeout, g_main_context_default());
-
-	m_timeout = timeout;
+void TimeoutBase::Arm(unsigned seconds)
+{
+	m_seconds = seconds;
+	Arm();
 }
 
 void TimeoutBase::Cancel()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 
-	if (m_timeout) {
-		if (!g_source_is_destroyed(m_timeout)) {
-			g_source_destroy(m_timeout);
-		}
-
-		m_timeout = NULL;
+	if (m_timer) {
+		Clock::GetInstance().CancelTimer(m_timer);
+		m_timer = 0;
+		PendingTimers().Add(-1);
 	}
 }
 
-gboolean TimeoutBase::StaticWakeupTimeout(gpointer data)
+bool TimeoutBase::IsArmed() const
+{
+	return m_timer != 0;
+}
+
+void TimeoutBase::Fire()
 {
 	LOG_AM_TRACE("Entering function %s", __FUNCTION__);
 	LOG_AM_DEBUG("Wakeup");
 
-	TimeoutBase *base = static_cast<TimeoutBase *>(data);
+	static MetricsCounter& s_fired = Metrics::GetCounter("timers.fired");
+	s_fired.Increment();
 
 	/* Reset NOW, because the timeout call could delete this object. */
-	base->m_timeout = NULL;
+	m_timer = 0;
+	PendingTimers().Add(-1);
 
 	try {
-		base->WakeupTimeout();
+		WakeupTimeout();
 	} catch (const std::exception& except) {
 		LOG_AM_ERROR(MSGID_TIMEOUT_EXCEPTION,0, "Unhandled exception \"%s\" occurred",except.what());
 	} catch (...) {
 		LOG_AM_ERROR(MSGID_TIMEOUT_ERR_UNKNOWN,0, "Unhandled exception of unknown type occurred");
 	}
-
-	return false;
 }
-
@@ -0,0 +1,253 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2009-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "WorkloadRecorder.h"
+#include "Activity.h"
+#include "ActivityJson.h"
+#include "ActivityManager.h"
+#include "DiagnosticFile.h"
+#include "MojoBusMessage.h"
+#include "MojoObjectWrapper.h"
+#include "MojoSubscription.h"
+#include "MojoURL.h"
+#include "Logging.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/time.h>
+
+FILE				*WorkloadRecorder::s_file = NULL;
+std::string			WorkloadRecorder::s_path;
+MojInt64			WorkloadRecorder::s_start = 0;
+unsigned long long	WorkloadRecorder::s_records = 0;
+
+static MojInt64 MonotonicMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((MojInt64)ts.tv_sec * 1000LL) + ((MojInt64)ts.tv_nsec / 1000000LL);
+}
+
+MojErr WorkloadRecorder::Start(const std::string& name,
+	boost::shared_ptr<ActivityManager> am)
+{
+	if (!DiagnosticFile::IsValidName(name)) {
+		return MojErrInvalidArg;
+	}
+
+	if (s_file) {
+		Stop(am);
+	}
+
+	/* Build the start record before opening the trace, so a failure here
+	 * leaves nothing half started */
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	MojObject activities(MojObject::TypeArray);
+	MojErr err = ActivitiesToJson(am, activities, true);
+	MojErrCheck(err);
+
+	MojObject record(MojObject::TypeObject);
+	err = record.putString(_T("k"), _T("start"));
+	MojErrCheck(err);
+	err = record.putInt(_T("w"), ((MojInt64)tv.tv_sec * 1000LL) +
+		((MojInt64)tv.tv_usec / 1000LL));
+	MojErrCheck(err);
+	err = record.put(_T("a"), activities);
+	MojErrCheck(err);
+
+	std::string path;
+	FILE *file = DiagnosticFile::Create(name, false, path);
+	if (!file) {
+		int error = errno;
+		LOG_AM_ERROR(MSGID_TRACE_OPEN_FAIL, 2, PMLOGKS("path", path.c_str()),
+			PMLOGKS("error", strerror(error)),
+			"Failed to open workload trace file");
+		return (error == EEXIST) ? MojErrExists : MojErrAccessDenied;
+	}
+
+	s_file = file;
+	s_path = path;
+	s_start = MonotonicMs();
+	s_records = 0;
+
+	Write(record);
+
+	LOG_AM_DEBUG("Workload recording started to %s", path.c_str());
+
+	return MojErrNone;
+}
+
+MojErr WorkloadRecorder::Stop(boost::shared_ptr<ActivityManager> am)
+{
+	if (!s_file) {
+		return MojErrNone;
+	}
+
+	MojObject activities(MojObject::TypeArray);
+	MojErr err = ActivitiesToJson(am, activities, false);
+
+	MojObject record(MojObject::TypeObject);
+	record.putString(_T("k"), _T("end"));
+	record.putInt(_T("t"), GetElapsed());
+	record.put(_T("a"), activities);
+
+	Write(record);
+
+	fclose(s_file);
+	s_file = NULL;
+
+	LOG_AM_DEBUG("Workload recording to %s stopped after %llu records",
+		s_path.c_str(), s_records);
+
+	return err;
+}
+
+const std::string& WorkloadRecorder::GetPath()
+{
+	return s_path;
+}
+
+unsigned long long WorkloadRecorder::GetRecordCount()
+{
+	return s_records;
+}
+
+void WorkloadRecorder::RecordCall(MojServiceMessage *msg,
+	const MojObject& payload)
+{
+	if (!s_file) {
+		return;
+	}
+
+	MojObject record(MojObject::TypeObject);
+	record.putString(_T("k"), _T("call"));
+	record.putInt(_T("t"), GetElapsed());
+
+	/* The recorder must never fail the request it is recording */
+	try {
+		const MojChar *category = MojoBusMessage::GetCategory(msg);
+		record.putString(_T("c"), category ? category : _T("/"));
+
+		BusId caller = MojoSubscription::GetBusId(msg);
+		record.putString(_T("s"), caller.GetId().c_str());
+		record.putInt(_T("st"), (MojInt64)caller.GetType());
+
+		if (MojoBusMessage::IsPublic(msg)) {
+			record.putBool(_T("pub"), true);
+		}
+	} catch (...) {
+		record.putString(_T("c"), _T("/"));
+	}
+
+	const MojChar *method = msg->method();
+	record.putString(_T("m"), method ? method : _T(""));
+	record.put(_T("p"), payload);
+
+	Write(record);
+}
+
+void WorkloadRecorder::RecordActivityId(activityId_t id)
+{
+	if (!s_file) {
+		return;
+	}
+
+	MojObject record(MojObject::TypeObject);
+	record.putString(_T("k"), _T("id"));
+	record.putInt(_T("t"), GetElapsed());
+	record.putInt(_T("i"), (MojInt64)id);
+
+	Write(record);
+}
+
+void WorkloadRecorder::RecordSignal(const MojoURL& url,
+	const MojObject& params, const MojObject& response, MojErr err)
+{
+	if (!s_file) {
+		return;
+	}
+
+	MojObject record(MojObject::TypeObject);
+	record.putString(_T("k"), _T("signal"));
+	record.putInt(_T("t"), GetElapsed());
+	record.putString(_T("u"), url.GetString().c_str());
+	record.put(_T("q"), params);
+	record.put(_T("p"), response);
+	if (err) {
+		record.putInt(_T("e"), (MojInt64)err);
+	}
+
+	Write(record);
+}
+
+MojErr WorkloadRecorder::ActivitiesToJson(
+	boost::shared_ptr<ActivityManager> am, MojObject& rep, bool full)
+{
+	MojErr err;
+
+	ActivityManager::ActivityVec activities = am->GetActivities();
+	for (ActivityManager::ActivityVec::const_iterator iter =
+		activities.begin(); iter != activities.end(); ++iter) {
+		MojObject entry(MojObject::TypeObject);
+
+		err = (*iter)->IdentityToJson(entry);
+		MojErrCheck(err);
+
+		err = entry.putString(_T("state"),
+			(*iter)->GetStateString().c_str());
+		MojErrCheck(err);
+
+		if (full) {
+			MojObject activity(MojObject::TypeObject);
+			err = (*iter)->ToJson(activity, ACTIVITY_JSON_PERSIST);
+			MojErrCheck(err);
+
+			err = entry.put(_T("activity"), activity);
+			MojErrCheck(err);
+		}
+
+		err = rep.push(entry);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+MojInt64 WorkloadRecorder::GetElapsed()
+{
+	return MonotonicMs() - s_start;
+}
+
+void WorkloadRecorder::Write(MojObject& record)
+{
+	MojoObjectJson json(record);
+
+	if ((fputs(json.c_str(), s_file) < 0) || (fputc('\n', s_file) == EOF)) {
+		LOG_AM_ERROR(MSGID_TRACE_WRITE_FAIL, 1,
+			PMLOGKS("path", s_path.c_str()),
+			"Failed to write workload trace; recording stopped");
+		fclose(s_file);
+		s_file = NULL;
+		return;
+	}
+
+	s_records++;
+}